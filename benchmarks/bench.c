@@ -0,0 +1,145 @@
+/*
+=======================================================================================
+ Benchmark driver, runs a script several times with each execution engine and reports
+ the average time of a run. Scripts are parsed and compiled only once, so only the
+ execution is measured. Benchmark scripts should not print anything
+
+ Scripts run as written unless an optimization level is given, the -O1 passes fold
+ loops like the one in dispatch.sim away and leave nothing to time
+=======================================================================================
+*/
+
+#include <time.h>
+
+#include "lexer.h"
+#include "parser.h"
+#include "interpreter.h"
+#include "passManager.h"
+#include "vm.h"
+#include "jit.h"
+#include "closure.h"
+#include "scriptReader.h"
+
+double nowMs(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+int countNodes(SyntaxNode* node) {
+    if (node == NULL) return 0;
+    return 1 + countNodes(node->subnodeA) + countNodes(node->subnodeB) + countNodes(node->subnodeC);
+}
+
+// Evaluates one straight-line statement many times, so the time only depends on how fast eval()
+// goes through the nodes and moves values around
+void nodeThroughput(const char* statement, int iterations) {
+    SimplicError* error = initError();
+    Token* tokenList = initTokenQueue();
+    MemoryBank* bank = initMemoryBank();
+    insertInt(bank, "X", 12345);
+    insertStr(bank, "S", "ABC");
+    ControlState control = { .bank = bank, .out = stdout, .returned = false };
+
+    tokenizeSource(&tokenList, statement, error);
+    SyntaxNode* tree = parseTokenList(&tokenList, error);
+    int nodes = countNodes(tree);
+
+    double start = nowMs();
+    for (int i = 0; i < iterations; i++) {
+        eval(tree, &control, error);
+    }
+    double elapsed = nowMs() - start;
+    printf("  %-45s %3d nodes %8.1f Mnodes/s\n", statement, nodes, nodes * (double)iterations / elapsed / 1000.0);
+
+    freeSyntaxTree(tree);
+    deleteTokenQueue(&tokenList);
+    deleteMemoryBank(&bank);
+    deleteError(&error);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printf("Usage: %s <file> [runs] [level] | %s --nodes\n", argv[0], argv[0]);
+        return 0;
+    }
+
+    if (strcmp(argv[1], "--nodes") == 0) {
+        printf("Node throughput, SimplicValue is %d bytes\n", (int)sizeof(SimplicValue));
+        nodeThroughput("SET R = X * 3 + X / 7 - X % 5 LT X + 100", 2000000);
+        nodeThroughput("SET R = X + 1 + X + 2 + X + 3 + X + 4", 2000000);
+        nodeThroughput("SET R = S + X", 2000000);
+        return 0;
+    }
+    int runs = (argc > 2) ? atoi(argv[2]) : 5;
+    int level = (argc > 3) ? atoi(argv[3]) : 0;
+
+    SimplicError* error = initError();
+    Script* script = readScript(argv[1], error);
+    if (error->hasError) {
+        printError(error);
+        return 1;
+    }
+
+    Token* tokenList = initTokenQueue();
+    tokenizeSourceLength(&tokenList, script->text, script->length, error);
+    SyntaxNode* tree = parseProgram(&tokenList, error);
+    PassPipeline pipeline;
+    initPipeline(&pipeline, level);
+    runPipeline(&pipeline, tree, error);
+    VMProgram* code = compileProgram(tree, error);
+    VMProgram* jitCode = compileProgram(tree, error);
+    Closure* closure = compileClosure(tree, error);
+    if (error->hasError) {
+        printError(error);
+        return 1;
+    }
+
+    ControlState control = { .bank = NULL, .out = stdout, .returned = false };
+    double start = nowMs();
+    for (int i = 0; i < runs; i++) {
+        control.returned = false;
+        SimplicValue val = runProgram(code, &control, error);
+        if (val.type == VALUE_STR) free(val.string);
+    }
+    printf("  vm:      %10.3f ms/run\n", (nowMs() - start) / runs);
+
+    // Loops that can't be translated still run as bytecode
+    int loops = jitCompileProgram(jitCode);
+    start = nowMs();
+    for (int i = 0; i < runs; i++) {
+        control.returned = false;
+        SimplicValue val = runProgram(jitCode, &control, error);
+        if (val.type == VALUE_STR) free(val.string);
+    }
+    printf("  vm+jit:  %10.3f ms/run (%d native loops)\n", (nowMs() - start) / runs, loops);
+
+    start = nowMs();
+    for (int i = 0; i < runs; i++) {
+        control.returned = false;
+        control.bank = initMemoryBank();
+        SimplicValue val = runClosure(closure, &control, error);
+        if (val.type == VALUE_STR) free(val.string);
+        deleteMemoryBank(&control.bank);
+    }
+    printf("  closure: %10.3f ms/run\n", (nowMs() - start) / runs);
+
+    start = nowMs();
+    for (int i = 0; i < runs; i++) {
+        control.returned = false;
+        control.bank = initMemoryBank();
+        SimplicValue val = eval(tree, &control, error);
+        if (val.type == VALUE_STR) free(val.string);
+        deleteMemoryBank(&control.bank);
+    }
+    printf("  eval:    %10.3f ms/run\n", (nowMs() - start) / runs);
+
+    deleteProgram(&code);
+    deleteProgram(&jitCode);
+    deleteClosure(&closure);
+    freeSyntaxTree(tree);
+    deleteTokenQueue(&tokenList);
+    deleteError(&error);
+    deleteScript(&script);
+    return 0;
+}
@@ -0,0 +1,21 @@
+// Generated by simplic --emit-c from test
+#include "simplicRuntime.h"
+
+int main(void) {
+    SrValue v_S = SR_UNDECLARED;
+
+    {
+        SrValue t0 = sr_str("A");
+        sr_assign(&v_S, t0);
+    }
+    {
+        SrValue t1 = sr_var(&v_S, "S");
+        if (sr_cond(t1, "IF")) {
+            {
+                SrValue t2 = sr_int(1);
+                sr_print(t2, false);
+            }
+        }
+    }
+    return 0;
+}
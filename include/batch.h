@@ -0,0 +1,49 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+/*
+=======================================================================================
+ Batch mode runs many scripts in one process on a pool of threads. Each thread starts
+ with a block of consecutive scripts and runs them from the front, a thread that runs
+ out of them steals from the back of another thread's block, so a few long scripts
+ don't leave the other threads idle. Every script runs on its own interpreter state
+ and prints to its own buffer. Buffers are written out in the order the scripts were
+ given as soon as a script and all the ones before it have finished, so the output
+ is the same as running them one by one, whatever the number of threads.
+ What each script returned and how long it took are kept for the summary
+=======================================================================================
+*/
+
+#include "simplic.h"
+#include "simplicError.h"
+#include "server.h"
+
+// One script of the batch
+typedef struct BatchJob BatchJob;
+struct BatchJob {
+    char* path;
+    RunResult result; // status is 1 if the script could not be read
+    double seconds; // Reading and running it
+};
+
+typedef struct Batch Batch;
+struct Batch {
+    BatchJob* jobs; // In the order they were added, the one of the output
+    size_t count;
+    size_t capacity;
+    int threads; // Used by the last runBatch()
+    double seconds; // Wall time of the last runBatch()
+};
+
+Batch* initBatch(void);
+
+// Adds a script, or every .sim file of a directory sorted by name. false if the directory can't be read
+bool addBatchPath(Batch* batch, const char* path, SimplicError* error);
+
+// Runs every script with runner on up to threads threads (0 for one per CPU), their output goes to out
+void runBatch(Batch* batch, int threads, ScriptRunner runner, void* context, FILE* out);
+
+void printBatchSummary(const Batch* batch, FILE* out); // Return code and time of each script, then the totals
+void deleteBatch(Batch** batch);
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef CLOSURE_H
+#define CLOSURE_H
+
+/*
+=======================================================================================
+ Closure compilation is an execution engine halfway between eval() and the VM. Each
+ node of the AST is compiled once into a Closure: a small record holding a pointer to
+ the function that executes it. That function is chosen at compile time depending on
+ the node type, the operator and the shape of the operands (for example "variable LT
+ constant"), so running a closure never inspects node types or operator strings.
+ Variables are stored in the memory bank, exactly like eval() does
+=======================================================================================
+*/
+
+#include "simplic.h"
+#include "simplicError.h"
+#include "interpreter.h"
+#include "dataStructures/ast.h"
+#include "dataStructures/memoryBank.h"
+
+typedef struct Closure Closure;
+typedef SimplicValue (*ClosureFn)(Closure* self, ControlState* control, SimplicError* error);
+
+struct Closure {
+    ClosureFn fn; // Specialized code for this node
+    Closure* a; // Operands, same meaning as the subnodes of the AST node
+    Closure* b;
+    Closure* c;
+    Closure** statements; // Null-terminated list of closures, for blocks
+    char name[IDENTIFIER_SIZE]; // For variables
+    int number; // For numbers
+    char* string; // For strings
+};
+
+// Compiles an AST into a tree of closures, the AST is not modified and can be freed afterwards
+Closure* compileClosure(SyntaxNode* node, SimplicError* error);
+
+// Runs a closure tree, returns the same value eval() would return for the original AST
+SimplicValue runClosure(Closure* closure, ControlState* control, SimplicError* error);
+
+void deleteClosure(Closure** closure);
+
+#endif
@@ -37,6 +37,8 @@ struct SyntaxNode {
     NodeType type;
     char varName[IDENTIFIER_SIZE]; // For variables
     char operator[BIN_OP_OPERATOR_SIZE];  // For bin_ops
+    int quick; // Form eval() has rewritten a bin_op into at runtime, 0 until it first runs
+    bool provenInt; // Set by inferTypes(): expression always yields an integer, or assigned variable never holds a string
     int numberValue;    // For numbers
     char* string; // For strings
     SyntaxNode** blockStatements; // List of Syntax trees, used to store blocks of instructions
@@ -48,6 +50,8 @@ struct SyntaxNode {
 SyntaxNode* initNode(void); // Used to create a node, sets to NULL its fields
 
 void freeSyntaxTree(SyntaxNode* tree);
-bool compareSyntaxTree(SyntaxNode* a, SyntaxNode* b); // Used to compare AST in tests
+SyntaxNode* copySyntaxTree(SyntaxNode* tree); // Deep copy
+bool compareSyntaxTree(SyntaxNode* a, SyntaxNode* b); // Structural equality, used by tests and the optimizer
+unsigned int hashSyntaxTree(SyntaxNode* tree); // Equal trees (see compareSyntaxTree()) have equal hashes
 
 #endif
\ No newline at end of file
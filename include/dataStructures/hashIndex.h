@@ -0,0 +1,44 @@
+#ifndef HASHINDEX_H
+#define HASHINDEX_H
+
+/*
+=======================================================================================
+ Hash index over entries kept in arrays by someone else, like the names of the
+ variables of a pass or the constants of a compiled program. The index only stores
+ the hash of each entry and its position in those arrays, the owner compares keys
+ itself, so the same index works with names, strings or numbers:
+
+    int cursor;
+    for (int i = hashIndexFirst(&index, hash, &cursor); i >= 0; i = hashIndexNext(&index, hash, &cursor))
+        if (strcmp(names[i], name) == 0) return i;
+
+ Open addressing with linear probing, the table doubles before it is half full
+=======================================================================================
+*/
+
+#include "simplic.h"
+
+typedef struct HashIndex HashIndex;
+struct HashIndex {
+    unsigned int* hashes;
+    int* entries; // Position of the entry in the owner's arrays, -1 for free slots
+    int capacity; // Slots, a power of 2 (0 until the first entry is added)
+    int count;
+};
+
+HashIndex initHashIndex(void); // Empty, allocates nothing
+HashIndex copyHashIndex(const HashIndex* index);
+void freeHashIndex(HashIndex* index); // Frees the slots, the index is left empty and can be used again
+
+unsigned int hashName(const char* name); // Hash of a string key
+unsigned int hashInt(int value); // Hash of an integer key
+
+void hashIndexAdd(HashIndex* index, unsigned int hash, int entry);
+void hashIndexRemove(HashIndex* index, unsigned int hash, int entry);
+void hashIndexMove(HashIndex* index, unsigned int hash, int entry, int newEntry); // The entry changed position in the arrays
+
+// Entries whose hash may be hash, in no particular order. -1 once there are no more
+int hashIndexFirst(const HashIndex* index, unsigned int hash, int* cursor);
+int hashIndexNext(const HashIndex* index, unsigned int hash, int* cursor);
+
+#endif
@@ -19,9 +19,6 @@ typedef enum {
     VALUE_VOID
 } ValueType;
 
-void initMemoryBank(void);
-void deleteMemoryBank(void); // Empties the variable bank, call at exit
-
 typedef struct MemoryCell MemoryCell;
 struct MemoryCell {
     char name[IDENTIFIER_SIZE];
@@ -30,7 +27,14 @@ struct MemoryCell {
     MemoryCell* next; // In case of name collision
 };
 
-extern MemoryCell* MemoryBank[HASH_TABLE_SIZE]; // Hashmap of variables
+// Variables of one running script, each script gets its own so several can run at once
+typedef struct MemoryBank MemoryBank;
+struct MemoryBank {
+    MemoryCell* cells[HASH_TABLE_SIZE]; // Hashmap of variables
+};
+
+MemoryBank* initMemoryBank(void); // Empty bank
+void deleteMemoryBank(MemoryBank** bank); // Frees every variable and the bank, sets it to NULL
 
 // Struct used to wrap values read from the bank and check for errors
 typedef struct BankResult BankResult;
@@ -41,13 +45,14 @@ struct BankResult {
 };
 
 // Assigns a value to a variable or adds it to the bank in case it didn't exist 
-void insertInt(const char* key, int value); 
-void insertStr(const char* key, const char* str);
+void insertInt(MemoryBank* bank, const char* key, int value); 
+void insertStr(MemoryBank* bank, const char* key, const char* str);
 
 // Get a variable from the bank
-BankResult getInt(const char* key, SimplicError* error);
-BankResult getStr(const char* key, SimplicError* error);
-bool varIsInt(const char* key, SimplicError* error); // Checks if certain stored variable is an integer
-BankResult deleteVariable(const char* key, SimplicError* error); // Return 0 if variable was unset successfuly, else -1
+BankResult getInt(MemoryBank* bank, const char* key, SimplicError* error);
+BankResult getStr(MemoryBank* bank, const char* key, SimplicError* error);
+bool varIsInt(MemoryBank* bank, const char* key, SimplicError* error); // Checks if certain stored variable is an integer
+MemoryCell* getCell(MemoryBank* bank, const char* key, SimplicError* error); // Direct access to a variable, its type and value with one lookup
+BankResult deleteVariable(MemoryBank* bank, const char* key, SimplicError* error); // Return 0 if variable was unset successfuly, else -1
 
 #endif
\ No newline at end of file
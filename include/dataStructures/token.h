@@ -64,7 +64,7 @@ int deleteTokenQueue(Token** tokenList); // -1 if list is already empty
 
 int enqueueToken(Token** tokenList, TokenType type, const char* name, char* string); // -1 if fail
 Token dequeueToken(Token** tokenList); // Pops out a token and returns a copy of it
-Token* peekTokenQueue(Token** tokenList); // Returns reference to current token
+Token* peekTokenQueue(Token** tokenList); // Returns reference to current token, an EOF token once the list is empty
 
 void printTokenQueue(Token* tokenList);
 
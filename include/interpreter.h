@@ -4,30 +4,48 @@
 /*
 =======================================================================================
  The interpreter is the part of the... interpreter that executes the code. It receives
- ASTs from the parser and executes them recursively, deciding what to do at each node.
+ ASTs from the parser and walks them, deciding what to do at each node.
  Some nodes are instructions which have their operands as child nodes, this child
  nodes can also be instructions themselves and so need to be solved first.
- The variables are stored at runtime in the VariableBank, this is a hashTable that
- uses the variable's names as keys. A variable can store different types of data
+ The variables are stored at runtime in the MemoryBank given in ControlState, this is
+ a hashTable that uses the variable's names as keys. A variable can store different types of data
  (Integers or Strings for now). After the evaluation the AST used is deleted.
 =======================================================================================
 */
 
+#include <setjmp.h>
+
 #include "simplic.h"
 #include "dataStructures/memoryBank.h"
 #include "dataStructures/ast.h"
 #include "simplicError.h"
 
-// Wrapper type for eval(), contains the result of the last evaluation
+// Wrapper type for eval(), contains the result of the last evaluation. Values are copied
+// around constantly so they are kept in 16 bytes: strings keep integer at 0, that's the
+// value they have in arithmetic
 typedef struct SimplicValue SimplicValue;
 struct SimplicValue {
     ValueType type;
     int integer;
     char* string;
-    bool receivedReturn;
 };
 
-// Receives an AST as input and computes it recursively, returning the value of each node
-SimplicValue eval(SyntaxNode* node, SimplicError* error);
+_Static_assert(sizeof(SimplicValue) <= 16, "SimplicValue must fit in 16 bytes");
+
+// State of a running program, kept by the engine instead of inside the values.
+// RETURN leaves the program in a single step: eval() drops its whole work stack, the VM
+// leaves its dispatch loop and closures jump back to runClosure() through unwind.
+// Engines reach the variables and the output only through here, never through globals
+typedef struct ControlState ControlState;
+struct ControlState {
+    MemoryBank* bank; // Variables, for eval() and closures (the VM keeps them in registers)
+    FILE* out; // Where PRINT and PRINTLN write
+    bool returned; // Set once RETURN has been executed
+    jmp_buf* unwind; // Set by engines that run on nested C calls
+    SimplicValue value; // Value given to RETURN while unwinding
+};
+
+// Receives an AST as input and computes it, returning the value of its last node
+SimplicValue eval(SyntaxNode* node, ControlState* control, SimplicError* error);
 
 #endif
\ No newline at end of file
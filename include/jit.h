@@ -0,0 +1,42 @@
+#ifndef JIT_H
+#define JIT_H
+
+/*
+=======================================================================================
+ The JIT translates WHILE loops of a compiled VM program into x86-64 machine code.
+ Only loops made of integer operations, comparisons, INCR/DECR and nested IF/WHILE are
+ translated; anything else (strings, PRINT, RETURN, UNSET...) keeps running as
+ bytecode. Each instruction is turned into a fixed template of machine code and the
+ most used registers of the loop are kept in CPU registers while it runs.
+ A translated loop replaces the jump that starts it with OP_JIT_LOOP. Before entering
+ native code the VM checks that every variable of the loop holds an integer, if not,
+ the loop runs as bytecode. Native code goes back to the bytecode to report errors
+ such as divisions by 0, so messages are the same ones the VM gives.
+ The JIT is only available on Linux x86-64, it does nothing on other platforms
+=======================================================================================
+*/
+
+#include "vm.h"
+
+struct JitLoop {
+    void* code; // Executable memory holding the loop
+    size_t codeSize;
+    int (*entry)(int* slots); // Runs the loop, returns the instruction where the bytecode must resume
+    int* guards; // Variables that must hold integers before entering
+    int guardCount;
+    int* loads; // Registers copied into slots before entering
+    int loadCount;
+    int* writes; // Registers copied back from slots after leaving
+    int writeCount;
+    int* slots; // Integer value of each register while the loop runs
+};
+
+// Translates every loop of the program that can be translated, returns how many were translated
+int jitCompileProgram(VMProgram* program);
+
+// Runs a translated loop over the VM registers, returns the next instruction of the bytecode
+int jitRunLoop(JitLoop* loop, SimplicValue* registers, int fallback);
+
+void jitDeleteLoops(VMProgram* program);
+
+#endif
@@ -16,4 +16,15 @@
 // Receives null-terminated string as input, creates queue of tokens from a source code
 void tokenizeSource(Token** tokenList, const char* src, SimplicError* error);
 
+// Same with the first len chars of src, which needs no null terminator (a mapped script file for instance)
+void tokenizeSourceLength(Token** tokenList, const char* src, size_t len, SimplicError* error);
+
+// Receives a batch of tokens, first to last linked through next, which it now owns
+typedef void (*TokenBatchHandler)(Token* first, Token* last, void* context);
+
+// Same as tokenizeSourceLength(), but the tokens are handed to handler as they are made, in batches of
+// whole top level statements of at least batchTokens tokens. Parsing each batch on its own gives the same
+// statements as parsing all of them at once. The last batch ends with EOF, unless there was an error
+void tokenizeSourceBatches(const char* src, size_t len, size_t batchTokens, TokenBatchHandler handler, void* context, SimplicError* error);
+
 #endif
\ No newline at end of file
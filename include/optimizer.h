@@ -0,0 +1,63 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+/*
+=======================================================================================
+ The optimizer rewrites the AST of a whole program (see parseProgram()) before it is
+ sent to the interpreter. Every pass keeps the observable behaviour of the program
+ (output, return code and runtime errors) and only changes the shape of the trees.
+ Constant propagation walks the program in execution order keeping track of the
+ variables whose value is known, reads of those variables are replaced with their
+ value and the resulting expressions are folded into numbers when possible.
+ Dead code elimination then drops the statements that can never run: the ones after
+ a RETURN, the WHILEs whose condition is 0 and the branches an IF with a constant
+ condition never takes, the branch it does take replaces the IF.
+ Loop invariant code motion moves the expressions a WHILE computes with variables it
+ never writes into a new variable set before the loop, and common subexpression
+ elimination computes the repeated expressions of a statement once. Both only move
+ integer expressions that can't fail, so errors still show up at the same point.
+ Induction variable analysis finds the variables a loop changes by a constant once per
+ iteration: products of them by a constant become a variable updated with an addition,
+ and loops that only count and add up terms get an IF before them that computes the
+ final values at once and skips the iterations.
+ Loop unrolling copies the body of small innermost counted loops a few times, so the
+ condition is checked once for all the copies, the original loop runs the iterations
+ left over.
+ Type inference does not change the trees, it only flags them: it follows the types
+ each variable may hold through the program and marks the expressions proven to be
+ integers, and the assignments to variables that never hold a string. The VM compiles
+ those to instructions that skip the runtime type checks
+=======================================================================================
+*/
+
+#include "simplic.h"
+#include "dataStructures/ast.h"
+
+// Replaces reads of variables with a known integer value by that value, then folds the program
+void propagateConstants(SyntaxNode* program);
+
+// Frees the statements that never run and replaces IFs with a constant condition by their branch
+void eliminateDeadCode(SyntaxNode* program);
+
+// Computes before each WHILE the integer expressions that are the same in every iteration
+void hoistLoopInvariants(SyntaxNode* program);
+
+// Computes the integer expressions repeated inside a statement once, before the statement
+void eliminateCommonSubexpressions(SyntaxNode* program);
+
+// Strength reduction of I * c and closed forms of counted sum loops, see above
+void reduceInductionVariables(SyntaxNode* program);
+
+// Unrolls small counted loops copying their body factor times, does nothing if factor is below 2
+void unrollLoops(SyntaxNode* program, int factor);
+
+// Flags the nodes whose type is known before running (see provenInt in ast.h), run it after the other passes
+void inferTypes(SyntaxNode* program);
+
+// Folds binary operations between numbers into a single number node, returns the folded tree
+SyntaxNode* foldConstants(SyntaxNode* node);
+
+// Computes l op r like the interpreter does, false if the operation must be left to runtime (division by 0)
+bool foldBinOp(const char* operator, int l, int r, int* result);
+
+#endif
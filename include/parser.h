@@ -19,7 +19,14 @@
 #include "simplicError.h"
 #include "dataStructures/ast.h"
 
+// The passes and engines that walk the trees recurse, so deeper programs fail with ERROR_NESTING_TOO_DEEP
+#define MAX_EXPRESSION_DEPTH 4096 // Operators nested in one expression, like the + of X + 1 + 1 ...
+#define MAX_BLOCK_NESTING 1024 // WHILE and IF blocks one inside another
+
 // Parses a line of code from the token list and generates an AST used later for execution
 SyntaxNode* parseTokenList(Token** tokenList, SimplicError* error);
 
+// Parses every line left in the token list into a single block AST, used for whole-program analysis
+SyntaxNode* parseProgram(Token** tokenList, SimplicError* error);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,57 @@
+#ifndef PASSMANAGER_H
+#define PASSMANAGER_H
+
+/*
+=======================================================================================
+ The pass manager runs the optimizer passes (see optimizer.h and ssa.h) over a whole program in
+ a fixed order, between parseProgram() and the execution engines. Each -O level turns
+ on a set of passes, which can then be enabled or disabled one by one by name.
+ For debugging it can write the AST before and after each pass, time each pass and
+ check after each of them that the tree is still well formed, so a broken pass is
+ reported by name instead of crashing an engine
+=======================================================================================
+*/
+
+#include "simplic.h"
+#include "simplicError.h"
+#include "dataStructures/ast.h"
+
+// Passes in the order they run
+typedef enum {
+    PASS_CONSTANTS,
+    PASS_DEAD_CODE,
+    PASS_SSA,
+    PASS_HOIST,
+    PASS_CSE,
+    PASS_INDUCTION,
+    PASS_UNROLL,
+    PASS_TYPES,
+    PASS_COUNT
+} PassId;
+
+// Which passes run and what is reported about them
+typedef struct PassPipeline PassPipeline;
+struct PassPipeline {
+    bool enabled[PASS_COUNT];
+    int unrollFactor; // Copies of the body made by PASS_UNROLL
+    FILE* dump; // Gets the AST before the first pass and after each pass, NULL for none
+    FILE* timing; // Gets the time each pass took, NULL for none
+    bool verify; // Checks the tree after each pass
+};
+
+// -O0 runs nothing, -O1 every pass but unrolling and -O2 every pass. Nothing is dumped, timed or verified
+void initPipeline(PassPipeline* pipeline, int level);
+
+const char* passName(PassId pass); // Name used by setPassEnabled()
+bool setPassEnabled(PassPipeline* pipeline, const char* name, bool enabled); // false if no pass has that name
+
+// Runs the enabled passes, stops with an error if a pass leaves a malformed tree
+void runPipeline(const PassPipeline* pipeline, SyntaxNode* program, SimplicError* error);
+
+// Checks every node has the children its type needs (see parser.c), sets the error if not
+bool verifySyntaxTree(SyntaxNode* program, SimplicError* error);
+
+// Writes the tree one node per line, children indented below their parent
+void dumpSyntaxTree(SyntaxNode* program, FILE* out);
+
+#endif
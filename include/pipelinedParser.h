@@ -0,0 +1,22 @@
+#ifndef PIPELINEDPARSER_H
+#define PIPELINEDPARSER_H
+
+/*
+=======================================================================================
+ Pipelined front end for big scripts: the lexer runs on a thread of its own and hands
+ the tokens over in batches of whole top level statements (see
+ tokenizeSourceBatches()), while the calling thread parses each batch as it arrives.
+ Batches go through a single producer, single consumer ring of atomics, neither side
+ takes a lock. The program is the same, and so is any error, as the one lexing then
+ parsing the whole source gives
+=======================================================================================
+*/
+
+#include "simplic.h"
+#include "simplicError.h"
+#include "dataStructures/ast.h"
+
+// Lexes and parses the length chars of src into a program block. NULL if either fails, see error
+SyntaxNode* parsePipelined(const char* src, size_t length, size_t batchTokens, SimplicError* error);
+
+#endif
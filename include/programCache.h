@@ -0,0 +1,29 @@
+#ifndef PROGRAMCACHE_H
+#define PROGRAMCACHE_H
+
+/*
+=======================================================================================
+ The program cache keeps the AST of scripts that already ran, so running the same
+ script again skips lexing, parsing and the optimizer passes. Entries are files in a
+ cache directory named after a hash of the script's source and of the passes that
+ ran on it. A file holds a header followed by the nodes of the tree in preorder, as
+ fixed size records, and a table with the names and strings they use. Files are
+ read with mmap() and the tree is rebuilt from the records in one pass.
+ The header repeats the hashes, the size of the source and the version and build of
+ the interpreter, any mismatch (or a truncated or corrupt file) is a miss and the
+ entry is written again after parsing. Entries are written to a temporary file that
+ is then renamed, so concurrent runs and threads never see a half written entry
+=======================================================================================
+*/
+
+#include "simplic.h"
+#include "passManager.h"
+#include "dataStructures/ast.h"
+
+// Returns the program stored for the length chars of source and these passes, NULL on a miss
+SyntaxNode* loadCachedProgram(const char* dir, const char* source, size_t length, const PassPipeline* pipeline);
+
+// Stores the program made from source by the passes, creates dir if needed. false if it could not be written
+bool storeCachedProgram(const char* dir, const char* source, size_t length, const PassPipeline* pipeline, SyntaxNode* program);
+
+#endif
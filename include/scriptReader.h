@@ -1,10 +1,29 @@
 #ifndef SCRIPTREADER_H
 #define SCRIPTREADER_H
 
+/*
+=======================================================================================
+ Loads the text of a simplic script. Regular files are mapped read-only with mmap(),
+ so the lexer works on the page cache directly and nothing is copied however big the
+ script is. Pipes, terminals and stdin (given as "-") can't be mapped, those are read
+ with read() into a buffer that grows as needed.
+ The text is not null-terminated, use its length (see tokenizeSourceLength())
+=======================================================================================
+*/
+
 #include "simplicError.h"
 #include "simplic.h"
 
-// Used to read a simplic script from a file
-const char* readScriptFile(const char* fileName, SimplicError* error);
+typedef struct Script Script;
+struct Script {
+    const char* text; // length chars, not null-terminated
+    size_t length;
+    bool mapped; // text is a mapping of the file rather than a heap buffer
+};
+
+// Used to read a simplic script from a file, "-" reads stdin. NULL if it could not be read
+Script* readScript(const char* fileName, SimplicError* error);
+
+void deleteScript(Script** script); // Unmaps or frees the text, sets *script to NULL
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,41 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+/*
+=======================================================================================
+ Server mode keeps one interpreter process resident so short scripts don't pay for
+ starting it. The server listens on a Unix domain socket and runs one script per
+ connection, one after the other, each on a fresh memory bank and error state.
+ Every script runs in a forked copy of the server, so one that crashes only ends its
+ own run, and clients that don't send their request in time are dropped.
+ A client sends the path of the script (or its source) together with its own stdout
+ and stderr, passed as file descriptors over the socket. The script's output goes
+ straight to them as it runs, and the client then gets a RunResult back and exits
+ with its status. Everything stays on the local machine
+=======================================================================================
+*/
+
+#include "simplic.h"
+#include "simplicError.h"
+#include "scriptReader.h"
+
+// What running a script gave, sent back to the client
+typedef struct RunResult RunResult;
+struct RunResult {
+    int status; // Exit status of the interpreter if it had run the script itself
+    bool returned; // The script ended with RETURN
+    int returnCode; // Value returned, when returned is true
+};
+
+// Runs one script writing what it prints to out, name is the path or "-" for sources sent by the client
+typedef void (*ScriptRunner)(const char* name, const Script* script, FILE* out, RunResult* result, void* context);
+
+// Serves scripts on socketPath until a client asks to stop (see stopServer()). false if the socket can't be used
+bool serveScripts(const char* socketPath, ScriptRunner runner, void* context, SimplicError* error);
+
+// Has the server run a script file, or script when it is not NULL. Output goes to the out and err descriptors
+bool submitScript(const char* socketPath, const char* fileName, const Script* script, int out, int err, RunResult* result, SimplicError* error);
+
+bool stopServer(const char* socketPath, SimplicError* error); // Returns once the server stopped listening
+
+#endif
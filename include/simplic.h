@@ -19,5 +19,6 @@
 #define HASH_TABLE_SIZE 500 // Size of the memory variable table
 #define CHARS_FOR_INT_TO_STRING 10 // Number or chars reserved to represent an int as a string
 #define BIN_OP_OPERATOR_SIZE 3 // chars reserver to store the operator of a binary operation
+#define SIMPLIC_VERSION "1.0" // Entries of the program cache made by other versions are ignored
 
 #endif
\ No newline at end of file
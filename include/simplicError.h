@@ -26,6 +26,7 @@ typedef enum {
     ERROR_TYPE_MISMATCH,
     ERROR_READING_SCRIPT_FILE,
     ERROR_MALLOC_FAILURE,
+    ERROR_NESTING_TOO_DEEP,
     ERROR_MISC // Do not bother with these
 } SimplicErrorType;
 
@@ -39,7 +40,8 @@ struct SimplicError {
 SimplicError* initError(void); // Allocates error in memory
 void setError(SimplicError* error, SimplicErrorType errCode, const char* format, ...); // Throws error with message
 void unsetError(SimplicError* error); // Unsets error
-void printError(SimplicError* error);
+void printError(SimplicError* error); // Prints the error to stdout
+void fprintError(FILE* out, SimplicError* error);
 void deleteError(SimplicError** error); // Deletes error
 
 #endif
\ No newline at end of file
@@ -0,0 +1,116 @@
+#ifndef SIMPLICRUNTIME_H
+#define SIMPLICRUNTIME_H
+
+/*
+=======================================================================================
+ Runtime library of the C programs generated by simplic --emit-c (see transpiler.h).
+ It does not depend on any other part of the interpreter, so a generated program only
+ needs this header and the runtime library to be built:
+
+    cc -O2 -I include program.c build/release/libsimplicRuntime.a -o program
+
+ Values behave like in eval(): integers and strings, strings count as 0 in arithmetic
+ and + concatenates. Every variable is a local SrValue of the generated main(), an
+ undeclared variable holds SR_VOID. Errors print the same message the interpreter
+ prints and end the program. Operations on integers are inlined so the C compiler
+ can optimize them, strings are handled out of line
+=======================================================================================
+*/
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+typedef enum {
+    SR_INT,
+    SR_STR,
+    SR_VOID
+} SrType;
+
+// A value owns its string, operations consume their operands
+typedef struct SrValue SrValue;
+struct SrValue {
+    SrType type;
+    int integer;
+    char* string;
+};
+
+#define SR_UNDECLARED ((SrValue){ .type = SR_VOID, .integer = 0, .string = NULL })
+
+// Out of line parts of the runtime
+SrValue sr_str(const char* s); // Copies s
+SrValue sr_concat(SrValue l, SrValue r); // + with at least one string
+void sr_print(SrValue v, bool newline);
+void sr_unset(SrValue* var, const char* name);
+_Noreturn void sr_return(SrValue v); // Prints the return code and ends the program
+_Noreturn void sr_undeclared(const char* name); // Reports the access to an undeclared variable and ends the program
+_Noreturn void sr_divisionByZero(void);
+_Noreturn void sr_conditionMismatch(const char* statement); // Condition of a WHILE or IF was not an integer
+
+static inline SrValue sr_int(int n) {
+    return (SrValue){ .type = SR_INT, .integer = n, .string = NULL };
+}
+
+// Reads a variable, returns a copy of its value
+static inline SrValue sr_var(const SrValue* var, const char* name) {
+    if (var->type == SR_INT) return *var;
+    if (var->type == SR_VOID) sr_undeclared(name);
+    return sr_str(var->string);
+}
+
+static inline void sr_assign(SrValue* var, SrValue v) {
+    if (var->type == SR_STR) free(var->string);
+    *var = v;
+}
+
+// INCR and DECR, strings are left untouched
+static inline void sr_incr(SrValue* var, const char* name, int delta) {
+    if (var->type == SR_VOID) sr_undeclared(name);
+    if (var->type == SR_INT) var->integer += delta;
+}
+
+// Integer value used by arithmetic, consumes v
+static inline int sr_toInt(SrValue v) {
+    if (v.type == SR_STR) free(v.string);
+    return v.integer;
+}
+
+static inline int sr_cond(SrValue v, const char* statement) {
+    if (v.type != SR_INT) sr_conditionMismatch(statement);
+    return v.integer;
+}
+
+static inline SrValue sr_add(SrValue l, SrValue r) {
+    if (l.type == SR_INT && r.type == SR_INT) return sr_int(l.integer + r.integer);
+    return sr_concat(l, r);
+}
+
+static inline SrValue sr_div(SrValue l, SrValue r) {
+    int x = sr_toInt(l), y = sr_toInt(r);
+    if (y == 0) sr_divisionByZero();
+    return sr_int(x / y);
+}
+
+static inline SrValue sr_mod(SrValue l, SrValue r) {
+    int x = sr_toInt(l), y = sr_toInt(r);
+    if (y == 0) sr_divisionByZero();
+    return sr_int(x % y);
+}
+
+#define SR_INT_OP(name, expr) \
+    static inline SrValue sr_##name(SrValue l, SrValue r) { \
+        int x = sr_toInt(l), y = sr_toInt(r); \
+        return sr_int(expr); \
+    }
+
+SR_INT_OP(sub, x - y)
+SR_INT_OP(mul, x * y)
+SR_INT_OP(lt, x < y)
+SR_INT_OP(leq, x <= y)
+SR_INT_OP(gt, x > y)
+SR_INT_OP(geq, x >= y)
+SR_INT_OP(eq, x == y)
+SR_INT_OP(neq, x != y)
+SR_INT_OP(and, x && y)
+SR_INT_OP(or, x || y)
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef SIMPLICVM_H
+#define SIMPLICVM_H
+
+/*
+=======================================================================================
+ A SimplicVM holds everything one script needs from the moment its text is lexed
+ until it has run: its tokens, its variables, its error, where it prints and the
+ passes it is optimized with. The lexer, parser, optimizer and every engine only use
+ the state they are handed, so scripts on separate SimplicVMs don't share anything
+ and can run at the same time on separate threads.
+ A tree belongs to the SimplicVM that parsed it: eval() quickens its nodes as it
+ runs, so the same tree must not be run by two threads at once
+=======================================================================================
+*/
+
+#include "simplic.h"
+#include "simplicError.h"
+#include "passManager.h"
+#include "interpreter.h"
+#include "dataStructures/token.h"
+
+typedef struct SimplicVM SimplicVM;
+struct SimplicVM {
+    SimplicError* error; // Set by whichever stage fails, lexing, parsing or running
+    ControlState control; // Variables (control.bank), output (control.out) and control flow, given to the engines
+    Token* tokens; // Tokens of the script being parsed
+    PassPipeline pipeline; // Passes run by parseScript()
+    bool pipelinedParse; // parseScript() lexes big scripts on a second thread while it parses (see pipelinedParser.h)
+};
+
+// Empty bank and no error, what the scripts print goes to out. Scripts are lexed and parsed on the calling thread
+SimplicVM* initSimplicVM(FILE* out, const PassPipeline* pipeline);
+
+void resetSimplicVM(SimplicVM* vm); // Forgets the variables, tokens, error and RETURN of the last script
+void deleteSimplicVM(SimplicVM** vm);
+
+// Lexes, parses and optimizes the length chars of src. NULL if any of them fails, see vm->error
+SyntaxNode* parseScript(SimplicVM* vm, const char* src, size_t length);
+
+#endif
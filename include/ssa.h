@@ -0,0 +1,108 @@
+#ifndef SSA_H
+#define SSA_H
+
+/*
+=======================================================================================
+ The SSA form is a mid-level representation of a whole program used for dataflow
+ optimizations. The AST is lowered into basic blocks joined by jumps and branches,
+ where every assignment makes a new version of its variable (a value) and the
+ versions that reach a join point are merged by a phi. Expressions become temporary
+ values, so each value is defined exactly once and its uses point straight at it.
+ Blocks keep the structure of the WHILEs and IFs they come from, which lets the
+ optimized program be lowered back into an AST for the execution engines: every
+ version of a variable is stored in the variable itself, so the optimizations must
+ never make two versions of one variable live at the same time. They only replace
+ uses by constants, drop dead values and never taken branches, which keeps that true.
+ Sparse conditional constant propagation finds the values that are the same every
+ time they are computed, following only the branches that can be taken. Dead code
+ elimination then keeps the values that reach an output, a condition or an UNSET
+ (and those that may fail), so stores nobody reads disappear
+=======================================================================================
+*/
+
+#include "simplic.h"
+#include "dataStructures/ast.h"
+#include "dataStructures/hashIndex.h"
+
+typedef enum {
+    SSA_CONST,   // Integer constant, not placed in any block
+    SSA_STRING,  // String literal, not placed in any block
+    SSA_UNDEF,   // Version of a variable before its first assignment, not placed in any block
+    SSA_PHI,     // Version of a variable where control flow joins, one argument per predecessor
+    SSA_BIN_OP,  // Temporary, a operator b
+    SSA_SET,     // Version of a variable, copy of a
+    SSA_INCR,    // Version of a variable, a + 1 if a is an integer
+    SSA_DECR,
+    SSA_UNSET,   // Version of a variable emptied by UNSET, a is the version it replaces
+    SSA_PRINT,   // Prints a
+    SSA_PRINTLN
+} SsaOp;
+
+// How control leaves a block
+typedef enum {
+    SSA_JUMP,    // Goes to target[0]
+    SSA_BRANCH,  // Goes to target[0] if cond is not 0, to target[1] otherwise
+    SSA_RETURN,  // Ends the program returning cond
+    SSA_HALT     // End of the program
+} SsaExit;
+
+typedef struct SsaValue SsaValue;
+struct SsaValue {
+    SsaOp op;
+    int block; // Block that computes it, -1 for constants, strings and undefs
+    char varName[IDENTIFIER_SIZE]; // Variable this value is a version of, empty for temporaries
+    char operator[BIN_OP_OPERATOR_SIZE];
+    int number;
+    char* string;
+    int a; // Operands, -1 if unused
+    int b;
+    int* args; // Phi arguments, in the order of the predecessors of the block
+    int replacement; // Value used instead of this one, -1 if none (trivial phis)
+};
+
+typedef struct SsaBlock SsaBlock;
+struct SsaBlock {
+    int* values; // Phis first, then the rest in execution order
+    int count;
+    int capacity;
+    int* preds;
+    int predCount;
+    int predCapacity;
+    SsaExit exit;
+    int cond; // Condition of a branch, result of a return
+    int target[2];
+    int merge; // Block where both sides of an IF meet, or the block after a WHILE
+    bool loop; // The block computes the condition of a WHILE, target[0] is the body
+    bool reachable; // Computed by optimizeSsa()
+};
+
+typedef struct SsaProgram SsaProgram;
+struct SsaProgram {
+    SsaValue* values;
+    int valueCount;
+    int valueCapacity;
+    SsaBlock* blocks; // blocks[0] is the entry
+    int blockCount;
+    int blockCapacity;
+    char (*varNames)[IDENTIFIER_SIZE];
+    int varCount;
+    int varCapacity;
+    HashIndex varIndex; // Position of each name in varNames
+};
+
+// Lowers the AST of a whole program, returns NULL if the tree has a shape the SSA form can't express
+SsaProgram* buildSsa(SyntaxNode* program);
+
+// Constant propagation, branch folding and dead code elimination, see above
+void optimizeSsa(SsaProgram* ssa);
+
+// Makes the AST of the program back from its SSA form
+SyntaxNode* lowerSsa(SsaProgram* ssa);
+
+// Builds, optimizes and lowers back a program, replacing its statements in place
+void optimizeWithSsa(SyntaxNode* program);
+
+void printSsa(SsaProgram* ssa, FILE* out); // One line per value, used for debugging
+void deleteSsa(SsaProgram** ssa);
+
+#endif
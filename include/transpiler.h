@@ -0,0 +1,23 @@
+#ifndef TRANSPILER_H
+#define TRANSPILER_H
+
+/*
+=======================================================================================
+ The transpiler translates the AST of a whole program into a standalone C program,
+ so hot scripts can be built ahead of time by an optimizing C compiler. The generated
+ code calls the runtime library (see simplicRuntime.h) for values, strings, printing
+ and errors, and keeps the semantics of eval(): operands are computed left to right,
+ RETURN prints the return code and errors print the interpreter's messages.
+ Each expression is split into one temporary per node, so the C compiler can't change
+ the order in which errors are detected
+=======================================================================================
+*/
+
+#include "simplic.h"
+#include "simplicError.h"
+#include "dataStructures/ast.h"
+
+// Writes the C translation of a whole program (see parseProgram()), name is used in the header comment
+void transpileProgram(SyntaxNode* program, const char* name, FILE* out, SimplicError* error);
+
+#endif
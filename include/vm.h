@@ -0,0 +1,144 @@
+#ifndef VM_H
+#define VM_H
+
+/*
+=======================================================================================
+ The virtual machine is the execution engine used for whole programs. Instead of
+ walking the AST on every execution like eval() does, the compiler translates the
+ program once into a flat list of three-address instructions, then the VM runs them.
+ Instructions operate on registers: the first ones hold the program's variables,
+ they are followed by the constants used by the program (loaded once, never written)
+ and finally by the temporaries needed to compute intermediate results, the ones
+ that only ever hold integers first.
+ When type inference (see inferTypes()) proves the operands of an instruction are
+ integers, the compiler uses its int form, which skips every type check.
+ Variables are resolved to a register at compile time, so the VM never looks up a
+ name during execution. An undeclared variable is an empty (VALUE_VOID) register
+=======================================================================================
+*/
+
+#include "simplic.h"
+#include "simplicError.h"
+#include "interpreter.h"
+#include "dataStructures/ast.h"
+
+typedef enum {
+    OP_HALT,    // Ends the program without a return value
+    OP_MOVE,    // A = B
+    OP_ADD,     // A = B + C (also string concatenation)
+    OP_SUB,     // A = B - C
+    OP_MUL,
+    OP_DIV,
+    OP_MOD,
+    OP_LT,      // A = B < C
+    OP_LEQ,
+    OP_GT,
+    OP_GEQ,
+    OP_EQ,
+    OP_NEQ,
+    OP_AND,
+    OP_OR,
+    OP_INCR,    // A++ (only if A is an integer)
+    OP_DECR,
+    OP_UNSET,   // Empties variable A
+    OP_PRINT,   // Prints A
+    OP_PRINTLN,
+    OP_RETURN,  // Ends the program returning A
+    OP_JMP,     // Jumps to instruction B
+    OP_JMPF,    // Jumps to instruction B if A is 0, C tells which statement owns the condition
+    OP_JMPT,    // Jumps to instruction B if A is not 0
+    OP_JIT_LOOP, // Runs native loop A, jumps to instruction B if the loop can't run natively (see jit.h)
+
+    // Int forms, in the same order as the generic opcodes. Operands are known to be integers and
+    // A never holds a string, so only the integer of the registers is read and written
+    OP_IMOVE,
+    OP_IADD,
+    OP_ISUB,
+    OP_IMUL,
+    OP_IDIV,
+    OP_IMOD,
+    OP_ILT,
+    OP_ILEQ,
+    OP_IGT,
+    OP_IGEQ,
+    OP_IEQ,
+    OP_INEQ,
+    OP_IAND,
+    OP_IOR,
+    OP_IINCR,
+    OP_IDECR,
+    OP_IJMPF,
+    OP_IJMPT,
+
+    // Superinstructions, each one replaces the comparison of a condition and the jump that reads it.
+    // Comparisons followed by their jump are the most executed pair of instructions in every sample
+    // program. Operands are integers, they jump to instruction B if A op C
+    OP_JLT,
+    OP_JLEQ,
+    OP_JGT,
+    OP_JGEQ,
+    OP_JEQ,
+    OP_JNEQ,
+    OP_JMODZ,  // Jumps to B if A % C is 0, conditions like X % C EQ 0 also save the modulo's instruction
+    OP_JMODNZ,
+
+    OP_SWITCH  // Jumps to the target of integer A in jump table B, replaces a run of IF A EQ constant
+} OpCode;
+
+// Statement that owns a conditional jump, used for the type mismatch message
+typedef enum {
+    COND_IF,
+    COND_WHILE
+} ConditionKind;
+
+typedef struct JitLoop JitLoop;
+
+// Targets of a SWITCH, indexed by value when the cases are dense and searched otherwise
+typedef struct JumpTable JumpTable;
+struct JumpTable {
+    int low; // Smallest case
+    int count; // Entries in targets
+    int* keys; // Sorted cases, NULL if the table is dense (the target of value is targets[value - low])
+    int* targets;
+    int otherwise; // Where execution continues if no case matches
+};
+
+typedef struct Instruction Instruction;
+struct Instruction {
+    OpCode opcode;
+    int a; // Usually the destination register
+    int b; // Usually the first operand register
+    int c; // Usually the second operand register
+    const void* handler; // Code that runs the instruction, resolved before the first run (threaded dispatch)
+};
+
+// Result of compiling a whole program, can be run any number of times
+typedef struct VMProgram VMProgram;
+struct VMProgram {
+    Instruction* code;
+    int codeSize;
+    char (*varNames)[IDENTIFIER_SIZE]; // Name of the variable stored at each register
+    int varCount;
+    SimplicValue* constants; // Stored in the registers that follow the variables
+    int constCount;
+    int registerCount; // Variables + constants + temporaries
+    bool threaded; // True once every instruction knows its handler
+    JumpTable* jumpTables;
+    int jumpTableCount;
+    JitLoop* jitLoops; // Loops compiled to native code, only when the JIT is enabled
+    int jitLoopCount;
+};
+
+// Translates the AST of a whole program (see parseProgram()) into VM instructions
+VMProgram* compileProgram(SyntaxNode* program, SimplicError* error);
+
+// Runs a compiled program, control->returned is set if RETURN was executed
+SimplicValue runProgram(VMProgram* program, ControlState* control, SimplicError* error);
+
+// Generic opcode an int form stands for (OP_IADD gives OP_ADD), other opcodes are returned unchanged
+OpCode genericOpcode(OpCode opcode);
+
+void printProgram(VMProgram* program); // Prints the instructions, used for debugging
+void deleteProgram(VMProgram** program);
+
+#endif
@@ -0,0 +1,245 @@
+#ifndef _DEFAULT_SOURCE
+    #define _DEFAULT_SOURCE // Threads, directories and open_memstream() are not part of ISO C
+#endif
+#include "private_batch.h"
+
+double bt_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+Batch* initBatch(void) {
+    Batch* batch = malloc(sizeof(Batch));
+    *batch = (Batch){ .jobs = NULL, .count = 0, .capacity = 0, .threads = 0, .seconds = 0 };
+    return batch;
+}
+
+void deleteBatch(Batch** batch) {
+    if (*batch == NULL) return;
+
+    for (size_t i = 0; i < (*batch)->count; i++) free((*batch)->jobs[i].path);
+    free((*batch)->jobs);
+    free(*batch);
+    *batch = NULL;
+}
+
+void bt_addJob(Batch* batch, char* path) {
+    if (batch->count == batch->capacity) {
+        batch->capacity = (batch->capacity == 0) ? 16 : batch->capacity * 2;
+        batch->jobs = realloc(batch->jobs, sizeof(BatchJob) * batch->capacity);
+    }
+
+    batch->jobs[batch->count++] = (BatchJob){
+        .path = path,
+        .result = { .status = 1, .returned = false, .returnCode = 0 },
+        .seconds = 0
+    };
+}
+
+int bt_compareNames(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+bool bt_addDirectory(Batch* batch, const char* dir, SimplicError* error) {
+    DIR* stream = opendir(dir);
+    if (stream == NULL) {
+        setError(error, ERROR_READING_SCRIPT_FILE, "Could not read directory %s", dir);
+        return false;
+    }
+
+    char** names = NULL;
+    size_t count = 0, capacity = 0;
+    const size_t extension = strlen(BATCH_EXTENSION);
+
+    struct dirent* entry;
+    while ((entry = readdir(stream)) != NULL) {
+        size_t length = strlen(entry->d_name);
+        if (length <= extension || strcmp(entry->d_name + length - extension, BATCH_EXTENSION) != 0) continue;
+
+        if (count == capacity) {
+            capacity = (capacity == 0) ? 16 : capacity * 2;
+            names = realloc(names, sizeof(char*) * capacity);
+        }
+        size_t size = strlen(dir) + length + 2;
+        names[count] = malloc(size);
+        snprintf(names[count++], size, "%s/%s", dir, entry->d_name);
+    }
+    closedir(stream);
+
+    // readdir() order depends on the file system, the output must not
+    if (count > 0) qsort(names, count, sizeof(char*), bt_compareNames);
+    for (size_t i = 0; i < count; i++) bt_addJob(batch, names[i]);
+    free(names);
+    return true;
+}
+
+bool addBatchPath(Batch* batch, const char* path, SimplicError* error) {
+    struct stat info;
+    if (stat(path, &info) == 0 && S_ISDIR(info.st_mode)) return bt_addDirectory(batch, path, error);
+
+    // Anything else is read when it runs, like a single script would be
+    char* copy = malloc(strlen(path) + 1);
+    strcpy(copy, path);
+    bt_addJob(batch, copy);
+    return true;
+}
+
+bool bt_take(WorkQueue* queue, bool steal, size_t* job) {
+    bool taken = false;
+
+    pthread_mutex_lock(&queue->lock);
+    if (queue->next < queue->end) {
+        *job = steal ? --queue->end : queue->next++;
+        taken = true;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return taken;
+}
+
+bool bt_nextJob(BatchRun* run, int id, size_t* job) {
+    if (bt_take(&run->queues[id], false, job)) return true;
+
+    // Nothing is ever added, so once every queue is empty the worker is done
+    for (int i = 1; i < run->workers; i++) {
+        if (bt_take(&run->queues[(id + i) % run->workers], true, job)) return true;
+    }
+    return false;
+}
+
+void bt_runJob(BatchRun* run, size_t index) {
+    BatchJob* job = &run->batch->jobs[index];
+    char* output = NULL;
+    size_t size = 0;
+    double start = bt_now();
+
+    FILE* out = open_memstream(&output, &size);
+    if (out == NULL) {
+        job->result.status = 1;
+    } else {
+        SimplicError* error = initError();
+        Script* script = readScript(job->path, error);
+
+        job->result = (RunResult){ .status = 0, .returned = false, .returnCode = 0 };
+        if (error->hasError) {
+            fprintError(out, error);
+            job->result.status = 1;
+        } else {
+            run->runner(job->path, script, out, &job->result, run->context);
+        }
+
+        deleteScript(&script);
+        deleteError(&error);
+        fclose(out);
+    }
+    job->seconds = bt_now() - start;
+
+    pthread_mutex_lock(&run->lock);
+    run->outputs[index] = output;
+    run->outputSizes[index] = size;
+    run->done[index] = true;
+    pthread_cond_broadcast(&run->finished);
+    pthread_mutex_unlock(&run->lock);
+}
+
+void* bt_worker(void* argument) {
+    Worker* worker = argument;
+    size_t job;
+
+    while (bt_nextJob(worker->run, worker->id, &job)) bt_runJob(worker->run, job);
+    return NULL;
+}
+
+void runBatch(Batch* batch, int threads, ScriptRunner runner, void* context, FILE* out) {
+    double start = bt_now();
+
+    if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads <= 0) threads = 1;
+    if ((size_t)threads > batch->count) threads = (batch->count == 0) ? 1 : (int)batch->count;
+
+    BatchRun run = {
+        .batch = batch, .runner = runner, .context = context, .workers = threads,
+        .queues = malloc(sizeof(WorkQueue) * threads),
+        .outputs = calloc(batch->count + 1, sizeof(char*)),
+        .outputSizes = calloc(batch->count + 1, sizeof(size_t)),
+        .done = calloc(batch->count + 1, sizeof(bool))
+    };
+    pthread_mutex_init(&run.lock, NULL);
+    pthread_cond_init(&run.finished, NULL);
+
+    // Consecutive blocks, so the scripts that are written out first also tend to finish first
+    for (int i = 0; i < threads; i++) {
+        pthread_mutex_init(&run.queues[i].lock, NULL);
+        run.queues[i].next = batch->count * i / threads;
+        run.queues[i].end = batch->count * (i + 1) / threads;
+    }
+
+    pthread_t* ids = malloc(sizeof(pthread_t) * threads);
+    Worker* workers = malloc(sizeof(Worker) * threads);
+    bool* started = malloc(sizeof(bool) * threads);
+    int running = 0;
+    for (int i = 0; i < threads; i++) {
+        workers[i] = (Worker){ .run = &run, .id = i };
+        started[i] = pthread_create(&ids[i], NULL, bt_worker, &workers[i]) == 0;
+        if (started[i]) running++;
+    }
+
+    // Queues of workers that didn't start get stolen by the others, with none this thread does the work
+    if (running == 0) bt_worker(&workers[0]);
+
+    for (size_t i = 0; i < batch->count; i++) {
+        pthread_mutex_lock(&run.lock);
+        while (!run.done[i]) pthread_cond_wait(&run.finished, &run.lock);
+        pthread_mutex_unlock(&run.lock);
+
+        if (run.outputs[i] != NULL) fwrite(run.outputs[i], 1, run.outputSizes[i], out);
+        free(run.outputs[i]);
+    }
+    fflush(out);
+
+    // Every worker may still look into any queue until it stops
+    for (int i = 0; i < threads; i++) {
+        if (started[i]) pthread_join(ids[i], NULL);
+    }
+    for (int i = 0; i < threads; i++) pthread_mutex_destroy(&run.queues[i].lock);
+    pthread_mutex_destroy(&run.lock);
+    pthread_cond_destroy(&run.finished);
+
+    free(started);
+    free(workers);
+    free(ids);
+    free(run.queues);
+    free(run.outputs);
+    free(run.outputSizes);
+    free(run.done);
+
+    batch->threads = running == 0 ? 1 : running;
+    batch->seconds = bt_now() - start;
+}
+
+void printBatchSummary(const Batch* batch, FILE* out) {
+    size_t zero = 0, other = 0, none = 0, failed = 0;
+    double total = 0;
+
+    fprintf(out, "\nBatch of %zu scripts on %d thread%s:\n", batch->count, batch->threads, (batch->threads == 1) ? "" : "s");
+    for (size_t i = 0; i < batch->count; i++) {
+        const BatchJob* job = &batch->jobs[i];
+        total += job->seconds;
+
+        if (job->result.status != 0) {
+            failed++;
+            fprintf(out, "  %-16s", "not run");
+        } else if (job->result.returned) {
+            if (job->result.returnCode == 0) zero++;
+            else other++;
+            fprintf(out, "  returned %-7d", job->result.returnCode);
+        } else {
+            none++;
+            fprintf(out, "  %-16s", "no RETURN");
+        }
+        fprintf(out, " %9.3f ms  %s\n", job->seconds * 1000, job->path);
+    }
+
+    fprintf(out, "Returned 0: %zu, another code: %zu, no RETURN: %zu, not run: %zu\n", zero, other, none, failed);
+    fprintf(out, "%.3f ms running scripts, %.3f ms wall\n", total * 1000, batch->seconds * 1000);
+}
@@ -0,0 +1,154 @@
+#define _DEFAULT_SOURCE // Before any system header, like in batch.c
+#include "unity.h"
+#include "unity_internals.h"
+
+#include "batch.c"
+#include <stdatomic.h>
+#include <sys/stat.h>
+
+#define TEST_DIR "build/tests/batchScripts"
+#define SCRIPT_COUNT 40
+
+SimplicError* error;
+Batch* batch;
+
+void setUp(void) {
+    error = initError();
+    batch = initBatch();
+    mkdir(TEST_DIR, 0777);
+}
+
+void tearDown(void) {
+    deleteError(&error);
+    deleteBatch(&batch);
+}
+
+void writeFile(const char* name, const char* text) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", TEST_DIR, name);
+    FILE* file = fopen(path, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    fputs(text, file);
+    fclose(file);
+}
+
+// Echoes the script and returns its length. Longer scripts spin for longer, so they finish out of order
+void echoRunner(const char* name, const Script* script, FILE* out, RunResult* result, void* context) {
+    atomic_int* runs = context;
+    atomic_fetch_add(runs, 1);
+
+    volatile unsigned long spin = 0;
+    for (unsigned long i = 0; i < script->length * 20000ul; i++) spin += i;
+
+    fprintf(out, "%s:", name);
+    fwrite(script->text, 1, script->length, out);
+    fputc('\n', out);
+
+    result->status = 0;
+    result->returned = script->length % 2 == 0;
+    result->returnCode = (int)script->length;
+}
+
+// Runs the batch and returns everything it wrote, to be freed
+char* runAndCapture(int threads, atomic_int* runs) {
+    FILE* out = tmpfile();
+    TEST_ASSERT_NOT_NULL(out);
+    runBatch(batch, threads, echoRunner, runs, out);
+
+    long size = ftell(out);
+    char* text = malloc(size + 1);
+    rewind(out);
+    TEST_ASSERT_EQUAL_INT(size, fread(text, 1, size, out));
+    text[size] = '\0';
+    fclose(out);
+    return text;
+}
+
+void testDirectoriesAreSorted(void) {
+    mkdir(TEST_DIR "/sorted", 0777);
+    writeFile("sorted/b.sim", "B");
+    writeFile("sorted/a.sim", "A");
+    writeFile("sorted/notes.txt", "not a script");
+    writeFile("sorted/.sim", "no name");
+
+    TEST_ASSERT_TRUE(addBatchPath(batch, TEST_DIR "/sorted", error));
+    TEST_ASSERT_TRUE(addBatchPath(batch, TEST_DIR "/sorted/a.sim", error));
+
+    TEST_ASSERT_EQUAL_INT(3, batch->count);
+    TEST_ASSERT_EQUAL_STRING(TEST_DIR "/sorted/a.sim", batch->jobs[0].path);
+    TEST_ASSERT_EQUAL_STRING(TEST_DIR "/sorted/b.sim", batch->jobs[1].path);
+    TEST_ASSERT_EQUAL_STRING(TEST_DIR "/sorted/a.sim", batch->jobs[2].path);
+
+    // A missing script is reported when it runs, like without --jobs
+    TEST_ASSERT_TRUE(addBatchPath(batch, TEST_DIR "/noSuchScript.sim", error));
+    TEST_ASSERT_EQUAL_INT(4, batch->count);
+    TEST_ASSERT_FALSE(error->hasError);
+}
+
+void testOutputFollowsTheGivenOrder(void) {
+    char name[64], text[64], expected[8192] = "";
+    atomic_int runs = 0;
+
+    // Long scripts first, so with several threads the later ones finish earlier
+    for (int i = 0; i < SCRIPT_COUNT; i++) {
+        snprintf(name, sizeof(name), "order%02d.sim", i);
+        snprintf(text, sizeof(text), "%.*s", SCRIPT_COUNT - i, "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx");
+        writeFile(name, text);
+
+        snprintf(name, sizeof(name), TEST_DIR "/order%02d.sim", i);
+        TEST_ASSERT_TRUE(addBatchPath(batch, name, error));
+        snprintf(expected + strlen(expected), sizeof(expected) - strlen(expected), "%s:%s\n", name, text);
+    }
+
+    for (int threads = 1; threads <= 4; threads += 3) {
+        char* output = runAndCapture(threads, &runs);
+        TEST_ASSERT_EQUAL_STRING(expected, output);
+        TEST_ASSERT_EQUAL_INT(threads, batch->threads);
+        free(output);
+
+        for (int i = 0; i < SCRIPT_COUNT; i++) {
+            TEST_ASSERT_EQUAL_INT(0, batch->jobs[i].result.status);
+            TEST_ASSERT_EQUAL_INT(SCRIPT_COUNT - i, batch->jobs[i].result.returnCode);
+            TEST_ASSERT_EQUAL(i % 2 == 0, batch->jobs[i].result.returned);
+        }
+    }
+
+    // Every script ran exactly once each time
+    TEST_ASSERT_EQUAL_INT(SCRIPT_COUNT * 2, runs);
+}
+
+void testMissingScriptsAreReported(void) {
+    atomic_int runs = 0;
+    writeFile("present.sim", "P");
+    addBatchPath(batch, TEST_DIR "/missing.sim", error);
+    addBatchPath(batch, TEST_DIR "/present.sim", error);
+
+    // More threads than scripts only starts as many as there are scripts
+    char* output = runAndCapture(8, &runs);
+    TEST_ASSERT_EQUAL_INT(2, batch->threads);
+    TEST_ASSERT_EQUAL_INT(1, runs);
+
+    TEST_ASSERT_EQUAL_INT(1, batch->jobs[0].result.status);
+    TEST_ASSERT_EQUAL_INT(0, batch->jobs[1].result.status);
+    TEST_ASSERT_NOT_NULL(strstr(output, "Error: "));
+    TEST_ASSERT_NOT_NULL(strstr(output, TEST_DIR "/present.sim:P\n"));
+    TEST_ASSERT_TRUE(strstr(output, "Error: ") < strstr(output, "present.sim:P"));
+    free(output);
+}
+
+void testEmptyBatch(void) {
+    atomic_int runs = 0;
+    char* output = runAndCapture(0, &runs);
+    TEST_ASSERT_EQUAL_STRING("", output);
+    TEST_ASSERT_EQUAL_INT(0, runs);
+    free(output);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(testDirectoriesAreSorted);
+    RUN_TEST(testOutputFollowsTheGivenOrder);
+    RUN_TEST(testMissingScriptsAreReported);
+    RUN_TEST(testEmptyBatch);
+    return UNITY_END();
+}
@@ -0,0 +1,52 @@
+#ifndef PRIVATE_BATCH_H
+#define PRIVATE_BATCH_H
+
+#include <dirent.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "batch.h"
+
+#define BATCH_EXTENSION ".sim" // Scripts picked from a directory
+
+// Scripts a worker has left, jobs next to end - 1. The owner takes from the front, thieves from the back
+typedef struct WorkQueue WorkQueue;
+struct WorkQueue {
+    pthread_mutex_t lock; // Held for a take, scripts are long enough that it is never contended for long
+    size_t next;
+    size_t end;
+};
+
+// State of one runBatch() shared by its workers
+typedef struct BatchRun BatchRun;
+struct BatchRun {
+    Batch* batch;
+    ScriptRunner runner;
+    void* context;
+    WorkQueue* queues; // One per worker
+    int workers;
+    char** outputs; // What each script printed, NULL if it could not be captured
+    size_t* outputSizes;
+    bool* done;
+    pthread_mutex_t lock; // Guards done, finished is signalled whenever a script ends
+    pthread_cond_t finished;
+};
+
+typedef struct Worker Worker;
+struct Worker {
+    BatchRun* run;
+    int id; // Index of its own queue
+};
+
+static double bt_now(void); // Seconds on a monotonic clock
+static void bt_addJob(Batch* batch, char* path); // Takes ownership of path
+static int bt_compareNames(const void* a, const void* b);
+static bool bt_addDirectory(Batch* batch, const char* dir, SimplicError* error);
+
+static bool bt_take(WorkQueue* queue, bool steal, size_t* job); // false if the queue is empty
+static bool bt_nextJob(BatchRun* run, int id, size_t* job); // Own queue first, then the others
+static void bt_runJob(BatchRun* run, size_t index);
+static void* bt_worker(void* argument);
+
+#endif
@@ -0,0 +1,482 @@
+#include "private_closure.h"
+
+SimplicValue cl_makeInt(int n) {
+    return (SimplicValue){ .type = VALUE_INT, .integer = n, .string = NULL };
+}
+
+SimplicValue cl_makeStr(const char* s) {
+    SimplicValue res = { .type = VALUE_STR, .integer = 0, .string = NULL };
+    res.string = malloc(sizeof(char) * (strlen(s) + 1));
+    strcpy(res.string, s);
+    return res;
+}
+
+SimplicValue cl_makeVoid(void) {
+    return (SimplicValue){ .type = VALUE_VOID, .integer = 0, .string = NULL };
+}
+
+SimplicValue cl_makeError(void) {
+    return (SimplicValue){ .type = 0, .integer = 0, .string = NULL };
+}
+
+Closure* cl_initClosure(ClosureFn fn) {
+    Closure* res = malloc(sizeof(Closure));
+    res->fn = fn;
+    res->a = NULL;
+    res->b = NULL;
+    res->c = NULL;
+    res->statements = NULL;
+    res->name[0] = '\0';
+    res->number = 0;
+    res->string = NULL;
+    return res;
+}
+
+bool cl_evalOperands(Closure* self, ControlState* control, SimplicError* error, SimplicValue* l, SimplicValue* r) {
+    *l = self->a->fn(self->a, control, error);
+    if (error->hasError) return false;
+
+    *r = self->b->fn(self->b, control, error);
+    if (error->hasError) {
+        if (l->type == VALUE_STR) free(l->string);
+        return false;
+    }
+    return true;
+}
+
+// ------------------------------------------
+// Leaves
+// ------------------------------------------
+
+SimplicValue cl_number(Closure* self, ControlState* control, SimplicError* error) {
+    (void)control;
+    (void)error;
+    return cl_makeInt(self->number);
+}
+
+SimplicValue cl_string(Closure* self, ControlState* control, SimplicError* error) {
+    (void)control;
+    (void)error;
+    return cl_makeStr(self->string);
+}
+
+SimplicValue cl_var(Closure* self, ControlState* control, SimplicError* error) {
+    (void)control;
+    MemoryCell* cell = getCell(control->bank, self->name, error);
+    if (cell == NULL) return cl_makeError(); // Requested var was not initialized
+
+    if (cell->strPtr == NULL) return cl_makeInt(cell->value);
+    return cl_makeStr(cell->strPtr);
+}
+
+// ------------------------------------------
+// Binary operations
+// ------------------------------------------
+
+// Any operands, strings count as 0 like in eval()
+#define CL_INT_OP_GENERIC(op, expr) \
+    SimplicValue cl_##op(Closure* self, ControlState* control, SimplicError* error) { \
+        SimplicValue l, r; \
+        if (!cl_evalOperands(self, control, error, &l, &r)) return cl_makeError(); \
+        if (l.type == VALUE_STR) free(l.string); \
+        if (r.type == VALUE_STR) free(r.string); \
+        int x = l.integer, y = r.integer; \
+        return cl_makeInt(expr); \
+    }
+
+// Operands read straight from the bank, strings take the generic path
+#define CL_INT_OP_SHAPES(op, expr) \
+    SimplicValue cl_##op##VarConst(Closure* self, ControlState* control, SimplicError* error) { \
+        MemoryCell* cell = getCell(control->bank, self->a->name, error); \
+        if (cell == NULL) return cl_makeError(); \
+        if (cell->strPtr != NULL) return cl_##op(self, control, error); \
+        int x = cell->value, y = self->b->number; \
+        return cl_makeInt(expr); \
+    } \
+    SimplicValue cl_##op##VarVar(Closure* self, ControlState* control, SimplicError* error) { \
+        MemoryCell* left = getCell(control->bank, self->a->name, error); \
+        if (left == NULL) return cl_makeError(); \
+        MemoryCell* right = getCell(control->bank, self->b->name, error); \
+        if (right == NULL) return cl_makeError(); \
+        if (left->strPtr != NULL || right->strPtr != NULL) return cl_##op(self, control, error); \
+        int x = left->value, y = right->value; \
+        return cl_makeInt(expr); \
+    }
+
+SimplicValue cl_add(Closure* self, ControlState* control, SimplicError* error) {
+    SimplicValue l, r;
+    if (!cl_evalOperands(self, control, error, &l, &r)) return cl_makeError();
+
+    if (l.type != VALUE_STR && r.type != VALUE_STR) return cl_makeInt(l.integer + r.integer);
+
+    // String concat, an int operand is written as text
+    int len = CHARS_FOR_INT_TO_STRING + 1;
+    len += (l.type == VALUE_STR) ? strlen(l.string) : 0;
+    len += (r.type == VALUE_STR) ? strlen(r.string) : 0;
+    char* buffer = malloc(sizeof(char) * (len + 1));
+
+    if (l.type == VALUE_STR && r.type == VALUE_STR) {
+        snprintf(buffer, len + 1, "%s%s", l.string, r.string);
+    } else if (l.type == VALUE_STR) {
+        snprintf(buffer, len + 1, "%s%d", l.string, r.integer);
+    } else {
+        snprintf(buffer, len + 1, "%d%s", l.integer, r.string);
+    }
+
+    if (l.type == VALUE_STR) free(l.string);
+    if (r.type == VALUE_STR) free(r.string);
+    return (SimplicValue){ .type = VALUE_STR, .integer = 0, .string = buffer };
+}
+
+CL_INT_OP_SHAPES(add, x + y)
+CL_INT_OP_GENERIC(sub, x - y)
+CL_INT_OP_SHAPES(sub, x - y)
+CL_INT_OP_GENERIC(mul, x * y)
+CL_INT_OP_SHAPES(mul, x * y)
+CL_INT_OP_GENERIC(lt, (x < y) ? 1 : 0)
+CL_INT_OP_SHAPES(lt, (x < y) ? 1 : 0)
+CL_INT_OP_GENERIC(leq, (x <= y) ? 1 : 0)
+CL_INT_OP_SHAPES(leq, (x <= y) ? 1 : 0)
+CL_INT_OP_GENERIC(gt, (x > y) ? 1 : 0)
+CL_INT_OP_SHAPES(gt, (x > y) ? 1 : 0)
+CL_INT_OP_GENERIC(geq, (x >= y) ? 1 : 0)
+CL_INT_OP_SHAPES(geq, (x >= y) ? 1 : 0)
+CL_INT_OP_GENERIC(eq, (x == y) ? 1 : 0)
+CL_INT_OP_SHAPES(eq, (x == y) ? 1 : 0)
+CL_INT_OP_GENERIC(neq, (x != y) ? 1 : 0)
+CL_INT_OP_SHAPES(neq, (x != y) ? 1 : 0)
+CL_INT_OP_GENERIC(and, (x && y) ? 1 : 0)
+CL_INT_OP_SHAPES(and, (x && y) ? 1 : 0)
+CL_INT_OP_GENERIC(or, (x || y) ? 1 : 0)
+CL_INT_OP_SHAPES(or, (x || y) ? 1 : 0)
+
+SimplicValue cl_div(Closure* self, ControlState* control, SimplicError* error) {
+    SimplicValue l, r;
+    if (!cl_evalOperands(self, control, error, &l, &r)) return cl_makeError();
+    if (l.type == VALUE_STR) free(l.string);
+    if (r.type == VALUE_STR) free(r.string);
+
+    if (r.integer == 0) {
+        setError(error, ERROR_DIVISION_BY_ZERO, "Division by 0, execution halted");
+        return cl_makeError();
+    }
+    return cl_makeInt(l.integer / r.integer);
+}
+
+SimplicValue cl_mod(Closure* self, ControlState* control, SimplicError* error) {
+    SimplicValue l, r;
+    if (!cl_evalOperands(self, control, error, &l, &r)) return cl_makeError();
+    if (l.type == VALUE_STR) free(l.string);
+    if (r.type == VALUE_STR) free(r.string);
+
+    if (r.integer == 0) {
+        setError(error, ERROR_DIVISION_BY_ZERO, "Division by 0, execution halted");
+        return cl_makeError();
+    }
+    return cl_makeInt(l.integer % r.integer);
+}
+
+SimplicValue cl_divVarConst(Closure* self, ControlState* control, SimplicError* error) {
+    (void)control;
+    MemoryCell* cell = getCell(control->bank, self->a->name, error);
+    if (cell == NULL) return cl_makeError();
+    if (cell->strPtr != NULL) return cl_makeInt(0); // A string counts as 0
+    return cl_makeInt(cell->value / self->b->number);
+}
+
+SimplicValue cl_modVarConst(Closure* self, ControlState* control, SimplicError* error) {
+    (void)control;
+    MemoryCell* cell = getCell(control->bank, self->a->name, error);
+    if (cell == NULL) return cl_makeError();
+    if (cell->strPtr != NULL) return cl_makeInt(0);
+    return cl_makeInt(cell->value % self->b->number);
+}
+
+// ------------------------------------------
+// Statements
+// ------------------------------------------
+
+SimplicValue cl_assign(Closure* self, ControlState* control, SimplicError* error) {
+    SimplicValue val = self->b->fn(self->b, control, error);
+    if (error->hasError) return cl_makeError();
+
+    if (val.type == VALUE_INT) {
+        insertInt(control->bank, self->name, val.integer);
+    } else if (val.type == VALUE_STR) {
+        insertStr(control->bank, self->name, val.string);
+        free(val.string);
+    }
+    return cl_makeVoid();
+}
+
+SimplicValue cl_assignConst(Closure* self, ControlState* control, SimplicError* error) {
+    (void)control;
+    (void)error;
+    insertInt(control->bank, self->name, self->b->number);
+    return cl_makeVoid();
+}
+
+SimplicValue cl_unassign(Closure* self, ControlState* control, SimplicError* error) {
+    (void)control;
+    deleteVariable(control->bank, self->name, error);
+    if (error->hasError) return cl_makeError();
+    return cl_makeVoid();
+}
+
+SimplicValue cl_print(Closure* self, ControlState* control, SimplicError* error) {
+    SimplicValue val = self->b->fn(self->b, control, error);
+    if (error->hasError) return cl_makeError();
+
+    if (val.type == VALUE_INT) {
+        fprintf(control->out, "%d", val.integer);
+    } else if (val.type == VALUE_STR) {
+        fprintf(control->out, "%s", val.string);
+        free(val.string);
+    }
+    return cl_makeVoid();
+}
+
+SimplicValue cl_println(Closure* self, ControlState* control, SimplicError* error) {
+    SimplicValue val = self->b->fn(self->b, control, error);
+    if (error->hasError) return cl_makeError();
+
+    if (val.type == VALUE_INT) {
+        fprintf(control->out, "%d\n", val.integer);
+    } else if (val.type == VALUE_STR) {
+        fprintf(control->out, "%s\n", val.string);
+        free(val.string);
+    }
+    return cl_makeVoid();
+}
+
+SimplicValue cl_return(Closure* self, ControlState* control, SimplicError* error) {
+    SimplicValue val = self->b->fn(self->b, control, error);
+    if (error->hasError) return cl_makeError();
+
+    // Statements hold nothing that needs freeing, so every enclosing closure can be skipped
+    control->returned = true;
+    control->value = val;
+    longjmp(*control->unwind, 1);
+}
+
+SimplicValue cl_increment(Closure* self, ControlState* control, SimplicError* error) {
+    (void)control;
+    MemoryCell* cell = getCell(control->bank, self->b->name, error);
+    if (cell == NULL) return cl_makeError();
+    if (cell->strPtr == NULL) cell->value++; // Strings are left untouched
+    return cl_makeVoid();
+}
+
+SimplicValue cl_decrement(Closure* self, ControlState* control, SimplicError* error) {
+    (void)control;
+    MemoryCell* cell = getCell(control->bank, self->b->name, error);
+    if (cell == NULL) return cl_makeError();
+    if (cell->strPtr == NULL) cell->value--;
+    return cl_makeVoid();
+}
+
+SimplicValue cl_block(Closure* self, ControlState* control, SimplicError* error) {
+    for (Closure** statement = self->statements; *statement != NULL; statement++) {
+        (*statement)->fn(*statement, control, error);
+        if (error->hasError) return cl_makeError();
+    }
+    return cl_makeVoid();
+}
+
+SimplicValue cl_while(Closure* self, ControlState* control, SimplicError* error) {
+    while (1) {
+        SimplicValue cond = self->a->fn(self->a, control, error); // Condition
+        if (error->hasError) return cl_makeError();
+        if (cond.type != VALUE_INT) {
+            free(cond.string);
+            setError(error, ERROR_TYPE_MISMATCH, "WHILE condition must be integer");
+            return cl_makeError();
+        }
+        if (!cond.integer) break;
+
+        self->b->fn(self->b, control, error); // Body
+        if (error->hasError) return cl_makeError();
+    }
+    return cl_makeVoid();
+}
+
+SimplicValue cl_if(Closure* self, ControlState* control, SimplicError* error) {
+    SimplicValue cond = self->a->fn(self->a, control, error); // Condition
+    if (error->hasError) return cl_makeError();
+    if (cond.type != VALUE_INT) {
+        free(cond.string);
+        setError(error, ERROR_TYPE_MISMATCH, "IF condition must be integer");
+        return cl_makeError();
+    }
+
+    // Runs the THEN block, or the ELSE block if there is one
+    Closure* body = (cond.integer) ? self->b : self->c;
+    if (body == NULL) return cl_makeVoid();
+
+    body->fn(body, control, error);
+    if (error->hasError) return cl_makeError();
+    return cl_makeVoid();
+}
+
+// ------------------------------------------
+// Compiler
+// ------------------------------------------
+
+// Picks one of the three shapes of an integer operation
+#define CL_SELECT_SHAPE(op) \
+    ((varLeft && constRight) ? cl_##op##VarConst : (varLeft && varRight) ? cl_##op##VarVar : cl_##op)
+
+ClosureFn cl_selectBinOp(SyntaxNode* node) {
+    bool varLeft = node->subnodeA->type == NODE_VAR;
+    bool varRight = node->subnodeB->type == NODE_VAR;
+    bool constRight = node->subnodeB->type == NODE_NUMBER;
+    const char* op = node->operator;
+
+    if (strcmp(op, "+") == 0) return CL_SELECT_SHAPE(add);
+    if (strcmp(op, "-") == 0) return CL_SELECT_SHAPE(sub);
+    if (strcmp(op, "*") == 0) return CL_SELECT_SHAPE(mul);
+    if (strcmp(op, "<") == 0) return CL_SELECT_SHAPE(lt);
+    if (strcmp(op, "<=") == 0) return CL_SELECT_SHAPE(leq);
+    if (strcmp(op, ">") == 0) return CL_SELECT_SHAPE(gt);
+    if (strcmp(op, ">=") == 0) return CL_SELECT_SHAPE(geq);
+    if (strcmp(op, "==") == 0) return CL_SELECT_SHAPE(eq);
+    if (strcmp(op, "!=") == 0) return CL_SELECT_SHAPE(neq);
+    if (strcmp(op, "&&") == 0) return CL_SELECT_SHAPE(and);
+    if (strcmp(op, "||") == 0) return CL_SELECT_SHAPE(or);
+
+    // Dividing by a constant other than 0 can never fail
+    bool safeDivisor = constRight && node->subnodeB->numberValue != 0;
+    if (strcmp(op, "/") == 0) return (varLeft && safeDivisor) ? cl_divVarConst : cl_div;
+    if (strcmp(op, "%") == 0) return (varLeft && safeDivisor) ? cl_modVarConst : cl_mod;
+
+    return NULL;
+}
+
+Closure* compileClosure(SyntaxNode* node, SimplicError* error) {
+    Closure* res;
+    int i;
+
+    if (node == NULL || error->hasError) return NULL;
+
+    switch (node->type) {
+        case NODE_NUMBER:
+            res = cl_initClosure(cl_number);
+            res->number = node->numberValue;
+            return res;
+
+        case NODE_STRING:
+            res = cl_initClosure(cl_string);
+            res->string = malloc(sizeof(char) * (strlen(node->string) + 1));
+            strcpy(res->string, node->string);
+            return res;
+
+        case NODE_VAR:
+            res = cl_initClosure(cl_var);
+            strcpy(res->name, node->varName);
+            return res;
+
+        case NODE_BIN_OP: {
+            ClosureFn fn = cl_selectBinOp(node);
+            if (fn == NULL) {
+                setError(error, ERROR_INVALID_EXPR, "Unknown operator: %s", node->operator);
+                return NULL;
+            }
+            res = cl_initClosure(fn);
+            res->a = compileClosure(node->subnodeA, error);
+            res->b = compileClosure(node->subnodeB, error);
+            return res;
+        }
+
+        case NODE_ASSIGN:
+            res = cl_initClosure((node->subnodeB->type == NODE_NUMBER) ? cl_assignConst : cl_assign);
+            strcpy(res->name, node->varName);
+            res->b = compileClosure(node->subnodeB, error);
+            return res;
+
+        case NODE_UNASSIGN:
+            res = cl_initClosure(cl_unassign);
+            strcpy(res->name, node->varName);
+            return res;
+
+        case NODE_PRINT:
+        case NODE_PRINTLN:
+            res = cl_initClosure((node->type == NODE_PRINT) ? cl_print : cl_println);
+            res->b = compileClosure(node->subnodeB, error);
+            return res;
+
+        case NODE_RETURN:
+            res = cl_initClosure(cl_return);
+            res->b = compileClosure(node->subnodeB, error);
+            return res;
+
+        case NODE_INCREMENT:
+        case NODE_DECREMENT:
+            if (node->subnodeB->type != NODE_VAR) {
+                setError(error, ERROR_INVALID_EXPR, "INCR/DECR can only be applied to a variable");
+                return NULL;
+            }
+            res = cl_initClosure((node->type == NODE_INCREMENT) ? cl_increment : cl_decrement);
+            res->b = compileClosure(node->subnodeB, error);
+            return res;
+
+        case NODE_BLOCK:
+            res = cl_initClosure(cl_block);
+            i = 0;
+            while (node->blockStatements[i] != NULL) i++;
+
+            res->statements = malloc(sizeof(Closure*) * (i + 1));
+            for (int j = 0; j < i; j++) {
+                res->statements[j] = compileClosure(node->blockStatements[j], error);
+            }
+            res->statements[i] = NULL;
+            return res;
+
+        case NODE_WHILE:
+        case NODE_IF:
+            res = cl_initClosure((node->type == NODE_WHILE) ? cl_while : cl_if);
+            res->a = compileClosure(node->subnodeA, error);
+            res->b = compileClosure(node->subnodeB, error);
+            res->c = compileClosure(node->subnodeC, error);
+            return res;
+
+        default:
+            setError(error, ERROR_UNKNOWN_INSTRUCTION, "Tried to compile unknown node of type: %d", node->type);
+            return NULL;
+    }
+}
+
+SimplicValue runClosure(Closure* closure, ControlState* control, SimplicError* error) {
+    jmp_buf unwind;
+    SimplicValue res;
+    if (error->hasError) return cl_makeError();
+
+    // RETURN jumps straight back here from any depth
+    control->unwind = &unwind;
+    if (setjmp(unwind) == 0) {
+        res = closure->fn(closure, control, error);
+    } else {
+        res = control->value;
+    }
+    control->unwind = NULL;
+    return res;
+}
+
+void deleteClosure(Closure** closure) {
+    if (closure == NULL || *closure == NULL) return;
+
+    Closure* c = *closure;
+    deleteClosure(&c->a);
+    deleteClosure(&c->b);
+    deleteClosure(&c->c);
+
+    if (c->statements != NULL) {
+        for (Closure** statement = c->statements; *statement != NULL; statement++) {
+            deleteClosure(statement);
+        }
+        free(c->statements);
+    }
+
+    free(c->string);
+    free(c);
+    *closure = NULL;
+}
@@ -0,0 +1,153 @@
+#include "unity.h"
+#include "unity_internals.h"
+
+#include "closure.c"
+#include "parser.h"
+#include "differential.h"
+
+Token* tokenList;
+SimplicError* error;
+ControlState control;
+
+void setUp(void) {
+    control.returned = false;
+    tokenList = initTokenQueue();
+    control.bank = initMemoryBank();
+    control.out = stdout;
+    error = initError();
+}
+
+void tearDown(void) {
+    deleteTokenQueue(&tokenList);
+    deleteMemoryBank(&control.bank);
+    deleteError(&error);
+}
+
+// Compiles a parsed program into closures and runs it
+SimplicValue closureEngine(SyntaxNode* tree, ControlState* control, SimplicError* error) {
+    SimplicValue val = { .type = VALUE_VOID, .integer = 0, .string = NULL };
+    Closure* closure = compileClosure(tree, error);
+    if (!error->hasError)
+        val = runClosure(closure, control, error);
+    deleteClosure(&closure);
+    return val;
+}
+
+// Compiles a whole program into closures and runs it
+SimplicValue runClosures(const char* program) {
+    SimplicValue val = { .type = VALUE_VOID, .integer = 0, .string = NULL };
+    tokenizeSource(&tokenList, program, error);
+    SyntaxNode* tree = parseProgram(&tokenList, error);
+
+    if (!error->hasError)
+        val = closureEngine(tree, &control, error);
+
+    freeSyntaxTree(tree);
+    return val;
+}
+
+void testReturnCorrectInt(void) {
+    SimplicValue val = runClosures("SET X = 7\nRETURN X\n");
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_TRUE(control.returned);
+    TEST_ASSERT_EQUAL_INT(7, val.integer);
+}
+
+void testSpecializedShapes(void) {
+    SimplicValue val = runClosures(
+        "SET X = 10\n"
+        "SET Y = 3\n"
+        "SET A = X - 4\n"       // Variable and constant
+        "SET B = X * Y\n"       // Two variables
+        "SET C = 2 + X\n"       // Generic
+        "SET D = X / 3 + X % 3\n"
+        "RETURN A + B + C + D\n");
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(6 + 30 + 12 + 4, val.integer);
+}
+
+void testAccessToUndeclaredVariable(void) {
+    runClosures("SET X = Y LT 3\n");
+    TEST_ASSERT_TRUE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(ERROR_ACCESS_TO_UNDECLARED_VAR, error->errCode);
+    TEST_ASSERT_EQUAL_STRING("Variable Y not initialized", error->errMsg);
+}
+
+void testDivisionByZero(void) {
+    runClosures("SET X = 9\nSET Y = 0\nSET Z = X / Y\nPRINT Z\n");
+    TEST_ASSERT_TRUE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(ERROR_DIVISION_BY_ZERO, error->errCode);
+}
+
+void testStringOperandInSpecializedShape(void) {
+    SimplicValue val = runClosures("SET S = \"A\"\nSET X = S + 1\nRETURN X\n");
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_EQUAL_STRING("A1", val.string);
+    free(val.string);
+}
+
+void testReturnFromNested(void) {
+    SimplicValue val = runClosures(
+        "SET X = 0\n"
+        "WHILE X LT 5 DO\n"
+            "INCR X\n"
+            "IF X EQ 5 THEN\n"
+                "RETURN 0\n"
+            "FI\n"
+        "DONE\n"
+        "RETURN 1\n");
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(0, val.integer);
+}
+
+// Shape the closure of the first statement's expression was given
+ClosureFn shapeOf(const char* program) {
+    tokenizeSource(&tokenList, program, error);
+    SyntaxNode* tree = parseProgram(&tokenList, error);
+    TEST_ASSERT_FALSE(error->hasError);
+
+    ClosureFn fn = cl_selectBinOp(tree->blockStatements[0]->subnodeB);
+    freeSyntaxTree(tree);
+    return fn;
+}
+
+void testShapeSelection(void) {
+    TEST_ASSERT_TRUE(shapeOf("SET A = X - 4\n") == cl_subVarConst);
+    TEST_ASSERT_TRUE(shapeOf("SET A = X * Y\n") == cl_mulVarVar);
+    TEST_ASSERT_TRUE(shapeOf("SET A = 2 + X\n") == cl_add);
+    TEST_ASSERT_TRUE(shapeOf("SET A = X LT 10 * Y\n") == cl_lt);
+    TEST_ASSERT_TRUE(shapeOf("SET A = X / 3\n") == cl_divVarConst);
+
+    // Division by the constant 0 must still fail
+    TEST_ASSERT_TRUE(shapeOf("SET A = X % 0\n") == cl_mod);
+}
+
+// Specialized shapes skip eval()'s generic path, errors and strings must come out the same anyway
+void testSameResultsAsEval(void) {
+    const char* programs[] = {
+        "SET S = \"A\"\nSET T = \"B\"\nRETURN S EQ T\n",
+        "SET S = \"A\"\nRETURN S / 2\n",
+        "SET S = \"A\"\nIF S THEN\nRETURN 1\nFI\n",
+        "SET S = \"A\"\nPRINTLN S - 1\nPRINTLN S + 1\nPRINTLN 1 + S\n",
+        "SET S = \"A\"\nSET T = \"B\"\nPRINTLN S + T\nPRINTLN S * T\nPRINTLN S LT T\n",
+        "SET X = 1\nRETURN X * Y\n",
+        "SET Y = 1\nRETURN X * Y\n",
+        "RETURN Q LT 3\n",
+        "SET X = 0 - 7\nPRINTLN X / 2\nPRINTLN X % 3\nRETURN X / 0\n",
+        "SET X = 0\nSET Y = 0\nRETURN X AND Y OR X NEQ Y\n",
+    };
+    assertAllSameAsEval(closureEngine, programs, sizeof(programs) / sizeof(programs[0]));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(testReturnCorrectInt);
+    RUN_TEST(testSpecializedShapes);
+    RUN_TEST(testAccessToUndeclaredVariable);
+    RUN_TEST(testDivisionByZero);
+    RUN_TEST(testStringOperandInSpecializedShape);
+    RUN_TEST(testReturnFromNested);
+    RUN_TEST(testShapeSelection);
+    RUN_TEST(testSameResultsAsEval);
+    return UNITY_END();
+}
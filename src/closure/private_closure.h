@@ -0,0 +1,57 @@
+#ifndef PRIVATE_CLOSURE_H
+#define PRIVATE_CLOSURE_H
+
+#include "closure.h"
+
+// Wrapper functions for the closures, same meaning as the ones used by eval()
+static SimplicValue cl_makeInt(int n);
+static SimplicValue cl_makeStr(const char* s); // Returns a copy of s
+static SimplicValue cl_makeVoid(void);
+static SimplicValue cl_makeError(void); // The error itself is stored in SimplicError
+
+static Closure* cl_initClosure(ClosureFn fn);
+static bool cl_evalOperands(Closure* self, ControlState* control, SimplicError* error, SimplicValue* l, SimplicValue* r); // false on error
+
+// Leaves
+static SimplicValue cl_number(Closure* self, ControlState* control, SimplicError* error);
+static SimplicValue cl_string(Closure* self, ControlState* control, SimplicError* error);
+static SimplicValue cl_var(Closure* self, ControlState* control, SimplicError* error);
+
+// Binary operations, integer ones come in three shapes: any operands, variable and constant, two variables
+#define CL_DECLARE_INT_OP(op) \
+    static SimplicValue cl_##op(Closure* self, ControlState* control, SimplicError* error); \
+    static SimplicValue cl_##op##VarConst(Closure* self, ControlState* control, SimplicError* error); \
+    static SimplicValue cl_##op##VarVar(Closure* self, ControlState* control, SimplicError* error);
+
+CL_DECLARE_INT_OP(add)
+CL_DECLARE_INT_OP(sub)
+CL_DECLARE_INT_OP(mul)
+CL_DECLARE_INT_OP(lt)
+CL_DECLARE_INT_OP(leq)
+CL_DECLARE_INT_OP(gt)
+CL_DECLARE_INT_OP(geq)
+CL_DECLARE_INT_OP(eq)
+CL_DECLARE_INT_OP(neq)
+CL_DECLARE_INT_OP(and)
+CL_DECLARE_INT_OP(or)
+static SimplicValue cl_div(Closure* self, ControlState* control, SimplicError* error);
+static SimplicValue cl_mod(Closure* self, ControlState* control, SimplicError* error);
+static SimplicValue cl_divVarConst(Closure* self, ControlState* control, SimplicError* error); // Only used when the constant is not 0
+static SimplicValue cl_modVarConst(Closure* self, ControlState* control, SimplicError* error);
+
+// Statements
+static SimplicValue cl_assign(Closure* self, ControlState* control, SimplicError* error);
+static SimplicValue cl_assignConst(Closure* self, ControlState* control, SimplicError* error); // SET X = number
+static SimplicValue cl_unassign(Closure* self, ControlState* control, SimplicError* error);
+static SimplicValue cl_print(Closure* self, ControlState* control, SimplicError* error);
+static SimplicValue cl_println(Closure* self, ControlState* control, SimplicError* error);
+static SimplicValue cl_return(Closure* self, ControlState* control, SimplicError* error);
+static SimplicValue cl_increment(Closure* self, ControlState* control, SimplicError* error);
+static SimplicValue cl_decrement(Closure* self, ControlState* control, SimplicError* error);
+static SimplicValue cl_block(Closure* self, ControlState* control, SimplicError* error);
+static SimplicValue cl_while(Closure* self, ControlState* control, SimplicError* error);
+static SimplicValue cl_if(Closure* self, ControlState* control, SimplicError* error);
+
+static ClosureFn cl_selectBinOp(SyntaxNode* node); // Picks the specialized function of a binary operation, NULL if unknown
+
+#endif
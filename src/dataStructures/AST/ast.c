@@ -4,6 +4,8 @@ SyntaxNode* initNode() {
     SyntaxNode* res = malloc(sizeof(SyntaxNode));
     res->numberValue = 0;
     strcpy(res->operator, "&");
+    res->quick = 0;
+    res->provenInt = false;
     res->string = NULL;
     res->subnodeA = NULL;
     res->subnodeB = NULL;
@@ -15,59 +17,108 @@ SyntaxNode* initNode() {
 }
 
 void freeSyntaxTree(SyntaxNode* tree) {
-    int i;
-
     if (tree == NULL)
         return;
 
-    switch (tree->type) {
-        case NODE_NUMBER:
-        case NODE_VAR:
-        case NODE_UNASSIGN:
-            // No child nodes to free
-            break;
-        case NODE_STRING:
-            free(tree->string);
-            break;
-
-        case NODE_BIN_OP:
-        case NODE_WHILE:
-            freeSyntaxTree(tree->subnodeA);
-            freeSyntaxTree(tree->subnodeB);
-            break;
+    // Nodes still to be freed, kept on the heap so generated scripts can nest as deep as they like
+    int capacity = 64, count = 0;
+    SyntaxNode** pending = malloc(sizeof(SyntaxNode*) * capacity);
+    pending[count++] = tree;
+
+    while (count > 0) {
+        tree = pending[--count];
+        if (tree == NULL)
+            continue;
+
+        // A node adds at most 3 children, blocks make room for their own statements
+        if (count + 3 > capacity) {
+            capacity *= 2;
+            pending = realloc(pending, sizeof(SyntaxNode*) * capacity);
+        }
+
+        switch (tree->type) {
+            case NODE_NUMBER:
+            case NODE_VAR:
+            case NODE_UNASSIGN:
+                // No child nodes to free
+                break;
+            case NODE_STRING:
+                free(tree->string);
+                break;
+
+            case NODE_BIN_OP:
+            case NODE_WHILE:
+                pending[count++] = tree->subnodeA;
+                pending[count++] = tree->subnodeB;
+                break;
+
+            case NODE_BLOCK: // Array of ASTs
+                for (int i = 0; tree->blockStatements[i] != NULL; i++) { // Free each AST
+                    if (count == capacity) {
+                        capacity *= 2;
+                        pending = realloc(pending, sizeof(SyntaxNode*) * capacity);
+                    }
+                    pending[count++] = tree->blockStatements[i];
+                }
+                free(tree->blockStatements); // Free list of ASts
+                break;
+
+            case NODE_IF:
+                pending[count++] = tree->subnodeA;
+                pending[count++] = tree->subnodeB;
+                pending[count++] = tree->subnodeC;
+                break;
+
+            case NODE_ASSIGN:
+            case NODE_PRINT:
+            case NODE_PRINTLN:
+            case NODE_RETURN:
+            case NODE_INCREMENT:
+            case NODE_DECREMENT:
+                // These have only one child on the right
+                pending[count++] = tree->subnodeB;
+                break;
+
+            default:
+                // Undefined, try to free both branches
+                pending[count++] = tree->subnodeA;
+                pending[count++] = tree->subnodeB;
+                break;
+        }
+
+        free(tree);
+    }
 
-        case NODE_BLOCK: // Array of ASTs
-            i = 0;
-            while (tree->blockStatements[i] != NULL) { // Free each AST
-                freeSyntaxTree(tree->blockStatements[i++]);
-            }
-            free(tree->blockStatements); // Free list of ASts
-            break;
+    free(pending);
+}
 
-        case NODE_IF:
-            freeSyntaxTree(tree->subnodeA);
-            freeSyntaxTree(tree->subnodeB);
-            freeSyntaxTree(tree->subnodeC);
-            break;
+SyntaxNode* copySyntaxTree(SyntaxNode* tree) {
+    int i;
+    if (tree == NULL) return NULL;
 
-        case NODE_ASSIGN:
-        case NODE_PRINT:
-        case NODE_PRINTLN:
-        case NODE_RETURN:
-        case NODE_INCREMENT:
-        case NODE_DECREMENT:
-            // These have only one child on the right
-            freeSyntaxTree(tree->subnodeB);
-            break;
+    SyntaxNode* res = malloc(sizeof(SyntaxNode));
+    *res = *tree;
+    res->quick = 0; // Forms picked at runtime belong to the original
+    res->subnodeA = copySyntaxTree(tree->subnodeA);
+    res->subnodeB = copySyntaxTree(tree->subnodeB);
+    res->subnodeC = copySyntaxTree(tree->subnodeC);
+
+    if (tree->string != NULL) {
+        res->string = malloc(strlen(tree->string) + 1);
+        strcpy(res->string, tree->string);
+    }
 
-        default:
-            // Undefined, try to free both branches
-            freeSyntaxTree(tree->subnodeA);
-            freeSyntaxTree(tree->subnodeB);
-            break;
+    if (tree->blockStatements != NULL) {
+        i = 0;
+        while (tree->blockStatements[i] != NULL) i++;
+        res->blockStatements = malloc(sizeof(SyntaxNode*) * (i + 1));
+        res->blockStatements[i] = NULL;
+        while (i-- > 0) {
+            res->blockStatements[i] = copySyntaxTree(tree->blockStatements[i]);
+        }
     }
 
-    free(tree);
+    return res;
 }
 
 bool compareSyntaxTree(SyntaxNode* a, SyntaxNode* b) {
@@ -92,6 +143,8 @@ bool compareSyntaxTree(SyntaxNode* a, SyntaxNode* b) {
             return strcmp(a->string, b->string) == 0;
 
         case NODE_BIN_OP:
+            return strcmp(a->operator, b->operator) == 0 && compareSyntaxTree(a->subnodeA, b->subnodeA) && compareSyntaxTree(a->subnodeB, b->subnodeB);
+
         case NODE_WHILE:
             return compareSyntaxTree(a->subnodeA, b->subnodeA) && compareSyntaxTree(a->subnodeB, b->subnodeB);
 
@@ -125,4 +178,57 @@ bool compareSyntaxTree(SyntaxNode* a, SyntaxNode* b) {
     }
 
     return false;
-}
\ No newline at end of file
+}
+
+unsigned int hashMix(unsigned int hash, const void* data, size_t size) {
+    // FNV-1a
+    const unsigned char* bytes = data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+unsigned int hashSyntaxTree(SyntaxNode* tree) {
+    unsigned int hash = 2166136261u;
+    unsigned int child;
+    int i;
+    if (tree == NULL) return hash;
+
+    hash = hashMix(hash, &tree->type, sizeof(tree->type));
+
+    // Same fields compareSyntaxTree() looks at, so equal trees always get the same hash
+    switch (tree->type) {
+        case NODE_NUMBER:
+            return hashMix(hash, &tree->numberValue, sizeof(tree->numberValue));
+
+        case NODE_VAR:
+        case NODE_UNASSIGN:
+            return hashMix(hash, tree->varName, strlen(tree->varName));
+
+        case NODE_STRING:
+            return hashMix(hash, tree->string, strlen(tree->string));
+
+        case NODE_BIN_OP:
+            hash = hashMix(hash, tree->operator, strlen(tree->operator));
+            break;
+
+        case NODE_BLOCK:
+            i = 0;
+            while (tree->blockStatements[i] != NULL) {
+                child = hashSyntaxTree(tree->blockStatements[i++]);
+                hash = hashMix(hash, &child, sizeof(child));
+            }
+            return hash;
+
+        default:
+            break;
+    }
+
+    child = hashSyntaxTree(tree->subnodeA);
+    hash = hashMix(hash, &child, sizeof(child));
+    child = hashSyntaxTree(tree->subnodeB);
+    hash = hashMix(hash, &child, sizeof(child));
+    child = hashSyntaxTree(tree->subnodeC);
+    return hashMix(hash, &child, sizeof(child));
+}
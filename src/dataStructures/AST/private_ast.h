@@ -3,4 +3,6 @@
 
 #include "dataStructures/ast.h"
 
+static unsigned int hashMix(unsigned int hash, const void* data, size_t size); // Adds bytes to a hash
+
 #endif
\ No newline at end of file
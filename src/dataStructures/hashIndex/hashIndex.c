@@ -0,0 +1,129 @@
+#include "private_hashIndex.h"
+
+HashIndex initHashIndex(void) {
+    return (HashIndex){ .hashes = NULL, .entries = NULL, .capacity = 0, .count = 0 };
+}
+
+HashIndex copyHashIndex(const HashIndex* index) {
+    HashIndex res = *index;
+    if (index->capacity > 0) {
+        res.hashes = malloc(sizeof(unsigned int) * index->capacity);
+        res.entries = malloc(sizeof(int) * index->capacity);
+        memcpy(res.hashes, index->hashes, sizeof(unsigned int) * index->capacity);
+        memcpy(res.entries, index->entries, sizeof(int) * index->capacity);
+    }
+    return res;
+}
+
+void freeHashIndex(HashIndex* index) {
+    free(index->hashes);
+    free(index->entries);
+    *index = initHashIndex();
+}
+
+unsigned int hashName(const char* name) {
+    // FNV-1a
+    unsigned int hash = 2166136261u;
+    while (*name != '\0') {
+        hash ^= (unsigned char)*name++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+unsigned int hashInt(int value) {
+    // Spreads consecutive numbers over the whole table
+    unsigned int hash = (unsigned int)value;
+    hash ^= hash >> 16;
+    hash *= 0x45d9f3bu;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+void hi_grow(HashIndex* index) {
+    HashIndex old = *index;
+
+    index->capacity = (old.capacity == 0) ? HASH_INDEX_MIN_CAPACITY : old.capacity * 2;
+    index->hashes = malloc(sizeof(unsigned int) * index->capacity);
+    index->entries = malloc(sizeof(int) * index->capacity);
+    index->count = 0;
+    for (int i = 0; i < index->capacity; i++) index->entries[i] = -1;
+
+    for (int i = 0; i < old.capacity; i++) {
+        if (old.entries[i] >= 0) hashIndexAdd(index, old.hashes[i], old.entries[i]);
+    }
+    free(old.hashes);
+    free(old.entries);
+}
+
+void hashIndexAdd(HashIndex* index, unsigned int hash, int entry) {
+    if ((index->count + 1) * 2 > index->capacity) hi_grow(index);
+
+    unsigned int mask = index->capacity - 1;
+    unsigned int slot = hash & mask;
+    while (index->entries[slot] >= 0) slot = (slot + 1) & mask;
+
+    index->hashes[slot] = hash;
+    index->entries[slot] = entry;
+    index->count++;
+}
+
+int hi_find(const HashIndex* index, unsigned int hash, int entry) {
+    if (index->capacity == 0) return -1;
+
+    unsigned int mask = index->capacity - 1;
+    for (unsigned int slot = hash & mask; index->entries[slot] >= 0; slot = (slot + 1) & mask) {
+        if (index->entries[slot] == entry) return slot;
+    }
+    return -1;
+}
+
+void hashIndexRemove(HashIndex* index, unsigned int hash, int entry) {
+    int found = hi_find(index, hash, entry);
+    if (found < 0) return;
+
+    // Entries after the hole that would not be found past it are moved back into it
+    unsigned int mask = index->capacity - 1;
+    unsigned int hole = found;
+    unsigned int slot = hole;
+    while (true) {
+        slot = (slot + 1) & mask;
+        if (index->entries[slot] < 0) break;
+
+        unsigned int home = index->hashes[slot] & mask;
+        bool reachable = (hole <= slot) ? (hole < home && home <= slot) : (hole < home || home <= slot);
+        if (reachable) continue;
+
+        index->hashes[hole] = index->hashes[slot];
+        index->entries[hole] = index->entries[slot];
+        hole = slot;
+    }
+
+    index->entries[hole] = -1;
+    index->count--;
+}
+
+void hashIndexMove(HashIndex* index, unsigned int hash, int entry, int newEntry) {
+    int found = hi_find(index, hash, entry);
+    if (found >= 0) index->entries[found] = newEntry;
+}
+
+int hashIndexFirst(const HashIndex* index, unsigned int hash, int* cursor) {
+    if (index->capacity == 0) return -1;
+
+    *cursor = (hash & (index->capacity - 1)) - 1;
+    return hashIndexNext(index, hash, cursor);
+}
+
+int hashIndexNext(const HashIndex* index, unsigned int hash, int* cursor) {
+    unsigned int mask = index->capacity - 1;
+    unsigned int slot = ((unsigned int)*cursor + 1) & mask;
+
+    for (; index->entries[slot] >= 0; slot = (slot + 1) & mask) {
+        if (index->hashes[slot] == hash) {
+            *cursor = slot;
+            return index->entries[slot];
+        }
+    }
+    return -1;
+}
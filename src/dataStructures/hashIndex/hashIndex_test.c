@@ -0,0 +1,120 @@
+#include "unity.h"
+#include "unity_internals.h"
+
+#include "hashIndex.c"
+
+#define KEYS 2000
+
+HashIndex index_;
+int keys[KEYS]; // Owner's array, -1 for removed entries
+
+void setUp(void) {
+    index_ = initHashIndex();
+}
+
+void tearDown(void) {
+    freeHashIndex(&index_);
+}
+
+// Position of key in keys through the index, like the owners do
+int find(const HashIndex* index, int key) {
+    unsigned int hash = hashInt(key);
+    int cursor;
+    for (int i = hashIndexFirst(index, hash, &cursor); i >= 0; i = hashIndexNext(index, hash, &cursor)) {
+        if (keys[i] == key) return i;
+    }
+    return -1;
+}
+
+void testFindsWhatWasAdded(void) {
+    TEST_ASSERT_EQUAL_INT(-1, find(&index_, 5)); // Nothing allocated yet
+
+    for (int i = 0; i < KEYS; i++) {
+        keys[i] = i * 7;
+        hashIndexAdd(&index_, hashInt(keys[i]), i);
+    }
+    TEST_ASSERT_EQUAL_INT(KEYS, index_.count);
+    TEST_ASSERT_TRUE(index_.count * 2 <= index_.capacity);
+
+    for (int i = 0; i < KEYS; i++) TEST_ASSERT_EQUAL_INT(i, find(&index_, i * 7));
+    TEST_ASSERT_EQUAL_INT(-1, find(&index_, 3));
+}
+
+// Every key has the same hash, so removals have to close the holes they leave in the probe sequence
+void testRemoveKeepsCollisionsReachable(void) {
+    for (int i = 0; i < 40; i++) {
+        keys[i] = i;
+        hashIndexAdd(&index_, 12345, i);
+    }
+    for (int i = 0; i < 40; i += 3) {
+        hashIndexRemove(&index_, 12345, i);
+        keys[i] = -1;
+    }
+
+    int cursor, seen = 0;
+    for (int i = hashIndexFirst(&index_, 12345, &cursor); i >= 0; i = hashIndexNext(&index_, 12345, &cursor)) {
+        TEST_ASSERT_NOT_EQUAL(-1, keys[i]);
+        seen++;
+    }
+    TEST_ASSERT_EQUAL_INT(26, seen);
+    TEST_ASSERT_EQUAL_INT(26, index_.count);
+}
+
+// Removing and moving entries the way an array that fills its holes with the last entry does
+void testSwapRemove(void) {
+    int count = KEYS;
+    for (int i = 0; i < count; i++) {
+        keys[i] = i;
+        hashIndexAdd(&index_, hashInt(i), i);
+    }
+
+    for (int key = 0; key < KEYS; key += 2) {
+        int i = find(&index_, key);
+        TEST_ASSERT_NOT_EQUAL(-1, i);
+        hashIndexRemove(&index_, hashInt(key), i);
+
+        count--;
+        if (i != count) {
+            keys[i] = keys[count];
+            hashIndexMove(&index_, hashInt(keys[i]), count, i);
+        }
+    }
+
+    TEST_ASSERT_EQUAL_INT(KEYS / 2, index_.count);
+    for (int key = 0; key < KEYS; key++) {
+        int i = find(&index_, key);
+        if (key % 2 == 0) {
+            TEST_ASSERT_EQUAL_INT(-1, i);
+        } else {
+            TEST_ASSERT_TRUE(i >= 0 && i < count);
+        }
+    }
+}
+
+void testCopyIsIndependent(void) {
+    for (int i = 0; i < 100; i++) {
+        keys[i] = i;
+        hashIndexAdd(&index_, hashInt(i), i);
+    }
+
+    HashIndex copy = copyHashIndex(&index_);
+    hashIndexRemove(&copy, hashInt(50), 50);
+    TEST_ASSERT_EQUAL_INT(-1, find(&copy, 50));
+    TEST_ASSERT_EQUAL_INT(50, find(&index_, 50));
+    freeHashIndex(&copy);
+}
+
+void testHashName(void) {
+    TEST_ASSERT_EQUAL_UINT(hashName("COUNTER"), hashName("COUNTER"));
+    TEST_ASSERT_NOT_EQUAL(hashName("A1"), hashName("A2"));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(testFindsWhatWasAdded);
+    RUN_TEST(testRemoveKeepsCollisionsReachable);
+    RUN_TEST(testSwapRemove);
+    RUN_TEST(testCopyIsIndependent);
+    RUN_TEST(testHashName);
+    return UNITY_END();
+}
@@ -0,0 +1,11 @@
+#ifndef PRIVATE_HASHINDEX_H
+#define PRIVATE_HASHINDEX_H
+
+#include "dataStructures/hashIndex.h"
+
+#define HASH_INDEX_MIN_CAPACITY 16
+
+static void hi_grow(HashIndex* index); // Doubles the slots and places every entry again
+static int hi_find(const HashIndex* index, unsigned int hash, int entry); // Slot of the entry or -1
+
+#endif
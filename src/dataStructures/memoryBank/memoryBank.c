@@ -1,11 +1,11 @@
 #include "dataStructures/memoryBank.h"
 
-MemoryCell* MemoryBank[HASH_TABLE_SIZE];
-
-void initMemoryBank(void){
+MemoryBank* initMemoryBank(void){
+    MemoryBank* bank = malloc(sizeof(MemoryBank));
     for (int i = 0; i < HASH_TABLE_SIZE; i++) {
-        MemoryBank[i] = NULL;
+        bank->cells[i] = NULL;
     }
+    return bank;
 }
 
 unsigned long stringHash(const char *str){
@@ -61,9 +61,9 @@ BankResult makeError(SimplicError* err, SimplicErrorType code, const char* fmt,
     return (BankResult){ .integer = -1, .string = NULL, .hasError = true };
 }
 
-void insertInt(const char* key, int value) {
+void insertInt(MemoryBank* bank, const char* key, int value) {
     unsigned int index = stringHash(key);
-    MemoryCell* current = MemoryBank[index];
+    MemoryCell* current = bank->cells[index];
 
     // Check if it already exists
     while (current != NULL) {
@@ -83,13 +83,13 @@ void insertInt(const char* key, int value) {
 
     strcpy(newMemCell->name, key);
     newMemCell->value = value;
-    newMemCell->next = MemoryBank[index]; // In case there is a collision
-    MemoryBank[index] = newMemCell;
+    newMemCell->next = bank->cells[index]; // In case there is a collision
+    bank->cells[index] = newMemCell;
 }
 
-void insertStr(const char* key, const char* str) {
+void insertStr(MemoryBank* bank, const char* key, const char* str) {
     unsigned int index = stringHash(key);
-    MemoryCell* current = MemoryBank[index];
+    MemoryCell* current = bank->cells[index];
 
     // Check if it already exists
     while (current != NULL) {
@@ -116,14 +116,14 @@ void insertStr(const char* key, const char* str) {
     newMemCell->strPtr = malloc(sizeof(char) * (len + 1));
     strcpy(newMemCell->strPtr, str);
 
-    newMemCell->next = MemoryBank[index];  // In case there is a collision
-    MemoryBank[index] = newMemCell;
+    newMemCell->next = bank->cells[index];  // In case there is a collision
+    bank->cells[index] = newMemCell;
 }
 
 
-BankResult getInt(const char* key, SimplicError* error) {
+BankResult getInt(MemoryBank* bank, const char* key, SimplicError* error) {
     unsigned int index = stringHash(key);
-    MemoryCell* current = MemoryBank[index];
+    MemoryCell* current = bank->cells[index];
     while (current != NULL) {
         if (strcmp(current->name, key) == 0) {
             return makeResultInt(current->value);
@@ -133,9 +133,9 @@ BankResult getInt(const char* key, SimplicError* error) {
     return makeError(error, ERROR_ACCESS_TO_UNDECLARED_VAR, "Variable %s not initialized", key);
 }
 
-bool varIsInt(const char* key, SimplicError* error) {
+bool varIsInt(MemoryBank* bank, const char* key, SimplicError* error) {
     unsigned int index = stringHash(key);
-    MemoryCell* current = MemoryBank[index];
+    MemoryCell* current = bank->cells[index];
     while (current != NULL) {
         if (strcmp(current->name, key) == 0) {
             return (current->strPtr == NULL);
@@ -146,9 +146,22 @@ bool varIsInt(const char* key, SimplicError* error) {
     return false;
 }
 
-BankResult getStr(const char* key, SimplicError* error) {
+MemoryCell* getCell(MemoryBank* bank, const char* key, SimplicError* error) {
     unsigned int index = stringHash(key);
-    MemoryCell* current = MemoryBank[index];
+    MemoryCell* current = bank->cells[index];
+    while (current != NULL) {
+        if (strcmp(current->name, key) == 0) {
+            return current;
+        }
+        current = current->next;
+    }
+    setError(error, ERROR_ACCESS_TO_UNDECLARED_VAR, "Variable %s not initialized", key);
+    return NULL;
+}
+
+BankResult getStr(MemoryBank* bank, const char* key, SimplicError* error) {
+    unsigned int index = stringHash(key);
+    MemoryCell* current = bank->cells[index];
     while (current != NULL) {
         if (strcmp(current->name, key) == 0) {
             return makeResultStr(current->strPtr);
@@ -158,14 +171,14 @@ BankResult getStr(const char* key, SimplicError* error) {
     return makeError(error, ERROR_ACCESS_TO_UNDECLARED_VAR, "Variable %s not initialized", key);
 }
 
-BankResult deleteVariable(const char* key, SimplicError* error) {
+BankResult deleteVariable(MemoryBank* bank, const char* key, SimplicError* error) {
     unsigned int index = stringHash(key);
-    MemoryCell* current = MemoryBank[index];
+    MemoryCell* current = bank->cells[index];
     MemoryCell* prev = NULL;
     while (current != NULL) {
         if (strcmp(current->name, key) == 0) {
             if (prev == NULL){
-                MemoryBank[index] = current->next;
+                bank->cells[index] = current->next;
             } else{
                 prev->next = current->next;
             }
@@ -183,9 +196,11 @@ BankResult deleteVariable(const char* key, SimplicError* error) {
     return makeError(error, ERROR_ACCESS_TO_UNDECLARED_VAR, "Tried to unset undeclared variable %s", key);
 }
 
-void deleteMemoryBank() {
+void deleteMemoryBank(MemoryBank** bank) {
+    if (*bank == NULL) return;
+
     for (int i = 0; i < HASH_TABLE_SIZE; i++) {
-        MemoryCell* current = MemoryBank[i];
+        MemoryCell* current = (*bank)->cells[i];
         while (current != NULL) {
             MemoryCell* temp = current;
             current = current->next;
@@ -195,6 +210,7 @@ void deleteMemoryBank() {
 
             free(temp);
         }
-        MemoryBank[i] = NULL;
     }
+    free(*bank);
+    *bank = NULL;
 }
\ No newline at end of file
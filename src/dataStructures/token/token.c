@@ -108,10 +108,14 @@ int deleteTokenQueue(Token** tokenList){
 }
 
 Token* peekTokenQueue(Token** tokenList) {
-    return *tokenList;
+    // Past the end there is only EOF, a program cut short is then a parse error and not a crash
+    static Token end = { .type = TOKEN_EOF, .name = "", .next = NULL, .string = NULL };
+    return (*tokenList == NULL) ? &end : *tokenList;
 }
 
 Token dequeueToken(Token** tokenList) {
+    if (*tokenList == NULL) return *peekTokenQueue(tokenList);
+
     Token copy;
     copy.type = (*tokenList)->type;
     copy.next = (*tokenList)->next;
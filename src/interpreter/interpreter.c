@@ -1,19 +1,11 @@
 #include "private_interpreter.h"
 
-SimplicValue eval_returnInt(int n) {
-    return (SimplicValue){ .type = VALUE_INT, .integer = n, .string = NULL, .receivedReturn = true };
-}
-
-SimplicValue eval_returnStr(char* s) {
-    return (SimplicValue){ .type = VALUE_INT, .integer = 0, .string = s, .receivedReturn = true };
-}
-
 SimplicValue eval_makeResultInt(int n) {
-    return (SimplicValue){ .type = VALUE_INT, .integer = n, .string = NULL, .receivedReturn = false };
+    return (SimplicValue){ .type = VALUE_INT, .integer = n, .string = NULL };
 }
 
 SimplicValue eval_makeResultStr(char* s) {
-    SimplicValue res = { .type = VALUE_STR, .integer = 0, .string = NULL, .receivedReturn = false };
+    SimplicValue res = { .type = VALUE_STR, .integer = 0, .string = NULL };
     int len = strlen(s);
     res.string = malloc(sizeof(char)*(len+1));
     strcpy(res.string, s);
@@ -22,7 +14,7 @@ SimplicValue eval_makeResultStr(char* s) {
 }
 
 SimplicValue eval_makeResultVoid() {
-    return (SimplicValue){ .type = VALUE_VOID, .integer = 0, .string = NULL , .receivedReturn = false };
+    return (SimplicValue){ .type = VALUE_VOID, .integer = 0, .string = NULL  };
 }
 
 SimplicValue eval_makeError(SimplicError* err, SimplicErrorType code, const char* fmt, ...) {
@@ -47,222 +39,461 @@ SimplicValue eval_makeError(SimplicError* err, SimplicErrorType code, const char
         }
     }
 
-    return (SimplicValue){ .type = 0, .integer = 0, .string = NULL, .receivedReturn = false };
+    return (SimplicValue){ .type = 0, .integer = 0, .string = NULL };
 }
 
 SimplicValue eval_makeError_keepErrInfo(SimplicError* err) {
-    return (SimplicValue){ .type = 0, .integer = 0, .string = NULL, .receivedReturn = false };
+    return (SimplicValue){ .type = 0, .integer = 0, .string = NULL };
     setError(err, err->errCode, err->errMsg );
 }
 
-SimplicValue eval(SyntaxNode* node, SimplicError* error) { 
-    if(error->hasError) return eval_makeError_keepErrInfo(error);
-    if(node->type == NODE_NUMBER) return eval_makeResultInt(node->numberValue);
-    if(node->type == NODE_STRING){
-        SimplicValue res = eval_makeResultStr(node->string);
-        return res;
-    }
-    if(node->type == NODE_VAR){
-        if(varIsInt(node->varName, error) && !error->hasError) { 
-            // Variable is an int
-            BankResult res = getInt(node->varName, error);
-            if(res.hasError){
-                return eval_makeError_keepErrInfo(error); // Requested var was not initialized
-            } else {
-                return eval_makeResultInt(res.integer);
-            }
-        } 
-        else if(!error->hasError) {
-            // Variable is a string
-            BankResult res = getStr(node->varName, error);
-            if(res.hasError){
-                return eval_makeError_keepErrInfo(error); // Requested var was not initialized
-            } else {
-                return eval_makeResultStr(res.string);
-            }
-        } else {
-            return eval_makeError_keepErrInfo(error);
-        }
-    }
-    if(node->type == NODE_BIN_OP){
-        SimplicValue l = eval(node->subnodeA, error);
-        SimplicValue r = eval(node->subnodeB, error);
-        if(error->hasError) return eval_makeError_keepErrInfo(error);
-
-        // String concat
-        if (l.type == VALUE_STR && r.type == VALUE_STR &&  (strcmp(node->operator, "+") == 0)) {
-            int len = strlen(l.string) + strlen(r.string);
-            char* buffer = malloc(sizeof(char)*(len+1));
-            snprintf(buffer, len+1, "%s%s", l.string, r.string);
-            
-            SimplicValue res = eval_makeResultStr(buffer);
-            free(buffer);
-            free(l.string); // We are done using the string values, so we free them
-            free(r.string);
-            return res;
-        }
+// ------------------------------------------
+// Work stack
+// ------------------------------------------
+
+void eval_initStack(EvalStack* stack) {
+    stack->frames = stack->inlineFrames;
+    stack->frameCount = 0;
+    stack->frameCapacity = EVAL_INLINE_DEPTH;
+    stack->values = stack->inlineValues;
+    stack->valueCount = 0;
+    stack->valueCapacity = EVAL_INLINE_DEPTH;
+}
 
-        // String and number concat
-        if (l.type == VALUE_STR && r.type == VALUE_INT && (strcmp(node->operator, "+") == 0)) {
-            int len = strlen(l.string) + CHARS_FOR_INT_TO_STRING;
-            char* buffer = malloc(sizeof(char)*(len+1));
-            snprintf(buffer, len+1, "%s%d", l.string, r.integer);
+void eval_deleteStack(EvalStack* stack) {
+    eval_unwind(stack); // Values left behind by an error still own their strings
+    if (stack->frames != stack->inlineFrames) free(stack->frames);
+    if (stack->values != stack->inlineValues) free(stack->values);
+}
 
-            SimplicValue res = eval_makeResultStr(buffer);
-            free(buffer);
-            free(l.string);
-            return res;
-        }
+void eval_unwind(EvalStack* stack) {
+    for (int i = 0; i < stack->valueCount; i++) {
+        if (stack->values[i].type == VALUE_STR) free(stack->values[i].string);
+    }
+    stack->valueCount = 0;
+    stack->frameCount = 0;
+}
 
-        if(l.type == VALUE_INT && r.type == VALUE_STR && (strcmp(node->operator, "+") == 0)) {
-            int len = strlen(r.string) + CHARS_FOR_INT_TO_STRING;
-            char* buffer = malloc(sizeof(char)*(len+1));
-            snprintf(buffer, len+1, "%d%s", l.integer, r.string);
+void eval_growValues(EvalStack* stack) {
+    stack->valueCapacity *= 2;
+    if (stack->values == stack->inlineValues) {
+        stack->values = malloc(sizeof(SimplicValue) * stack->valueCapacity);
+        memcpy(stack->values, stack->inlineValues, sizeof(stack->inlineValues));
+    } else {
+        stack->values = realloc(stack->values, sizeof(SimplicValue) * stack->valueCapacity);
+    }
+}
 
-            SimplicValue res = eval_makeResultStr(buffer);
-            free(buffer);
-            free(r.string);
-            return res;
-        }
+void eval_growFrames(EvalStack* stack) {
+    stack->frameCapacity *= 2;
+    if (stack->frames == stack->inlineFrames) {
+        stack->frames = malloc(sizeof(EvalFrame) * stack->frameCapacity);
+        memcpy(stack->frames, stack->inlineFrames, sizeof(stack->inlineFrames));
+    } else {
+        stack->frames = realloc(stack->frames, sizeof(EvalFrame) * stack->frameCapacity);
+    }
+}
 
-        // Arithmetic operations
-        if ((strcmp(node->operator, "+") == 0)) return eval_makeResultInt(l.integer + r.integer);
-        if ((strcmp(node->operator, "-") == 0)) return eval_makeResultInt(l.integer - r.integer);
-        if ((strcmp(node->operator, "*") == 0)) return eval_makeResultInt(l.integer * r.integer);
-        if ((strcmp(node->operator, "/") == 0)) {
-            if(r.integer == 0){
-                return eval_makeError(error, ERROR_DIVISION_BY_ZERO, "Division by 0, execution halted");
-            } else {
-                return eval_makeResultInt(l.integer / r.integer);
-            }
-        }
-        if ((strcmp(node->operator, "%") == 0)) return eval_makeResultInt(l.integer % r.integer);
+inline void eval_pushValue(EvalStack* stack, SimplicValue val) {
+    if (stack->valueCount == stack->valueCapacity) eval_growValues(stack);
+    stack->values[stack->valueCount++] = val;
+}
 
-        // Relational operations
-        if ((strcmp(node->operator, "<") == 0)){ return eval_makeResultInt((l.integer < r.integer)? 1 : 0); }
-        if ((strcmp(node->operator, "<=") == 0)){ return eval_makeResultInt((l.integer <= r.integer)? 1 : 0); }
-        if ((strcmp(node->operator, ">") == 0)){ return eval_makeResultInt((l.integer > r.integer)? 1 : 0); }
-        if ((strcmp(node->operator, ">=") == 0)){ return eval_makeResultInt((l.integer >= r.integer)? 1 : 0); }
+inline SimplicValue eval_popValue(EvalStack* stack) {
+    return stack->values[--stack->valueCount];
+}
+
+inline void eval_pushFrame(EvalStack* stack, SyntaxNode* node) {
+    if (stack->frameCount == stack->frameCapacity) eval_growFrames(stack);
+    stack->frames[stack->frameCount++] = (EvalFrame){ .node = node, .step = 0 };
+}
 
-        // Equality operations
-        if ((strcmp(node->operator, "==") == 0)){ return eval_makeResultInt((l.integer == r.integer)? 1 : 0); }
-        if ((strcmp(node->operator, "!=") == 0)){ return eval_makeResultInt((l.integer != r.integer)? 1 : 0); }
+// ------------------------------------------
+// Nodes
+// ------------------------------------------
 
-        // Logical operations
-        if ((strcmp(node->operator, "&&") == 0)){ return eval_makeResultInt((l.integer && r.integer)? 1 : 0); }
-        if ((strcmp(node->operator, "||") == 0)){ return eval_makeResultInt((l.integer || r.integer)? 1 : 0); }
+inline bool eval_direct(SyntaxNode* node, SimplicValue* res, ControlState* control, SimplicError* error) {
+    // Leaves don't need a frame, their value is known right away
+    if (EVAL_IS_LEAF(node)) {
+        *res = eval_leaf(node, control, error);
+        return true;
     }
-    if(node->type == NODE_ASSIGN){
-        SimplicValue val = eval(node->subnodeB, error);
-        if (error->hasError) return eval_makeError_keepErrInfo(error);
-
-        if (val.type == VALUE_INT) {
-            insertInt(node->varName, val.integer);
-        } else if (val.type == VALUE_STR) {
-            insertStr(node->varName, val.string);
-            free(val.string);
+
+    // Neither do operations on two leaves, which are most of them
+    if (node->type == NODE_BIN_OP && EVAL_IS_LEAF(node->subnodeA) && EVAL_IS_LEAF(node->subnodeB)) {
+        SimplicValue l = eval_leaf(node->subnodeA, control, error);
+        if (error->hasError) {
+            *res = l;
+            return true;
+        }
+        SimplicValue r = eval_leaf(node->subnodeB, control, error);
+        if (error->hasError) {
+            if (l.type == VALUE_STR) free(l.string);
+            *res = r;
+            return true;
         }
-        return eval_makeResultVoid();
+        *res = eval_binOp(node, l, r, error);
+        return true;
     }
-    if(node->type == NODE_UNASSIGN){
-        deleteVariable(node->varName, error);
-        if (error->hasError) return eval_makeError_keepErrInfo(error);
-        return eval_makeResultVoid();
+    return false;
+}
+
+inline bool eval_directStatement(SyntaxNode* node, SimplicValue* res, ControlState* control, SimplicError* error) {
+    SimplicValue val;
+
+    switch (node->type) {
+        case NODE_UNASSIGN:
+            deleteVariable(control->bank, node->varName, error);
+            *res = eval_makeResultVoid();
+            return true;
+
+        case NODE_ASSIGN:
+        case NODE_PRINT:
+        case NODE_PRINTLN:
+        case NODE_INCREMENT:
+        case NODE_DECREMENT:
+            if (!eval_direct(node->subnodeB, &val, control, error)) return false;
+            *res = error->hasError ? val : eval_statement(node, val, control, error);
+            return true;
+
+        default:
+            return false; // Loops, conditionals and RETURN always get a frame
     }
-    if(node->type == NODE_PRINT || node->type == NODE_PRINTLN){
-        SimplicValue val = eval(node->subnodeB, error);
-        if (error->hasError) return eval_makeError_keepErrInfo(error);
-        const char* delimiter = (node->type == NODE_PRINTLN)? "\n" : ""; // Add \n if PRINTLN
-
-        if (val.type == VALUE_INT) {
-            printf("%d%s", val.integer, delimiter);
-        } else if (val.type == VALUE_STR) {
-            printf("%s%s", val.string, delimiter);
-            free(val.string);
-        }
-        return eval_makeResultVoid();
+}
+
+SimplicValue eval_leaf(SyntaxNode* node, ControlState* control, SimplicError* error) {
+    if(node->type == NODE_NUMBER) return eval_makeResultInt(node->numberValue);
+    if(node->type == NODE_STRING) return eval_makeResultStr(node->string);
+
+    // One lookup gives both the type and the value of the variable
+    MemoryCell* cell = getCell(control->bank, node->varName, error);
+    if (cell == NULL) return eval_makeError_keepErrInfo(error); // Requested var was not initialized
+    if (cell->strPtr == NULL) return eval_makeResultInt(cell->value);
+    return eval_makeResultStr(cell->strPtr);
+}
+
+QuickForm eval_quickForm(const char* operator) {
+    static const struct { const char* operator; QuickForm form; } table[] = {
+        { "+", QUICK_ADD }, { "-", QUICK_SUB }, { "*", QUICK_MUL }, { "/", QUICK_DIV }, { "%", QUICK_MOD },
+        { "<", QUICK_LT }, { "<=", QUICK_LEQ }, { ">", QUICK_GT }, { ">=", QUICK_GEQ },
+        { "==", QUICK_EQ }, { "!=", QUICK_NEQ }, { "&&", QUICK_AND }, { "||", QUICK_OR }
+    };
+
+    for (unsigned int i = 0; i < sizeof(table) / sizeof(table[0]); i++) {
+        if (strcmp(table[i].operator, operator) == 0) return table[i].form;
     }
-    if(node->type == NODE_RETURN){
-        SimplicValue val = eval(node->subnodeB, error);
-        if (error->hasError) return eval_makeError_keepErrInfo(error);
-        
-        if (val.type == VALUE_INT) {
-            return eval_returnInt(val.integer); // Sets a flag indicating that the last instruction was a return, used to stop eval()
-        } else if (val.type == VALUE_STR) {
-            return eval_returnStr(val.string);
+    return QUICK_GENERIC;
+}
+
+SimplicValue eval_binOp(SyntaxNode* node, SimplicValue l, SimplicValue r, SimplicError* error) {
+    if (node->quick > QUICK_GENERIC) {
+        // Quickened site, the only check left is that both operands are still integers
+        if (l.type == VALUE_INT && r.type == VALUE_INT) {
+            switch ((QuickForm)node->quick) {
+                case QUICK_ADD: return eval_makeResultInt(l.integer + r.integer);
+                case QUICK_SUB: return eval_makeResultInt(l.integer - r.integer);
+                case QUICK_MUL: return eval_makeResultInt(l.integer * r.integer);
+                case QUICK_DIV:
+                    if (r.integer == 0) return eval_makeError(error, ERROR_DIVISION_BY_ZERO, "Division by 0, execution halted");
+                    return eval_makeResultInt(l.integer / r.integer);
+                case QUICK_MOD:
+                    if (r.integer == 0) return eval_makeError(error, ERROR_DIVISION_BY_ZERO, "Division by 0, execution halted");
+                    return eval_makeResultInt(l.integer % r.integer);
+                case QUICK_LT: return eval_makeResultInt(l.integer < r.integer);
+                case QUICK_LEQ: return eval_makeResultInt(l.integer <= r.integer);
+                case QUICK_GT: return eval_makeResultInt(l.integer > r.integer);
+                case QUICK_GEQ: return eval_makeResultInt(l.integer >= r.integer);
+                case QUICK_EQ: return eval_makeResultInt(l.integer == r.integer);
+                case QUICK_NEQ: return eval_makeResultInt(l.integer != r.integer);
+                case QUICK_AND: return eval_makeResultInt(l.integer && r.integer);
+                case QUICK_OR: return eval_makeResultInt(l.integer || r.integer);
+                default: break;
+            }
         }
+        node->quick = QUICK_GENERIC; // A string showed up, deoptimize for good
+    } else if (node->quick == QUICK_UNSEEN) {
+        // First run, specialize the site if it starts with two integers
+        node->quick = (l.type == VALUE_INT && r.type == VALUE_INT) ? eval_quickForm(node->operator) : QUICK_GENERIC;
     }
+    return eval_binOpGeneric(node, l, r, error);
+}
 
-    if(node->type == NODE_INCREMENT){
-        SimplicValue val = eval(node->subnodeB, error);
+SimplicValue eval_binOpGeneric(SyntaxNode* node, SimplicValue l, SimplicValue r, SimplicError* error) {
+    // String concat
+    if (l.type == VALUE_STR && r.type == VALUE_STR &&  (strcmp(node->operator, "+") == 0)) {
+        int len = strlen(l.string) + strlen(r.string);
+        char* buffer = malloc(sizeof(char)*(len+1));
+        snprintf(buffer, len+1, "%s%s", l.string, r.string);
+        
+        SimplicValue res = eval_makeResultStr(buffer);
+        free(buffer);
+        free(l.string); // We are done using the string values, so we free them
+        free(r.string);
+        return res;
+    }
 
-        if(val.type == VALUE_INT) {
-            if (error->hasError) return eval_makeError_keepErrInfo(error);
+    // String and number concat
+    if (l.type == VALUE_STR && r.type == VALUE_INT && (strcmp(node->operator, "+") == 0)) {
+        int len = strlen(l.string) + CHARS_FOR_INT_TO_STRING;
+        char* buffer = malloc(sizeof(char)*(len+1));
+        snprintf(buffer, len+1, "%s%d", l.string, r.integer);
 
-            val.integer++;
-            insertInt(node->subnodeB->varName, val.integer);
-        }
-        return eval_makeResultVoid();
+        SimplicValue res = eval_makeResultStr(buffer);
+        free(buffer);
+        free(l.string);
+        return res;
     }
 
-    if(node->type == NODE_DECREMENT){
-        SimplicValue val = eval(node->subnodeB, error);
+    if(l.type == VALUE_INT && r.type == VALUE_STR && (strcmp(node->operator, "+") == 0)) {
+        int len = strlen(r.string) + CHARS_FOR_INT_TO_STRING;
+        char* buffer = malloc(sizeof(char)*(len+1));
+        snprintf(buffer, len+1, "%d%s", l.integer, r.string);
 
-        if(val.type == VALUE_INT) {
-            if (error->hasError) return eval_makeError_keepErrInfo(error);
+        SimplicValue res = eval_makeResultStr(buffer);
+        free(buffer);
+        free(r.string);
+        return res;
+    }
 
-            val.integer--;
-            insertInt(node->subnodeB->varName, val.integer);
+    // Strings count as 0 from here on, they are no longer needed
+    if (l.type == VALUE_STR) free(l.string);
+    if (r.type == VALUE_STR) free(r.string);
+
+    // Arithmetic operations
+    if ((strcmp(node->operator, "+") == 0)) return eval_makeResultInt(l.integer + r.integer);
+    if ((strcmp(node->operator, "-") == 0)) return eval_makeResultInt(l.integer - r.integer);
+    if ((strcmp(node->operator, "*") == 0)) return eval_makeResultInt(l.integer * r.integer);
+    if ((strcmp(node->operator, "/") == 0)) {
+        if(r.integer == 0){
+            return eval_makeError(error, ERROR_DIVISION_BY_ZERO, "Division by 0, execution halted");
+        } else {
+            return eval_makeResultInt(l.integer / r.integer);
         }
-        return eval_makeResultVoid();
     }
-
-    // Executes all the statements inside a code block, these are stores in a null-delimited array of ASTs
-    if (node->type == NODE_BLOCK) {
-        int i = 0;
-        while (node->blockStatements[i] != NULL) {
-            SimplicValue res = eval(node->blockStatements[i++], error);
-            if (error->hasError) return eval_makeError_keepErrInfo(error);
-            if (res.receivedReturn) return res; // Propagate RETURN
+    if ((strcmp(node->operator, "%") == 0)) {
+        if(r.integer == 0){
+            return eval_makeError(error, ERROR_DIVISION_BY_ZERO, "Division by 0, execution halted");
+        } else {
+            return eval_makeResultInt(l.integer % r.integer);
         }
-        return eval_makeResultVoid();
     }
 
-    // Executes a code block while condition evaluates true
-    if (node->type == NODE_WHILE) {
-        while (1) {
-            SimplicValue cond = eval(node->subnodeA, error); // Condition
-            if (error->hasError) return eval_makeError_keepErrInfo(error);
-            if (cond.type != VALUE_INT)
-                return eval_makeError(error, ERROR_TYPE_MISMATCH, "WHILE condition must be integer");
-            if (!cond.integer) break;
-
-            SimplicValue body = eval(node->subnodeB, error); // Body
-            if (error->hasError) return eval_makeError_keepErrInfo(error);
-            if (body.receivedReturn) return body; // Propagate RETURN
+    // Relational operations
+    if ((strcmp(node->operator, "<") == 0)){ return eval_makeResultInt((l.integer < r.integer)? 1 : 0); }
+    if ((strcmp(node->operator, "<=") == 0)){ return eval_makeResultInt((l.integer <= r.integer)? 1 : 0); }
+    if ((strcmp(node->operator, ">") == 0)){ return eval_makeResultInt((l.integer > r.integer)? 1 : 0); }
+    if ((strcmp(node->operator, ">=") == 0)){ return eval_makeResultInt((l.integer >= r.integer)? 1 : 0); }
+
+    // Equality operations
+    if ((strcmp(node->operator, "==") == 0)){ return eval_makeResultInt((l.integer == r.integer)? 1 : 0); }
+    if ((strcmp(node->operator, "!=") == 0)){ return eval_makeResultInt((l.integer != r.integer)? 1 : 0); }
+
+    // Logical operations
+    if ((strcmp(node->operator, "&&") == 0)){ return eval_makeResultInt((l.integer && r.integer)? 1 : 0); }
+    if ((strcmp(node->operator, "||") == 0)){ return eval_makeResultInt((l.integer || r.integer)? 1 : 0); }
+
+    return eval_makeError(error, ERROR_MISC, "Unknown operator: %s", node->operator);
+}
+
+// Runs the statement on top of the stack once its operand has been computed
+SimplicValue eval_statement(SyntaxNode* node, SimplicValue val, ControlState* control, SimplicError* error) {
+    switch (node->type) {
+        case NODE_ASSIGN:
+            if (val.type == VALUE_INT) {
+                insertInt(control->bank, node->varName, val.integer);
+            } else if (val.type == VALUE_STR) {
+                insertStr(control->bank, node->varName, val.string);
+                free(val.string);
+            }
+            return eval_makeResultVoid();
+
+        case NODE_PRINT:
+        case NODE_PRINTLN: {
+            const char* delimiter = (node->type == NODE_PRINTLN)? "\n" : ""; // Add \n if PRINTLN
+            if (val.type == VALUE_INT) {
+                fprintf(control->out, "%d%s", val.integer, delimiter);
+            } else if (val.type == VALUE_STR) {
+                fprintf(control->out, "%s%s", val.string, delimiter);
+                free(val.string);
+            }
+            return eval_makeResultVoid();
         }
-        return eval_makeResultVoid();
+
+        case NODE_INCREMENT:
+        case NODE_DECREMENT:
+            if(val.type == VALUE_INT) {
+                val.integer += (node->type == NODE_INCREMENT) ? 1 : -1;
+                insertInt(control->bank, node->subnodeB->varName, val.integer);
+            } else if (val.type == VALUE_STR) {
+                free(val.string); // Strings are left untouched
+            }
+            return eval_makeResultVoid();
+
+        default:
+            return eval_makeError(error, ERROR_MISC, "Tried to evaluate unknown node of type: %d", node->type);
     }
+}
+
+// Every node on the way down gets a frame in a heap stack instead of a C call, so the
+// depth of the tree is only limited by memory. A frame's step tells which of its children
+// have already been evaluated. The value of the last finished node is kept in acc, only
+// left operands that wait for their right side go to the value stack. Children that can be
+// computed without a frame of their own are evaluated in place and the frame keeps going
+SimplicValue eval(SyntaxNode* node, ControlState* control, SimplicError* error) { 
+    if(error->hasError) return eval_makeError_keepErrInfo(error);
+
+    EvalStack stack;
+    SimplicValue acc = eval_makeResultVoid();
+    eval_initStack(&stack);
+    if (!eval_direct(node, &acc, control, error) && !eval_directStatement(node, &acc, control, error))
+        eval_pushFrame(&stack, node);
+
+    while (stack.frameCount > 0 && !error->hasError) {
+        EvalFrame* frame = &stack.frames[stack.frameCount - 1];
+        SyntaxNode* current = frame->node;
+        SimplicValue r;
+
+        switch (current->type) {
+            case NODE_BIN_OP:
+                if (frame->step == 0) {
+                    frame->step = 1;
+                    if (!eval_direct(current->subnodeA, &acc, control, error)) {
+                        eval_pushFrame(&stack, current->subnodeA);
+                        break;
+                    }
+                    if (error->hasError) break;
+                }
+                if (frame->step == 1) {
+                    // acc holds the left operand
+                    if (!eval_direct(current->subnodeB, &r, control, error)) {
+                        frame->step = 2;
+                        eval_pushValue(&stack, acc);
+                        eval_pushFrame(&stack, current->subnodeB);
+                        break;
+                    }
+                    if (error->hasError) {
+                        if (acc.type == VALUE_STR) free(acc.string);
+                        acc = r;
+                        break;
+                    }
+                    stack.frameCount--;
+                    acc = eval_binOp(current, acc, r, error);
+                    break;
+                }
+
+                // The right operand comes from its own frame
+                stack.frameCount--;
+                acc = eval_binOp(current, eval_popValue(&stack), acc, error);
+                break;
+
+            case NODE_UNASSIGN:
+                stack.frameCount--;
+                deleteVariable(control->bank, current->varName, error);
+                acc = eval_makeResultVoid();
+                break;
+
+            case NODE_ASSIGN:
+            case NODE_PRINT:
+            case NODE_PRINTLN:
+            case NODE_INCREMENT:
+            case NODE_DECREMENT:
+            case NODE_RETURN:
+                if (frame->step == 0) {
+                    frame->step = 1;
+                    if (!eval_direct(current->subnodeB, &acc, control, error)) {
+                        eval_pushFrame(&stack, current->subnodeB);
+                        break;
+                    }
+                    if (error->hasError) break;
+                }
+
+                if (current->type == NODE_RETURN) {
+                    // Leaves the whole program at once, acc holds the value
+                    control->returned = true;
+                    eval_unwind(&stack);
+                    break;
+                }
+                stack.frameCount--;
+                acc = eval_statement(current, acc, control, error);
+                break;
+
+            // Executes all the statements inside a code block, these are stores in a null-delimited array of ASTs.
+            // Simple statements run right here, the rest get their own frame and the block resumes after them
+            case NODE_BLOCK: {
+                bool waiting = false;
+                while (!waiting && !error->hasError && current->blockStatements[frame->step] != NULL) {
+                    SyntaxNode* statement = current->blockStatements[frame->step++];
+                    if (!eval_directStatement(statement, &acc, control, error)) {
+                        eval_pushFrame(&stack, statement);
+                        waiting = true;
+                    }
+                }
+                if (waiting || error->hasError) break;
+
+                stack.frameCount--;
+                acc = eval_makeResultVoid();
+                break;
+            }
 
-    // Executes a code block if the condition is true; if it's false and there's another code block, execute that one
-    if (node->type == NODE_IF) {
-        SimplicValue cond = eval(node->subnodeA, error); // Condition
-        if (error->hasError) return eval_makeError_keepErrInfo(error);
-        if (cond.type != VALUE_INT)
-                return eval_makeError(error, ERROR_TYPE_MISMATCH, "IF condition must be integer");
-
-        if (cond.integer) {
-            SimplicValue body = eval(node->subnodeB, error);
-            if (error->hasError) return eval_makeError_keepErrInfo(error);
-            if (body.receivedReturn) return body; // Propagate RETURN
-        } else if(node->subnodeC != NULL) {
-            // There is an ELSE block
-            SimplicValue body = eval(node->subnodeC, error);
-            if (error->hasError) return eval_makeError_keepErrInfo(error);
-            if (body.receivedReturn) return body; // Propagate RETURN
+            // Executes a code block while condition evaluates true
+            case NODE_WHILE:
+                if (frame->step != 1) { // First time, or the body has just finished
+                    frame->step = 1;
+                    if (!eval_direct(current->subnodeA, &acc, control, error)) { // Condition
+                        eval_pushFrame(&stack, current->subnodeA);
+                        break;
+                    }
+                    if (error->hasError) break;
+                }
+
+                if (acc.type != VALUE_INT) {
+                    free(acc.string);
+                    acc = eval_makeError(error, ERROR_TYPE_MISMATCH, "WHILE condition must be integer");
+                } else if (!acc.integer) {
+                    stack.frameCount--;
+                    acc = eval_makeResultVoid();
+                } else {
+                    frame->step = 2;
+                    eval_pushFrame(&stack, current->subnodeB); // Body
+                }
+                break;
+
+            // Executes a code block if the condition is true; if it's false and there's another code block, execute that one
+            case NODE_IF:
+                if (frame->step == 2) {
+                    stack.frameCount--; // The value of the branch is the value of the IF
+                    break;
+                }
+                if (frame->step == 0) {
+                    frame->step = 1;
+                    if (!eval_direct(current->subnodeA, &acc, control, error)) { // Condition
+                        eval_pushFrame(&stack, current->subnodeA);
+                        break;
+                    }
+                    if (error->hasError) break;
+                }
+
+                SyntaxNode* branch = acc.integer ? current->subnodeB : current->subnodeC;
+                if (acc.type != VALUE_INT) {
+                    free(acc.string);
+                    acc = eval_makeError(error, ERROR_TYPE_MISMATCH, "IF condition must be integer");
+                } else if (branch == NULL) {
+                    // False condition and no ELSE block
+                    stack.frameCount--;
+                    acc = eval_makeResultVoid();
+                } else {
+                    frame->step = 2;
+                    eval_pushFrame(&stack, branch);
+                }
+                break;
+
+            default:
+                acc = eval_makeError(error, ERROR_MISC, "Tried to evaluate unknown node of type: %d", current->type);
+                break;
         }
-        return eval_makeResultVoid();
     }
 
-    return eval_makeError(error, ERROR_MISC, "Tried to evaluate unknown node of type: %d", node->type);
+    if (error->hasError && acc.type == VALUE_STR) free(acc.string);
+    eval_deleteStack(&stack);
+    return error->hasError ? eval_makeError_keepErrInfo(error) : acc;
 }
@@ -7,17 +7,20 @@
 
 Token* tokenList;
 SimplicError* error;
+ControlState control;
 SyntaxNode* tree;
 
 void setUp(void) {
+    control.returned = false;
     tokenList = initTokenQueue();
-    initMemoryBank();
+    control.bank = initMemoryBank();
+    control.out = stdout;
     error = initError();
 }
 
 void tearDown(void) {
     deleteTokenQueue(&tokenList);
-    deleteMemoryBank();
+    deleteMemoryBank(&control.bank);
     deleteError(&error);
 }
 
@@ -33,9 +36,9 @@ void testReturnCorrectInt(void) {
     while(!end){
         tokenizeSource(&tokenList, program, error);
         tree = parseTokenList(&tokenList, error);
-        val = eval(tree, error);
+        val = eval(tree, &control, error);
 
-        if(val.receivedReturn || error->hasError)
+        if(control.returned || error->hasError)
             end = true;
 
         freeSyntaxTree(tree);
@@ -58,9 +61,9 @@ void testComplexOperations(void) {
     while(!end){
         tokenizeSource(&tokenList, program, error);
         tree = parseTokenList(&tokenList, error);
-        val = eval(tree, error);
+        val = eval(tree, &control, error);
 
-        if(val.receivedReturn || error->hasError)
+        if(control.returned || error->hasError)
             end = true;
 
         freeSyntaxTree(tree);
@@ -75,13 +78,12 @@ void accessToUndeclaredVariable(void) {
         "SET X = X\n";
 
     bool end = false;
-    SimplicValue val;
     while(!end){
         tokenizeSource(&tokenList, program, error);
         tree = parseTokenList(&tokenList, error);
-        val = eval(tree, error);
+        eval(tree, &control, error);
 
-        if(val.receivedReturn || error->hasError) 
+        if(control.returned || error->hasError) 
             end = true;
 
         freeSyntaxTree(tree);
@@ -98,13 +100,12 @@ void divisionByZero(void) {
         "PRINT Z = X\n"; // <-- CHECK THIS
 
     bool end = false;
-    SimplicValue val;
     while(!end){
         tokenizeSource(&tokenList, program, error);
         tree = parseTokenList(&tokenList, error);
-        val = eval(tree, error);
+        eval(tree, &control, error);
 
-        if(val.receivedReturn || error->hasError) 
+        if(control.returned || error->hasError) 
             end = true;
 
         freeSyntaxTree(tree);
@@ -124,9 +125,9 @@ void stringConcatenation(void) {
     while(!end){
         tokenizeSource(&tokenList, program, error);
         tree = parseTokenList(&tokenList, error);
-        val = eval(tree, error);
+        val = eval(tree, &control, error);
 
-        if(val.receivedReturn || error->hasError) 
+        if(control.returned || error->hasError) 
             end = true;
 
         freeSyntaxTree(tree);
@@ -148,9 +149,9 @@ void stringAndNumberConcatenation(void) {
     while(!end){
         tokenizeSource(&tokenList, program, error);
         tree = parseTokenList(&tokenList, error);
-        val = eval(tree, error);
+        val = eval(tree, &control, error);
 
-        if(val.receivedReturn || error->hasError) 
+        if(control.returned || error->hasError) 
             end = true;
 
         freeSyntaxTree(tree);
@@ -172,9 +173,9 @@ void relationalOperationsGreater(void) {
     while(!end){
         tokenizeSource(&tokenList, program, error);
         tree = parseTokenList(&tokenList, error);
-        val = eval(tree, error);
+        val = eval(tree, &control, error);
 
-        if(val.receivedReturn || error->hasError) 
+        if(control.returned || error->hasError) 
             end = true;
 
         freeSyntaxTree(tree);
@@ -194,9 +195,9 @@ void relationalOperationsLower(void) {
     while(!end){
         tokenizeSource(&tokenList, program, error);
         tree = parseTokenList(&tokenList, error);
-        val = eval(tree, error);
+        val = eval(tree, &control, error);
 
-        if(val.receivedReturn || error->hasError) 
+        if(control.returned || error->hasError) 
             end = true;
 
         freeSyntaxTree(tree);
@@ -216,9 +217,9 @@ void equalityOperationsEqual(void) {
     while(!end){
         tokenizeSource(&tokenList, program, error);
         tree = parseTokenList(&tokenList, error);
-        val = eval(tree, error);
+        val = eval(tree, &control, error);
 
-        if(val.receivedReturn || error->hasError) 
+        if(control.returned || error->hasError) 
             end = true;
 
         freeSyntaxTree(tree);
@@ -238,9 +239,9 @@ void equalityOperationsNotEqual(void) {
     while(!end){
         tokenizeSource(&tokenList, program, error);
         tree = parseTokenList(&tokenList, error);
-        val = eval(tree, error);
+        val = eval(tree, &control, error);
 
-        if(val.receivedReturn || error->hasError) 
+        if(control.returned || error->hasError) 
             end = true;
 
         freeSyntaxTree(tree);
@@ -262,9 +263,9 @@ void logicalOperatorsAndOr(void) {
     while(!end){
         tokenizeSource(&tokenList, program, error);
         tree = parseTokenList(&tokenList, error);
-        val = eval(tree, error);
+        val = eval(tree, &control, error);
 
-        if(val.receivedReturn || error->hasError) 
+        if(control.returned || error->hasError) 
             end = true;
 
         freeSyntaxTree(tree);
@@ -281,13 +282,12 @@ void unsetVariable(void) {
         "RETURN X\n";
 
     bool end = false;
-    SimplicValue val;
     while(!end){
         tokenizeSource(&tokenList, program, error);
         tree = parseTokenList(&tokenList, error);
-        val = eval(tree, error);
+        eval(tree, &control, error);
 
-        if(val.receivedReturn || error->hasError) 
+        if(control.returned || error->hasError) 
             end = true;
 
         freeSyntaxTree(tree);
@@ -309,9 +309,9 @@ void whileLoop(void) {
     while(!end){
         tokenizeSource(&tokenList, program, error);
         tree = parseTokenList(&tokenList, error);
-        val = eval(tree, error);
+        val = eval(tree, &control, error);
 
-        if(val.receivedReturn || error->hasError) 
+        if(control.returned || error->hasError) 
             end = true;
 
         freeSyntaxTree(tree);
@@ -342,9 +342,9 @@ void nestedWhileLoop(void) {
     while(!end){
         tokenizeSource(&tokenList, program, error);
         tree = parseTokenList(&tokenList, error);
-        val = eval(tree, error);
+        val = eval(tree, &control, error);
 
-        if(val.receivedReturn || error->hasError) 
+        if(control.returned || error->hasError) 
             end = true;
 
         freeSyntaxTree(tree);
@@ -368,9 +368,9 @@ void ifStatement(void) {
     while(!end){
         tokenizeSource(&tokenList, program, error);
         tree = parseTokenList(&tokenList, error);
-        val = eval(tree, error);
+        val = eval(tree, &control, error);
 
-        if(val.receivedReturn || error->hasError) 
+        if(control.returned || error->hasError) 
             end = true;
 
         freeSyntaxTree(tree);
@@ -394,9 +394,9 @@ void elseStatement(void) {
     while(!end){
         tokenizeSource(&tokenList, program, error);
         tree = parseTokenList(&tokenList, error);
-        val = eval(tree, error);
+        val = eval(tree, &control, error);
 
-        if(val.receivedReturn || error->hasError) 
+        if(control.returned || error->hasError) 
             end = true;
 
         freeSyntaxTree(tree);
@@ -423,9 +423,9 @@ void returnFromNested(void) {
     while(!end){
         tokenizeSource(&tokenList, program, error);
         tree = parseTokenList(&tokenList, error);
-        val = eval(tree, error);
+        val = eval(tree, &control, error);
 
-        if(val.receivedReturn || error->hasError) 
+        if(control.returned || error->hasError) 
             end = true;
 
         freeSyntaxTree(tree);
@@ -435,6 +435,66 @@ void returnFromNested(void) {
     TEST_ASSERT_EQUAL_INT(0, val.integer);
 }
 
+// Trees can nest far deeper than the parser allows (MAX_EXPRESSION_DEPTH), neither eval() nor freeSyntaxTree() recurse
+void deeplyNestedExpression(void) {
+    const int depth = 200000;
+    insertInt(control.bank, "X", 5);
+
+    // X + 1 + 1 + ... , nested to the left like the parser does
+    SyntaxNode* expr = initNode();
+    expr->type = NODE_VAR;
+    strcpy(expr->varName, "X");
+    for (int i = 0; i < depth; i++) {
+        SyntaxNode* one = initNode();
+        one->type = NODE_NUMBER;
+        one->numberValue = 1;
+
+        SyntaxNode* add = initNode();
+        add->type = NODE_BIN_OP;
+        strcpy(add->operator, "+");
+        add->subnodeA = expr;
+        add->subnodeB = one;
+        expr = add;
+    }
+
+    SimplicValue val = eval(expr, &control, error);
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(5 + depth, val.integer);
+
+    freeSyntaxTree(expr);
+}
+
+// Bin_op sites are rewritten to their int-int form and go back to the generic one when a string shows up
+void quickeningAndDeoptimization(void) {
+    const char* program =
+        "SET I = 0\n"
+        "SET S = 0\n"
+        "WHILE I LT 3 DO\n"
+            "IF I EQ 2 THEN\n"
+                "SET S = \"A\"\n"
+            "FI\n"
+            "SET R = S + 1\n"
+            "INCR I\n"
+        "DONE\n"
+        "RETURN R\n";
+
+    tokenizeSource(&tokenList, program, error);
+    tree = parseProgram(&tokenList, error);
+    SyntaxNode* loop = tree->blockStatements[2];
+    SyntaxNode* condition = loop->subnodeA;
+    SyntaxNode* addition = loop->subnodeB->blockStatements[1]->subnodeB;
+    TEST_ASSERT_EQUAL_INT(QUICK_UNSEEN, addition->quick);
+
+    SimplicValue val = eval(tree, &control, error);
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_EQUAL_STRING("A1", val.string);
+    TEST_ASSERT_EQUAL_INT(QUICK_LT, condition->quick);
+    TEST_ASSERT_EQUAL_INT(QUICK_GENERIC, addition->quick);
+
+    free(val.string);
+    freeSyntaxTree(tree);
+}
+
 int main(void) {
     UNITY_BEGIN();
     RUN_TEST(testReturnCorrectInt);
@@ -454,5 +514,7 @@ int main(void) {
     RUN_TEST(ifStatement);
     RUN_TEST(elseStatement);
     RUN_TEST(returnFromNested);
+    RUN_TEST(deeplyNestedExpression);
+    RUN_TEST(quickeningAndDeoptimization);
     return UNITY_END();
 }
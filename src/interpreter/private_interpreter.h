@@ -3,13 +3,74 @@
 
 #include "interpreter.h"
 
+#define EVAL_INLINE_DEPTH 16 // Frames and values kept inside eval() before moving to the heap
+#define EVAL_IS_LEAF(node) ((node)->type == NODE_NUMBER || (node)->type == NODE_STRING || (node)->type == NODE_VAR)
+
+// Forms a bin_op node can be rewritten into by eval(). Each site starts unseen, becomes an
+// int-int form if its first operands are integers and goes back to generic for good once
+// it sees a string
+typedef enum {
+    QUICK_UNSEEN,
+    QUICK_GENERIC,
+    QUICK_ADD,
+    QUICK_SUB,
+    QUICK_MUL,
+    QUICK_DIV,
+    QUICK_MOD,
+    QUICK_LT,
+    QUICK_LEQ,
+    QUICK_GT,
+    QUICK_GEQ,
+    QUICK_EQ,
+    QUICK_NEQ,
+    QUICK_AND,
+    QUICK_OR
+} QuickForm;
+
+// Node that is waiting for its children to be evaluated
+typedef struct EvalFrame EvalFrame;
+struct EvalFrame {
+    SyntaxNode* node;
+    int step; // Children already evaluated, or next statement for blocks
+};
+
+// Explicit stack used by eval() instead of recursion, it grows on the heap when needed
+typedef struct EvalStack EvalStack;
+struct EvalStack {
+    EvalFrame* frames;
+    int frameCount;
+    int frameCapacity;
+    SimplicValue* values; // Left operands waiting for their right side
+    int valueCount;
+    int valueCapacity;
+    EvalFrame inlineFrames[EVAL_INLINE_DEPTH];
+    SimplicValue inlineValues[EVAL_INLINE_DEPTH];
+};
+
 // Wrapper functions for eval()
 static SimplicValue eval_makeResultInt(int n);
 static SimplicValue eval_makeResultStr(char* s);
 static SimplicValue eval_makeResultVoid(); // For empty results such as the one from PRINT
 static SimplicValue eval_makeError(SimplicError* err, SimplicErrorType code, const char* fmt, ...);
 static SimplicValue eval_makeError_keepErrInfo(SimplicError* err);
-static SimplicValue eval_returnInt(int n); // Exits from the interpreter
-static SimplicValue eval_returnStr(char* s);
 
-#endif
\ No newline at end of file
+// Work stack
+static void eval_initStack(EvalStack* stack);
+static void eval_deleteStack(EvalStack* stack); // Frees the heap arrays and any value left on the stack
+static void eval_unwind(EvalStack* stack); // Drops every frame and pending value, used by RETURN
+static void eval_growValues(EvalStack* stack); // Moves the stack to the heap or doubles it
+static void eval_growFrames(EvalStack* stack);
+static inline void eval_pushValue(EvalStack* stack, SimplicValue val);
+static inline SimplicValue eval_popValue(EvalStack* stack);
+static inline void eval_pushFrame(EvalStack* stack, SyntaxNode* node);
+
+// Nodes
+static inline bool eval_direct(SyntaxNode* node, SimplicValue* res, ControlState* control, SimplicError* error); // Value of nodes that need no frame, false otherwise
+static SimplicValue eval_leaf(SyntaxNode* node, ControlState* control, SimplicError* error); // Numbers, strings and variables
+static SimplicValue eval_binOp(SyntaxNode* node, SimplicValue l, SimplicValue r, SimplicError* error); // Quickens the node as it goes
+static SimplicValue eval_binOpGeneric(SyntaxNode* node, SimplicValue l, SimplicValue r, SimplicError* error); // Any operand types
+static QuickForm eval_quickForm(const char* operator); // Int-int form of an operator
+static inline bool eval_directStatement(SyntaxNode* node, SimplicValue* res, ControlState* control, SimplicError* error); // Runs statements whose operand needs no frame
+static SimplicValue eval_statement(SyntaxNode* node, SimplicValue val, ControlState* control, SimplicError* error);
+
+#endif
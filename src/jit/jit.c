@@ -0,0 +1,528 @@
+#ifndef _DEFAULT_SOURCE
+    #define _DEFAULT_SOURCE // mmap() flags are not part of ISO C
+#endif
+#include "private_jit.h"
+
+#ifdef JIT_AVAILABLE
+
+#include <sys/mman.h>
+
+// x86-64 register numbers
+enum { RAX = 0, RCX = 1, RDX = 2, RBX = 3, RSI = 6, RDI = 7, R8 = 8, R9, R10, R11, R12, R13, R14, R15 };
+
+// rdi points to the slots, rax, rcx and rdx are scratch registers for the templates
+static const int allocatable[] = { RBX, R12, R13, R14, R15, RSI, R8, R9, R10, R11 };
+#define JIT_ALLOCATABLE (int)(sizeof(allocatable) / sizeof(allocatable[0]))
+
+bool jit_isConstant(VMProgram* program, int reg) {
+    return reg >= program->varCount && reg < program->varCount + program->constCount;
+}
+
+bool jit_canTranslate(VMProgram* program, int start, int end) {
+    for (int pc = start; pc <= end; pc++) {
+        Instruction ins = program->code[pc];
+        ins.opcode = genericOpcode(ins.opcode); // Native code only holds integers, int forms translate the same way
+        int reads[2] = { -1, -1 };
+
+        switch (ins.opcode) {
+            case OP_MOVE:
+                reads[0] = ins.b;
+                break;
+
+            case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV: case OP_MOD:
+            case OP_LT: case OP_LEQ: case OP_GT: case OP_GEQ: case OP_EQ: case OP_NEQ:
+            case OP_AND: case OP_OR:
+                reads[0] = ins.b;
+                reads[1] = ins.c;
+                break;
+
+            case OP_INCR:
+            case OP_DECR:
+                break;
+
+            case OP_JLT: case OP_JLEQ: case OP_JGT: case OP_JGEQ: case OP_JEQ: case OP_JNEQ:
+            case OP_JMODZ: case OP_JMODNZ:
+                reads[0] = ins.a;
+                reads[1] = ins.c;
+                if (ins.b < start || ins.b > end + 1) return false;
+                break;
+
+            case OP_JMPF:
+            case OP_JMPT:
+                reads[0] = ins.a;
+                // fall through
+            case OP_JMP:
+            case OP_JIT_LOOP: // Nested loop already translated, it's still a jump to its condition
+                if (ins.b < start || ins.b > end + 1) return false;
+                break;
+
+            default:
+                return false; // PRINT, RETURN, UNSET... stay in the bytecode
+        }
+
+        // String constants would make the loop work with strings
+        for (int i = 0; i < 2; i++) {
+            if (reads[i] >= 0 && jit_isConstant(program, reads[i]) && program->constants[reads[i] - program->varCount].type != VALUE_INT)
+                return false;
+        }
+    }
+    return true;
+}
+
+void jit_collectRegisters(JitCompiler* jc, JitLoop* loop) {
+    VMProgram* p = jc->program;
+    int* uses = calloc(p->registerCount, sizeof(int));
+    bool* written = calloc(p->registerCount, sizeof(bool));
+
+    for (int pc = jc->start; pc <= jc->end; pc++) {
+        Instruction ins = p->code[pc];
+        ins.opcode = genericOpcode(ins.opcode);
+        switch (ins.opcode) {
+            case OP_MOVE:
+                uses[ins.a]++;
+                uses[ins.b]++;
+                written[ins.a] = true;
+                break;
+
+            case OP_INCR:
+            case OP_DECR:
+                uses[ins.a] += 2;
+                written[ins.a] = true;
+                break;
+
+            case OP_JMPF:
+            case OP_JMPT:
+                uses[ins.a]++;
+                break;
+
+            case OP_JLT: case OP_JLEQ: case OP_JGT: case OP_JGEQ: case OP_JEQ: case OP_JNEQ:
+            case OP_JMODZ: case OP_JMODNZ:
+                uses[ins.a]++;
+                uses[ins.c]++;
+                break;
+
+            case OP_JMP:
+            case OP_JIT_LOOP:
+                break;
+
+            default: // Binary operations
+                uses[ins.a]++;
+                uses[ins.b]++;
+                uses[ins.c]++;
+                written[ins.a] = true;
+                break;
+        }
+    }
+
+    loop->guards = malloc(sizeof(int) * p->registerCount);
+    loop->loads = malloc(sizeof(int) * p->registerCount);
+    loop->writes = malloc(sizeof(int) * p->registerCount);
+
+    for (int r = 0; r < p->registerCount; r++) {
+        if (uses[r] == 0 || jit_isConstant(p, r)) {
+            uses[r] = 0; // Constants are immediate operands
+            continue;
+        }
+        loop->loads[loop->loadCount++] = r;
+        if (r < p->varCount) loop->guards[loop->guardCount++] = r;
+        if (written[r]) loop->writes[loop->writeCount++] = r;
+    }
+
+    // The most used registers of the loop are kept in CPU registers
+    for (int i = 0; i < JIT_ALLOCATABLE; i++) {
+        int best = -1;
+        for (int r = 0; r < p->registerCount; r++) {
+            if (uses[r] > 0 && jc->hostOf[r] < 0 && (best < 0 || uses[r] > uses[best])) best = r;
+        }
+        if (best < 0) break;
+        jc->hostOf[best] = allocatable[i];
+    }
+
+    free(uses);
+    free(written);
+}
+
+void jit_byte(JitCompiler* jc, uint8_t b) {
+    if (jc->size == jc->capacity) {
+        jc->capacity = (jc->capacity == 0) ? 256 : jc->capacity * 2;
+        jc->bytes = realloc(jc->bytes, jc->capacity);
+    }
+    jc->bytes[jc->size++] = b;
+}
+
+void jit_bytes(JitCompiler* jc, const uint8_t* b, int n) {
+    for (int i = 0; i < n; i++) jit_byte(jc, b[i]);
+}
+
+void jit_int32(JitCompiler* jc, int32_t n) {
+    uint32_t u = (uint32_t)n;
+    for (int i = 0; i < 4; i++) jit_byte(jc, (u >> (8 * i)) & 0xFF); // Little endian
+}
+
+void jit_patch32(JitCompiler* jc, size_t offset, int32_t n) {
+    uint32_t u = (uint32_t)n;
+    for (int i = 0; i < 4; i++) jc->bytes[offset + i] = (u >> (8 * i)) & 0xFF;
+}
+
+void jit_rex(JitCompiler* jc, int reg, int rm) {
+    if (reg >= 8 || rm >= 8) jit_byte(jc, 0x40 | ((reg >= 8) ? 0x04 : 0) | ((rm >= 8) ? 0x01 : 0));
+}
+
+// Slots are 4 bytes wide, the slot of register r is at [rdi + 4 * r]
+void jit_slotLoad(JitCompiler* jc, int host, int reg) {
+    jit_rex(jc, host, RDI);
+    jit_byte(jc, 0x8B); // mov host, [rdi + disp32]
+    jit_byte(jc, 0x80 | ((host & 7) << 3) | RDI);
+    jit_int32(jc, reg * 4);
+}
+
+void jit_slotStore(JitCompiler* jc, int reg, int host) {
+    jit_rex(jc, host, RDI);
+    jit_byte(jc, 0x89); // mov [rdi + disp32], host
+    jit_byte(jc, 0x80 | ((host & 7) << 3) | RDI);
+    jit_int32(jc, reg * 4);
+}
+
+void jit_load(JitCompiler* jc, int host, int reg) {
+    VMProgram* p = jc->program;
+
+    if (jit_isConstant(p, reg)) {
+        jit_rex(jc, 0, host);
+        jit_byte(jc, 0xB8 + (host & 7)); // mov host, imm32
+        jit_int32(jc, p->constants[reg - p->varCount].integer);
+    } else if (jc->hostOf[reg] >= 0) {
+        int src = jc->hostOf[reg];
+        jit_rex(jc, src, host);
+        jit_byte(jc, 0x89); // mov host, src
+        jit_byte(jc, 0xC0 | ((src & 7) << 3) | (host & 7));
+    } else {
+        jit_slotLoad(jc, host, reg);
+    }
+}
+
+void jit_store(JitCompiler* jc, int reg, int host) {
+    if (jc->hostOf[reg] >= 0) {
+        int dest = jc->hostOf[reg];
+        jit_rex(jc, host, dest);
+        jit_byte(jc, 0x89); // mov dest, host
+        jit_byte(jc, 0xC0 | ((host & 7) << 3) | (dest & 7));
+    } else {
+        jit_slotStore(jc, reg, host);
+    }
+}
+
+void jit_jump(JitCompiler* jc, const uint8_t* opcode, int n, int target, bool toExit) {
+    jit_bytes(jc, opcode, n);
+
+    if (jc->fixupCount == jc->fixupCapacity) {
+        jc->fixupCapacity = (jc->fixupCapacity == 0) ? 16 : jc->fixupCapacity * 2;
+        jc->fixups = realloc(jc->fixups, sizeof(JitFixup) * jc->fixupCapacity);
+    }
+    jc->fixups[jc->fixupCount++] = (JitFixup){ .offset = jc->size, .target = target, .toExit = toExit };
+    jit_int32(jc, 0); // rel32, patched later
+}
+
+void jit_instruction(JitCompiler* jc, int pc) {
+    static const uint8_t jmp[] = { 0xE9 };
+    static const uint8_t jz[] = { 0x0F, 0x84 };
+    static const uint8_t jnz[] = { 0x0F, 0x85 };
+    static const uint8_t testEax[] = { 0x85, 0xC0 };
+    static const uint8_t movzxEaxAl[] = { 0x0F, 0xB6, 0xC0 };
+    Instruction ins = jc->program->code[pc];
+    ins.opcode = genericOpcode(ins.opcode);
+
+    switch (ins.opcode) {
+        case OP_MOVE:
+            jit_load(jc, RAX, ins.b);
+            jit_store(jc, ins.a, RAX);
+            break;
+
+        case OP_ADD:
+        case OP_SUB:
+        case OP_MUL: {
+            static const uint8_t add[] = { 0x01, 0xC8 }; // add eax, ecx
+            static const uint8_t sub[] = { 0x29, 0xC8 }; // sub eax, ecx
+            static const uint8_t mul[] = { 0x0F, 0xAF, 0xC1 }; // imul eax, ecx
+            jit_load(jc, RAX, ins.b);
+            jit_load(jc, RCX, ins.c);
+            if (ins.opcode == OP_ADD) jit_bytes(jc, add, sizeof(add));
+            else if (ins.opcode == OP_SUB) jit_bytes(jc, sub, sizeof(sub));
+            else jit_bytes(jc, mul, sizeof(mul));
+            jit_store(jc, ins.a, RAX);
+            break;
+        }
+
+        case OP_DIV:
+        case OP_MOD: {
+            static const uint8_t testEcx[] = { 0x85, 0xC9 };
+            static const uint8_t cmpEcxMinusOne[] = { 0x83, 0xF9, 0xFF };
+            static const uint8_t idiv[] = { 0x99, 0xF7, 0xF9 }; // cdq, idiv ecx
+            jit_load(jc, RAX, ins.b);
+            jit_load(jc, RCX, ins.c);
+
+            // Divisors 0 and -1 go back to the bytecode, which reports the error with its usual message
+            jit_bytes(jc, testEcx, sizeof(testEcx));
+            jit_jump(jc, jz, sizeof(jz), pc, true);
+            jit_bytes(jc, cmpEcxMinusOne, sizeof(cmpEcxMinusOne));
+            jit_jump(jc, jz, sizeof(jz), pc, true);
+
+            jit_bytes(jc, idiv, sizeof(idiv));
+            jit_store(jc, ins.a, (ins.opcode == OP_DIV) ? RAX : RDX);
+            break;
+        }
+
+        case OP_LT: case OP_LEQ: case OP_GT: case OP_GEQ: case OP_EQ: case OP_NEQ: {
+            static const uint8_t cmp[] = { 0x39, 0xC8 }; // cmp eax, ecx
+            uint8_t setcc[] = { 0x0F, 0x00, 0xC0 }; // setcc al
+            switch (ins.opcode) {
+                case OP_LT: setcc[1] = 0x9C; break;
+                case OP_LEQ: setcc[1] = 0x9E; break;
+                case OP_GT: setcc[1] = 0x9F; break;
+                case OP_GEQ: setcc[1] = 0x9D; break;
+                case OP_EQ: setcc[1] = 0x94; break;
+                default: setcc[1] = 0x95; break;
+            }
+            jit_load(jc, RAX, ins.b);
+            jit_load(jc, RCX, ins.c);
+            jit_bytes(jc, cmp, sizeof(cmp));
+            jit_bytes(jc, setcc, sizeof(setcc));
+            jit_bytes(jc, movzxEaxAl, sizeof(movzxEaxAl));
+            jit_store(jc, ins.a, RAX);
+            break;
+        }
+
+        case OP_AND:
+        case OP_OR: {
+            // al = eax != 0, cl = ecx != 0, then the logical operation is done on bytes
+            static const uint8_t toBool[] = { 0x85, 0xC0, 0x0F, 0x95, 0xC0, 0x85, 0xC9, 0x0F, 0x95, 0xC1 };
+            static const uint8_t andAlCl[] = { 0x20, 0xC8 };
+            static const uint8_t orAlCl[] = { 0x08, 0xC8 };
+            jit_load(jc, RAX, ins.b);
+            jit_load(jc, RCX, ins.c);
+            jit_bytes(jc, toBool, sizeof(toBool));
+            jit_bytes(jc, (ins.opcode == OP_AND) ? andAlCl : orAlCl, 2);
+            jit_bytes(jc, movzxEaxAl, sizeof(movzxEaxAl));
+            jit_store(jc, ins.a, RAX);
+            break;
+        }
+
+        case OP_INCR:
+        case OP_DECR: {
+            static const uint8_t inc[] = { 0x83, 0xC0, 0x01 }; // add eax, 1
+            static const uint8_t dec[] = { 0x83, 0xE8, 0x01 }; // sub eax, 1
+            jit_load(jc, RAX, ins.a);
+            jit_bytes(jc, (ins.opcode == OP_INCR) ? inc : dec, 3);
+            jit_store(jc, ins.a, RAX);
+            break;
+        }
+
+        case OP_JMP:
+        case OP_JIT_LOOP:
+            jit_jump(jc, jmp, sizeof(jmp), ins.b, ins.b > jc->end);
+            break;
+
+        case OP_JMPF:
+        case OP_JMPT:
+            jit_load(jc, RAX, ins.a);
+            jit_bytes(jc, testEax, sizeof(testEax));
+            jit_jump(jc, (ins.opcode == OP_JMPF) ? jz : jnz, 2, ins.b, ins.b > jc->end);
+            break;
+
+        case OP_JLT: case OP_JLEQ: case OP_JGT: case OP_JGEQ: case OP_JEQ: case OP_JNEQ: {
+            static const uint8_t cmp[] = { 0x39, 0xC8 }; // cmp eax, ecx
+            uint8_t jcc[] = { 0x0F, 0x00 };
+            switch (ins.opcode) {
+                case OP_JLT: jcc[1] = 0x8C; break;
+                case OP_JLEQ: jcc[1] = 0x8E; break;
+                case OP_JGT: jcc[1] = 0x8F; break;
+                case OP_JGEQ: jcc[1] = 0x8D; break;
+                case OP_JEQ: jcc[1] = 0x84; break;
+                default: jcc[1] = 0x85; break;
+            }
+            jit_load(jc, RAX, ins.a);
+            jit_load(jc, RCX, ins.c);
+            jit_bytes(jc, cmp, sizeof(cmp));
+            jit_jump(jc, jcc, sizeof(jcc), ins.b, ins.b > jc->end);
+            break;
+        }
+
+        case OP_JMODZ:
+        case OP_JMODNZ: {
+            static const uint8_t testEcx[] = { 0x85, 0xC9 };
+            static const uint8_t cmpEcxMinusOne[] = { 0x83, 0xF9, 0xFF };
+            static const uint8_t idiv[] = { 0x99, 0xF7, 0xF9 }; // cdq, idiv ecx
+            static const uint8_t testEdx[] = { 0x85, 0xD2 };
+            jit_load(jc, RAX, ins.a);
+            jit_load(jc, RCX, ins.c);
+
+            // Same exits as OP_MOD
+            jit_bytes(jc, testEcx, sizeof(testEcx));
+            jit_jump(jc, jz, sizeof(jz), pc, true);
+            jit_bytes(jc, cmpEcxMinusOne, sizeof(cmpEcxMinusOne));
+            jit_jump(jc, jz, sizeof(jz), pc, true);
+
+            jit_bytes(jc, idiv, sizeof(idiv));
+            jit_bytes(jc, testEdx, sizeof(testEdx));
+            jit_jump(jc, (ins.opcode == OP_JMODZ) ? jz : jnz, 2, ins.b, ins.b > jc->end);
+            break;
+        }
+
+        default:
+            break; // Rejected by jit_canTranslate()
+    }
+}
+
+bool jit_compileLoop(VMProgram* program, int start, int end, JitLoop* loop) {
+    static const uint8_t prologue[] = { 0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57 }; // push rbx, r12-r15
+    static const uint8_t epilogue[] = { 0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5B, 0xC3 }; // pop r15-r12, rbx, ret
+    static const uint8_t jmp[] = { 0xE9 };
+
+    if (!jit_canTranslate(program, start, end)) return false;
+
+    *loop = (JitLoop){ .code = NULL, .codeSize = 0, .entry = NULL, .guards = NULL, .guardCount = 0, .loads = NULL,
+                       .loadCount = 0, .writes = NULL, .writeCount = 0, .slots = NULL };
+    JitCompiler jc = { .program = program, .start = start, .end = end, .bytes = NULL, .size = 0, .capacity = 0,
+                       .labels = NULL, .fixups = NULL, .fixupCount = 0, .fixupCapacity = 0, .hostOf = NULL };
+    jc.labels = malloc(sizeof(size_t) * (end - start + 1));
+    jc.hostOf = malloc(sizeof(int) * program->registerCount);
+    for (int r = 0; r < program->registerCount; r++) jc.hostOf[r] = -1;
+
+    jit_collectRegisters(&jc, loop);
+
+    jit_bytes(&jc, prologue, sizeof(prologue));
+    for (int r = 0; r < program->registerCount; r++) {
+        if (jc.hostOf[r] >= 0) jit_slotLoad(&jc, jc.hostOf[r], r);
+    }
+
+    for (int pc = start; pc <= end; pc++) {
+        jc.labels[pc - start] = jc.size;
+        jit_instruction(&jc, pc);
+    }
+    jit_jump(&jc, jmp, sizeof(jmp), end + 1, true); // The condition was false, the loop is over
+
+    // Common exit, eax already holds the instruction where the bytecode resumes
+    size_t exitLabel = jc.size;
+    for (int r = 0; r < program->registerCount; r++) {
+        if (jc.hostOf[r] >= 0) jit_slotStore(&jc, r, jc.hostOf[r]);
+    }
+    jit_bytes(&jc, epilogue, sizeof(epilogue));
+
+    // Every exit gets a stub that sets the return value, then jumps to the common exit
+    int fixupCount = jc.fixupCount;
+    for (int i = 0; i < fixupCount; i++) {
+        JitFixup f = jc.fixups[i];
+        size_t target;
+
+        if (f.toExit) {
+            target = jc.size;
+            jit_byte(&jc, 0xB8); // mov eax, imm32
+            jit_int32(&jc, f.target);
+            jit_byte(&jc, 0xE9);
+            jit_int32(&jc, (int32_t)(exitLabel - (jc.size + 4)));
+        } else {
+            target = jc.labels[f.target - start];
+        }
+        jit_patch32(&jc, f.offset, (int32_t)(target - (f.offset + 4)));
+    }
+
+    void* code = mmap(NULL, jc.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    bool ok = code != MAP_FAILED;
+    if (ok) {
+        memcpy(code, jc.bytes, jc.size);
+        ok = mprotect(code, jc.size, PROT_READ | PROT_EXEC) == 0; // Never writable and executable at once
+        if (!ok) munmap(code, jc.size);
+    }
+
+    if (ok) {
+        loop->code = code;
+        loop->codeSize = jc.size;
+        memcpy(&loop->entry, &code, sizeof(code)); // ISO C has no cast from data to function pointers
+        loop->slots = malloc(sizeof(int) * program->registerCount);
+    } else {
+        free(loop->guards);
+        free(loop->loads);
+        free(loop->writes);
+    }
+
+    free(jc.bytes);
+    free(jc.labels);
+    free(jc.fixups);
+    free(jc.hostOf);
+    return ok;
+}
+
+int jitCompileProgram(VMProgram* program) {
+    program->jitLoops = malloc(sizeof(JitLoop) * program->codeSize);
+
+    // A WHILE is a jump to its condition followed by the body, the condition ends with a JMPT to the body.
+    // Inner loops end first, so they are translated before the loops that contain them
+    for (int pc = 0; pc < program->codeSize; pc++) {
+        Instruction ins = program->code[pc];
+        // Superinstructions keep an operand in C, but only a WHILE jumps backwards
+        bool fused = ins.opcode >= OP_JLT && ins.opcode <= OP_JMODNZ;
+        if (fused ? ins.b > pc : (genericOpcode(ins.opcode) != OP_JMPT || ins.c != COND_WHILE)) continue;
+
+        int start = ins.b - 1;
+        if (start < 0 || program->code[start].opcode != OP_JMP) continue;
+
+        if (jit_compileLoop(program, start, pc, &program->jitLoops[program->jitLoopCount])) {
+            Instruction* entry = &program->code[start];
+            *entry = (Instruction){ .opcode = OP_JIT_LOOP, .a = program->jitLoopCount, .b = entry->b, .c = 0, .handler = NULL };
+            program->jitLoopCount++;
+        }
+    }
+
+    program->threaded = false; // New instructions need their handlers
+    return program->jitLoopCount;
+}
+
+int jitRunLoop(JitLoop* loop, SimplicValue* registers, int fallback) {
+    for (int i = 0; i < loop->guardCount; i++) {
+        if (registers[loop->guards[i]].type != VALUE_INT) return fallback; // Strings or undeclared vars
+    }
+
+    for (int i = 0; i < loop->loadCount; i++) {
+        SimplicValue* reg = &registers[loop->loads[i]];
+        loop->slots[loop->loads[i]] = (reg->type == VALUE_INT) ? reg->integer : 0; // Temporaries may hold anything
+    }
+
+    int next = loop->entry(loop->slots);
+
+    for (int i = 0; i < loop->writeCount; i++) {
+        SimplicValue* reg = &registers[loop->writes[i]];
+        if (reg->type == VALUE_STR) free(reg->string);
+        *reg = (SimplicValue){ .type = VALUE_INT, .integer = loop->slots[loop->writes[i]], .string = NULL };
+    }
+    return next;
+}
+
+#else
+
+int jitCompileProgram(VMProgram* program) {
+    (void)program;
+    return 0;
+}
+
+int jitRunLoop(JitLoop* loop, SimplicValue* registers, int fallback) {
+    (void)loop;
+    (void)registers;
+    return fallback;
+}
+
+#endif
+
+void jitDeleteLoops(VMProgram* program) {
+    for (int i = 0; i < program->jitLoopCount; i++) {
+        JitLoop* loop = &program->jitLoops[i];
+#ifdef JIT_AVAILABLE
+        munmap(loop->code, loop->codeSize);
+#endif
+        free(loop->guards);
+        free(loop->loads);
+        free(loop->writes);
+        free(loop->slots);
+    }
+    free(program->jitLoops);
+    program->jitLoops = NULL;
+    program->jitLoopCount = 0;
+}
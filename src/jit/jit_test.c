@@ -0,0 +1,185 @@
+#define _DEFAULT_SOURCE // Needed by jit.c, must come before any system header
+#include "unity.h"
+#include "unity_internals.h"
+
+#include "jit.c"
+#include "parser.h"
+#include "differential.h"
+
+Token* tokenList;
+SimplicError* error;
+ControlState control;
+int translatedLoops;
+
+void setUp(void) {
+    control.returned = false;
+    tokenList = initTokenQueue();
+    control.bank = initMemoryBank();
+    control.out = stdout;
+    error = initError();
+    translatedLoops = 0;
+}
+
+void tearDown(void) {
+    deleteTokenQueue(&tokenList);
+    deleteMemoryBank(&control.bank);
+    deleteError(&error);
+}
+
+// Compiles a parsed program, translates its loops and runs it in the VM
+SimplicValue jitEngine(SyntaxNode* tree, ControlState* control, SimplicError* error) {
+    SimplicValue val = { .type = VALUE_VOID, .integer = 0, .string = NULL };
+    VMProgram* code = compileProgram(tree, error);
+    if (!error->hasError) {
+        translatedLoops = jitCompileProgram(code);
+        val = runProgram(code, control, error);
+    }
+    deleteProgram(&code);
+    return val;
+}
+
+// Compiles a whole program, translates its loops and runs it in the VM
+SimplicValue runJit(const char* program) {
+    SimplicValue val = { .type = VALUE_VOID, .integer = 0, .string = NULL };
+    tokenizeSource(&tokenList, program, error);
+    SyntaxNode* tree = parseProgram(&tokenList, error);
+
+    if (!error->hasError)
+        val = jitEngine(tree, &control, error);
+
+    freeSyntaxTree(tree);
+    return val;
+}
+
+void testIntegerLoopIsTranslated(void) {
+    SimplicValue val = runJit(
+        "SET BASE = 3\n"
+        "SET EXPO = 5\n"
+        "SET RESULT = 1\n"
+        "WHILE EXPO GT 0 DO\n"
+            "SET RESULT = RESULT * BASE\n"
+            "DECR EXPO\n"
+        "DONE\n"
+        "RETURN RESULT\n");
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(243, val.integer);
+#ifdef JIT_AVAILABLE
+    TEST_ASSERT_EQUAL_INT(1, translatedLoops);
+#endif
+}
+
+void testLoopWithPrintIsNotTranslated(void) {
+    runJit("SET I = 0\nWHILE I LT 1 DO\nPRINT \"\"\nINCR I\nDONE\n");
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(0, translatedLoops);
+}
+
+void testNestedLoopsAreTranslated(void) {
+    SimplicValue val = runJit(
+        "SET X = 0\n"
+        "SET Y = 0\n"
+        "SET ITERS = 0\n"
+        "WHILE X LT 50 DO\n"
+            "WHILE Y LT 50 DO\n"
+                "INCR Y\n"
+                "INCR ITERS\n"
+            "DONE\n"
+            "SET Y = 0\n"
+            "INCR X\n"
+        "DONE\n"
+        "RETURN ITERS\n");
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(2500, val.integer);
+#ifdef JIT_AVAILABLE
+    TEST_ASSERT_EQUAL_INT(2, translatedLoops);
+#endif
+}
+
+void testDivisionByZeroInsideLoop(void) {
+    runJit("SET X = 5\nSET Y = 3\nWHILE X GT 0 DO\nSET Z = 10 / Y\nDECR Y\nDONE\n");
+    TEST_ASSERT_TRUE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(ERROR_DIVISION_BY_ZERO, error->errCode);
+    TEST_ASSERT_EQUAL_STRING("Division by 0, execution halted", error->errMsg);
+}
+
+void testStringVariableFallsBackToBytecode(void) {
+    SimplicValue val = runJit("SET X = \"A\"\nSET I = 0\nWHILE I LT 3 DO\nSET X = X * 2\nINCR I\nDONE\nRETURN X\n");
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(0, val.integer);
+}
+
+#ifdef JIT_AVAILABLE
+int registerOf(VMProgram* program, const char* name) {
+    for (int i = 0; i < program->varCount; i++) {
+        if (strcmp(program->varNames[i], name) == 0) return i;
+    }
+    TEST_FAIL_MESSAGE(name);
+    return -1;
+}
+#endif
+
+void testGuardsDecideTheEntry(void) {
+#ifdef JIT_AVAILABLE
+    tokenizeSource(&tokenList, "SET X = 0\nSET N = 5\nWHILE X LT N DO\nINCR X\nDONE\nRETURN X\n", error);
+    SyntaxNode* tree = parseProgram(&tokenList, error);
+    VMProgram* code = compileProgram(tree, error);
+    TEST_ASSERT_EQUAL_INT(1, jitCompileProgram(code));
+
+    SimplicValue* R = calloc(code->registerCount, sizeof(SimplicValue));
+    memcpy(R + code->varCount, code->constants, sizeof(SimplicValue) * code->constCount);
+    int x = registerOf(code, "X");
+    int n = registerOf(code, "N");
+
+    // Integers enter native code, which runs the whole loop and gives the instruction after it
+    R[x] = (SimplicValue){ .type = VALUE_INT, .integer = 0, .string = NULL };
+    R[n] = (SimplicValue){ .type = VALUE_INT, .integer = 5, .string = NULL };
+    int next = jitRunLoop(&code->jitLoops[0], R, -1);
+    TEST_ASSERT_NOT_EQUAL(-1, next);
+    TEST_ASSERT_EQUAL_INT(OP_RETURN, code->code[next].opcode);
+    TEST_ASSERT_EQUAL_INT(5, R[x].integer);
+
+    // A string or an unset variable sends the loop back to its bytecode, registers untouched
+    R[x].integer = 1;
+    R[n] = (SimplicValue){ .type = VALUE_STR, .integer = 0, .string = "5" };
+    TEST_ASSERT_EQUAL_INT(-1, jitRunLoop(&code->jitLoops[0], R, -1));
+    TEST_ASSERT_EQUAL_INT(1, R[x].integer);
+    R[n] = (SimplicValue){ .type = VALUE_VOID, .integer = 0, .string = NULL };
+    TEST_ASSERT_EQUAL_INT(-1, jitRunLoop(&code->jitLoops[0], R, -1));
+    TEST_ASSERT_EQUAL_INT(VALUE_INT, R[x].type);
+
+    free(R);
+    deleteProgram(&code);
+    freeSyntaxTree(tree);
+#endif
+}
+
+// Loops that run natively, that fail their guards and that leave native code to report an error
+void testSameResultsAsEval(void) {
+    const char* programs[] = {
+        "SET X = 2\nSET C = 0\nWHILE X LT 500 DO\nSET Y = 2\nSET P = 1\nWHILE Y * Y LEQ X DO\nIF X % Y EQ 0 THEN\nSET P = 0\nFI\nINCR Y\nDONE\nSET C = C + P\nINCR X\nDONE\nRETURN C\n",
+        "SET I = 0\nSET S = 0\nWHILE I LT 100 DO\nIF I % 3 EQ 0 OR I % 5 EQ 0 THEN\nSET S = S + I\nELSE\nSET S = S - 1\nFI\nINCR I\nDONE\nRETURN S\n",
+        "SET I = 0\nSET S = 0\nWHILE I LT 30 DO\nSET A = I GT 10 AND I LEQ 20\nSET B = I GEQ 25 OR I EQ 3\nSET S = S + A + B + I NEQ 7\nINCR I\nDONE\nRETURN S\n",
+        "SET I = 10\nSET S = 1000\nSET L = 0 - 10\nWHILE I GT L DO\nSET S = S - I / 3 + I % 4\nDECR I\nDONE\nRETURN S\n",
+        "SET I = 0\nSET S = 0\nWHILE I LT 5 DO\nSET D = I - 1\nSET S = S + 7 / D\nINCR I\nDONE\nRETURN S\n",
+        "SET I = 0\nWHILE I LT 5 DO\nSET Q = Q + 1\nINCR I\nDONE\n",
+        "SET I = 0\nSET S = \"A\"\nWHILE I LT 5 DO\nINCR I\nDONE\nRETURN S + I\n",
+        "SET I = 0\nWHILE I LT 1000 DO\nINCR I\nIF I EQ 500 THEN\nRETURN I\nFI\nDONE\n",
+        "SET I = 3\nWHILE I DO\nDECR I\nDONE\nRETURN I\n",
+        "SET X = \"A\"\nSET I = 0\nWHILE I LT 3 DO\nSET X = X * 2\nINCR I\nDONE\nRETURN X\n",
+        "SET N = 3\nSET K = 0\nWHILE K LT 2 DO\nSET I = 0\nWHILE I LT N DO\nINCR I\nDONE\nPRINTLN I\nSET N = \"4\"\nINCR K\nDONE\n",
+        "SET N = 3\nSET K = 0\nWHILE K LT 2 DO\nSET I = 0\nWHILE I LT N DO\nINCR I\nDONE\nPRINTLN I\nUNSET N\nINCR K\nDONE\n",
+    };
+    assertAllSameAsEval(jitEngine, programs, sizeof(programs) / sizeof(programs[0]));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(testIntegerLoopIsTranslated);
+    RUN_TEST(testLoopWithPrintIsNotTranslated);
+    RUN_TEST(testNestedLoopsAreTranslated);
+    RUN_TEST(testDivisionByZeroInsideLoop);
+    RUN_TEST(testStringVariableFallsBackToBytecode);
+    RUN_TEST(testGuardsDecideTheEntry);
+    RUN_TEST(testSameResultsAsEval);
+    return UNITY_END();
+}
@@ -0,0 +1,58 @@
+#ifndef PRIVATE_JIT_H
+#define PRIVATE_JIT_H
+
+#include <stdint.h>
+#include "jit.h"
+
+#if defined(__x86_64__) && defined(__linux__)
+    #define JIT_AVAILABLE
+#endif
+
+#ifdef JIT_AVAILABLE
+
+// Jump waiting for the address of its target, resolved once the whole loop is emitted
+typedef struct JitFixup JitFixup;
+struct JitFixup {
+    size_t offset; // Position of the rel32 field
+    int target; // Instruction of the loop, or instruction where the bytecode resumes if toExit
+    bool toExit;
+};
+
+// State kept while translating one loop
+typedef struct JitCompiler JitCompiler;
+struct JitCompiler {
+    VMProgram* program;
+    int start; // First instruction of the loop (the jump to its condition)
+    int end; // Last instruction of the loop (the JMPT of its condition)
+    uint8_t* bytes;
+    size_t size;
+    size_t capacity;
+    size_t* labels; // Native offset of each instruction of the loop
+    JitFixup* fixups;
+    int fixupCount;
+    int fixupCapacity;
+    int* hostOf; // CPU register holding each VM register, -1 if it lives in its slot
+};
+
+// Loop analysis
+static bool jit_isConstant(VMProgram* program, int reg);
+static bool jit_canTranslate(VMProgram* program, int start, int end); // Checks instructions and operands
+static void jit_collectRegisters(JitCompiler* jc, JitLoop* loop); // Fills guards, loads, writes and hostOf
+
+// Machine code emitters
+static void jit_byte(JitCompiler* jc, uint8_t b);
+static void jit_bytes(JitCompiler* jc, const uint8_t* b, int n);
+static void jit_int32(JitCompiler* jc, int32_t n);
+static void jit_rex(JitCompiler* jc, int reg, int rm); // Only emitted for r8-r15
+static void jit_patch32(JitCompiler* jc, size_t offset, int32_t n);
+static void jit_slotLoad(JitCompiler* jc, int host, int reg); // Always reads the slot of the register
+static void jit_slotStore(JitCompiler* jc, int reg, int host);
+static void jit_load(JitCompiler* jc, int host, int reg); // host = VM register
+static void jit_store(JitCompiler* jc, int reg, int host); // VM register = host
+static void jit_jump(JitCompiler* jc, const uint8_t* opcode, int n, int target, bool toExit);
+static void jit_instruction(JitCompiler* jc, int pc);
+static bool jit_compileLoop(VMProgram* program, int start, int end, JitLoop* loop);
+
+#endif
+
+#endif
@@ -1,7 +1,5 @@
 #include "private_lexer.h"
 
-const char* src;
-
 bool isAlpha(char c){
 	return ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z'));
 }
@@ -14,28 +12,81 @@ bool isAlphaNumer(char c){
 	return (isAlpha(c) || isNumber(c) || c == '_');
 }
 
+bool startsStatement(TokenType type){
+	return type == TOKEN_SET || type == TOKEN_UNSET || type == TOKEN_PRINT || type == TOKEN_PRINTLN || type == TOKEN_RETURN ||
+	       type == TOKEN_INCREMENT || type == TOKEN_DECREMENT || type == TOKEN_WHILE || type == TOKEN_IF;
+}
+
+bool endsStatement(TokenType type){
+	return type == TOKEN_VAR || type == TOKEN_NUMBER || type == TOKEN_STRING || type == TOKEN_DONE || type == TOKEN_FI;
+}
+
+void emitToken(LexerOutput* output, TokenType type, const char* name, char* string) {
+	// A statement keyword after the end of an expression, outside any block, starts a new top level statement
+	if (output->handler != NULL && output->count >= output->batchTokens && output->depth == 0 &&
+	    startsStatement(type) && endsStatement(output->lastType)) {
+		output->handler(*output->head, output->last, output->context);
+		*output->head = NULL;
+		output->tail = output->head;
+		output->last = NULL;
+		output->count = 0;
+	}
+
+	enqueueToken(output->tail, type, name, string); // *tail is always the empty end of the list
+	if (*output->tail == NULL) return;
+
+	output->last = *output->tail;
+	output->lastType = type;
+	output->tail = &(*output->tail)->next;
+	output->count++;
+	if (type == TOKEN_WHILE || type == TOKEN_IF) output->depth++;
+	if (type == TOKEN_DONE || type == TOKEN_FI) output->depth--;
+}
+
 void tokenizeSource(Token** tokenList, const char* src, SimplicError* error) {
-	unsigned short int i = 0;
-	int len = strlen(src);
+	tokenizeSourceLength(tokenList, src, strlen(src), error);
+}
+
+void tokenizeSourceLength(Token** tokenList, const char* src, size_t len, SimplicError* error) {
+	LexerOutput output = { .head = tokenList, .tail = tokenList, .last = NULL, .lastType = TOKEN_ERROR_TOKEN, .count = 0, .depth = 0,
+	                       .batchTokens = 0, .handler = NULL, .context = NULL };
+
+	// New tokens go after the ones already in the list
+	while (*output.tail != NULL) output.tail = &(*output.tail)->next;
+	tokenize(&output, src, len, error);
+}
+
+void tokenizeSourceBatches(const char* src, size_t len, size_t batchTokens, TokenBatchHandler handler, void* context, SimplicError* error) {
+	Token* batch = NULL;
+	LexerOutput output = { .head = &batch, .tail = &batch, .last = NULL, .lastType = TOKEN_ERROR_TOKEN, .count = 0, .depth = 0,
+	                       .batchTokens = batchTokens, .handler = handler, .context = context };
+
+	tokenize(&output, src, len, error);
+	if (batch != NULL) handler(batch, output.last, context); // Ends with EOF, unless lexing failed
+}
+
+void tokenize(LexerOutput* output, const char* src, size_t len, SimplicError* error) {
+	size_t i = 0;
 
 	while(i < len){
 		// Symbol or escape seq
-		while (src[i] == ' ' || src[i] == '\t' || src[i] == '\n') i++;
+		while (i < len && (src[i] == ' ' || src[i] == '\t' || src[i] == '\n')) i++;
+		if (i >= len) break;
 
 		// Coment '#', skip to the next \n (or EOF)
-		if(src[i] == '#') { while(src[i] != '\n' && i < len) i++; }
+		if(src[i] == '#') { while(i < len && src[i] != '\n') i++; continue; }
 
-		if (src[i] == '=')  { i++; enqueueToken(tokenList, TOKEN_EQUALS, "=", NULL); continue; }
-		if (src[i] == '+')  { i++; enqueueToken(tokenList, TOKEN_PLUS, "+", NULL); continue; }
-		if (src[i] == '-')  { i++; enqueueToken(tokenList, TOKEN_MINUS, "-", NULL); continue; }
-		if (src[i] == '*')  { i++; enqueueToken(tokenList, TOKEN_MULT, "*", NULL); continue; }
-		if (src[i] == '/')  { i++; enqueueToken(tokenList, TOKEN_DIV, "/", NULL); continue; }
-		if (src[i] == '%')  { i++; enqueueToken(tokenList, TOKEN_MOD, "%", NULL); continue; }
+		if (src[i] == '=')  { i++; emitToken(output, TOKEN_EQUALS, "=", NULL); continue; }
+		if (src[i] == '+')  { i++; emitToken(output, TOKEN_PLUS, "+", NULL); continue; }
+		if (src[i] == '-')  { i++; emitToken(output, TOKEN_MINUS, "-", NULL); continue; }
+		if (src[i] == '*')  { i++; emitToken(output, TOKEN_MULT, "*", NULL); continue; }
+		if (src[i] == '/')  { i++; emitToken(output, TOKEN_DIV, "/", NULL); continue; }
+		if (src[i] == '%')  { i++; emitToken(output, TOKEN_MOD, "%", NULL); continue; }
 
 		// String literal
 		if (src[i] == '"') { 
 			i++; // Skip ' " '
-			int j = i;
+			size_t j = i;
 			while(j < len && src[j] != '"') { 
 				j++; 
 			}
@@ -56,50 +107,56 @@ void tokenizeSource(Token** tokenList, const char* src, SimplicError* error) {
 			buffer[j] = '\0';
 
 			i++; // Skip last ' " '
-			enqueueToken(tokenList, TOKEN_STRING, "STRING", buffer); 
+			emitToken(output, TOKEN_STRING, "STRING", buffer); 
 			continue;
 		}
 
 		// Identifier or variable
 		if (isAlpha(src[i])) {
 			char buffer[IDENTIFIER_SIZE]; int j = 0;
-			while (isAlphaNumer(src[i])) buffer[j++] = src[i++];
+			while (i < len && isAlphaNumer(src[i])) {
+				if (j < IDENTIFIER_SIZE - 1) buffer[j++] = src[i]; // Longer names are cut
+				i++;
+			}
 			buffer[j] = '\0';
-			if (strcmp(buffer, "SET") == 0) { enqueueToken(tokenList, TOKEN_SET, "SET", NULL); continue; }
-			if (strcmp(buffer, "UNSET") == 0) { enqueueToken(tokenList, TOKEN_UNSET, "UNSET", NULL); continue; }
-			if (strcmp(buffer, "PRINT") == 0) { enqueueToken(tokenList, TOKEN_PRINT, "PRINT", NULL); continue; }
-			if (strcmp(buffer, "PRINTLN") == 0) { enqueueToken(tokenList, TOKEN_PRINTLN, "PRINTLN", NULL); continue; }
-			if (strcmp(buffer, "RETURN") == 0) { enqueueToken(tokenList, TOKEN_RETURN, "RETURN", NULL); continue; }
-			if (strcmp(buffer, "INCR") == 0) { enqueueToken(tokenList, TOKEN_INCREMENT, "INCR", NULL); continue; }
-			if (strcmp(buffer, "DECR") == 0) { enqueueToken(tokenList, TOKEN_DECREMENT, "DECR", NULL); continue; }
-			if (strcmp(buffer, "GT") == 0) { enqueueToken(tokenList, TOKEN_GT, "GT", NULL); continue; }
-			if (strcmp(buffer, "LT") == 0) { enqueueToken(tokenList, TOKEN_LT, "LT", NULL); continue; }
-			if (strcmp(buffer, "GEQ") == 0) { enqueueToken(tokenList, TOKEN_GEQ, "GEQ", NULL); continue; }
-			if (strcmp(buffer, "LEQ") == 0) { enqueueToken(tokenList, TOKEN_LEQ, "LEQ", NULL); continue; }
-			if (strcmp(buffer, "EQ") == 0) { enqueueToken(tokenList, TOKEN_EQ, "EQ", NULL); continue; }
-			if (strcmp(buffer, "NEQ") == 0) { enqueueToken(tokenList, TOKEN_NEQ, "NEQ", NULL); continue; }
-			if (strcmp(buffer, "AND") == 0) { enqueueToken(tokenList, TOKEN_AND, "AND", NULL); continue; }
-			if (strcmp(buffer, "OR") == 0) { enqueueToken(tokenList, TOKEN_OR, "OR", NULL); continue; }
-			if (strcmp(buffer, "WHILE") == 0) { enqueueToken(tokenList, TOKEN_WHILE, "WHILE", NULL); continue; }
-			if (strcmp(buffer, "DO") == 0) { enqueueToken(tokenList, TOKEN_DO, "DO", NULL); continue; }
-			if (strcmp(buffer, "DONE") == 0) { enqueueToken(tokenList, TOKEN_DONE, "DONE", NULL); continue; }
-			if (strcmp(buffer, "IF") == 0) { enqueueToken(tokenList, TOKEN_IF, "IF", NULL); continue; }
-			if (strcmp(buffer, "THEN") == 0) { enqueueToken(tokenList, TOKEN_THEN, "THEN", NULL); continue; }
-			if (strcmp(buffer, "ELSE") == 0) { enqueueToken(tokenList, TOKEN_ELSE, "ELSE", NULL); continue; }
-			if (strcmp(buffer, "FI") == 0) { enqueueToken(tokenList, TOKEN_FI, "FI", NULL); continue; }
-			enqueueToken(tokenList, TOKEN_VAR, buffer, NULL); continue;
+			if (strcmp(buffer, "SET") == 0) { emitToken(output, TOKEN_SET, "SET", NULL); continue; }
+			if (strcmp(buffer, "UNSET") == 0) { emitToken(output, TOKEN_UNSET, "UNSET", NULL); continue; }
+			if (strcmp(buffer, "PRINT") == 0) { emitToken(output, TOKEN_PRINT, "PRINT", NULL); continue; }
+			if (strcmp(buffer, "PRINTLN") == 0) { emitToken(output, TOKEN_PRINTLN, "PRINTLN", NULL); continue; }
+			if (strcmp(buffer, "RETURN") == 0) { emitToken(output, TOKEN_RETURN, "RETURN", NULL); continue; }
+			if (strcmp(buffer, "INCR") == 0) { emitToken(output, TOKEN_INCREMENT, "INCR", NULL); continue; }
+			if (strcmp(buffer, "DECR") == 0) { emitToken(output, TOKEN_DECREMENT, "DECR", NULL); continue; }
+			if (strcmp(buffer, "GT") == 0) { emitToken(output, TOKEN_GT, "GT", NULL); continue; }
+			if (strcmp(buffer, "LT") == 0) { emitToken(output, TOKEN_LT, "LT", NULL); continue; }
+			if (strcmp(buffer, "GEQ") == 0) { emitToken(output, TOKEN_GEQ, "GEQ", NULL); continue; }
+			if (strcmp(buffer, "LEQ") == 0) { emitToken(output, TOKEN_LEQ, "LEQ", NULL); continue; }
+			if (strcmp(buffer, "EQ") == 0) { emitToken(output, TOKEN_EQ, "EQ", NULL); continue; }
+			if (strcmp(buffer, "NEQ") == 0) { emitToken(output, TOKEN_NEQ, "NEQ", NULL); continue; }
+			if (strcmp(buffer, "AND") == 0) { emitToken(output, TOKEN_AND, "AND", NULL); continue; }
+			if (strcmp(buffer, "OR") == 0) { emitToken(output, TOKEN_OR, "OR", NULL); continue; }
+			if (strcmp(buffer, "WHILE") == 0) { emitToken(output, TOKEN_WHILE, "WHILE", NULL); continue; }
+			if (strcmp(buffer, "DO") == 0) { emitToken(output, TOKEN_DO, "DO", NULL); continue; }
+			if (strcmp(buffer, "DONE") == 0) { emitToken(output, TOKEN_DONE, "DONE", NULL); continue; }
+			if (strcmp(buffer, "IF") == 0) { emitToken(output, TOKEN_IF, "IF", NULL); continue; }
+			if (strcmp(buffer, "THEN") == 0) { emitToken(output, TOKEN_THEN, "THEN", NULL); continue; }
+			if (strcmp(buffer, "ELSE") == 0) { emitToken(output, TOKEN_ELSE, "ELSE", NULL); continue; }
+			if (strcmp(buffer, "FI") == 0) { emitToken(output, TOKEN_FI, "FI", NULL); continue; }
+			emitToken(output, TOKEN_VAR, buffer, NULL); continue;
 		}
 
 		// Number
 		if (isNumber(src[i])) {
 			char buffer[IDENTIFIER_SIZE]; int j = 0;
-			while (isNumber(src[i])) buffer[j++] = src[i++];
+			while (i < len && isNumber(src[i])) {
+				if (j < IDENTIFIER_SIZE - 1) buffer[j++] = src[i];
+				i++;
+			}
 			buffer[j] = '\0';
-			enqueueToken(tokenList, TOKEN_NUMBER, buffer, NULL); continue;
+			emitToken(output, TOKEN_NUMBER, buffer, NULL); continue;
 		}
 
 		i++; // Unknown character
 		// Maybe create unknown token and halt interpreter ???
 	}
-	enqueueToken(tokenList, TOKEN_EOF, "", NULL); // Reached string end, add EOF
+	emitToken(output, TOKEN_EOF, "", NULL); // Reached string end, add EOF
 }
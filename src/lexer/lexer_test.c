@@ -119,11 +119,68 @@ void tokenizeWorks(){
     deleteError(&error);
 }
 
+// Counts the tokens of a list and checks the last one is the EOF
+int countTokens(Token* list) {
+    int count = 0;
+    Token* last = NULL;
+
+    for (Token* token = list; token != NULL; token = token->next) {
+        count++;
+        last = token;
+    }
+    TEST_ASSERT_NOT_NULL(last);
+    TEST_ASSERT_TRUE(last->type == TOKEN_EOF);
+    return count;
+}
+
+void tokenizeStopsAtLength(void) {
+    // Nothing after the first len chars is read, not even a terminator
+    const char program[] = { 'S', 'E', 'T', ' ', 'X', ' ', '=', ' ', '3', '4', 'P', 'R', 'I', 'N', 'T' };
+
+    SimplicError* error = initError();
+    Token* myList = initTokenQueue();
+
+    tokenizeSourceLength(&myList, program, 10, error);
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(5, countTokens(myList));
+    TEST_ASSERT_EQUAL_STRING("34", myList->next->next->next->name);
+    deleteTokenQueue(&myList);
+
+    // A string cut by the length is not terminated
+    tokenizeSourceLength(&myList, "PRINT \"AB\"", 9, error);
+    TEST_ASSERT_TRUE(error->hasError);
+    TEST_ASSERT_TRUE(error->errCode == ERROR_NON_TERMINATED_STRING_LITERAL);
+
+    deleteTokenQueue(&myList);
+    deleteError(&error);
+}
+
+void tokenizeLongSource(void) {
+    // Past the 65535 chars an unsigned short index could reach
+    const int lines = 20000;
+    char* program = malloc(lines * 7 + 1);
+    for (int i = 0; i < lines; i++) memcpy(program + i * 7, "INCR X\n", 7);
+    program[lines * 7] = '\0';
+
+    SimplicError* error = initError();
+    Token* myList = initTokenQueue();
+
+    tokenizeSource(&myList, program, error);
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(lines * 2 + 1, countTokens(myList));
+
+    deleteTokenQueue(&myList);
+    deleteError(&error);
+    free(program);
+}
+
 int main(void) {
     UNITY_BEGIN();
     RUN_TEST(isAlphaWorks);
     RUN_TEST(isNumberWorks);
     RUN_TEST(isAlphaNumerWorks);
     RUN_TEST(tokenizeWorks);
+    RUN_TEST(tokenizeStopsAtLength);
+    RUN_TEST(tokenizeLongSource);
     return UNITY_END();
 }
@@ -3,9 +3,27 @@
 
 #include "lexer.h"
 
+// Where tokenize() puts the tokens, a list that may be handed out in batches as it grows
+typedef struct LexerOutput LexerOutput;
+struct LexerOutput {
+	Token** head; // Start of the list, or of the batch being filled
+	Token** tail; // Its empty end
+	Token* last; // Last token of the batch, NULL while it is empty
+	TokenType lastType; // Type of the last token emitted, even if already handed out
+	size_t count; // Tokens in the current batch
+	int depth; // WHILE and IF blocks left open
+	size_t batchTokens; // Tokens a batch holds at least before it is handed out
+	TokenBatchHandler handler; // NULL keeps every token in one list
+	void* context;
+};
+
 // Used to tokenize the code
 static bool isAlpha(char c);
 static bool isNumber(char c);
 static bool isAlphaNumer(char c);
+static bool startsStatement(TokenType type); // Keywords that begin a statement
+static bool endsStatement(TokenType type); // Tokens a statement can end with
+static void emitToken(LexerOutput* output, TokenType type, const char* name, char* string); // Appends without walking the list
+static void tokenize(LexerOutput* output, const char* src, size_t len, SimplicError* error);
 
 #endif
\ No newline at end of file
@@ -1,64 +1,237 @@
-#include "lexer.h"
-#include "parser.h"
-#include "interpreter.h"
+#include <unistd.h>
+#include "simplicVM.h"
+#include "programCache.h"
+#include "vm.h"
+#include "jit.h"
+#include "closure.h"
+#include "transpiler.h"
 #include "scriptReader.h"
+#include "server.h"
+#include "batch.h"
 
-int main(int argc, char *argv[]) {
-    if (argc < 2) {
-        printf("Usage: %s <file>\n", argv[0]);
-        return 0;
+// Execution engines, all of them give the same results
+typedef enum {
+    ENGINE_VM,
+    ENGINE_CLOSURE,
+    ENGINE_AST
+} Engine;
+
+// Options every script runs with, a server (see --serve) uses its own for every client
+typedef struct RunOptions RunOptions;
+struct RunOptions {
+    Engine engine;
+    bool jit;
+    bool emitC;
+    PassPipeline pipeline;
+    const char* cacheDir; // NULL or empty runs without the program cache
+    bool pipelinedParse; // Big scripts are lexed on a second thread while they are parsed
+};
+
+// Runs the whole program with the selected engine
+SimplicValue runEngine(Engine engine, bool jit, SyntaxNode* tree, ControlState* control, SimplicError* error) {
+    SimplicValue val = { .type = VALUE_VOID, .integer = 0, .string = NULL };
+
+    if (engine == ENGINE_AST) return eval(tree, control, error);
+
+    if (engine == ENGINE_CLOSURE) {
+        Closure* closure = compileClosure(tree, error);
+        if (!error->hasError)
+            val = runClosure(closure, control, error);
+        deleteClosure(&closure);
+        return val;
     }
 
-    SimplicError* error = initError();
-    const char* program = readScriptFile(argv[1], error);
+    VMProgram* code = compileProgram(tree, error);
+    if (!error->hasError) {
+        if (jit) jitCompileProgram(code);
+        val = runProgram(code, control, error);
+    }
+    deleteProgram(&code);
+    return val;
+}
 
-    if(error->hasError) {
-        printError(error);
-        return 1;
+// Writes the C translation of the program to out, nothing is written if it fails
+void emitProgram(SyntaxNode* tree, const char* path, FILE* out, SimplicError* error) {
+    FILE* buffer = tmpfile();
+    if (buffer == NULL) {
+        setError(error, ERROR_MISC, "Could not create a temporary file for the C program");
+        return;
+    }
+
+    transpileProgram(tree, path, buffer, error);
+    if (!error->hasError) {
+        int c;
+        rewind(buffer);
+        while ((c = fgetc(buffer)) != EOF) fputc(c, out);
+    }
+    fclose(buffer);
+}
+
+// Parses, optimizes and runs one script, writing what it prints to out. The ScriptRunner of the server and batches
+void runScript(const char* name, const Script* script, FILE* out, RunResult* result, void* context) {
+    const RunOptions* options = context;
+    SimplicVM* vm = initSimplicVM(out, &options->pipeline);
+    SimplicError* error = vm->error;
+    vm->pipelinedParse = options->pipelinedParse;
+
+    // With --emit-c the only output is the C program
+    if (!options->emitC) {
+        fprintf(out, "Script %s contents:\n", name);
+        fwrite(script->text, 1, script->length, out);
+        fprintf(out, "\n\nProgram Output:\n\n");
     }
     
-    printf("Script %s contents:\n%s\n\nProgram Output:\n\n", argv[1], program);
-    
-    Token* tokenList = initTokenQueue();
-    initMemoryBank();
-    SimplicValue val;
+    SimplicValue val = { .type = VALUE_VOID, .integer = 0, .string = NULL };
 
-    tokenizeSource(&tokenList, program, error);
+    // A cached tree skips the passes, so they are only dumped or timed when it is not used
+    bool cached = options->cacheDir != NULL && options->cacheDir[0] != '\0';
+    SyntaxNode* tree = NULL;
+    if (cached && vm->pipeline.dump == NULL && vm->pipeline.timing == NULL)
+        tree = loadCachedProgram(options->cacheDir, script->text, script->length, &vm->pipeline);
 
-    for (;;) {
-        SyntaxNode* result = parseTokenList(&tokenList, error);
+    if (tree == NULL) {
+        tree = parseScript(vm, script->text, script->length);
 
-        if (!result && !error->hasError) {
-            break; // Reached EOF with no return
-        }
-            
-        if (error->hasError) {
-            printError(error);
-            break;
-        }
+        // Failing to store only means the next run parses again
+        if (tree != NULL && cached)
+            storeCachedProgram(options->cacheDir, script->text, script->length, &vm->pipeline, tree);
+    }
 
-        val = eval(result, error);
-        freeSyntaxTree(result);
-        
+    if (error->hasError) {
+        fprintError(out, error);
+    } else if (options->emitC) {
+        emitProgram(tree, name, out, error);
+        if (error->hasError) fprintError(out, error);
+    } else {
+        val = runEngine(options->engine, options->jit, tree, &vm->control, error);
 
         if (error->hasError) {
-            printError(error);
-            break;
-        }
-
-        if (val.receivedReturn) {
-            printf("Program ended with return code: %d\n", val.integer);
-            break;
+            fprintError(out, error);
+        } else if (vm->control.returned) {
+            fprintf(out, "Program ended with return code: %d\n", val.integer);
         }
     }
+    freeSyntaxTree(tree);
+
+    // Errors in the script are reported in its output, the interpreter itself worked
+    result->status = 0;
+    result->returned = !error->hasError && vm->control.returned;
+    result->returnCode = result->returned ? val.integer : 0;
 
     if(val.type == VALUE_STR){
         free(val.string);
     }
     
-    deleteTokenQueue(&tokenList);
-    deleteMemoryBank();
+    deleteSimplicVM(&vm);
+}
+
+int main(int argc, char *argv[]) {
+    RunOptions options = { .engine = ENGINE_VM, .jit = false, .emitC = false, .cacheDir = getenv("SIMPLIC_CACHE_DIR"), .pipelinedParse = false };
+    int level = 1; // -O0 runs the program as written, -O2 adds the passes that make the program larger
+    int unroll = 4;
+    bool dump = false, timing = false, verify = false;
+    const char* path = NULL;
+    const char* serve = NULL; // Socket of the server to start, or to send the script to with --submit
+    bool submit = false, shutdown = false;
+    int jobs = -1; // Threads of --jobs, 0 for one per CPU. Below 0 runs the last script given alone
+    const char** paths = malloc(sizeof(char*) * argc);
+    int pathCount = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--engine=vm") == 0) options.engine = ENGINE_VM;
+        else if (strcmp(argv[i], "--engine=closure") == 0) options.engine = ENGINE_CLOSURE;
+        else if (strcmp(argv[i], "--engine=ast") == 0) options.engine = ENGINE_AST;
+        else if (strcmp(argv[i], "--jit") == 0) options.jit = true;
+        else if (strcmp(argv[i], "--emit-c") == 0) options.emitC = true;
+        else if (strncmp(argv[i], "-O", 2) == 0 && argv[i][2] >= '0' && argv[i][2] <= '2' && argv[i][3] == '\0') level = argv[i][2] - '0';
+        else if (strncmp(argv[i], "--unroll=", 9) == 0) unroll = atoi(argv[i] + 9);
+        else if (strcmp(argv[i], "--dump-ast") == 0) dump = true;
+        else if (strcmp(argv[i], "--time-passes") == 0) timing = true;
+        else if (strcmp(argv[i], "--verify-ast") == 0) verify = true;
+        else if (strcmp(argv[i], "--pipelined-parse") == 0) options.pipelinedParse = true;
+        else if (strncmp(argv[i], "--cache-dir=", 12) == 0) options.cacheDir = argv[i] + 12;
+        else if (strncmp(argv[i], "--enable-pass=", 14) == 0 || strncmp(argv[i], "--disable-pass=", 15) == 0) continue;
+        else if ((strcmp(argv[i], "--serve") == 0 || strcmp(argv[i], "--submit") == 0 || strcmp(argv[i], "--shutdown") == 0) && i + 1 < argc) {
+            submit = strcmp(argv[i], "--submit") == 0;
+            shutdown = strcmp(argv[i], "--shutdown") == 0;
+            serve = argv[++i];
+        }
+        else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) jobs = atoi(argv[++i]);
+        else path = paths[pathCount++] = argv[i];
+    }
+
+    if (path == NULL && (serve == NULL || submit)) {
+        free(paths);
+        printf("Usage: %s [--engine=vm|closure|ast] [--jit] [--emit-c] [-O0|-O1|-O2] [--unroll=N]\n"
+               "       [--enable-pass=NAME] [--disable-pass=NAME] [--dump-ast] [--time-passes] [--verify-ast]\n"
+               "       [--cache-dir=DIR] [--pipelined-parse] <file|->\n"
+               "   or: %s [options] --serve SOCKET\n"
+               "   or: %s --submit SOCKET <file|->\n"
+               "   or: %s [options] --jobs N <file|dir>...\n"
+               "   or: %s --shutdown SOCKET\n", argv[0], argv[0], argv[0], argv[0], argv[0]);
+        return 0;
+    }
+
+    // The C compiler already does the loop work for --emit-c, and the transpiler has no use for the types
+    PassPipeline* pipeline = &options.pipeline;
+    initPipeline(pipeline, level);
+    if (options.emitC) {
+        for (int pass = PASS_HOIST; pass < PASS_COUNT; pass++) pipeline->enabled[pass] = false;
+    }
+    pipeline->unrollFactor = unroll;
+    pipeline->dump = dump ? stderr : NULL;
+    pipeline->timing = timing ? stderr : NULL;
+    pipeline->verify = verify;
+
+    for (int i = 1; i < argc; i++) {
+        bool enable = strncmp(argv[i], "--enable-pass=", 14) == 0;
+        if (!enable && strncmp(argv[i], "--disable-pass=", 15) != 0) continue;
+
+        const char* name = strchr(argv[i], '=') + 1;
+        if (!setPassEnabled(pipeline, name, enable)) {
+            printf("Unknown pass: %s\n", name);
+            free(paths);
+            return 1;
+        }
+    }
+
+    SimplicError* error = initError();
+    RunResult result = { .status = 1, .returned = false, .returnCode = 0 };
+    Script* script = NULL;
+
+    if (serve != NULL && !submit) {
+        bool ok = shutdown ? stopServer(serve, error) : serveScripts(serve, runScript, &options, error);
+        result.status = ok ? 0 : 1;
+    } else if (submit) {
+        // Sources on stdin are sent whole, files are read by the server
+        if (strcmp(path, "-") == 0) script = readScript(path, error);
+        if (!error->hasError) submitScript(serve, path, script, STDOUT_FILENO, STDERR_FILENO, &result, error);
+    } else if (jobs >= 0) {
+        // The summary goes to stderr, so stdout is what running the scripts one by one prints
+        Batch* batch = initBatch();
+        for (int i = 0; i < pathCount && !error->hasError; i++) addBatchPath(batch, paths[i], error);
+
+        if (!error->hasError) {
+            runBatch(batch, jobs, runScript, &options, stdout);
+            printBatchSummary(batch, stderr);
+
+            result.status = 0;
+            for (size_t i = 0; i < batch->count; i++) {
+                if (batch->jobs[i].result.status != 0) result.status = 1;
+            }
+        }
+        deleteBatch(&batch);
+    } else {
+        script = readScript(path, error);
+        if (!error->hasError) runScript(path, script, stdout, &result, &options);
+    }
+
+    if (error->hasError) {
+        printError(error);
+        result.status = 1;
+    }
     deleteError(&error);
-    free((char*)program);
-    return 0;
-}
\ No newline at end of file
+    deleteScript(&script);
+    free(paths);
+    return result.status;
+}
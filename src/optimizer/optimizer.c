@@ -0,0 +1,1301 @@
+#include "private_optimizer.h"
+
+ConstantEnv envCopy(const ConstantEnv* env) {
+    ConstantEnv res = { .names = NULL, .values = NULL, .count = env->count, .capacity = env->count, .index = copyHashIndex(&env->index) };
+    if (env->count > 0) {
+        res.names = malloc(sizeof(*res.names) * env->count);
+        res.values = malloc(sizeof(int) * env->count);
+        memcpy(res.names, env->names, sizeof(*res.names) * env->count);
+        memcpy(res.values, env->values, sizeof(int) * env->count);
+    }
+    return res;
+}
+
+void envFree(ConstantEnv* env) {
+    free(env->names);
+    free(env->values);
+    freeHashIndex(&env->index);
+    env->names = NULL;
+    env->values = NULL;
+    env->count = 0;
+    env->capacity = 0;
+}
+
+int envFind(const ConstantEnv* env, const char* name) {
+    unsigned int hash = hashName(name);
+    int cursor;
+    for (int i = hashIndexFirst(&env->index, hash, &cursor); i >= 0; i = hashIndexNext(&env->index, hash, &cursor)) {
+        if (strcmp(env->names[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+void envSet(ConstantEnv* env, const char* name, int value) {
+    int i = envFind(env, name);
+    if (i >= 0) {
+        env->values[i] = value;
+        return;
+    }
+
+    if (env->count == env->capacity) {
+        env->capacity = (env->capacity == 0) ? 8 : env->capacity * 2;
+        env->names = realloc(env->names, sizeof(*env->names) * env->capacity);
+        env->values = realloc(env->values, sizeof(int) * env->capacity);
+    }
+    strcpy(env->names[env->count], name);
+    hashIndexAdd(&env->index, hashName(name), env->count);
+    env->values[env->count++] = value;
+}
+
+void envKill(ConstantEnv* env, const char* name) {
+    int i = envFind(env, name);
+    if (i < 0) return;
+    hashIndexRemove(&env->index, hashName(name), i);
+
+    // Move the last entry into the hole
+    env->count--;
+    if (i != env->count) {
+        memcpy(env->names[i], env->names[env->count], IDENTIFIER_SIZE);
+        env->values[i] = env->values[env->count];
+        hashIndexMove(&env->index, hashName(env->names[i]), env->count, i);
+    }
+}
+
+void envIntersect(ConstantEnv* env, const ConstantEnv* other) {
+    int i = 0;
+    while (i < env->count) {
+        int j = envFind(other, env->names[i]);
+        if (j < 0 || other->values[j] != env->values[i]) {
+            envKill(env, env->names[i]); // Does not advance, the hole is filled with another entry
+        } else {
+            i++;
+        }
+    }
+}
+
+void envKillWrittenVars(ConstantEnv* env, SyntaxNode* node) {
+    int i;
+    if (node == NULL) return;
+
+    switch (node->type) {
+        case NODE_ASSIGN:
+        case NODE_UNASSIGN:
+            envKill(env, node->varName);
+            break;
+
+        case NODE_INCREMENT:
+        case NODE_DECREMENT:
+            if (node->subnodeB != NULL && node->subnodeB->type == NODE_VAR)
+                envKill(env, node->subnodeB->varName);
+            break;
+
+        case NODE_BLOCK:
+            i = 0;
+            while (node->blockStatements[i] != NULL) {
+                envKillWrittenVars(env, node->blockStatements[i++]);
+            }
+            break;
+
+        case NODE_WHILE:
+        case NODE_IF:
+            envKillWrittenVars(env, node->subnodeB);
+            envKillWrittenVars(env, node->subnodeC);
+            break;
+
+        default:
+            // Expressions do not write variables
+            break;
+    }
+}
+
+bool foldBinOp(const char* operator, int l, int r, int* result) {
+    // Arithmetic is done unsigned so an overflow wraps around the same way it does at runtime
+    if (strcmp(operator, "+") == 0) { *result = (int)((unsigned int)l + (unsigned int)r); return true; }
+    if (strcmp(operator, "-") == 0) { *result = (int)((unsigned int)l - (unsigned int)r); return true; }
+    if (strcmp(operator, "*") == 0) { *result = (int)((unsigned int)l * (unsigned int)r); return true; }
+
+    // Division by zero must still be reported by the interpreter
+    if (strcmp(operator, "/") == 0 || strcmp(operator, "%") == 0) {
+        if (r == 0 || (l == -2147483647 - 1 && r == -1)) return false;
+        *result = (operator[0] == '/') ? l / r : l % r;
+        return true;
+    }
+
+    if (strcmp(operator, "<") == 0) { *result = (l < r) ? 1 : 0; return true; }
+    if (strcmp(operator, "<=") == 0) { *result = (l <= r) ? 1 : 0; return true; }
+    if (strcmp(operator, ">") == 0) { *result = (l > r) ? 1 : 0; return true; }
+    if (strcmp(operator, ">=") == 0) { *result = (l >= r) ? 1 : 0; return true; }
+    if (strcmp(operator, "==") == 0) { *result = (l == r) ? 1 : 0; return true; }
+    if (strcmp(operator, "!=") == 0) { *result = (l != r) ? 1 : 0; return true; }
+    if (strcmp(operator, "&&") == 0) { *result = (l && r) ? 1 : 0; return true; }
+    if (strcmp(operator, "||") == 0) { *result = (l || r) ? 1 : 0; return true; }
+
+    return false;
+}
+
+SyntaxNode* foldConstants(SyntaxNode* node) {
+    if (node == NULL || node->type != NODE_BIN_OP) return node;
+
+    node->subnodeA = foldConstants(node->subnodeA);
+    node->subnodeB = foldConstants(node->subnodeB);
+
+    if (node->subnodeA->type != NODE_NUMBER || node->subnodeB->type != NODE_NUMBER) return node;
+
+    int value;
+    if (!foldBinOp(node->operator, node->subnodeA->numberValue, node->subnodeB->numberValue, &value)) return node;
+
+    SyntaxNode* res = initNode();
+    res->type = NODE_NUMBER;
+    res->numberValue = value;
+    freeSyntaxTree(node);
+    return res;
+}
+
+SyntaxNode* substituteConstants(SyntaxNode* expr, const ConstantEnv* env) {
+    if (expr == NULL) return NULL;
+
+    if (expr->type == NODE_VAR) {
+        int i = envFind(env, expr->varName);
+        if (i < 0) return expr;
+
+        SyntaxNode* res = initNode();
+        res->type = NODE_NUMBER;
+        res->numberValue = env->values[i];
+        freeSyntaxTree(expr);
+        return res;
+    }
+
+    if (expr->type == NODE_BIN_OP) {
+        expr->subnodeA = substituteConstants(expr->subnodeA, env);
+        expr->subnodeB = substituteConstants(expr->subnodeB, env);
+        return foldConstants(expr);
+    }
+
+    return expr;
+}
+
+void propagateStatement(SyntaxNode* node, ConstantEnv* env) {
+    int i;
+    if (node == NULL) return;
+
+    switch (node->type) {
+        case NODE_ASSIGN:
+            node->subnodeB = substituteConstants(node->subnodeB, env);
+            if (node->subnodeB->type == NODE_NUMBER) {
+                envSet(env, node->varName, node->subnodeB->numberValue);
+            } else {
+                envKill(env, node->varName); // Unknown value or string
+            }
+            break;
+
+        case NODE_UNASSIGN:
+            envKill(env, node->varName);
+            break;
+
+        case NODE_PRINT:
+        case NODE_PRINTLN:
+        case NODE_RETURN:
+            node->subnodeB = substituteConstants(node->subnodeB, env);
+            break;
+
+        case NODE_INCREMENT:
+        case NODE_DECREMENT:
+            // The operand is the variable being written, so it is never replaced
+            if (node->subnodeB != NULL && node->subnodeB->type == NODE_VAR) {
+                i = envFind(env, node->subnodeB->varName);
+                if (i >= 0) {
+                    unsigned int value = (unsigned int)env->values[i];
+                    env->values[i] = (int)((node->type == NODE_INCREMENT) ? value + 1 : value - 1);
+                }
+            }
+            break;
+
+        case NODE_BLOCK:
+            i = 0;
+            while (node->blockStatements[i] != NULL) {
+                propagateStatement(node->blockStatements[i++], env);
+            }
+            break;
+
+        case NODE_WHILE: {
+            // Anything written in the loop may change between iterations
+            envKillWrittenVars(env, node);
+            node->subnodeA = substituteConstants(node->subnodeA, env);
+
+            ConstantEnv bodyEnv = envCopy(env);
+            propagateStatement(node->subnodeB, &bodyEnv);
+            envFree(&bodyEnv);
+            break;
+        }
+
+        case NODE_IF: {
+            node->subnodeA = substituteConstants(node->subnodeA, env);
+
+            // Only the reachable branch can change the known values
+            if (node->subnodeA->type == NODE_NUMBER) {
+                if (node->subnodeA->numberValue) {
+                    propagateStatement(node->subnodeB, env);
+                } else {
+                    propagateStatement(node->subnodeC, env);
+                }
+                break;
+            }
+
+            ConstantEnv elseEnv = envCopy(env);
+            propagateStatement(node->subnodeB, env);
+            propagateStatement(node->subnodeC, &elseEnv);
+            envIntersect(env, &elseEnv);
+            envFree(&elseEnv);
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+void propagateConstants(SyntaxNode* program) {
+    ConstantEnv env = { .names = NULL, .values = NULL, .count = 0, .capacity = 0 };
+    propagateStatement(program, &env);
+    envFree(&env);
+}
+
+bool pruneReturns(SyntaxNode* node) {
+    int i;
+    if (node == NULL) return false;
+
+    switch (node->type) {
+        case NODE_RETURN:
+            return true;
+
+        case NODE_BLOCK:
+            // Pruned blocks end with the statement that returns
+            for (i = 0; node->blockStatements[i] != NULL; i++);
+            return i > 0 && pruneReturns(node->blockStatements[i - 1]);
+
+        case NODE_IF:
+            return pruneReturns(node->subnodeB) && pruneReturns(node->subnodeC);
+
+        default:
+            return false;
+    }
+}
+
+void pruneBlock(SyntaxNode* block) {
+    int count = 0, size = 0;
+    while (block->blockStatements[count] != NULL) count++;
+
+    // Spliced branches can make the block longer
+    SyntaxNode** kept = malloc(sizeof(SyntaxNode*) * (count + 1));
+    int capacity = count + 1;
+    bool returned = false;
+
+    for (int i = 0; i < count; i++) {
+        SyntaxNode* node = block->blockStatements[i];
+        if (returned) {
+            freeSyntaxTree(node); // Never reached
+            continue;
+        }
+
+        if (node->type == NODE_WHILE && node->subnodeA->type == NODE_NUMBER && node->subnodeA->numberValue == 0) {
+            freeSyntaxTree(node);
+            continue;
+        }
+
+        if (node->type == NODE_IF && node->subnodeA->type == NODE_NUMBER) {
+            // Only the branch that runs is kept, its statements take the place of the IF
+            SyntaxNode* branch = node->subnodeA->numberValue ? node->subnodeB : node->subnodeC;
+            if (branch == node->subnodeB) node->subnodeB = NULL; else node->subnodeC = NULL;
+            freeSyntaxTree(node);
+            if (branch == NULL) continue;
+
+            if (branch->type != NODE_BLOCK) {
+                node = branch;
+            } else {
+                pruneBlock(branch);
+                int length = 0;
+                while (branch->blockStatements[length] != NULL) length++;
+
+                if (size + length + (count - i) > capacity) {
+                    capacity = size + length + (count - i);
+                    kept = realloc(kept, sizeof(SyntaxNode*) * capacity);
+                }
+                memcpy(&kept[size], branch->blockStatements, sizeof(SyntaxNode*) * length);
+                size += length;
+                returned = length > 0 && pruneReturns(kept[size - 1]);
+
+                free(branch->blockStatements);
+                free(branch);
+                continue;
+            }
+        }
+
+        pruneStatement(node);
+        kept[size++] = node;
+        returned = pruneReturns(node);
+    }
+
+    kept[size] = NULL;
+    free(block->blockStatements);
+    block->blockStatements = kept;
+}
+
+void pruneStatement(SyntaxNode* node) {
+    switch (node->type) {
+        case NODE_BLOCK:
+            pruneBlock(node);
+            break;
+
+        case NODE_WHILE:
+        case NODE_IF:
+            if (node->subnodeB != NULL) pruneStatement(node->subnodeB);
+            if (node->subnodeC != NULL) pruneStatement(node->subnodeC);
+            break;
+
+        default:
+            break;
+    }
+}
+
+void eliminateDeadCode(SyntaxNode* program) {
+    if (program != NULL) pruneStatement(program);
+}
+
+int typeVarIndex(TypeInference* ti, const char* name) {
+    for (int i = 0; i < ti->count; i++) {
+        if (strcmp(ti->names[i], name) == 0) return i;
+    }
+
+    if (ti->count == ti->capacity) {
+        ti->capacity = (ti->capacity == 0) ? 16 : ti->capacity * 2;
+        ti->names = realloc(ti->names, sizeof(*ti->names) * ti->capacity);
+    }
+    strcpy(ti->names[ti->count], name);
+    return ti->count++;
+}
+
+void typeCollectVars(TypeInference* ti, SyntaxNode* node) {
+    int i;
+    if (node == NULL) return;
+
+    switch (node->type) {
+        case NODE_VAR:
+        case NODE_ASSIGN:
+        case NODE_UNASSIGN:
+            typeVarIndex(ti, node->varName);
+            typeCollectVars(ti, node->subnodeB);
+            break;
+
+        case NODE_BLOCK:
+            i = 0;
+            while (node->blockStatements[i] != NULL) {
+                typeCollectVars(ti, node->blockStatements[i++]);
+            }
+            break;
+
+        default:
+            typeCollectVars(ti, node->subnodeA);
+            typeCollectVars(ti, node->subnodeB);
+            typeCollectVars(ti, node->subnodeC);
+            break;
+    }
+}
+
+unsigned char* typeEnvCopy(const TypeInference* ti, const unsigned char* env) {
+    unsigned char* res = malloc(ti->count + 1); // Never empty, even for programs without variables
+    memcpy(res, env, ti->count);
+    return res;
+}
+
+unsigned char typeOfExpr(TypeInference* ti, SyntaxNode* expr, unsigned char* env) {
+    unsigned char l, r;
+    int v;
+
+    switch (expr->type) {
+        case NODE_NUMBER:
+            expr->provenInt = true;
+            return TYPE_INT;
+
+        case NODE_VAR:
+            v = typeVarIndex(ti, expr->varName);
+            expr->provenInt = (env[v] == TYPE_INT);
+            // Reading an unset variable stops the program, so from here on it is set
+            env[v] &= (unsigned char)~TYPE_UNSET;
+            return env[v];
+
+        case NODE_BIN_OP:
+            l = typeOfExpr(ti, expr->subnodeA, env);
+            r = typeOfExpr(ti, expr->subnodeB, env);
+            expr->provenInt = expr->subnodeA->provenInt && expr->subnodeB->provenInt;
+            if (l == 0 || r == 0) return 0; // Never completes
+
+            // Only + can build a string, every other operator counts strings as 0
+            if (strcmp(expr->operator, "+") != 0) return TYPE_INT;
+            return (((l | r) & TYPE_STR) ? TYPE_STR : 0) | ((l & r & TYPE_INT) ? TYPE_INT : 0);
+
+        default:
+            expr->provenInt = false;
+            return TYPE_STR;
+    }
+}
+
+void typeStatement(TypeInference* ti, SyntaxNode* node, unsigned char* env) {
+    int i, v;
+    unsigned char t;
+    if (node == NULL) return;
+
+    switch (node->type) {
+        case NODE_ASSIGN:
+            t = typeOfExpr(ti, node->subnodeB, env);
+            v = typeVarIndex(ti, node->varName);
+            env[v] = t;
+            ti->everHeld[v] |= t;
+            break;
+
+        case NODE_UNASSIGN:
+            env[typeVarIndex(ti, node->varName)] = TYPE_UNSET;
+            break;
+
+        case NODE_PRINT:
+        case NODE_PRINTLN:
+            typeOfExpr(ti, node->subnodeB, env);
+            break;
+
+        case NODE_RETURN:
+            typeOfExpr(ti, node->subnodeB, env);
+            memset(env, 0, ti->count); // Nothing after it runs, so it adds nothing to the joins
+            break;
+
+        case NODE_INCREMENT:
+        case NODE_DECREMENT:
+            // Only integers change, the variable keeps its type
+            if (node->subnodeB != NULL && node->subnodeB->type == NODE_VAR)
+                typeOfExpr(ti, node->subnodeB, env);
+            break;
+
+        case NODE_BLOCK:
+            i = 0;
+            while (node->blockStatements[i] != NULL) {
+                typeStatement(ti, node->blockStatements[i++], env);
+            }
+            break;
+
+        case NODE_WHILE: {
+            // The condition runs on entry and after every iteration, it sees the types of both until they settle
+            unsigned char* head = typeEnvCopy(ti, env);
+            unsigned char* body;
+            bool changed;
+
+            do {
+                memcpy(env, head, ti->count);
+                typeOfExpr(ti, node->subnodeA, env);
+                body = typeEnvCopy(ti, env);
+                typeStatement(ti, node->subnodeB, body);
+
+                changed = false;
+                for (i = 0; i < ti->count; i++) {
+                    if ((head[i] | body[i]) != head[i]) {
+                        head[i] |= body[i];
+                        changed = true;
+                    }
+                }
+                free(body);
+            } while (changed);
+
+            free(head);
+            break;
+        }
+
+        case NODE_IF: {
+            typeOfExpr(ti, node->subnodeA, env);
+
+            unsigned char* elseEnv = typeEnvCopy(ti, env);
+            typeStatement(ti, node->subnodeB, env);
+            typeStatement(ti, node->subnodeC, elseEnv);
+            for (i = 0; i < ti->count; i++) {
+                env[i] |= elseEnv[i];
+            }
+            free(elseEnv);
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+void typeMarkAssignments(TypeInference* ti, SyntaxNode* node) {
+    int i;
+    if (node == NULL) return;
+
+    switch (node->type) {
+        case NODE_ASSIGN:
+            node->provenInt = !(ti->everHeld[typeVarIndex(ti, node->varName)] & TYPE_STR);
+            break;
+
+        case NODE_BLOCK:
+            i = 0;
+            while (node->blockStatements[i] != NULL) {
+                typeMarkAssignments(ti, node->blockStatements[i++]);
+            }
+            break;
+
+        case NODE_WHILE:
+        case NODE_IF:
+            typeMarkAssignments(ti, node->subnodeB);
+            typeMarkAssignments(ti, node->subnodeC);
+            break;
+
+        default:
+            break;
+    }
+}
+
+void inferTypes(SyntaxNode* program) {
+    TypeInference ti = { .names = NULL, .count = 0, .capacity = 0, .everHeld = NULL };
+    typeCollectVars(&ti, program);
+
+    // Every variable starts unset
+    unsigned char* env = malloc(ti.count + 1);
+    ti.everHeld = malloc(ti.count + 1);
+    memset(env, TYPE_UNSET, ti.count);
+    memset(ti.everHeld, TYPE_UNSET, ti.count);
+
+    typeStatement(&ti, program, env);
+    typeMarkAssignments(&ti, program);
+
+    free(env);
+    free(ti.everHeld);
+    free(ti.names);
+}
+
+SyntaxNode* makeNumber(int value) {
+    SyntaxNode* node = initNode();
+    node->type = NODE_NUMBER;
+    node->numberValue = value;
+    return node;
+}
+
+SyntaxNode* makeVar(const char* name) {
+    SyntaxNode* node = initNode();
+    node->type = NODE_VAR;
+    strcpy(node->varName, name);
+    return node;
+}
+
+SyntaxNode* makeBinOp(const char* operator, SyntaxNode* a, SyntaxNode* b) {
+    SyntaxNode* node = initNode();
+    node->type = NODE_BIN_OP;
+    strcpy(node->operator, operator);
+    node->subnodeA = a;
+    node->subnodeB = b;
+    return node;
+}
+
+SyntaxNode* makeBlock(void) {
+    SyntaxNode* node = initNode();
+    node->type = NODE_BLOCK;
+    node->blockStatements = calloc(1, sizeof(SyntaxNode*));
+    return node;
+}
+
+SyntaxNode* makeAssign(const char* name, SyntaxNode* value) {
+    SyntaxNode* node = initNode();
+    node->type = NODE_ASSIGN;
+    strcpy(node->varName, name);
+    node->subnodeB = value;
+    return node;
+}
+
+void exprCollectStable(ExprPass* pass, SyntaxNode* node, ConstantEnv* unstable) {
+    int i, n;
+    if (node == NULL) return;
+
+    switch (node->type) {
+        case NODE_ASSIGN:
+            envSet(&pass->stable, node->varName, 0);
+            if (!node->provenInt) envSet(unstable, node->varName, 0); // May hold a string
+            if (sscanf(node->varName, HIDDEN_VAR_FORMAT, &n) == 1 && n >= pass->tempCount) pass->tempCount = n + 1;
+            break;
+
+        case NODE_UNASSIGN:
+            envSet(unstable, node->varName, 0);
+            break;
+
+        case NODE_BLOCK:
+            i = 0;
+            while (node->blockStatements[i] != NULL) {
+                exprCollectStable(pass, node->blockStatements[i++], unstable);
+            }
+            break;
+
+        case NODE_WHILE:
+        case NODE_IF:
+            exprCollectStable(pass, node->subnodeB, unstable);
+            exprCollectStable(pass, node->subnodeC, unstable);
+            break;
+
+        default:
+            break;
+    }
+}
+
+bool exprSafe(SyntaxNode* expr, const ConstantEnv* vars) {
+    switch (expr->type) {
+        case NODE_NUMBER:
+            return true;
+
+        case NODE_VAR:
+            return envFind(vars, expr->varName) >= 0;
+
+        case NODE_BIN_OP:
+            // Only divisions by a constant that can't fail
+            if (strcmp(expr->operator, "/") == 0 || strcmp(expr->operator, "%") == 0) {
+                SyntaxNode* divisor = expr->subnodeB;
+                if (divisor->type != NODE_NUMBER || divisor->numberValue == 0 || divisor->numberValue == -1) return false;
+            }
+            return exprSafe(expr->subnodeA, vars) && exprSafe(expr->subnodeB, vars);
+
+        default:
+            return false; // Strings
+    }
+}
+
+void exprCollectSafe(SyntaxNode** slot, const ConstantEnv* vars, bool nested, ExprSlotList* list) {
+    SyntaxNode* expr = *slot;
+    if (expr->type != NODE_BIN_OP) return;
+
+    if (!exprSafe(expr, vars)) {
+        exprCollectSafe(&expr->subnodeA, vars, nested, list);
+        exprCollectSafe(&expr->subnodeB, vars, nested, list);
+        return;
+    }
+
+    if (list->count == list->capacity) {
+        list->capacity = (list->capacity == 0) ? 16 : list->capacity * 2;
+        list->items = realloc(list->items, sizeof(ExprSlot) * list->capacity);
+    }
+    int i = list->count++;
+    list->items[i] = (ExprSlot){ .slot = slot, .hash = hashSyntaxTree(expr), .end = 0 };
+
+    if (nested) {
+        exprCollectSafe(&expr->subnodeA, vars, nested, list);
+        exprCollectSafe(&expr->subnodeB, vars, nested, list);
+    }
+    list->items[i].end = list->count;
+}
+
+void exprCollectInStatement(SyntaxNode* node, const ConstantEnv* vars, ExprSlotList* list) {
+    int i;
+    if (node == NULL) return;
+
+    switch (node->type) {
+        case NODE_ASSIGN:
+        case NODE_PRINT:
+        case NODE_PRINTLN:
+        case NODE_RETURN:
+            exprCollectSafe(&node->subnodeB, vars, false, list);
+            break;
+
+        case NODE_BLOCK:
+            i = 0;
+            while (node->blockStatements[i] != NULL) {
+                exprCollectInStatement(node->blockStatements[i++], vars, list);
+            }
+            break;
+
+        case NODE_WHILE:
+        case NODE_IF:
+            exprCollectSafe(&node->subnodeA, vars, false, list);
+            exprCollectInStatement(node->subnodeB, vars, list);
+            exprCollectInStatement(node->subnodeC, vars, list);
+            break;
+
+        default:
+            break;
+    }
+}
+
+void exprNewVar(ExprPass* pass, ConstantEnv* assigned, char* name) {
+    snprintf(name, IDENTIFIER_SIZE, HIDDEN_VAR_FORMAT, pass->tempCount++);
+
+    // Only holds integers and it's assigned before any read
+    envSet(&pass->stable, name, 0);
+    if (assigned != NULL) envSet(assigned, name, 0);
+    if (pass->loopDepth > 0) envSet(&pass->loopTemps, name, 0);
+}
+
+SyntaxNode* exprMoveToVar(ExprPass* pass, SyntaxNode** slot, ConstantEnv* assigned) {
+    char name[IDENTIFIER_SIZE];
+    exprNewVar(pass, assigned, name);
+
+    SyntaxNode* set = makeAssign(name, *slot);
+    *slot = makeVar(name);
+    return set;
+}
+
+void exprInsert(SyntaxNode* block, int index, SyntaxNode* statement) {
+    int count = 0;
+    while (block->blockStatements[count] != NULL) count++;
+
+    block->blockStatements = realloc(block->blockStatements, sizeof(SyntaxNode*) * (count + 2));
+    memmove(&block->blockStatements[index + 1], &block->blockStatements[index], sizeof(SyntaxNode*) * (count - index + 1));
+    block->blockStatements[index] = statement;
+}
+
+int exprHoist(ExprPass* pass, SyntaxNode* block, int index, ConstantEnv* assigned) {
+    SyntaxNode* loop = block->blockStatements[index];
+    ExprSlotList list = { .items = NULL, .count = 0, .capacity = 0 };
+    SyntaxNode** hoisted = NULL;
+    int count = 0;
+
+    // Variables assigned before the loop that keep their value through it
+    ConstantEnv invariant = envCopy(assigned);
+    envKillWrittenVars(&invariant, loop);
+    exprCollectSafe(&loop->subnodeA, &invariant, false, &list);
+    exprCollectInStatement(loop->subnodeB, &invariant, &list);
+    envFree(&invariant);
+
+    for (int i = 0; i < list.count; i++) {
+        SyntaxNode** slot = list.items[i].slot;
+        int same = -1;
+
+        // Copies of an expression already moved out read the same variable
+        for (int j = 0; j < count && same < 0; j++) {
+            if (hashSyntaxTree(hoisted[j]->subnodeB) == list.items[i].hash && compareSyntaxTree(hoisted[j]->subnodeB, *slot)) same = j;
+        }
+
+        if (same >= 0) {
+            freeSyntaxTree(*slot);
+            *slot = makeVar(hoisted[same]->varName);
+        } else {
+            hoisted = realloc(hoisted, sizeof(SyntaxNode*) * (count + 1));
+            hoisted[count] = exprMoveToVar(pass, slot, assigned);
+            exprInsert(block, index + count, hoisted[count]);
+            count++;
+        }
+    }
+
+    free(list.items);
+    free(hoisted);
+    return count;
+}
+
+int exprReuse(ExprPass* pass, SyntaxNode* block, int index, ConstantEnv* assigned) {
+    SyntaxNode* statement = block->blockStatements[index];
+    SyntaxNode** root;
+    int count = 0;
+
+    switch (statement->type) {
+        case NODE_ASSIGN:
+        case NODE_PRINT:
+        case NODE_PRINTLN:
+        case NODE_RETURN:
+            root = &statement->subnodeB;
+            break;
+
+        case NODE_IF:
+            root = &statement->subnodeA;
+            break;
+
+        default:
+            return 0; // A WHILE condition runs again after every iteration, it can only be hoisted
+    }
+
+    for (;;) {
+        ExprSlotList list = { .items = NULL, .count = 0, .capacity = 0 };
+        exprCollectSafe(root, assigned, true, &list);
+
+        // Outermost expression that shows up more than once
+        int found = -1;
+        for (int i = 0; i < list.count && found < 0; i++) {
+            for (int j = list.items[i].end; j < list.count; j++) {
+                if (list.items[i].hash == list.items[j].hash && compareSyntaxTree(*list.items[i].slot, *list.items[j].slot)) {
+                    found = i;
+                    break;
+                }
+            }
+        }
+        if (found < 0) {
+            free(list.items);
+            return count;
+        }
+
+        ExprSlot first = list.items[found];
+        SyntaxNode* set = exprMoveToVar(pass, first.slot, assigned);
+
+        // Expressions inside a replaced copy are skipped, they were freed with it
+        int j = first.end;
+        while (j < list.count) {
+            if (list.items[j].hash == first.hash && compareSyntaxTree(set->subnodeB, *list.items[j].slot)) {
+                freeSyntaxTree(*list.items[j].slot);
+                *list.items[j].slot = makeVar(set->varName);
+                j = list.items[j].end;
+            } else {
+                j++;
+            }
+        }
+
+        exprInsert(block, index + count, set);
+        count++;
+        free(list.items);
+    }
+}
+
+void indCountUses(SyntaxNode* node, const char* name, int* reads, int* writes) {
+    int i;
+    if (node == NULL) return;
+
+    switch (node->type) {
+        case NODE_VAR:
+            if (strcmp(node->varName, name) == 0) (*reads)++;
+            return;
+
+        case NODE_ASSIGN:
+        case NODE_UNASSIGN:
+            if (strcmp(node->varName, name) == 0) (*writes)++;
+            break;
+
+        case NODE_INCREMENT:
+        case NODE_DECREMENT:
+            if (node->subnodeB != NULL && node->subnodeB->type == NODE_VAR && strcmp(node->subnodeB->varName, name) == 0) (*writes)++;
+            break;
+
+        case NODE_BLOCK:
+            i = 0;
+            while (node->blockStatements[i] != NULL) {
+                indCountUses(node->blockStatements[i++], name, reads, writes);
+            }
+            return;
+
+        default:
+            break;
+    }
+
+    indCountUses(node->subnodeA, name, reads, writes);
+    indCountUses(node->subnodeB, name, reads, writes);
+    indCountUses(node->subnodeC, name, reads, writes);
+}
+
+bool indStep(SyntaxNode* node, const char** name, int* step) {
+    if ((node->type == NODE_INCREMENT || node->type == NODE_DECREMENT) && node->subnodeB != NULL && node->subnodeB->type == NODE_VAR) {
+        *name = node->subnodeB->varName;
+        *step = (node->type == NODE_INCREMENT) ? 1 : -1;
+        return true;
+    }
+
+    // SET I = I + c and SET I = I - c
+    SyntaxNode* value = node->subnodeB;
+    if (node->type != NODE_ASSIGN || value->type != NODE_BIN_OP || value->subnodeA->type != NODE_VAR ||
+        value->subnodeB->type != NODE_NUMBER || strcmp(value->subnodeA->varName, node->varName) != 0)
+        return false;
+
+    unsigned int c = (unsigned int)value->subnodeB->numberValue;
+    if (strcmp(value->operator, "+") == 0) {
+        *step = (int)c;
+    } else if (strcmp(value->operator, "-") == 0) {
+        *step = (int)(0u - c);
+    } else {
+        return false;
+    }
+    *name = node->varName;
+    return true;
+}
+
+bool indIsInductionVar(ExprPass* pass, SyntaxNode* loop, const char* name, const ConstantEnv* assigned) {
+    int reads = 0, writes = 0;
+    if (envFind(&pass->stable, name) < 0 || envFind(assigned, name) < 0) return false;
+
+    indCountUses(loop, name, &reads, &writes);
+    return writes == 1;
+}
+
+bool indLinear(SyntaxNode* expr, const char* name, int* factor) {
+    if (expr->type == NODE_VAR && strcmp(expr->varName, name) == 0) {
+        *factor = 1;
+        return true;
+    }
+    if (expr->type != NODE_BIN_OP || strcmp(expr->operator, "*") != 0) return false;
+
+    SyntaxNode* a = expr->subnodeA;
+    SyntaxNode* b = expr->subnodeB;
+    if (a->type == NODE_NUMBER) {
+        SyntaxNode* swap = a;
+        a = b;
+        b = swap;
+    }
+    if (a->type != NODE_VAR || b->type != NODE_NUMBER || strcmp(a->varName, name) != 0) return false;
+
+    *factor = b->numberValue;
+    return true;
+}
+
+bool indAccumulation(ExprPass* pass, SyntaxNode* loop, SyntaxNode* node, const char* name, const ConstantEnv* invariant,
+                     const ConstantEnv* assigned) {
+    int reads = 0, writes = 0, factor;
+    SyntaxNode* value = node->subnodeB;
+
+    if (node->type != NODE_ASSIGN || value->type != NODE_BIN_OP || value->subnodeA->type != NODE_VAR ||
+        strcmp(value->subnodeA->varName, node->varName) != 0 || strcmp(node->varName, name) == 0)
+        return false;
+    if (strcmp(value->operator, "+") != 0 && strcmp(value->operator, "-") != 0) return false;
+
+    // Nothing else in the loop may see the partial sums
+    if (envFind(&pass->stable, node->varName) < 0 || envFind(assigned, node->varName) < 0) return false;
+    indCountUses(loop, node->varName, &reads, &writes);
+    if (reads != 1 || writes != 1) return false;
+
+    return exprSafe(value->subnodeB, invariant) || indLinear(value->subnodeB, name, &factor);
+}
+
+SyntaxNode* indTripCount(SyntaxNode* loop) {
+    SyntaxNode* cond = loop->subnodeA;
+    SyntaxNode* count = makeBinOp("-", copySyntaxTree(cond->subnodeB), makeVar(cond->subnodeA->varName));
+    if (strcmp(cond->operator, "<=") == 0) count = makeBinOp("+", count, makeNumber(1));
+    return count;
+}
+
+int indClosedForm(ExprPass* pass, SyntaxNode* block, int index, ConstantEnv* assigned) {
+    SyntaxNode* loop = block->blockStatements[index];
+    SyntaxNode* cond = loop->subnodeA;
+    SyntaxNode* body = loop->subnodeB;
+    const char* stepVar;
+    int step, factor, update = -1;
+    bool linear = false;
+
+    // WHILE I LT E DO or WHILE I LEQ E DO
+    if (body->type != NODE_BLOCK || cond->type != NODE_BIN_OP || cond->subnodeA->type != NODE_VAR) return 0;
+    if (strcmp(cond->operator, "<") != 0 && strcmp(cond->operator, "<=") != 0) return 0;
+    const char* name = cond->subnodeA->varName;
+    if (!indIsInductionVar(pass, loop, name, assigned)) return 0;
+
+    ConstantEnv invariant = envCopy(assigned);
+    envKillWrittenVars(&invariant, loop);
+    bool ok = exprSafe(cond->subnodeB, &invariant);
+
+    // The body only increments I once and adds terms that depend on I or on nothing the loop writes
+    for (int i = 0; ok && body->blockStatements[i] != NULL; i++) {
+        SyntaxNode* node = body->blockStatements[i];
+        if (indStep(node, &stepVar, &step) && strcmp(stepVar, name) == 0) {
+            ok = step == 1;
+            update = i;
+        } else {
+            ok = indAccumulation(pass, loop, node, name, &invariant, assigned);
+            if (ok && !exprSafe(node->subnodeB->subnodeB, &invariant)) linear = true;
+        }
+    }
+    if (!ok || update < 0) {
+        envFree(&invariant);
+        return 0;
+    }
+
+    // n = E - I iterations, and I takes n * I + n * (n - 1) / 2 over them. Every operation wraps around like the
+    // loop would, n / 2 * (n - 1 + n % 2) is n * (n - 1) / 2 without the overflow of the product
+    char count[IDENTIFIER_SIZE], triangle[IDENTIFIER_SIZE];
+    SyntaxNode* fast = makeBlock();
+    int size = 0;
+
+    exprNewVar(pass, NULL, count);
+    exprInsert(fast, size++, makeAssign(count, indTripCount(loop)));
+    if (linear) {
+        exprNewVar(pass, NULL, triangle);
+        SyntaxNode* half = makeBinOp("/", makeVar(count), makeNumber(2));
+        SyntaxNode* other = makeBinOp("+", makeBinOp("-", makeVar(count), makeNumber(1)), makeBinOp("%", makeVar(count), makeNumber(2)));
+        exprInsert(fast, size++, makeAssign(triangle, makeBinOp("*", half, other)));
+    }
+
+    for (int i = 0; body->blockStatements[i] != NULL; i++) {
+        SyntaxNode* node = body->blockStatements[i];
+        if (i == update) continue;
+
+        SyntaxNode* term = node->subnodeB->subnodeB;
+        SyntaxNode* total;
+        if (exprSafe(term, &invariant)) {
+            total = makeBinOp("*", makeVar(count), copySyntaxTree(term));
+        } else {
+            indLinear(term, name, &factor);
+            total = makeBinOp("+", makeBinOp("*", makeVar(count), makeVar(name)), makeVar(triangle));
+            if (i > update) total = makeBinOp("+", total, makeVar(count)); // Sees I after its increment
+            if (factor != 1) total = makeBinOp("*", makeNumber(factor), total);
+        }
+        exprInsert(fast, size++, makeAssign(node->varName, makeBinOp(node->subnodeB->operator, makeVar(node->varName), total)));
+    }
+    exprInsert(fast, size++, makeAssign(name, makeBinOp("+", makeVar(name), makeVar(count))));
+    envFree(&invariant);
+
+    // Taken when the loop runs and n fits in an int, the loop then finds its condition false right away
+    SyntaxNode* shortcut = initNode();
+    shortcut->type = NODE_IF;
+    SyntaxNode* runs = makeBinOp(cond->operator, makeVar(name), copySyntaxTree(cond->subnodeB));
+    shortcut->subnodeA = makeBinOp("&&", runs, makeBinOp(">", indTripCount(loop), makeNumber(0)));
+    shortcut->subnodeB = fast;
+    exprInsert(block, index, shortcut);
+    return 1;
+}
+
+void indCollectFactors(SyntaxNode* node, const char* name, int** factors, int* count) {
+    int i, factor;
+    if (node == NULL) return;
+
+    if (node->type == NODE_BLOCK) {
+        i = 0;
+        while (node->blockStatements[i] != NULL) {
+            indCollectFactors(node->blockStatements[i++], name, factors, count);
+        }
+        return;
+    }
+
+    if (node->type == NODE_BIN_OP && indLinear(node, name, &factor) && factor != 0 && factor != 1) {
+        for (i = 0; i < *count && (*factors)[i] != factor; i++);
+        if (i == *count) {
+            *factors = realloc(*factors, sizeof(int) * (*count + 1));
+            (*factors)[(*count)++] = factor;
+        }
+        return;
+    }
+
+    indCollectFactors(node->subnodeA, name, factors, count);
+    indCollectFactors(node->subnodeB, name, factors, count);
+    indCollectFactors(node->subnodeC, name, factors, count);
+}
+
+void indReplaceProducts(SyntaxNode** slot, const char* name, int factor, const char* product) {
+    int i, f;
+    SyntaxNode* node = *slot;
+    if (node == NULL) return;
+
+    if (node->type == NODE_BLOCK) {
+        i = 0;
+        while (node->blockStatements[i] != NULL) {
+            indReplaceProducts(&node->blockStatements[i++], name, factor, product);
+        }
+        return;
+    }
+
+    if (node->type == NODE_BIN_OP && indLinear(node, name, &f) && f == factor) {
+        freeSyntaxTree(node);
+        *slot = makeVar(product);
+        return;
+    }
+
+    indReplaceProducts(&node->subnodeA, name, factor, product);
+    indReplaceProducts(&node->subnodeB, name, factor, product);
+    indReplaceProducts(&node->subnodeC, name, factor, product);
+}
+
+int indStrengthReduce(ExprPass* pass, SyntaxNode* block, int index, ConstantEnv* assigned) {
+    SyntaxNode* loop = block->blockStatements[index];
+    SyntaxNode* body = loop->subnodeB;
+    char product[IDENTIFIER_SIZE];
+    const char* name;
+    int step, count = 0;
+    if (body->type != NODE_BLOCK) return 0;
+
+    // I changes by a constant once per iteration, so I * c changes by step * c
+    for (int i = 0; body->blockStatements[i] != NULL; i++) {
+        if (!indStep(body->blockStatements[i], &name, &step) || !indIsInductionVar(pass, loop, name, assigned)) continue;
+
+        int* factors = NULL;
+        int factorCount = 0;
+        indCollectFactors(loop->subnodeA, name, &factors, &factorCount);
+        indCollectFactors(body, name, &factors, &factorCount);
+
+        for (int j = 0; j < factorCount; j++) {
+            exprNewVar(pass, assigned, product);
+            indReplaceProducts(&loop->subnodeA, name, factors[j], product);
+            indReplaceProducts(&loop->subnodeB, name, factors[j], product);
+
+            SyntaxNode* start = makeBinOp("*", makeVar(name), makeNumber(factors[j]));
+            int delta = (int)((unsigned int)step * (unsigned int)factors[j]);
+            exprInsert(block, index + count++, makeAssign(product, start));
+            exprInsert(body, i + 1, makeAssign(product, makeBinOp("+", makeVar(product), makeNumber(delta))));
+        }
+        i += factorCount;
+        free(factors);
+    }
+
+    return count;
+}
+
+int unrollSize(SyntaxNode* node) {
+    int i, size = 1;
+    if (node == NULL) return 0;
+    if (node->type == NODE_WHILE) return UNROLL_MAX_NODES + 1; // Only innermost loops
+
+    if (node->type == NODE_BLOCK) {
+        i = 0;
+        while (node->blockStatements[i] != NULL) {
+            size += unrollSize(node->blockStatements[i++]);
+        }
+        return size;
+    }
+    return size + unrollSize(node->subnodeA) + unrollSize(node->subnodeB) + unrollSize(node->subnodeC);
+}
+
+int unrollLoop(ExprPass* pass, SyntaxNode* block, int index, ConstantEnv* assigned) {
+    SyntaxNode* loop = block->blockStatements[index];
+    SyntaxNode* cond = loop->subnodeA;
+    SyntaxNode* body = loop->subnodeB;
+    const char* name = NULL;
+    const char* stepVar;
+    int step = 0, s;
+
+    // WHILE I LT E with I going up, or WHILE I GT E with I going down
+    if (body->type != NODE_BLOCK || cond->type != NODE_BIN_OP || cond->subnodeA->type != NODE_VAR) return 0;
+    bool up = strcmp(cond->operator, "<") == 0 || strcmp(cond->operator, "<=") == 0;
+    bool down = strcmp(cond->operator, ">") == 0 || strcmp(cond->operator, ">=") == 0;
+    if ((!up && !down) || unrollSize(body) > UNROLL_MAX_NODES) return 0;
+
+    for (int i = 0; body->blockStatements[i] != NULL; i++) {
+        if (indStep(body->blockStatements[i], &stepVar, &s) && strcmp(stepVar, cond->subnodeA->varName) == 0) {
+            name = stepVar;
+            step = s;
+        }
+    }
+    if (name == NULL || (up ? step <= 0 : step >= 0) || !indIsInductionVar(pass, loop, name, assigned)) return 0;
+
+    long long span = (long long)(pass->unroll - 1) * step;
+    if (span > INT_MAX || span < INT_MIN) return 0;
+
+    ConstantEnv invariant = envCopy(assigned);
+    envKillWrittenVars(&invariant, loop);
+    bool safe = exprSafe(cond->subnodeB, &invariant);
+    envFree(&invariant);
+    if (!safe) return 0;
+
+    // While I is still below E - (factor - 1) * step the next factor iterations all run, so their conditions are
+    // skipped. The original loop is left after it for the last iterations
+    // The bound wraps around when E is close to the end of the int range, then only the original loop may run
+    SyntaxNode* limit = foldConstants(makeBinOp("-", copySyntaxTree(cond->subnodeB), makeNumber((int)span)));
+    SyntaxNode* fits = foldConstants(makeBinOp(up ? "<" : ">", copySyntaxTree(limit), copySyntaxTree(cond->subnodeB)));
+    if (fits->type == NODE_NUMBER && fits->numberValue == 0) {
+        freeSyntaxTree(limit);
+        freeSyntaxTree(fits);
+        return 0;
+    }
+
+    char bound[IDENTIFIER_SIZE];
+    exprNewVar(pass, assigned, bound);
+    SyntaxNode* setBound = makeAssign(bound, limit);
+
+    SyntaxNode* unrolled = initNode();
+    unrolled->type = NODE_WHILE;
+    unrolled->subnodeA = makeBinOp(cond->operator, makeVar(name), makeVar(bound));
+    unrolled->subnodeB = makeBlock();
+    int size = 0;
+    for (int copy = 0; copy < pass->unroll; copy++) {
+        for (int i = 0; body->blockStatements[i] != NULL; i++) {
+            exprInsert(unrolled->subnodeB, size++, copySyntaxTree(body->blockStatements[i]));
+        }
+    }
+
+    exprInsert(block, index, setBound);
+    if (fits->type == NODE_NUMBER) {
+        freeSyntaxTree(fits);
+        exprInsert(block, index + 1, unrolled);
+        return 2;
+    }
+
+    SyntaxNode* check = initNode();
+    check->type = NODE_IF;
+    check->subnodeA = fits;
+    check->subnodeB = makeBlock();
+    exprInsert(check->subnodeB, 0, unrolled);
+    exprInsert(block, index + 1, check);
+    return 2;
+}
+
+int exprDeclareLoopTemps(ExprPass* pass, SyntaxNode* block, int index) {
+    int count = pass->loopTemps.count;
+
+    // Loops then only ever see integers in them, the JIT checks every variable a loop uses on entry
+    for (int i = 0; i < count; i++) {
+        exprInsert(block, index + i, makeAssign(pass->loopTemps.names[i], makeNumber(0)));
+    }
+
+    envFree(&pass->loopTemps);
+    return count;
+}
+
+void exprBlock(ExprPass* pass, SyntaxNode* block, ConstantEnv* assigned) {
+    ConstantEnv inner;
+
+    for (int i = 0; block->blockStatements[i] != NULL; i++) {
+        if (pass->reuse) i += exprReuse(pass, block, i, assigned);
+        SyntaxNode* node = block->blockStatements[i];
+
+        switch (node->type) {
+            case NODE_ASSIGN:
+                if (envFind(&pass->stable, node->varName) >= 0) envSet(assigned, node->varName, 0);
+                break;
+
+            case NODE_WHILE:
+                if (pass->hoist) i += exprHoist(pass, block, i, assigned);
+                if (pass->induction) {
+                    // After a closed form the loop itself only runs when the count overflows
+                    int closed = indClosedForm(pass, block, i, assigned);
+                    i += (closed > 0) ? closed : indStrengthReduce(pass, block, i, assigned);
+                }
+                if (pass->unroll > 1) i += unrollLoop(pass, block, i, assigned);
+                node = block->blockStatements[i];
+
+                // Nothing assigned inside is known after the loop, it may not run
+                inner = envCopy(assigned);
+                pass->loopDepth++;
+                if (node->subnodeB->type == NODE_BLOCK) exprBlock(pass, node->subnodeB, &inner);
+                pass->loopDepth--;
+                envFree(&inner);
+
+                if (pass->loopDepth == 0) i += exprDeclareLoopTemps(pass, block, i);
+                break;
+
+            case NODE_IF:
+                inner = envCopy(assigned);
+                if (node->subnodeB->type == NODE_BLOCK) exprBlock(pass, node->subnodeB, &inner);
+                envFree(&inner);
+
+                inner = envCopy(assigned);
+                if (node->subnodeC != NULL && node->subnodeC->type == NODE_BLOCK) exprBlock(pass, node->subnodeC, &inner);
+                envFree(&inner);
+                break;
+
+            default:
+                break;
+        }
+    }
+}
+
+void exprRun(SyntaxNode* program, ExprPass pass) {
+    ConstantEnv unstable = { .names = NULL, .values = NULL, .count = 0, .capacity = 0 };
+    ConstantEnv assigned = { .names = NULL, .values = NULL, .count = 0, .capacity = 0 };
+    if (program == NULL || program->type != NODE_BLOCK) return;
+
+    // Assignments are flagged by type inference when their variable never holds a string
+    inferTypes(program);
+    exprCollectStable(&pass, program, &unstable);
+    for (int i = 0; i < unstable.count; i++) {
+        envKill(&pass.stable, unstable.names[i]);
+    }
+
+    exprBlock(&pass, program, &assigned);
+
+    envFree(&unstable);
+    envFree(&assigned);
+    envFree(&pass.stable);
+}
+
+void hoistLoopInvariants(SyntaxNode* program) {
+    exprRun(program, (ExprPass){ .hoist = true });
+}
+
+void eliminateCommonSubexpressions(SyntaxNode* program) {
+    exprRun(program, (ExprPass){ .reuse = true });
+}
+
+void reduceInductionVariables(SyntaxNode* program) {
+    exprRun(program, (ExprPass){ .induction = true });
+}
+
+void unrollLoops(SyntaxNode* program, int factor) {
+    if (factor > 1) exprRun(program, (ExprPass){ .unroll = factor });
+}
@@ -0,0 +1,498 @@
+#include "unity.h"
+#include "unity_internals.h"
+
+#include "optimizer.c"
+#include "parser.h"
+#include "interpreter.h"
+
+Token* tokenList;
+SimplicError* error;
+ControlState control;
+
+void setUp(void) {
+    control.returned = false;
+    tokenList = initTokenQueue();
+    control.bank = initMemoryBank();
+    control.out = stdout;
+    error = initError();
+}
+
+void tearDown(void) {
+    deleteTokenQueue(&tokenList);
+    deleteMemoryBank(&control.bank);
+    deleteError(&error);
+}
+
+SyntaxNode* parseAndPropagate(const char* program) {
+    tokenizeSource(&tokenList, program, error);
+    SyntaxNode* tree = parseProgram(&tokenList, error);
+    TEST_ASSERT_FALSE(error->hasError);
+
+    propagateConstants(tree);
+    return tree;
+}
+
+void testFoldExpression(void) {
+    SyntaxNode* tree = parseAndPropagate("RETURN 2 * 4 + 3 GT 10\n");
+
+    SyntaxNode* value = tree->blockStatements[0]->subnodeB;
+    TEST_ASSERT_EQUAL_INT(NODE_NUMBER, value->type);
+    TEST_ASSERT_EQUAL_INT(1, value->numberValue);
+
+    freeSyntaxTree(tree);
+}
+
+void testDivisionByZeroNotFolded(void) {
+    SyntaxNode* tree = parseAndPropagate("SET Y = 0\nRETURN 9 / Y\n");
+
+    SyntaxNode* value = tree->blockStatements[1]->subnodeB;
+    TEST_ASSERT_EQUAL_INT(NODE_BIN_OP, value->type);
+
+    eval(tree, &control, error);
+    TEST_ASSERT_TRUE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(ERROR_DIVISION_BY_ZERO, error->errCode);
+
+    freeSyntaxTree(tree);
+}
+
+void testConstantInLoopCondition(void) {
+    SyntaxNode* tree = parseAndPropagate(
+        "SET X = 0\n"
+        "SET UPPERBOUND = 10 * 100\n"
+        "WHILE X LT UPPERBOUND DO\n"
+            "INCR X\n"
+        "DONE\n"
+        "RETURN X\n");
+
+    SyntaxNode* cond = tree->blockStatements[2]->subnodeA;
+    TEST_ASSERT_EQUAL_INT(NODE_VAR, cond->subnodeA->type); // X changes inside the loop
+    TEST_ASSERT_EQUAL_INT(NODE_NUMBER, cond->subnodeB->type);
+    TEST_ASSERT_EQUAL_INT(1000, cond->subnodeB->numberValue);
+
+    SimplicValue val = eval(tree, &control, error);
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(1000, val.integer);
+
+    freeSyntaxTree(tree);
+}
+
+void testBranchesMustAgree(void) {
+    SyntaxNode* tree = parseAndPropagate(
+        "SET A = 1\n"
+        "SET B = 1\n"
+        "IF A EQ 1 THEN\n"
+            "SET C = 5\n"
+        "ELSE\n"
+            "SET B = 2\n"
+        "FI\n"
+        "RETURN B + C\n");
+
+    // The condition is known to be true, so only the THEN branch is taken into account
+    SyntaxNode* value = tree->blockStatements[3]->subnodeB;
+    TEST_ASSERT_EQUAL_INT(NODE_NUMBER, value->type);
+    TEST_ASSERT_EQUAL_INT(6, value->numberValue);
+
+    freeSyntaxTree(tree);
+}
+
+void testUnknownAfterUnset(void) {
+    SyntaxNode* tree = parseAndPropagate(
+        "SET X = 99\n"
+        "UNSET X\n"
+        "RETURN X\n");
+
+    TEST_ASSERT_EQUAL_INT(NODE_VAR, tree->blockStatements[2]->subnodeB->type);
+
+    eval(tree, &control, error);
+    TEST_ASSERT_TRUE(error->hasError);
+
+    freeSyntaxTree(tree);
+}
+
+// Parses a program and runs type inference on it, without constant propagation
+SyntaxNode* parseAndInfer(const char* program) {
+    tokenizeSource(&tokenList, program, error);
+    SyntaxNode* tree = parseProgram(&tokenList, error);
+    TEST_ASSERT_FALSE(error->hasError);
+
+    inferTypes(tree);
+    return tree;
+}
+
+void testProvenIntAfterAssignment(void) {
+    SyntaxNode* tree = parseAndInfer("SET X = 1\nSET Y = X + 2\nPRINT Y\n");
+
+    TEST_ASSERT_TRUE(tree->blockStatements[1]->subnodeB->provenInt); // X + 2
+    TEST_ASSERT_TRUE(tree->blockStatements[2]->subnodeB->provenInt); // Y
+    TEST_ASSERT_TRUE(tree->blockStatements[1]->provenInt); // Y never holds a string
+
+    freeSyntaxTree(tree);
+}
+
+void testStringInOneBranch(void) {
+    SyntaxNode* tree = parseAndInfer(
+        "SET X = 1\n"
+        "IF X THEN\n"
+            "SET X = \"A\"\n"
+        "FI\n"
+        "PRINT X\n");
+
+    TEST_ASSERT_TRUE(tree->blockStatements[1]->subnodeA->provenInt); // Still an int in the condition
+    TEST_ASSERT_FALSE(tree->blockStatements[2]->subnodeB->provenInt);
+    TEST_ASSERT_FALSE(tree->blockStatements[0]->provenInt); // X holds a string somewhere
+
+    freeSyntaxTree(tree);
+}
+
+void testLoopFeedsTypesBack(void) {
+    SyntaxNode* tree = parseAndInfer(
+        "SET X = 0\n"
+        "SET I = 0\n"
+        "WHILE I LT 3 DO\n"
+            "PRINT X - 1\n"
+            "SET X = \"A\"\n"
+            "INCR I\n"
+        "DONE\n");
+
+    SyntaxNode* loop = tree->blockStatements[2];
+    TEST_ASSERT_TRUE(loop->subnodeA->provenInt);
+    TEST_ASSERT_FALSE(loop->subnodeB->blockStatements[0]->subnodeB->provenInt); // String on the second iteration
+    TEST_ASSERT_TRUE(loop->subnodeB->blockStatements[2]->subnodeB->provenInt);
+
+    freeSyntaxTree(tree);
+}
+
+void testUnsetAndReadRefinement(void) {
+    SyntaxNode* tree = parseAndInfer(
+        "SET X = 1\n"
+        "UNSET X\n"
+        "PRINT X\n"
+        "SET Y = 2\n"
+        "IF Y THEN\n"
+            "UNSET Y\n"
+        "FI\n"
+        "PRINT Y\n"
+        "PRINT Y\n");
+
+    TEST_ASSERT_FALSE(tree->blockStatements[2]->subnodeB->provenInt); // Unset
+    TEST_ASSERT_FALSE(tree->blockStatements[5]->subnodeB->provenInt); // Maybe unset
+    TEST_ASSERT_TRUE(tree->blockStatements[6]->subnodeB->provenInt); // The previous read would have failed
+
+    freeSyntaxTree(tree);
+}
+
+void testPruneConstantBranches(void) {
+    SyntaxNode* tree = parseAndPropagate(
+        "SET DEBUG = 0\n"
+        "IF DEBUG EQ 1 THEN\n"
+            "PRINTLN \"DEBUG\"\n"
+        "FI\n"
+        "IF DEBUG EQ 0 THEN\n"
+            "PRINT 1\n"
+            "PRINT 2\n"
+        "ELSE\n"
+            "PRINT 3\n"
+        "FI\n"
+        "WHILE DEBUG DO\n"
+            "PRINT 4\n"
+        "DONE\n"
+        "PRINT 5\n");
+    eliminateDeadCode(tree);
+
+    SyntaxNode* expected = parseAndPropagate("SET DEBUG = 0\nPRINT 1\nPRINT 2\nPRINT 5\n");
+    TEST_ASSERT_TRUE(compareSyntaxTree(expected, tree));
+
+    freeSyntaxTree(expected);
+    freeSyntaxTree(tree);
+}
+
+void testRemoveAfterReturn(void) {
+    SyntaxNode* tree = parseAndInfer(
+        "SET X = 1\n"
+        "WHILE X LT 5 DO\n"
+            "RETURN X\n"
+            "INCR X\n"
+        "DONE\n"
+        "IF X THEN\n"
+            "RETURN 1\n"
+        "ELSE\n"
+            "RETURN 2\n"
+            "PRINT 2\n"
+        "FI\n"
+        "PRINT X\n");
+    eliminateDeadCode(tree);
+
+    SyntaxNode* expected = parseAndInfer(
+        "SET X = 1\n"
+        "WHILE X LT 5 DO\n"
+            "RETURN X\n"
+        "DONE\n"
+        "IF X THEN\n"
+            "RETURN 1\n"
+        "ELSE\n"
+            "RETURN 2\n"
+        "FI\n");
+    TEST_ASSERT_TRUE(compareSyntaxTree(expected, tree));
+
+    freeSyntaxTree(expected);
+    freeSyntaxTree(tree);
+}
+
+void testHoistLoopInvariants(void) {
+    SyntaxNode* tree = parseAndInfer(
+        "SET N = 10\n"
+        "SET I = 0\n"
+        "SET S = 0\n"
+        "WHILE I LT N * 2 DO\n"
+            "SET S = S + N * 3\n"
+            "IF I LT N * 2 THEN\n" // Same as the condition
+                "INCR I\n"
+            "FI\n"
+        "DONE\n"
+        "RETURN S\n");
+    hoistLoopInvariants(tree);
+
+    TEST_ASSERT_EQUAL_INT(NODE_ASSIGN, tree->blockStatements[3]->type);
+    TEST_ASSERT_EQUAL_STRING("_T0", tree->blockStatements[3]->varName);
+    TEST_ASSERT_EQUAL_STRING("_T1", tree->blockStatements[4]->varName);
+    SyntaxNode* loop = tree->blockStatements[5];
+    TEST_ASSERT_EQUAL_INT(NODE_WHILE, loop->type);
+    TEST_ASSERT_EQUAL_STRING("_T0", loop->subnodeA->subnodeB->varName);
+    TEST_ASSERT_EQUAL_STRING("_T1", loop->subnodeB->blockStatements[0]->subnodeB->subnodeB->varName);
+    TEST_ASSERT_EQUAL_STRING("_T0", loop->subnodeB->blockStatements[1]->subnodeA->subnodeB->varName);
+
+    SimplicValue val = eval(tree, &control, error);
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(600, val.integer);
+
+    freeSyntaxTree(tree);
+}
+
+void testUnsafeExpressionsNotHoisted(void) {
+    SyntaxNode* tree = parseAndInfer(
+        "SET N = 10\n"
+        "SET D = 2\n"
+        "SET T = 1\n"
+        "IF N GT 5 THEN\n"
+            "SET T = \"A\"\n"
+        "FI\n"
+        "SET I = 0\n"
+        "WHILE I LT 3 DO\n"
+            "PRINT N / D\n"      // Might divide by 0
+            "PRINT T + 1\n"      // Might be a string
+            "PRINT I * 2\n"      // Written by the loop
+            "PRINT M + 1\n"      // Not assigned before the loop
+            "INCR I\n"
+        "DONE\n");
+    hoistLoopInvariants(tree);
+
+    TEST_ASSERT_EQUAL_INT(NODE_WHILE, tree->blockStatements[5]->type);
+
+    freeSyntaxTree(tree);
+}
+
+void testReuseCommonSubexpressions(void) {
+    const char* program = "SET A = 3\nSET B = 4\nRETURN A * B + 1 - A * B + 1\n";
+    SyntaxNode* tree = parseAndInfer(program);
+    SyntaxNode* before = parseAndInfer(program);
+    eliminateCommonSubexpressions(tree);
+
+    TEST_ASSERT_EQUAL_INT(NODE_ASSIGN, tree->blockStatements[2]->type);
+    TEST_ASSERT_EQUAL_STRING("_T0", tree->blockStatements[2]->varName);
+    TEST_ASSERT_EQUAL_INT(NODE_RETURN, tree->blockStatements[3]->type);
+    TEST_ASSERT_FALSE(compareSyntaxTree(before, tree));
+
+    SimplicValue expected = eval(before, &control, error);
+    control.returned = false;
+    SimplicValue val = eval(tree, &control, error);
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(expected.integer, val.integer);
+
+    freeSyntaxTree(before);
+    freeSyntaxTree(tree);
+}
+
+void testStructuralHash(void) {
+    SyntaxNode* tree = parseAndInfer("PRINT A + B\nPRINT A + B\nPRINT A - B\n");
+
+    SyntaxNode* sum = tree->blockStatements[0]->subnodeB;
+    SyntaxNode* difference = tree->blockStatements[2]->subnodeB;
+    TEST_ASSERT_TRUE(compareSyntaxTree(sum, tree->blockStatements[1]->subnodeB));
+    TEST_ASSERT_EQUAL_UINT(hashSyntaxTree(sum), hashSyntaxTree(tree->blockStatements[1]->subnodeB));
+    TEST_ASSERT_FALSE(compareSyntaxTree(sum, difference)); // Only the operator differs
+    TEST_ASSERT_NOT_EQUAL(hashSyntaxTree(sum), hashSyntaxTree(difference));
+
+    freeSyntaxTree(tree);
+}
+
+void testClosedFormLoop(void) {
+    SyntaxNode* tree = parseAndInfer(
+        "SET N = 1000\n"
+        "SET I = 3\n"
+        "SET S = 1\n"
+        "SET C = 0\n"
+        "WHILE I LT N DO\n"
+            "SET S = S + I * 2\n"
+            "SET C = C + N\n"
+            "INCR I\n"
+        "DONE\n"
+        "RETURN S + C\n");
+    reduceInductionVariables(tree);
+
+    // The IF computes every value, the loop is kept for when it isn't taken
+    TEST_ASSERT_EQUAL_INT(NODE_IF, tree->blockStatements[4]->type);
+    TEST_ASSERT_EQUAL_INT(NODE_WHILE, tree->blockStatements[5]->type);
+
+    SimplicValue val = eval(tree, &control, error);
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(1 + 2 * (999 * 1000 / 2 - 3) + 997 * 1000, val.integer);
+
+    freeSyntaxTree(tree);
+}
+
+void testLoopWithOutputKeepsIterating(void) {
+    SyntaxNode* tree = parseAndInfer(
+        "SET I = 0\n"
+        "SET S = 0\n"
+        "WHILE I LT 10 DO\n"
+            "SET S = S + I\n"
+            "PRINT S\n"
+            "INCR I\n"
+        "DONE\n");
+    reduceInductionVariables(tree);
+
+    TEST_ASSERT_EQUAL_INT(NODE_WHILE, tree->blockStatements[2]->type);
+
+    freeSyntaxTree(tree);
+}
+
+void testStrengthReduction(void) {
+    SyntaxNode* tree = parseAndInfer(
+        "SET I = 0\n"
+        "WHILE I LT 10 DO\n"
+            "PRINT I * 4\n"
+            "SET I = I + 3\n"
+        "DONE\n");
+    reduceInductionVariables(tree);
+
+    // SET _T0 = I * 4 before the loop, SET _T0 = _T0 + 12 after each step
+    SyntaxNode* start = tree->blockStatements[1];
+    TEST_ASSERT_EQUAL_INT(NODE_ASSIGN, start->type);
+    TEST_ASSERT_EQUAL_STRING("_T0", start->varName);
+    SyntaxNode* body = tree->blockStatements[2]->subnodeB;
+    TEST_ASSERT_EQUAL_INT(NODE_VAR, body->blockStatements[0]->subnodeB->type);
+    TEST_ASSERT_EQUAL_STRING("_T0", body->blockStatements[2]->varName);
+    TEST_ASSERT_EQUAL_INT(12, body->blockStatements[2]->subnodeB->subnodeB->numberValue);
+
+    freeSyntaxTree(tree);
+}
+
+void testUnrollCountedLoop(void) {
+    SyntaxNode* tree = parseAndInfer(
+        "SET N = 10\n"
+        "IF N GT 5 THEN\n"
+            "SET N = 11\n"
+        "FI\n"
+        "SET I = 0\n"
+        "SET P = 1\n"
+        "WHILE I LT N DO\n"
+            "SET P = P * 2 + I\n"
+            "INCR I\n"
+        "DONE\n"
+        "RETURN P\n");
+    unrollLoops(tree, 4);
+
+    // SET _T0 = N - 3, IF _T0 LT N THEN WHILE I LT _T0 DO (4 copies) DONE FI, then the original loop
+    TEST_ASSERT_EQUAL_STRING("_T0", tree->blockStatements[4]->varName);
+    SyntaxNode* check = tree->blockStatements[5];
+    TEST_ASSERT_EQUAL_INT(NODE_IF, check->type);
+    SyntaxNode* unrolled = check->subnodeB->blockStatements[0];
+    TEST_ASSERT_EQUAL_INT(NODE_WHILE, unrolled->type);
+    TEST_ASSERT_NOT_NULL(unrolled->subnodeB->blockStatements[7]);
+    TEST_ASSERT_NULL(unrolled->subnodeB->blockStatements[8]);
+    TEST_ASSERT_EQUAL_INT(NODE_WHILE, tree->blockStatements[6]->type);
+
+    SimplicValue val = eval(tree, &control, error);
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(4084, val.integer);
+
+    freeSyntaxTree(tree);
+}
+
+// Moving expressions around must not change what a program does
+void testExpressionPassesKeepResults(void) {
+    const char* programs[] = {
+        "SET X = 2\nSET C = 0\nWHILE X LT 200 DO\nSET Y = 2\nSET P = 1\nWHILE Y * Y LEQ X DO\nIF X % Y EQ 0 THEN\nSET P = 0\nFI\nINCR Y\nDONE\nSET C = C + P\nINCR X\nDONE\nRETURN C\n",
+        "SET N = 7\nSET I = 0\nSET S = 0\nWHILE I LT N * N DO\nSET S = S + N % 3 + I % 3 + N % 3\nINCR I\nDONE\nRETURN S\n",
+        "SET N = 7\nSET I = 0\nWHILE I LT 3 DO\nIF I EQ 1 THEN\nSET N = \"A\"\nFI\nPRINT N + 1\nINCR I\nDONE\n",
+        "SET N = 0\nSET I = 0\nWHILE I LT 3 DO\nPRINT 5 / N\nINCR I\nDONE\n",
+        "SET N = 4\nSET I = 0\nWHILE I LT N DO\nSET N = N + 0\nSET K = N * 2 + N * 2\nINCR I\nDONE\nRETURN K + I\n",
+        "SET I = 0\nWHILE I LT 3 DO\nSET M = 2\nINCR I\nDONE\nWHILE I LT 6 DO\nSET Z = M * 5\nINCR I\nDONE\nRETURN Z\n",
+        "SET I = 0 - 50\nSET S = 7\nSET T = 0\nWHILE I LEQ 60000 DO\nSET S = S + I * 1000\nINCR I\nSET T = T - I\nDONE\nRETURN S + T + I\n",
+        "SET N = 0\nSET I = 5\nSET S = 0\nWHILE I LT N DO\nSET S = S + 1\nINCR I\nDONE\nRETURN S * 100 + I\n",
+        "SET I = 0\nSET S = \"A\"\nWHILE I LT 3 DO\nSET S = S + I\nINCR I\nDONE\nRETURN S\n",
+        "SET I = 0\nSET S = 0\nWHILE I LT 9 DO\nSET S = S + I * 3 + I * 3\nSET I = I + 2\nIF I * 3 GT 10 THEN\nSET S = S - 1\nFI\nDONE\nRETURN S\n",
+        "SET I = 9\nSET S = 0\nWHILE I GT 0 DO\nSET S = S + I * 7\nDECR I\nDONE\nRETURN S\n",
+        "SET X = 3\nIF X GT 2 THEN\nIF X EQ 3 THEN\nRETURN 7\nFI\nELSE\nPRINT 1\nFI\nRETURN 8\n",
+        "SET X = 3\nWHILE X - 3 DO\nPRINT X\nDONE\nIF 1 THEN\nSET Y = \"A\"\nFI\nRETURN Y + X\n",
+        "SET E = 0 - 2147483647\nSET I = E - 1\nSET C = 0\nWHILE I LT E DO\nINCR C\nINCR I\nDONE\nRETURN C\n",
+        "SET N = 0\nWHILE N LT 4 DO\nINCR N\nDONE\nSET I = N * 5\nSET C = 1\nWHILE I GEQ N DO\nSET C = C * 3 + I\nSET I = I - 2\nDONE\nRETURN C + I\n",
+    };
+
+    for (unsigned int i = 0; i < sizeof(programs) / sizeof(programs[0]); i++) {
+        SyntaxNode* tree = parseAndInfer(programs[i]);
+        SyntaxNode* optimized = parseAndInfer(programs[i]);
+        propagateConstants(optimized);
+        eliminateDeadCode(optimized);
+        hoistLoopInvariants(optimized);
+        eliminateCommonSubexpressions(optimized);
+        reduceInductionVariables(optimized);
+        unrollLoops(optimized, 3);
+
+        SimplicValue expected = eval(tree, &control, error);
+        bool expectedError = error->hasError;
+        SimplicErrorType expectedCode = error->errCode;
+        tearDown();
+        setUp();
+
+        SimplicValue val = eval(optimized, &control, error);
+        TEST_ASSERT_EQUAL_INT(expectedError, error->hasError);
+        TEST_ASSERT_EQUAL_INT(expectedCode, error->errCode);
+        TEST_ASSERT_EQUAL_INT(expected.integer, val.integer);
+        if (expected.string != NULL) {
+            TEST_ASSERT_EQUAL_STRING(expected.string, val.string);
+        }
+
+        free(expected.string);
+        free(val.string);
+        freeSyntaxTree(tree);
+        freeSyntaxTree(optimized);
+        tearDown();
+        setUp();
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(testFoldExpression);
+    RUN_TEST(testDivisionByZeroNotFolded);
+    RUN_TEST(testConstantInLoopCondition);
+    RUN_TEST(testBranchesMustAgree);
+    RUN_TEST(testUnknownAfterUnset);
+    RUN_TEST(testProvenIntAfterAssignment);
+    RUN_TEST(testStringInOneBranch);
+    RUN_TEST(testLoopFeedsTypesBack);
+    RUN_TEST(testUnsetAndReadRefinement);
+    RUN_TEST(testPruneConstantBranches);
+    RUN_TEST(testRemoveAfterReturn);
+    RUN_TEST(testHoistLoopInvariants);
+    RUN_TEST(testUnsafeExpressionsNotHoisted);
+    RUN_TEST(testReuseCommonSubexpressions);
+    RUN_TEST(testStructuralHash);
+    RUN_TEST(testClosedFormLoop);
+    RUN_TEST(testLoopWithOutputKeepsIterating);
+    RUN_TEST(testStrengthReduction);
+    RUN_TEST(testUnrollCountedLoop);
+    RUN_TEST(testExpressionPassesKeepResults);
+    return UNITY_END();
+}
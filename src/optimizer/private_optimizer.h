@@ -0,0 +1,126 @@
+#ifndef PRIVATE_OPTIMIZER_H
+#define PRIVATE_OPTIMIZER_H
+
+#include <limits.h>
+#include "optimizer.h"
+#include "dataStructures/hashIndex.h"
+
+// Variables with a known integer value at a certain point of the program
+typedef struct ConstantEnv ConstantEnv;
+struct ConstantEnv {
+    char (*names)[IDENTIFIER_SIZE];
+    int* values;
+    int count;
+    int capacity;
+    HashIndex index; // Position of each name in names
+};
+
+// Types a variable may hold at a point of the program, sets of these bits
+#define TYPE_UNSET 1 // Never assigned or unset, reading it is an error
+#define TYPE_INT 2
+#define TYPE_STR 4
+
+// Variables of the program seen by type inference, environments are arrays of type sets indexed like names
+typedef struct TypeInference TypeInference;
+struct TypeInference {
+    char (*names)[IDENTIFIER_SIZE];
+    int count;
+    int capacity;
+    unsigned char* everHeld; // Every type each variable holds somewhere in the program
+};
+
+#define UNROLL_MAX_NODES 48 // Larger loop bodies are not unrolled
+#define HIDDEN_VAR_FORMAT "_T%d" // Variables made by the optimizer, names of the program never start with _
+
+// State of the passes that move expressions into variables of their own
+typedef struct ExprPass ExprPass;
+struct ExprPass {
+    bool hoist; // Moves loop invariant expressions before their loop
+    bool reuse; // Computes the repeated expressions of a statement once
+    bool induction; // Strength reduction and closed forms of counted loops
+    int unroll; // Copies of the body in unrolled loops, 0 to leave loops alone
+    ConstantEnv stable; // Variables that hold an integer from their first assignment on (values unused)
+    int tempCount;
+    int loopDepth;
+    ConstantEnv loopTemps; // Variables added inside the current outermost loop
+};
+
+// Place of the tree that holds an expression, so the expression can be replaced
+typedef struct ExprSlot ExprSlot;
+struct ExprSlot {
+    SyntaxNode** slot;
+    unsigned int hash;
+    int end; // Index of the first slot of the list that is not inside this expression
+};
+
+typedef struct ExprSlotList ExprSlotList;
+struct ExprSlotList {
+    ExprSlot* items;
+    int count;
+    int capacity;
+};
+
+// Environment functions, used to keep track of the known variables
+static ConstantEnv envCopy(const ConstantEnv* env);
+static void envFree(ConstantEnv* env);
+static int envFind(const ConstantEnv* env, const char* name); // Index of the variable or -1
+static void envSet(ConstantEnv* env, const char* name, int value);
+static void envKill(ConstantEnv* env, const char* name); // Forgets the value of a variable
+static void envIntersect(ConstantEnv* env, const ConstantEnv* other); // Keeps the values both envs agree on
+static void envKillWrittenVars(ConstantEnv* env, SyntaxNode* node); // Forgets every var written inside a tree
+
+static SyntaxNode* substituteConstants(SyntaxNode* expr, const ConstantEnv* env); // Replaces known vars and folds
+static void propagateStatement(SyntaxNode* node, ConstantEnv* env);
+
+// Dead code elimination
+static bool pruneReturns(SyntaxNode* node); // True if running the statement always ends the program
+static void pruneBlock(SyntaxNode* block);
+static void pruneStatement(SyntaxNode* node);
+
+// New nodes
+static SyntaxNode* makeNumber(int value);
+static SyntaxNode* makeVar(const char* name);
+static SyntaxNode* makeBinOp(const char* operator, SyntaxNode* a, SyntaxNode* b);
+static SyntaxNode* makeBlock(void); // Empty
+static SyntaxNode* makeAssign(const char* name, SyntaxNode* value);
+
+// Hoisting and reuse of expressions, sets of variables are ConstantEnvs whose values are unused
+static void exprCollectStable(ExprPass* pass, SyntaxNode* node, ConstantEnv* unstable);
+static bool exprSafe(SyntaxNode* expr, const ConstantEnv* vars); // True if expr can't fail or allocate
+static void exprCollectSafe(SyntaxNode** slot, const ConstantEnv* vars, bool nested, ExprSlotList* list); // Pre-order
+static void exprCollectInStatement(SyntaxNode* node, const ConstantEnv* vars, ExprSlotList* list); // Largest safe expressions
+static void exprNewVar(ExprPass* pass, ConstantEnv* assigned, char* name); // Names a hidden variable, assigned may be NULL
+static SyntaxNode* exprMoveToVar(ExprPass* pass, SyntaxNode** slot, ConstantEnv* assigned); // Returns the SET
+static void exprInsert(SyntaxNode* block, int index, SyntaxNode* statement);
+static int exprHoist(ExprPass* pass, SyntaxNode* block, int index, ConstantEnv* assigned); // Returns statements inserted
+static int exprReuse(ExprPass* pass, SyntaxNode* block, int index, ConstantEnv* assigned);
+// Induction variables, I is a variable a loop changes by a constant exactly once per iteration
+static void indCountUses(SyntaxNode* node, const char* name, int* reads, int* writes);
+static bool indStep(SyntaxNode* node, const char** name, int* step); // INCR, DECR, SET I = I + c or SET I = I - c
+static bool indIsInductionVar(ExprPass* pass, SyntaxNode* loop, const char* name, const ConstantEnv* assigned);
+static bool indLinear(SyntaxNode* expr, const char* name, int* factor); // I, I * c or c * I
+static bool indAccumulation(ExprPass* pass, SyntaxNode* loop, SyntaxNode* node, const char* name, const ConstantEnv* invariant,
+                            const ConstantEnv* assigned); // SET S = S + x where only this statement uses S
+static SyntaxNode* indTripCount(SyntaxNode* loop); // E - I, or E - I + 1 for LEQ
+static int indClosedForm(ExprPass* pass, SyntaxNode* block, int index, ConstantEnv* assigned); // Returns statements inserted
+static void indCollectFactors(SyntaxNode* node, const char* name, int** factors, int* count);
+static void indReplaceProducts(SyntaxNode** slot, const char* name, int factor, const char* product);
+static int indStrengthReduce(ExprPass* pass, SyntaxNode* block, int index, ConstantEnv* assigned); // Returns statements inserted
+
+// Loop unrolling
+static int unrollSize(SyntaxNode* node); // Nodes of a tree, more than UNROLL_MAX_NODES if it has a loop
+static int unrollLoop(ExprPass* pass, SyntaxNode* block, int index, ConstantEnv* assigned); // Returns statements inserted
+
+static int exprDeclareLoopTemps(ExprPass* pass, SyntaxNode* block, int index); // Returns statements inserted
+static void exprBlock(ExprPass* pass, SyntaxNode* block, ConstantEnv* assigned);
+static void exprRun(SyntaxNode* program, ExprPass pass); // Only the options of pass are set
+
+// Type inference
+static int typeVarIndex(TypeInference* ti, const char* name); // Adds the variable if it's new
+static void typeCollectVars(TypeInference* ti, SyntaxNode* node);
+static unsigned char* typeEnvCopy(const TypeInference* ti, const unsigned char* env);
+static unsigned char typeOfExpr(TypeInference* ti, SyntaxNode* expr, unsigned char* env); // Flags the expression too
+static void typeStatement(TypeInference* ti, SyntaxNode* node, unsigned char* env);
+static void typeMarkAssignments(TypeInference* ti, SyntaxNode* node); // Flags assignments to never-string variables
+
+#endif
@@ -22,7 +22,7 @@ TokenType findIfBlockDelimiter(Token** tokenList) {
 }
 
 ParseResult makeResult(SyntaxNode* n) {
-    return (ParseResult){ .node = n, .hasError = false };
+    return (ParseResult){ .node = n, .hasError = false, .depth = 0 };
 }
 
 ParseResult makeError(SimplicError* err, SimplicErrorType code, const char* fmt, ...) {
@@ -54,7 +54,30 @@ ParseResult makeError_keepErrInfo(SimplicError* err) {
     return makeError(err, err->errCode, err->errMsg);
 }
 
+ParseResult expressionError(SimplicError* err, SimplicErrorType code, const char* message) {
+    // A nesting error is kept as it is, the rest are reported as the part that failed
+    if (err->errCode == ERROR_NESTING_TOO_DEEP) return makeError_keepErrInfo(err);
+    return makeError(err, code, "%s", message);
+}
+
+ParseResult nestOperation(SyntaxNode* n, ParseResult left, ParseResult right, SimplicError* error) {
+    n->subnodeA = left.node;
+    n->subnodeB = right.node;
+
+    // Chains are parsed in a loop, but the passes and engines walking them recurse
+    int depth = 1 + (left.depth > right.depth ? left.depth : right.depth);
+    if (depth > MAX_EXPRESSION_DEPTH) {
+        freeSyntaxTree(n);
+        return makeError(error, ERROR_NESTING_TOO_DEEP, "Expression nested deeper than %d operators", MAX_EXPRESSION_DEPTH);
+    }
+    return (ParseResult){ .node = n, .hasError = false, .depth = depth };
+}
+
 ParseResult parseStatement(Token** tokenList, SimplicError* error) {
+    return parseNestedStatement(tokenList, error, 0);
+}
+
+ParseResult parseNestedStatement(Token** tokenList, SimplicError* error, int nesting) {
     Token* t = peekTokenQueue(tokenList);
 
     if (!t) return makeError(error, ERROR_UNKNOWN_INSTRUCTION, "Unexpected end of token list");
@@ -95,7 +118,7 @@ ParseResult parseStatement(Token** tokenList, SimplicError* error) {
             dequeueToken(tokenList); // consume '='
             ParseResult expr = parseLowestPrecedenceOperation(tokenList, error);
             if (expr.hasError || !expr.node)
-                return makeError(error, ERROR_INVALID_EXPR, "Invalid expression in SET statement");
+                return expressionError(error, ERROR_INVALID_EXPR, "Invalid expression in SET statement");
             valueNode = expr.node;
         }
 
@@ -127,7 +150,7 @@ ParseResult parseStatement(Token** tokenList, SimplicError* error) {
         dequeueToken(tokenList); // consume PRINT
         ParseResult expr = parseLowestPrecedenceOperation(tokenList, error);
         if (expr.hasError || !expr.node)
-            return makeError(error, ERROR_INVALID_EXPR, "Invalid PRINT expression");
+            return expressionError(error, ERROR_INVALID_EXPR, "Invalid PRINT expression");
         SyntaxNode* n = initNode();
         n->type = (oldType == TOKEN_PRINT) ? NODE_PRINT : NODE_PRINTLN;
         n->subnodeB = expr.node;
@@ -142,7 +165,7 @@ ParseResult parseStatement(Token** tokenList, SimplicError* error) {
         dequeueToken(tokenList); // consume RETURN
         ParseResult expr = parseLowestPrecedenceOperation(tokenList, error);
         if (expr.hasError || !expr.node)
-            return makeError(error, ERROR_INVALID_EXPR, "Invalid RETURN expression");
+            return expressionError(error, ERROR_INVALID_EXPR, "Invalid RETURN expression");
         SyntaxNode* n = initNode();
         n->type = NODE_RETURN;
         n->subnodeB = expr.node;
@@ -158,7 +181,7 @@ ParseResult parseStatement(Token** tokenList, SimplicError* error) {
         dequeueToken(tokenList);
         ParseResult expr = parseLowestPrecedenceOperation(tokenList, error);
         if (expr.hasError || !expr.node)
-            return makeError(error, ERROR_INVALID_EXPR, "Invalid expression in INCR/DECR statement");
+            return expressionError(error, ERROR_INVALID_EXPR, "Invalid expression in INCR/DECR statement");
         SyntaxNode* n = initNode();
         n->type = (oldType == TOKEN_INCREMENT) ? NODE_INCREMENT : NODE_DECREMENT;
         n->subnodeB = expr.node;
@@ -177,12 +200,19 @@ ParseResult parseStatement(Token** tokenList, SimplicError* error) {
         if (cond.hasError || !cond.node)
             return makeError_keepErrInfo(error);
 
-        if (peekTokenQueue(tokenList)->type != TOKEN_DO)
+        if (peekTokenQueue(tokenList)->type != TOKEN_DO) {
+            freeSyntaxTree(cond.node);
             return makeError(error, ERROR_MISC, "WHILE missing DO keyword, instead recived %s", peekTokenQueue(tokenList)->name);
+        }
         dequeueToken(tokenList); // consume DO
 
+        if (nesting == MAX_BLOCK_NESTING) {
+            freeSyntaxTree(cond.node);
+            return makeError(error, ERROR_NESTING_TOO_DEEP, "Blocks nested deeper than %d levels", MAX_BLOCK_NESTING);
+        }
+
         // Body (block)
-        SyntaxNode* body = parseBlock(tokenList, error, TOKEN_DONE);
+        SyntaxNode* body = parseBlock(tokenList, error, TOKEN_DONE, nesting + 1);
         
         if (error->hasError || !body)
             makeError_keepErrInfo(error);
@@ -207,17 +237,26 @@ ParseResult parseStatement(Token** tokenList, SimplicError* error) {
         if (cond.hasError || !cond.node)
             return makeError_keepErrInfo(error);
 
-        if (peekTokenQueue(tokenList)->type != TOKEN_THEN)
+        if (peekTokenQueue(tokenList)->type != TOKEN_THEN) {
+            freeSyntaxTree(cond.node);
             return makeError(error, ERROR_MISC, "IF missing THEN keyword, instead recived %s", peekTokenQueue(tokenList)->name);
+        }
         dequeueToken(tokenList); // consume THEN
 
         // Determine if block delimiter is FI or ELSE
         TokenType blockDelimiter = findIfBlockDelimiter(tokenList);
-        if(blockDelimiter == TOKEN_ERROR_TOKEN)
+        if(blockDelimiter == TOKEN_ERROR_TOKEN) {
+            freeSyntaxTree(cond.node);
             return makeError(error, ERROR_NON_TERMINATED_BLOCK, "IF missing delimiter keyword");
+        }
+
+        if (nesting == MAX_BLOCK_NESTING) {
+            freeSyntaxTree(cond.node);
+            return makeError(error, ERROR_NESTING_TOO_DEEP, "Blocks nested deeper than %d levels", MAX_BLOCK_NESTING);
+        }
 
         // If body, will be executed if condition is true
-        SyntaxNode* ifBody = parseBlock(tokenList, error, blockDelimiter);
+        SyntaxNode* ifBody = parseBlock(tokenList, error, blockDelimiter, nesting + 1);
 
         if (error->hasError || !ifBody)
             makeError_keepErrInfo(error);
@@ -225,7 +264,7 @@ ParseResult parseStatement(Token** tokenList, SimplicError* error) {
         // If delimiter was else, we store a second body that will be executed if condition is false
         SyntaxNode* elseBody = NULL;
         if(blockDelimiter == TOKEN_ELSE) {
-            elseBody = parseBlock(tokenList, error, TOKEN_FI);
+            elseBody = parseBlock(tokenList, error, TOKEN_FI, nesting + 1);
             if (error->hasError || !elseBody)
                 makeError_keepErrInfo(error);
         }
@@ -298,8 +337,10 @@ ParseResult parseTerm(Token** tokenList, SimplicError* error) {
         dequeueToken(tokenList);
         ParseResult right = parseFactor(tokenList, error);
 
-        if (right.hasError || !right.node)
-            return makeError(error, ERROR_UNDEFINED_SECOND_OPERAND, "Invalid right operand in binary term");
+        if (right.hasError || !right.node) {
+            freeSyntaxTree(left.node);
+            return expressionError(error, ERROR_UNDEFINED_SECOND_OPERAND, "Invalid right operand in binary term");
+        }
 
         SyntaxNode* n = initNode();
         n->type = NODE_BIN_OP;
@@ -318,10 +359,8 @@ ParseResult parseTerm(Token** tokenList, SimplicError* error) {
             ; // shut up the compiler
         }
 
-        n->subnodeA = left.node;
-        n->subnodeB = right.node;
-
-        left.node = n;
+        left = nestOperation(n, left, right, error);
+        if (left.hasError) return left;
     }
 
     return left;
@@ -342,8 +381,10 @@ ParseResult parseExpr(Token** tokenList, SimplicError* error) {
         dequeueToken(tokenList);
         ParseResult right = parseTerm(tokenList, error);
 
-        if (right.hasError || !right.node)
-            return makeError(error, ERROR_UNDEFINED_SECOND_OPERAND, "Invalid right operand in expression");
+        if (right.hasError || !right.node) {
+            freeSyntaxTree(left.node);
+            return expressionError(error, ERROR_UNDEFINED_SECOND_OPERAND, "Invalid right operand in expression");
+        }
 
         SyntaxNode* n = initNode();
         n->type = NODE_BIN_OP;
@@ -357,10 +398,8 @@ ParseResult parseExpr(Token** tokenList, SimplicError* error) {
             default:
             ;
         }
-        n->subnodeA = left.node;
-        n->subnodeB = right.node;
-
-        left.node = n;
+        left = nestOperation(n, left, right, error);
+        if (left.hasError) return left;
     }
 
     return left;
@@ -381,8 +420,10 @@ ParseResult parseRelational(Token** tokenList, SimplicError* error) {
         dequeueToken(tokenList);
         ParseResult right = parseTerm(tokenList, error);
 
-        if (right.hasError || !right.node)
-            return makeError(error, ERROR_UNDEFINED_SECOND_OPERAND, "Invalid right operand in relational comparison");
+        if (right.hasError || !right.node) {
+            freeSyntaxTree(left.node);
+            return expressionError(error, ERROR_UNDEFINED_SECOND_OPERAND, "Invalid right operand in relational comparison");
+        }
 
         SyntaxNode* n = initNode();
         n->type = NODE_BIN_OP;
@@ -402,10 +443,8 @@ ParseResult parseRelational(Token** tokenList, SimplicError* error) {
             default:
             ;
         }
-        n->subnodeA = left.node;
-        n->subnodeB = right.node;
-
-        left.node = n;
+        left = nestOperation(n, left, right, error);
+        if (left.hasError) return left;
     }
 
     return left;
@@ -426,8 +465,10 @@ ParseResult parseEquality(Token** tokenList, SimplicError* error) {
         dequeueToken(tokenList);
         ParseResult right = parseRelational(tokenList, error);
 
-        if (right.hasError || !right.node)
-            return makeError(error, ERROR_UNDEFINED_SECOND_OPERAND, "Invalid right operand in equality comparison");
+        if (right.hasError || !right.node) {
+            freeSyntaxTree(left.node);
+            return expressionError(error, ERROR_UNDEFINED_SECOND_OPERAND, "Invalid right operand in equality comparison");
+        }
 
         SyntaxNode* n = initNode();
         n->type = NODE_BIN_OP;
@@ -441,10 +482,8 @@ ParseResult parseEquality(Token** tokenList, SimplicError* error) {
             default:
             ;
         }
-        n->subnodeA = left.node;
-        n->subnodeB = right.node;
-
-        left.node = n;
+        left = nestOperation(n, left, right, error);
+        if (left.hasError) return left;
     }
 
     return left;
@@ -465,8 +504,10 @@ ParseResult parseLogical(Token** tokenList, SimplicError* error) {
         dequeueToken(tokenList);
         ParseResult right = parseEquality(tokenList, error);
 
-        if (right.hasError || !right.node)
-            return makeError(error, ERROR_UNDEFINED_SECOND_OPERAND, "Invalid right operand in logical comparison");
+        if (right.hasError || !right.node) {
+            freeSyntaxTree(left.node);
+            return expressionError(error, ERROR_UNDEFINED_SECOND_OPERAND, "Invalid right operand in logical comparison");
+        }
 
         SyntaxNode* n = initNode();
         n->type = NODE_BIN_OP;
@@ -480,10 +521,8 @@ ParseResult parseLogical(Token** tokenList, SimplicError* error) {
             default:
             ;
         }
-        n->subnodeA = left.node;
-        n->subnodeB = right.node;
-
-        left.node = n;
+        left = nestOperation(n, left, right, error);
+        if (left.hasError) return left;
     }
 
     return left;
@@ -499,7 +538,12 @@ SyntaxNode* parseTokenList(Token** tokenList, SimplicError* error) {
     return  res.node;
 }
 
-SyntaxNode* parseBlock(Token** tokenList, SimplicError* error, TokenType endToken) {
+SyntaxNode* parseProgram(Token** tokenList, SimplicError* error) {
+    // The whole program is a block delimited by EOF
+    return parseBlock(tokenList, error, TOKEN_EOF, 0);
+}
+
+SyntaxNode* parseBlock(Token** tokenList, SimplicError* error, TokenType endToken, int nesting) {
     // A block node has a list of ASTs (blockStatements) that will be run in one sitting by the interpreter
     // ------------------------------------------
     // BLOCK Node -> node list
@@ -509,7 +553,7 @@ SyntaxNode* parseBlock(Token** tokenList, SimplicError* error, TokenType endToke
     int statementCount = 0;
 
     while (peekTokenQueue(tokenList)->type != endToken && !error->hasError && peekTokenQueue(tokenList)->type != TOKEN_EOF) {
-        ParseResult statement = parseStatement(tokenList, error);
+        ParseResult statement = parseNestedStatement(tokenList, error, nesting);
 
         // If null, we reached endToken
         if (statement.node == NULL) break;
@@ -518,7 +562,10 @@ SyntaxNode* parseBlock(Token** tokenList, SimplicError* error, TokenType endToke
         blockStatements[statementCount++] = statement.node;
     }
 
-    if (peekTokenQueue(tokenList)->type != endToken && peekTokenQueue(tokenList)->type != TOKEN_EOF)
+    // At top level a bad statement keeps its own error, like when statements were parsed one at a time.
+    // Too deep a nesting too, the terminators after it are only missing because parsing stopped there
+    bool keepError = error->hasError && (endToken == TOKEN_EOF || error->errCode == ERROR_NESTING_TOO_DEEP);
+    if (!keepError && peekTokenQueue(tokenList)->type != endToken && peekTokenQueue(tokenList)->type != TOKEN_EOF)
         makeError(error, ERROR_NON_TERMINATED_BLOCK, "Expected matching block terminator, instead received: %s", peekTokenQueue(tokenList)->name);
 
     if (peekTokenQueue(tokenList)->type == endToken)
@@ -110,11 +110,101 @@ void testParseSetDeclarationOnly(void){
     deleteError(&error);
 }
 
+void testProgramKeepsStatementError(void){
+    SimplicError* error = initError();
+    tokenizeSource(&tokenList, "PRINTLN \"hi\"\n3\n", error);
+
+    SyntaxNode* program = parseProgram(&tokenList, error);
+    TEST_ASSERT_TRUE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(ERROR_UNKNOWN_INSTRUCTION, error->errCode);
+    TEST_ASSERT_EQUAL_STRING("Unknown statement: 3", error->errMsg);
+    freeSyntaxTree(program);
+    deleteTokenQueue(&tokenList);
+    deleteError(&error);
+
+    // Inside a block the terminator that is missing is reported
+    error = initError();
+    tokenList = initTokenQueue();
+    tokenizeSource(&tokenList, "WHILE 1 DO\n3\nDONE\n", error);
+
+    program = parseProgram(&tokenList, error);
+    TEST_ASSERT_EQUAL_INT(ERROR_NON_TERMINATED_BLOCK, error->errCode);
+    freeSyntaxTree(program);
+    deleteTokenQueue(&tokenList);
+    deleteError(&error);
+}
+
+// "SET X = 1 + 1 ... + 1" with the given number of operators
+char* makeChain(int operators) {
+    char* program = malloc(16 + operators * 4);
+    char* end = program + sprintf(program, "SET X = 1");
+    for (int i = 0; i < operators; i++) end += sprintf(end, " + 1");
+    sprintf(end, "\n");
+    return program;
+}
+
+// Count WHILE blocks, one inside the other, around an INCR
+char* makeNestedLoops(int count) {
+    char* program = malloc(8 + count * 20);
+    char* end = program;
+    for (int i = 0; i < count; i++) end += sprintf(end, "WHILE X DO\n");
+    end += sprintf(end, "INCR X\n");
+    for (int i = 0; i < count; i++) end += sprintf(end, "DONE\n");
+    return program;
+}
+
+void testNestingLimits(void) {
+    SimplicError* error = initError();
+    char* program = makeChain(MAX_EXPRESSION_DEPTH);
+    tokenizeSource(&tokenList, program, error);
+    SyntaxNode* tree = parseProgram(&tokenList, error);
+    TEST_ASSERT_FALSE(error->hasError);
+    freeSyntaxTree(tree);
+    deleteTokenQueue(&tokenList);
+    free(program);
+
+    // One operator more is reported as it is, not as a bad SET
+    program = makeChain(MAX_EXPRESSION_DEPTH + 1);
+    tokenList = initTokenQueue();
+    tokenizeSource(&tokenList, program, error);
+    tree = parseProgram(&tokenList, error);
+    TEST_ASSERT_EQUAL_INT(ERROR_NESTING_TOO_DEEP, error->errCode);
+    TEST_ASSERT_EQUAL_STRING("Expression nested deeper than 4096 operators", error->errMsg);
+    freeSyntaxTree(tree);
+    deleteTokenQueue(&tokenList);
+    deleteError(&error);
+    free(program);
+
+    error = initError();
+    program = makeNestedLoops(MAX_BLOCK_NESTING);
+    tokenList = initTokenQueue();
+    tokenizeSource(&tokenList, program, error);
+    tree = parseProgram(&tokenList, error);
+    TEST_ASSERT_FALSE(error->hasError);
+    freeSyntaxTree(tree);
+    deleteTokenQueue(&tokenList);
+    free(program);
+
+    // The blocks around the one too many don't report their missing DONE
+    program = makeNestedLoops(MAX_BLOCK_NESTING + 1);
+    tokenList = initTokenQueue();
+    tokenizeSource(&tokenList, program, error);
+    tree = parseProgram(&tokenList, error);
+    TEST_ASSERT_EQUAL_INT(ERROR_NESTING_TOO_DEEP, error->errCode);
+    TEST_ASSERT_EQUAL_STRING("Blocks nested deeper than 1024 levels", error->errMsg);
+    freeSyntaxTree(tree);
+    deleteTokenQueue(&tokenList);
+    deleteError(&error);
+    free(program);
+}
+
 int main(void) {
     UNITY_BEGIN();
     RUN_TEST(testParseSet);
 	RUN_TEST(testParsePrint);
 	RUN_TEST(testParseReturn);
     RUN_TEST(testParseSetDeclarationOnly);
+    RUN_TEST(testProgramKeepsStatementError);
+    RUN_TEST(testNestingLimits);
     return UNITY_END();
 }
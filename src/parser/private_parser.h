@@ -10,16 +10,19 @@ typedef struct ParseResult ParseResult;
 struct ParseResult{
     SyntaxNode* node;
     bool hasError;
+    int depth; // Operators nested in an expression, 0 for a factor
 };
 
 // Wrapper functions, used to return nodes or errors
 static ParseResult makeResult(SyntaxNode* n);
 static ParseResult makeError(SimplicError* err, SimplicErrorType code, const char* fmt, ...);
+static ParseResult expressionError(SimplicError* err, SimplicErrorType code, const char* message); // Failed expression or operand, keeps nesting errors
 
 static TokenType findIfBlockDelimiter(Token** tokenList); // Determines if the IF block delimiter is ELSE or FI (or none)
 
 // Node generators, used to determine the kind of node to create based on the token list
 static ParseResult parseStatement(Token** tokenList, SimplicError* error); // generates instruction nodes
+static ParseResult parseNestedStatement(Token** tokenList, SimplicError* error, int nesting); // nesting: blocks the statement is inside of
 static ParseResult parseFactor(Token** tokenList, SimplicError* error); // generates variable, number or string nodes
 static ParseResult parseTerm(Token** tokenList, SimplicError* error); // takes care of * and / nodes
 static ParseResult parseExpr(Token** tokenList, SimplicError* error); // takes care of + and - nodes
@@ -27,6 +30,7 @@ static ParseResult parseRelational(Token** tokenList, SimplicError* error); // T
 static ParseResult parseEquality(Token** tokenList, SimplicError* error); // Takes care of equality ops == and !=
 static ParseResult parseLogical(Token** tokenList, SimplicError* error); // Takes care of logical ops && and ||
 static ParseResult parseLowestPrecedenceOperation(Token** tokenList, SimplicError* error); // Wrapper to call lowest priority parsing
-static SyntaxNode* parseBlock(Token** tokenList, SimplicError* error, TokenType endToken); // takes care of code blocks
+static ParseResult nestOperation(SyntaxNode* n, ParseResult left, ParseResult right, SimplicError* error); // Gives a bin_op its operands, fails past MAX_EXPRESSION_DEPTH
+static SyntaxNode* parseBlock(Token** tokenList, SimplicError* error, TokenType endToken, int nesting); // takes care of code blocks
 
 #endif
\ No newline at end of file
@@ -0,0 +1,207 @@
+#include "private_passManager.h"
+
+static const PassInfo passes[PASS_COUNT] = {
+    [PASS_CONSTANTS] = { .name = "constants", .level = 1 },
+    [PASS_DEAD_CODE] = { .name = "deadcode", .level = 1 },
+    [PASS_SSA] = { .name = "ssa", .level = 1 },
+    [PASS_HOIST] = { .name = "hoist", .level = 1 },
+    [PASS_CSE] = { .name = "cse", .level = 1 },
+    [PASS_INDUCTION] = { .name = "induction", .level = 1 },
+    [PASS_UNROLL] = { .name = "unroll", .level = 2 },
+    [PASS_TYPES] = { .name = "types", .level = 1 },
+};
+
+void initPipeline(PassPipeline* pipeline, int level) {
+    for (int i = 0; i < PASS_COUNT; i++) {
+        pipeline->enabled[i] = level >= passes[i].level;
+    }
+    pipeline->unrollFactor = 4;
+    pipeline->dump = NULL;
+    pipeline->timing = NULL;
+    pipeline->verify = false;
+}
+
+const char* passName(PassId pass) {
+    return passes[pass].name;
+}
+
+bool setPassEnabled(PassPipeline* pipeline, const char* name, bool enabled) {
+    for (int i = 0; i < PASS_COUNT; i++) {
+        if (strcmp(passes[i].name, name) == 0) {
+            pipeline->enabled[i] = enabled;
+            return true;
+        }
+    }
+    return false;
+}
+
+double pm_nowMs(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+void pm_run(const PassPipeline* pipeline, PassId pass, SyntaxNode* program) {
+    switch (pass) {
+        case PASS_CONSTANTS: propagateConstants(program); break;
+        case PASS_DEAD_CODE: eliminateDeadCode(program); break;
+        case PASS_SSA: optimizeWithSsa(program); break;
+        case PASS_HOIST: hoistLoopInvariants(program); break;
+        case PASS_CSE: eliminateCommonSubexpressions(program); break;
+        case PASS_INDUCTION: reduceInductionVariables(program); break;
+        case PASS_UNROLL: unrollLoops(program, pipeline->unrollFactor); break;
+        case PASS_TYPES: inferTypes(program); break;
+        default: break;
+    }
+}
+
+void runPipeline(const PassPipeline* pipeline, SyntaxNode* program, SimplicError* error) {
+    if (pipeline->dump != NULL) {
+        fprintf(pipeline->dump, "=== parsed ===\n");
+        dumpSyntaxTree(program, pipeline->dump);
+    }
+
+    for (int i = 0; i < PASS_COUNT; i++) {
+        if (!pipeline->enabled[i]) continue;
+
+        double start = pm_nowMs();
+        pm_run(pipeline, i, program);
+        if (pipeline->timing != NULL) fprintf(pipeline->timing, "%-10s %9.3f ms\n", passes[i].name, pm_nowMs() - start);
+
+        if (pipeline->dump != NULL) {
+            fprintf(pipeline->dump, "=== after %s ===\n", passes[i].name);
+            dumpSyntaxTree(program, pipeline->dump);
+        }
+
+        const char* problem = pipeline->verify ? pm_verify(program, true) : NULL;
+        if (problem != NULL) {
+            setError(error, ERROR_INVALID_EXPR, "Malformed syntax tree after pass %s: %s", passes[i].name, problem);
+            return;
+        }
+    }
+}
+
+bool pm_isExpression(SyntaxNode* node) {
+    return node != NULL && (node->type == NODE_NUMBER || node->type == NODE_STRING || node->type == NODE_VAR || node->type == NODE_BIN_OP);
+}
+
+bool pm_knownOperator(const char* operator) {
+    static const char* operators[] = { "+", "-", "*", "/", "%", "<", "<=", ">", ">=", "==", "!=", "&&", "||" };
+
+    for (unsigned int i = 0; i < sizeof(operators) / sizeof(operators[0]); i++) {
+        if (strcmp(operators[i], operator) == 0) return true;
+    }
+    return false;
+}
+
+const char* pm_verify(SyntaxNode* node, bool statement) {
+    const char* problem = NULL;
+    int i;
+
+    if (node == NULL) return "Missing node";
+    if (statement == pm_isExpression(node)) return statement ? "Expression used as a statement" : "Statement used as an expression";
+
+    switch (node->type) {
+        case NODE_NUMBER:
+            return NULL;
+
+        case NODE_STRING:
+            return (node->string == NULL) ? "String node without its text" : NULL;
+
+        case NODE_VAR:
+        case NODE_UNASSIGN:
+            return (node->varName[0] == '\0') ? "Variable without a name" : NULL;
+
+        case NODE_BIN_OP:
+            if (!pm_knownOperator(node->operator)) return "Unknown operator";
+            problem = pm_verify(node->subnodeA, false);
+            return (problem != NULL) ? problem : pm_verify(node->subnodeB, false);
+
+        case NODE_ASSIGN:
+            if (node->varName[0] == '\0') return "Assignment without a variable";
+            return pm_verify(node->subnodeB, false);
+
+        case NODE_PRINT:
+        case NODE_PRINTLN:
+        case NODE_RETURN:
+            return pm_verify(node->subnodeB, false);
+
+        case NODE_INCREMENT:
+        case NODE_DECREMENT:
+            return (node->subnodeB == NULL || node->subnodeB->type != NODE_VAR) ? "INCR/DECR without a variable" : NULL;
+
+        case NODE_BLOCK:
+            if (node->blockStatements == NULL) return "Block without its statement list";
+            for (i = 0; node->blockStatements[i] != NULL && problem == NULL; i++) {
+                problem = pm_verify(node->blockStatements[i], true);
+            }
+            return problem;
+
+        case NODE_WHILE:
+        case NODE_IF:
+            problem = pm_verify(node->subnodeA, false);
+            if (problem == NULL && (node->subnodeB == NULL || node->subnodeB->type != NODE_BLOCK)) problem = "Loop or branch without a block";
+            if (problem == NULL) problem = pm_verify(node->subnodeB, true);
+            if (problem == NULL && node->subnodeC != NULL) {
+                problem = (node->type == NODE_WHILE || node->subnodeC->type != NODE_BLOCK) ? "Unexpected ELSE block" : pm_verify(node->subnodeC, true);
+            }
+            return problem;
+
+        default:
+            return "Unknown node type";
+    }
+}
+
+bool verifySyntaxTree(SyntaxNode* program, SimplicError* error) {
+    const char* problem = pm_verify(program, true);
+    if (problem != NULL) setError(error, ERROR_INVALID_EXPR, "Malformed syntax tree: %s", problem);
+    return problem == NULL;
+}
+
+const char* pm_nodeName(NodeType type) {
+    static const char* names[] = {
+        [NODE_ASSIGN] = "SET", [NODE_UNASSIGN] = "UNSET", [NODE_PRINT] = "PRINT", [NODE_PRINTLN] = "PRINTLN",
+        [NODE_RETURN] = "RETURN", [NODE_NUMBER] = "NUMBER", [NODE_STRING] = "STRING", [NODE_VAR] = "VAR",
+        [NODE_INCREMENT] = "INCR", [NODE_DECREMENT] = "DECR", [NODE_BIN_OP] = "BIN_OP", [NODE_BLOCK] = "BLOCK",
+        [NODE_WHILE] = "WHILE", [NODE_IF] = "IF"
+    };
+
+    if ((unsigned int)type >= sizeof(names) / sizeof(names[0])) return "?";
+    return names[type];
+}
+
+void pm_dump(SyntaxNode* node, int depth, FILE* out) {
+    int i;
+    fprintf(out, "%*s", 2 * depth, "");
+    if (node == NULL) {
+        fprintf(out, "(null)\n");
+        return;
+    }
+
+    fprintf(out, "%s", pm_nodeName(node->type));
+    switch (node->type) {
+        case NODE_NUMBER: fprintf(out, " %d", node->numberValue); break;
+        case NODE_STRING: fprintf(out, " \"%s\"", node->string); break;
+        case NODE_VAR:
+        case NODE_ASSIGN:
+        case NODE_UNASSIGN: fprintf(out, " %s", node->varName); break;
+        case NODE_BIN_OP: fprintf(out, " %s", node->operator); break;
+        default: break;
+    }
+    fputc('\n', out);
+
+    if (node->type == NODE_BLOCK) {
+        for (i = 0; node->blockStatements != NULL && node->blockStatements[i] != NULL; i++) {
+            pm_dump(node->blockStatements[i], depth + 1, out);
+        }
+        return;
+    }
+
+    if (node->subnodeA != NULL) pm_dump(node->subnodeA, depth + 1, out);
+    if (node->subnodeB != NULL) pm_dump(node->subnodeB, depth + 1, out);
+    if (node->subnodeC != NULL) pm_dump(node->subnodeC, depth + 1, out);
+}
+
+void dumpSyntaxTree(SyntaxNode* program, FILE* out) {
+    pm_dump(program, 0, out);
+}
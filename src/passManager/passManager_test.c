@@ -0,0 +1,188 @@
+#include "unity.h"
+#include "unity_internals.h"
+
+#include "passManager.c"
+#include "interpreter.h"
+#include "parser.h"
+
+Token* tokenList;
+SimplicError* error;
+ControlState control;
+
+void setUp(void) {
+    control.returned = false;
+    tokenList = initTokenQueue();
+    control.bank = initMemoryBank();
+    control.out = stdout;
+    error = initError();
+}
+
+void tearDown(void) {
+    deleteTokenQueue(&tokenList);
+    deleteMemoryBank(&control.bank);
+    deleteError(&error);
+}
+
+SyntaxNode* parse(const char* program) {
+    tokenizeSource(&tokenList, program, error);
+    return parseProgram(&tokenList, error);
+}
+
+// Runs a program with eval(), after the pipeline when one is given
+SimplicValue runProgram(const char* program, const PassPipeline* pipeline) {
+    SimplicValue val = { .type = VALUE_VOID, .integer = 0, .string = NULL };
+    SyntaxNode* tree = parse(program);
+
+    if (!error->hasError && pipeline != NULL)
+        runPipeline(pipeline, tree, error);
+    if (!error->hasError)
+        val = eval(tree, &control, error);
+
+    freeSyntaxTree(tree);
+    return val;
+}
+
+// Whole content of a temporary file
+char* readBack(FILE* file) {
+    long size = ftell(file);
+    char* text = calloc(size + 1, 1);
+    rewind(file);
+    TEST_ASSERT_EQUAL_INT(size, fread(text, 1, size, file));
+    return text;
+}
+
+void testLevelsEnablePasses(void) {
+    PassPipeline pipeline;
+
+    initPipeline(&pipeline, 0);
+    for (int i = 0; i < PASS_COUNT; i++) TEST_ASSERT_FALSE(pipeline.enabled[i]);
+
+    initPipeline(&pipeline, 1);
+    TEST_ASSERT_TRUE(pipeline.enabled[PASS_CONSTANTS]);
+    TEST_ASSERT_TRUE(pipeline.enabled[PASS_INDUCTION]);
+    TEST_ASSERT_TRUE(pipeline.enabled[PASS_TYPES]);
+    TEST_ASSERT_FALSE(pipeline.enabled[PASS_UNROLL]);
+
+    initPipeline(&pipeline, 2);
+    for (int i = 0; i < PASS_COUNT; i++) TEST_ASSERT_TRUE(pipeline.enabled[i]);
+}
+
+void testEnablePassByName(void) {
+    PassPipeline pipeline;
+    initPipeline(&pipeline, 1);
+
+    TEST_ASSERT_TRUE(setPassEnabled(&pipeline, "unroll", true));
+    TEST_ASSERT_TRUE(pipeline.enabled[PASS_UNROLL]);
+    TEST_ASSERT_TRUE(setPassEnabled(&pipeline, "cse", false));
+    TEST_ASSERT_FALSE(pipeline.enabled[PASS_CSE]);
+    TEST_ASSERT_FALSE(setPassEnabled(&pipeline, "inline", true));
+    TEST_ASSERT_EQUAL_STRING("deadcode", passName(PASS_DEAD_CODE));
+}
+
+void testVerifyAcceptsParsedProgram(void) {
+    SyntaxNode* tree = parse(
+        "SET X = 3\n"
+        "WHILE X GT 0 DO\n"
+            "IF X EQ 2 THEN\n"
+                "PRINT \"two\"\n"
+            "ELSE\n"
+                "DECR X\n"
+            "FI\n"
+            "DECR X\n"
+        "DONE\n"
+        "UNSET X\n");
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_TRUE(verifySyntaxTree(tree, error));
+    TEST_ASSERT_FALSE(error->hasError);
+    freeSyntaxTree(tree);
+}
+
+void testVerifyCatchesMissingOperand(void) {
+    SyntaxNode* tree = parse("SET X = 1 + 2\n");
+    TEST_ASSERT_FALSE(error->hasError);
+
+    SyntaxNode* sum = tree->blockStatements[0]->subnodeB;
+    freeSyntaxTree(sum->subnodeB);
+    sum->subnodeB = NULL;
+
+    TEST_ASSERT_FALSE(verifySyntaxTree(tree, error));
+    TEST_ASSERT_EQUAL_INT(ERROR_INVALID_EXPR, error->errCode);
+    TEST_ASSERT_EQUAL_STRING("Malformed syntax tree: Missing node", error->errMsg);
+    freeSyntaxTree(tree);
+}
+
+void testDumpAndTiming(void) {
+    PassPipeline pipeline;
+    initPipeline(&pipeline, 1);
+    pipeline.dump = tmpfile();
+    pipeline.timing = tmpfile();
+    TEST_ASSERT_NOT_NULL(pipeline.dump);
+    TEST_ASSERT_NOT_NULL(pipeline.timing);
+
+    SimplicValue val = runProgram("SET X = 2 * 3\nRETURN X\n", &pipeline);
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(6, val.integer);
+
+    char* dump = readBack(pipeline.dump);
+    TEST_ASSERT_NOT_NULL(strstr(dump, "=== parsed ===\nBLOCK\n  SET X\n    BIN_OP *\n"));
+    TEST_ASSERT_NOT_NULL(strstr(dump, "=== after constants ===\nBLOCK\n  SET X\n    NUMBER 6\n"));
+    TEST_ASSERT_NULL(strstr(dump, "=== after unroll ==="));
+
+    char* timing = readBack(pipeline.timing);
+    TEST_ASSERT_NOT_NULL(strstr(timing, "constants"));
+    TEST_ASSERT_NOT_NULL(strstr(timing, "types"));
+    TEST_ASSERT_NULL(strstr(timing, "unroll"));
+
+    free(dump);
+    free(timing);
+    fclose(pipeline.dump);
+    fclose(pipeline.timing);
+}
+
+// Every level, with verification on, must keep the results eval() gives for the parsed program
+void testPipelineKeepsResults(void) {
+    const char* programs[] = {
+        "SET N = 10\nSET I = 0\nSET S = 0\nWHILE I LT N DO\nSET S = S + I * 3\nINCR I\nDONE\nRETURN S\n",
+        "SET A = 0\nSET B = 1\nSET I = 0\nWHILE I LT 20 DO\nSET T = A + B\nSET A = B\nSET B = T\nINCR I\nDONE\nRETURN A\n",
+        "SET X = 2\nSET C = 0\nWHILE X LT 200 DO\nSET Y = 2\nSET P = 1\nWHILE Y * Y LEQ X DO\nIF X % Y EQ 0 THEN\nSET P = 0\nFI\nINCR Y\nDONE\nSET C = C + P\nINCR X\nDONE\nRETURN C\n",
+        "SET S = \"A\"\nSET I = 0\nWHILE I LT 5 DO\nSET S = S + I\nINCR I\nDONE\nRETURN S\n",
+        "SET X = 4\nIF 0 THEN\nSET X = 9\nFI\nRETURN X * 2 + X * 2\n",
+    };
+
+    for (unsigned int i = 0; i < sizeof(programs) / sizeof(programs[0]); i++) {
+        SimplicValue expected = runProgram(programs[i], NULL);
+        TEST_ASSERT_FALSE(error->hasError);
+        tearDown();
+        setUp();
+
+        for (int level = 0; level <= 2; level++) {
+            PassPipeline pipeline;
+            initPipeline(&pipeline, level);
+            pipeline.unrollFactor = 3;
+            pipeline.verify = true;
+
+            SimplicValue val = runProgram(programs[i], &pipeline);
+            TEST_ASSERT_FALSE(error->hasError);
+            TEST_ASSERT_EQUAL_INT(expected.integer, val.integer);
+            if (expected.string != NULL) {
+                TEST_ASSERT_EQUAL_STRING(expected.string, val.string);
+            }
+
+            free(val.string);
+            tearDown();
+            setUp();
+        }
+        free(expected.string);
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(testLevelsEnablePasses);
+    RUN_TEST(testEnablePassByName);
+    RUN_TEST(testVerifyAcceptsParsedProgram);
+    RUN_TEST(testVerifyCatchesMissingOperand);
+    RUN_TEST(testDumpAndTiming);
+    RUN_TEST(testPipelineKeepsResults);
+    return UNITY_END();
+}
@@ -0,0 +1,28 @@
+#ifndef PRIVATE_PASSMANAGER_H
+#define PRIVATE_PASSMANAGER_H
+
+#include <time.h>
+#include "passManager.h"
+#include "optimizer.h"
+#include "ssa.h"
+
+// Fixed data of each pass
+typedef struct PassInfo PassInfo;
+struct PassInfo {
+    const char* name;
+    int level; // Lowest -O level that runs it
+};
+
+static void pm_run(const PassPipeline* pipeline, PassId pass, SyntaxNode* program);
+static double pm_nowMs(void);
+
+// Checks
+static bool pm_isExpression(SyntaxNode* node);
+static bool pm_knownOperator(const char* operator);
+static const char* pm_verify(SyntaxNode* node, bool statement); // Returns what is wrong, NULL if the tree is fine
+
+// Dump
+static const char* pm_nodeName(NodeType type);
+static void pm_dump(SyntaxNode* node, int depth, FILE* out);
+
+#endif
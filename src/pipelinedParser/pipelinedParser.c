@@ -0,0 +1,115 @@
+#ifndef _DEFAULT_SOURCE
+    #define _DEFAULT_SOURCE // Threads and sched_yield() are not part of ISO C
+#endif
+#include "private_pipelinedParser.h"
+
+void pp_wait(int spins) {
+    if (spins >= SPINS_BEFORE_YIELD) sched_yield();
+}
+
+void pp_push(TokenRing* ring, TokenBatch batch) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    for (int spins = 0; tail - atomic_load_explicit(&ring->head, memory_order_acquire) == RING_SIZE; spins++) pp_wait(spins);
+
+    // The slot is written before the parser can see the new tail
+    ring->slots[tail % RING_SIZE] = batch;
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+}
+
+TokenBatch pp_pop(TokenRing* ring) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    for (int spins = 0; atomic_load_explicit(&ring->tail, memory_order_acquire) == head; spins++) pp_wait(spins);
+
+    // The slot is read before the lexer can see it free
+    TokenBatch batch = ring->slots[head % RING_SIZE];
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return batch;
+}
+
+void pp_handBatch(Token* first, Token* last, void* context) {
+    pp_push(context, (TokenBatch){ .first = first, .last = last });
+}
+
+void* pp_lex(void* argument) {
+    LexerJob* job = argument;
+
+    tokenizeSourceBatches(job->src, job->length, job->batchTokens, pp_handBatch, job->ring, job->error);
+    pp_push(job->ring, (TokenBatch){ .first = NULL, .last = NULL }); // End of the stream, whether lexing failed or not
+    return NULL;
+}
+
+void pp_parseBatch(TokenBatch batch, StatementList* list, SimplicError* error) {
+    Token* tokens = batch.first;
+
+    // Every batch but the last stops where the next statement starts
+    if (batch.last->type != TOKEN_EOF) batch.last->next = createToken(TOKEN_EOF, "", NULL);
+
+    SyntaxNode* part = parseProgram(&tokens, error);
+    deleteTokenQueue(&tokens); // Only left if the batch had an error
+
+    size_t count = 0;
+    while (part->blockStatements[count] != NULL) count++;
+    if (list->count + count > list->capacity) {
+        while (list->count + count > list->capacity) list->capacity = (list->capacity == 0) ? 64 : list->capacity * 2;
+        list->statements = realloc(list->statements, sizeof(SyntaxNode*) * list->capacity);
+    }
+
+    // The statements move to the program, the block that held them goes
+    if (count > 0) memcpy(list->statements + list->count, part->blockStatements, sizeof(SyntaxNode*) * count);
+    list->count += count;
+    part->blockStatements[0] = NULL;
+    freeSyntaxTree(part);
+}
+
+SyntaxNode* pp_parseSerial(const char* src, size_t length, SimplicError* error) {
+    Token* tokens = initTokenQueue();
+    SyntaxNode* program = NULL;
+
+    tokenizeSourceLength(&tokens, src, length, error);
+    if (!error->hasError) program = parseProgram(&tokens, error);
+    deleteTokenQueue(&tokens);
+
+    if (error->hasError) {
+        freeSyntaxTree(program);
+        return NULL;
+    }
+    return program;
+}
+
+SyntaxNode* parsePipelined(const char* src, size_t length, size_t batchTokens, SimplicError* error) {
+    TokenRing ring;
+    atomic_init(&ring.head, 0);
+    atomic_init(&ring.tail, 0);
+
+    LexerJob job = { .src = src, .length = length, .batchTokens = batchTokens, .ring = &ring, .error = initError() };
+    pthread_t lexer;
+    if (pthread_create(&lexer, NULL, pp_lex, &job) != 0) {
+        deleteError(&job.error);
+        return pp_parseSerial(src, length, error);
+    }
+
+    StatementList list = { .statements = NULL, .count = 0, .capacity = 0 };
+    for (TokenBatch batch = pp_pop(&ring); batch.first != NULL; batch = pp_pop(&ring)) {
+        // After an error the batches are only drained, the lexer may still find an error of its own
+        if (error->hasError) deleteTokenQueue(&batch.first);
+        else pp_parseBatch(batch, &list, error);
+    }
+    pthread_join(lexer, NULL);
+
+    // Lexing the whole source first would have stopped before parsing anything
+    if (job.error->hasError) setError(error, job.error->errCode, "%s", job.error->errMsg);
+    deleteError(&job.error);
+
+    SyntaxNode* program = initNode();
+    program->type = NODE_BLOCK;
+    program->blockStatements = realloc(list.statements, sizeof(SyntaxNode*) * (list.count + 1));
+    program->blockStatements[list.count] = NULL;
+
+    if (error->hasError) {
+        freeSyntaxTree(program);
+        return NULL;
+    }
+    return program;
+}
@@ -0,0 +1,154 @@
+#define _DEFAULT_SOURCE // Before any system header, like in pipelinedParser.c
+#include "unity.h"
+#include "unity_internals.h"
+
+#include "pipelinedParser.c"
+
+const char* program =
+    "SET S = \"Count: \"\nSET I = 0\nWHILE I LT 10 DO\n"
+    "IF I % 2 EQ 0 THEN\nSET S = S + I\nELSE\nIF I GT 5 THEN\nDECR I\nINCR I\nFI\nFI\nINCR I\nDONE\n"
+    "UNSET I\nSET EMPTY\nPRINTLN S + EMPTY\nPRINT 1 AND 0 OR 2 NEQ 3\nRETURN 7 * 6\n";
+
+SimplicError* error;
+SimplicError* serialError;
+
+void setUp(void) {
+    error = initError();
+    serialError = initError();
+}
+
+void tearDown(void) {
+    deleteError(&error);
+    deleteError(&serialError);
+}
+
+// What parseScript() gives without the pipeline
+SyntaxNode* parseSerial(const char* src) {
+    Token* tokens = initTokenQueue();
+    SyntaxNode* tree = NULL;
+
+    tokenizeSource(&tokens, src, serialError);
+    if (!serialError->hasError) tree = parseProgram(&tokens, serialError);
+    deleteTokenQueue(&tokens);
+
+    if (serialError->hasError) {
+        freeSyntaxTree(tree);
+        return NULL;
+    }
+    return tree;
+}
+
+// Both front ends give the same program, or the same error
+void assertSameParse(const char* src, size_t batchTokens) {
+    unsetError(error);
+    unsetError(serialError);
+
+    SyntaxNode* expected = parseSerial(src);
+    SyntaxNode* tree = parsePipelined(src, strlen(src), batchTokens, error);
+
+    TEST_ASSERT_EQUAL(serialError->hasError, error->hasError);
+    if (error->hasError) {
+        TEST_ASSERT_NULL(tree);
+        TEST_ASSERT_EQUAL_INT(serialError->errCode, error->errCode);
+        TEST_ASSERT_EQUAL_STRING(serialError->errMsg, error->errMsg);
+    } else {
+        TEST_ASSERT_TRUE(compareSyntaxTree(expected, tree));
+    }
+
+    freeSyntaxTree(expected);
+    freeSyntaxTree(tree);
+}
+
+typedef struct BatchCount BatchCount;
+struct BatchCount {
+    int batches;
+    int tokens;
+    TokenType lastType;
+};
+
+void countBatch(Token* first, Token* last, void* context) {
+    BatchCount* count = context;
+    count->batches++;
+    count->lastType = last->type;
+
+    Token* batch = first;
+    for (Token* t = first; t != NULL; t = t->next) count->tokens++;
+    deleteTokenQueue(&batch);
+}
+
+void testBatchesAreWholeStatements(void) {
+    BatchCount count = { .batches = 0, .tokens = 0, .lastType = TOKEN_ERROR_TOKEN };
+
+    // SET X = 1 | WHILE X LT 3 DO INCR X DONE | PRINT X EOF
+    const char* src = "SET X = 1\nWHILE X LT 3 DO\nINCR X\nDONE\nPRINT X\n";
+    tokenizeSourceBatches(src, strlen(src), 1, countBatch, &count, error);
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(3, count.batches);
+    TEST_ASSERT_EQUAL_INT(15, count.tokens);
+    TEST_ASSERT_EQUAL_INT(TOKEN_EOF, count.lastType);
+
+    // Big enough batches take the whole program
+    count = (BatchCount){ .batches = 0, .tokens = 0, .lastType = TOKEN_ERROR_TOKEN };
+    tokenizeSourceBatches(program, strlen(program), 4096, countBatch, &count, error);
+    TEST_ASSERT_EQUAL_INT(1, count.batches);
+}
+
+void testSameProgram(void) {
+    for (size_t batchTokens = 0; batchTokens < 12; batchTokens++) assertSameParse(program, batchTokens);
+    assertSameParse(program, 4096);
+    assertSameParse("", 1);
+    assertSameParse("# Only a comment", 1);
+}
+
+void testLexerErrorsWin(void) {
+    // The parser would fail first on its own
+    assertSameParse("PRINT 1 +\nPRINT 2\nSET X = \"never closed\n", 1);
+    TEST_ASSERT_EQUAL_INT(ERROR_NON_TERMINATED_STRING_LITERAL, error->errCode);
+}
+
+// Statements that don't parse, with stray block terminators and keywords where expressions go
+void testSameErrors(void) {
+    const char* words[] = {
+        "SET", "UNSET", "PRINT", "PRINTLN", "RETURN", "INCR", "DECR", "WHILE", "DO", "DONE", "IF", "THEN",
+        "ELSE", "FI", "X", "Y", "1", "2", "\"s\"", "=", "+", "*", "%", "LT", "EQ", "AND", "\n"
+    };
+    const int wordCount = sizeof(words) / sizeof(words[0]);
+    char src[512];
+    unsigned int seed = 12345;
+
+    for (int i = 0; i < 3000; i++) {
+        src[0] = '\0';
+        int length = 1 + i % 24;
+        for (int j = 0; j < length; j++) {
+            seed = seed * 1103515245u + 12345u;
+            strcat(src, words[(seed >> 16) % wordCount]);
+            strcat(src, " ");
+        }
+        assertSameParse(src, 1 + i % 4);
+    }
+}
+
+void testBigScript(void) {
+    const char* statement = "SET A = A + 1\nIF A % 3 EQ 0 THEN\nPRINT A\nELSE\nWHILE B LT A DO\nINCR B\nDONE\nFI\n";
+    size_t size = strlen(statement) * 5000 + 1;
+    char* src = malloc(size);
+
+    src[0] = '\0';
+    char* end = src;
+    for (int i = 0; i < 5000; i++) end = stpcpy(end, statement);
+
+    // Thousands of batches go round the ring many times
+    assertSameParse(src, 1);
+    assertSameParse(src, 4096);
+    free(src);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(testBatchesAreWholeStatements);
+    RUN_TEST(testSameProgram);
+    RUN_TEST(testLexerErrorsWin);
+    RUN_TEST(testSameErrors);
+    RUN_TEST(testBigScript);
+    return UNITY_END();
+}
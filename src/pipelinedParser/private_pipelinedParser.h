@@ -0,0 +1,57 @@
+#ifndef PRIVATE_PIPELINEDPARSER_H
+#define PRIVATE_PIPELINEDPARSER_H
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include "pipelinedParser.h"
+#include "lexer.h"
+#include "parser.h"
+
+#define RING_SIZE 64 // Batches the lexer may get ahead of the parser
+#define SPINS_BEFORE_YIELD 64 // Checks of an empty or full ring before giving the CPU away
+
+// Tokens first to last, linked through next. A batch with no tokens ends the stream
+typedef struct TokenBatch TokenBatch;
+struct TokenBatch {
+    Token* first;
+    Token* last;
+};
+
+// Only the lexer moves tail and only the parser moves head, each on its own cache line
+typedef struct TokenRing TokenRing;
+struct TokenRing {
+    TokenBatch slots[RING_SIZE];
+    _Alignas(64) atomic_size_t head; // Next slot to read
+    _Alignas(64) atomic_size_t tail; // Next slot to write
+};
+
+// What the lexer thread works on
+typedef struct LexerJob LexerJob;
+struct LexerJob {
+    const char* src;
+    size_t length;
+    size_t batchTokens;
+    TokenRing* ring;
+    SimplicError* error; // Its own, the parser's is not touched by the lexer
+};
+
+// Program being put together from the statements of each batch
+typedef struct StatementList StatementList;
+struct StatementList {
+    SyntaxNode** statements;
+    size_t count;
+    size_t capacity;
+};
+
+static void pp_wait(int spins); // Spins first, yields once the other side is clearly not about to move
+static void pp_push(TokenRing* ring, TokenBatch batch); // Waits while the ring is full
+static TokenBatch pp_pop(TokenRing* ring); // Waits while the ring is empty
+
+static void pp_handBatch(Token* first, Token* last, void* context); // TokenBatchHandler pushing to the ring
+static void* pp_lex(void* argument);
+
+static void pp_parseBatch(TokenBatch batch, StatementList* list, SimplicError* error);
+static SyntaxNode* pp_parseSerial(const char* src, size_t length, SimplicError* error); // If no thread can be started
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef PRIVATE_PROGRAMCACHE_H
+#define PRIVATE_PROGRAMCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "programCache.h"
+
+#define CACHE_MAGIC "SPCF"
+#define CACHE_FORMAT 1 // Changes whenever the records do
+#define CACHE_BUILD SIMPLIC_VERSION " " __DATE__ " " __TIME__ // A rebuilt interpreter may parse or optimize differently
+#define CACHE_NO_STRING UINT32_MAX
+
+// Flags of a record
+#define CACHE_PROVEN_INT 1
+#define CACHE_HAS_A 2
+#define CACHE_HAS_B 4
+#define CACHE_HAS_C 8
+
+// Start of every entry, the fields up to passesHash must match the ones of the run for a hit
+typedef struct CacheHeader CacheHeader;
+struct CacheHeader {
+    char magic[4];
+    uint32_t format;
+    char build[32];
+    uint64_t sourceHash;
+    uint64_t sourceSize;
+    uint64_t passesHash;
+    uint32_t nodeCount; // Records that follow the header
+    uint32_t stringBytes; // Size of the string table that follows the records
+};
+
+// One node of the tree, its children are the records that follow it
+typedef struct CacheRecord CacheRecord;
+struct CacheRecord {
+    uint8_t type;
+    uint8_t flags;
+    char operator[BIN_OP_OPERATOR_SIZE];
+    int32_t number;
+    uint32_t statements; // Blocks only
+    uint32_t name; // Offsets in the string table, CACHE_NO_STRING if the node has none
+    uint32_t string;
+};
+
+// Entry being written
+typedef struct CacheWriter CacheWriter;
+struct CacheWriter {
+    CacheRecord* records;
+    uint32_t count;
+    uint32_t capacity;
+    char* strings;
+    uint32_t stringBytes;
+    uint32_t stringCapacity;
+};
+
+// Entry being read, every offset and count is checked against the size of the file
+typedef struct CacheReader CacheReader;
+struct CacheReader {
+    const CacheRecord* records;
+    uint32_t count;
+    uint32_t next;
+    const char* strings;
+    uint32_t stringBytes;
+    bool failed;
+};
+
+static uint64_t pc_hash(uint64_t hash, const void* data, size_t size); // FNV-1a
+static void pc_header(CacheHeader* header, const char* source, size_t length, const PassPipeline* pipeline);
+static char* pc_path(const char* dir, const CacheHeader* header); // Entry file of a header
+
+// Writing
+static uint32_t pc_addString(CacheWriter* writer, const char* s);
+static void pc_addNode(CacheWriter* writer, SyntaxNode* node);
+
+// Reading
+static const char* pc_string(CacheReader* reader, uint32_t offset, size_t maxLength); // NULL if out of the table
+static SyntaxNode* pc_readNode(CacheReader* reader);
+static SyntaxNode* pc_decode(const void* data, size_t size, const CacheHeader* expected); // NULL if the entry is not valid
+
+#endif
@@ -0,0 +1,253 @@
+#ifndef _DEFAULT_SOURCE
+    #define _DEFAULT_SOURCE // mmap(), open() and mkdir() are not part of ISO C
+#endif
+#include "private_programCache.h"
+
+uint64_t pc_hash(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+void pc_header(CacheHeader* header, const char* source, size_t length, const PassPipeline* pipeline) {
+    memset(header, 0, sizeof(CacheHeader));
+    memcpy(header->magic, CACHE_MAGIC, sizeof(header->magic));
+    header->format = CACHE_FORMAT;
+    strncpy(header->build, CACHE_BUILD, sizeof(header->build) - 1);
+
+    header->sourceSize = length;
+    header->sourceHash = pc_hash(14695981039346656037ULL, source, header->sourceSize);
+
+    // Only the passes change the tree, dumping, timing and verifying don't
+    int32_t unroll = pipeline->unrollFactor;
+    header->passesHash = pc_hash(14695981039346656037ULL, pipeline->enabled, sizeof(pipeline->enabled));
+    header->passesHash = pc_hash(header->passesHash, &unroll, sizeof(unroll));
+}
+
+char* pc_path(const char* dir, const CacheHeader* header) {
+    size_t size = strlen(dir) + 48;
+    char* path = malloc(size);
+    snprintf(path, size, "%s/%016llx-%016llx.spc", dir, (unsigned long long)header->sourceHash, (unsigned long long)header->passesHash);
+    return path;
+}
+
+uint32_t pc_addString(CacheWriter* writer, const char* s) {
+    uint32_t length = strlen(s) + 1;
+    if (writer->stringBytes + length > writer->stringCapacity) {
+        while (writer->stringBytes + length > writer->stringCapacity) {
+            writer->stringCapacity = (writer->stringCapacity == 0) ? 256 : writer->stringCapacity * 2;
+        }
+        writer->strings = realloc(writer->strings, writer->stringCapacity);
+    }
+
+    memcpy(writer->strings + writer->stringBytes, s, length);
+    writer->stringBytes += length;
+    return writer->stringBytes - length;
+}
+
+void pc_addNode(CacheWriter* writer, SyntaxNode* node) {
+    if (writer->count == writer->capacity) {
+        writer->capacity = (writer->capacity == 0) ? 64 : writer->capacity * 2;
+        writer->records = realloc(writer->records, sizeof(CacheRecord) * writer->capacity);
+    }
+
+    // Records are written whole, padding included
+    CacheRecord record;
+    memset(&record, 0, sizeof(record));
+    record.type = node->type;
+    record.flags = (node->provenInt ? CACHE_PROVEN_INT : 0) | (node->subnodeA != NULL ? CACHE_HAS_A : 0) |
+                   (node->subnodeB != NULL ? CACHE_HAS_B : 0) | (node->subnodeC != NULL ? CACHE_HAS_C : 0);
+    memcpy(record.operator, node->operator, BIN_OP_OPERATOR_SIZE);
+    record.number = node->numberValue;
+    record.name = (node->varName[0] != '\0' && (node->type == NODE_VAR || node->type == NODE_ASSIGN || node->type == NODE_UNASSIGN))
+        ? pc_addString(writer, node->varName) : CACHE_NO_STRING;
+    record.string = (node->type == NODE_STRING) ? pc_addString(writer, node->string) : CACHE_NO_STRING;
+
+    if (node->type == NODE_BLOCK) {
+        while (node->blockStatements[record.statements] != NULL) record.statements++;
+    }
+
+    uint32_t index = writer->count++;
+    writer->records[index] = record;
+
+    if (node->type == NODE_BLOCK) {
+        for (uint32_t i = 0; i < record.statements; i++) {
+            pc_addNode(writer, node->blockStatements[i]);
+        }
+        return;
+    }
+    if (node->subnodeA != NULL) pc_addNode(writer, node->subnodeA);
+    if (node->subnodeB != NULL) pc_addNode(writer, node->subnodeB);
+    if (node->subnodeC != NULL) pc_addNode(writer, node->subnodeC);
+}
+
+bool storeCachedProgram(const char* dir, const char* source, size_t length, const PassPipeline* pipeline, SyntaxNode* program) {
+    CacheHeader header;
+    CacheWriter writer = { .records = NULL, .count = 0, .capacity = 0, .strings = NULL, .stringBytes = 0, .stringCapacity = 0 };
+
+    mkdir(dir, 0777); // Fails harmlessly if it already exists, fopen() reports any other problem
+
+    pc_header(&header, source, length, pipeline);
+    pc_addNode(&writer, program);
+    header.nodeCount = writer.count;
+    header.stringBytes = writer.stringBytes;
+
+    // Threads of one process (see --jobs) may store the same entry at once, each writes its own file
+    static atomic_uint stores = 0;
+    char* path = pc_path(dir, &header);
+    size_t size = strlen(path) + 48;
+    char* temporary = malloc(size);
+    snprintf(temporary, size, "%s.%ld.%u.tmp", path, (long)getpid(), atomic_fetch_add(&stores, 1));
+
+    bool ok = false;
+    FILE* file = fopen(temporary, "wb");
+    if (file != NULL) {
+        ok = fwrite(&header, sizeof(header), 1, file) == 1;
+        ok = ok && fwrite(writer.records, sizeof(CacheRecord), writer.count, file) == writer.count;
+        ok = ok && (writer.stringBytes == 0 || fwrite(writer.strings, 1, writer.stringBytes, file) == writer.stringBytes);
+        ok = (fclose(file) == 0) && ok;
+
+        // Readers see either the old entry or the whole new one
+        ok = ok && rename(temporary, path) == 0;
+        if (!ok) remove(temporary);
+    }
+
+    free(temporary);
+    free(path);
+    free(writer.records);
+    free(writer.strings);
+    return ok;
+}
+
+const char* pc_string(CacheReader* reader, uint32_t offset, size_t maxLength) {
+    if (offset >= reader->stringBytes) return NULL;
+
+    const char* s = reader->strings + offset;
+    size_t available = reader->stringBytes - offset;
+    const char* end = memchr(s, '\0', (available < maxLength) ? available : maxLength);
+    return (end == NULL) ? NULL : s;
+}
+
+SyntaxNode* pc_readNode(CacheReader* reader) {
+    if (reader->failed || reader->next >= reader->count) {
+        reader->failed = true;
+        return NULL;
+    }
+
+    // Subnodes each type may have, the ones freeSyntaxTree() frees
+    static const uint8_t subnodes[] = {
+        [NODE_ASSIGN] = CACHE_HAS_B, [NODE_PRINT] = CACHE_HAS_B, [NODE_PRINTLN] = CACHE_HAS_B, [NODE_RETURN] = CACHE_HAS_B,
+        [NODE_INCREMENT] = CACHE_HAS_B, [NODE_DECREMENT] = CACHE_HAS_B, [NODE_BIN_OP] = CACHE_HAS_A | CACHE_HAS_B,
+        [NODE_WHILE] = CACHE_HAS_A | CACHE_HAS_B, [NODE_IF] = CACHE_HAS_A | CACHE_HAS_B | CACHE_HAS_C
+    };
+    const uint8_t allSubnodes = CACHE_HAS_A | CACHE_HAS_B | CACHE_HAS_C;
+
+    const CacheRecord* record = &reader->records[reader->next++];
+    bool named = record->type == NODE_VAR || record->type == NODE_ASSIGN || record->type == NODE_UNASSIGN;
+    if (record->type > NODE_IF || (record->flags & allSubnodes & ~subnodes[record->type]) != 0 ||
+        (record->name != CACHE_NO_STRING && !named) || memchr(record->operator, '\0', BIN_OP_OPERATOR_SIZE) == NULL) {
+        reader->failed = true;
+        return NULL;
+    }
+
+    SyntaxNode* node = initNode();
+    node->type = record->type;
+    node->provenInt = (record->flags & CACHE_PROVEN_INT) != 0;
+    memcpy(node->operator, record->operator, BIN_OP_OPERATOR_SIZE);
+    node->numberValue = record->number;
+
+    if (record->name != CACHE_NO_STRING) {
+        const char* name = pc_string(reader, record->name, IDENTIFIER_SIZE);
+        if (name == NULL) reader->failed = true;
+        else strcpy(node->varName, name);
+    }
+
+    if ((record->string != CACHE_NO_STRING) != (node->type == NODE_STRING)) {
+        reader->failed = true;
+    } else if (node->type == NODE_STRING) {
+        const char* s = pc_string(reader, record->string, SIZE_MAX);
+        if (s == NULL) {
+            reader->failed = true;
+        } else {
+            node->string = malloc(strlen(s) + 1);
+            strcpy(node->string, s);
+        }
+    }
+
+    if (node->type == NODE_BLOCK) {
+        // Every statement takes a record at least
+        uint32_t count = (record->statements <= reader->count - reader->next) ? record->statements : 0;
+        if (count != record->statements) reader->failed = true;
+
+        node->blockStatements = malloc(sizeof(SyntaxNode*) * (count + 1));
+        uint32_t i;
+        for (i = 0; i < count && !reader->failed; i++) {
+            node->blockStatements[i] = pc_readNode(reader);
+            if (node->blockStatements[i] == NULL) break;
+        }
+        node->blockStatements[i] = NULL;
+        return node;
+    }
+
+    uint8_t flags = record->flags;
+    if (flags & CACHE_HAS_A) node->subnodeA = pc_readNode(reader);
+    if (flags & CACHE_HAS_B) node->subnodeB = pc_readNode(reader);
+    if (flags & CACHE_HAS_C) node->subnodeC = pc_readNode(reader);
+    return node;
+}
+
+SyntaxNode* pc_decode(const void* data, size_t size, const CacheHeader* expected) {
+    const CacheHeader* header = data;
+    if (size < sizeof(CacheHeader) || memcmp(header, expected, offsetof(CacheHeader, nodeCount)) != 0) return NULL;
+
+    uint64_t records = (uint64_t)header->nodeCount * sizeof(CacheRecord);
+    if (size != sizeof(CacheHeader) + records + header->stringBytes) return NULL;
+
+    CacheReader reader = {
+        .records = (const CacheRecord*)(header + 1),
+        .count = header->nodeCount,
+        .next = 0,
+        .strings = (const char*)(header + 1) + records,
+        .stringBytes = header->stringBytes,
+        .failed = false
+    };
+    SyntaxNode* program = pc_readNode(&reader);
+
+    // The records must make exactly one well formed program
+    SimplicError* error = initError();
+    bool valid = !reader.failed && reader.next == reader.count && program->type == NODE_BLOCK && verifySyntaxTree(program, error);
+    deleteError(&error);
+
+    if (!valid) {
+        freeSyntaxTree(program);
+        return NULL;
+    }
+    return program;
+}
+
+SyntaxNode* loadCachedProgram(const char* dir, const char* source, size_t length, const PassPipeline* pipeline) {
+    CacheHeader expected;
+    struct stat info;
+
+    pc_header(&expected, source, length, pipeline);
+    char* path = pc_path(dir, &expected);
+    int fd = open(path, O_RDONLY);
+    free(path);
+    if (fd < 0) return NULL;
+
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(CacheHeader)) {
+        close(fd);
+        return NULL;
+    }
+
+    void* data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return NULL;
+
+    SyntaxNode* program = pc_decode(data, info.st_size, &expected);
+    munmap(data, info.st_size);
+    return program;
+}
@@ -0,0 +1,179 @@
+#define _DEFAULT_SOURCE // Before any system header, like in programCache.c
+#include "unity.h"
+#include "unity_internals.h"
+
+#include "programCache.c"
+#include "interpreter.h"
+#include "optimizer.h"
+#include "parser.h"
+
+#define TEST_CACHE_DIR "build/tests/programCache"
+
+const char* program =
+    "SET S = \"Count: \"\nSET I = 0\nWHILE I LT 10 DO\n"
+    "IF I % 2 EQ 0 THEN\nSET S = S + I\nELSE\nDECR I\nINCR I\nFI\nINCR I\nDONE\n"
+    "UNSET I\nSET EMPTY = \"\"\nPRINTLN S + EMPTY\nRETURN 7 * 6\n";
+
+Token* tokenList;
+SimplicError* error;
+ControlState control;
+PassPipeline pipeline;
+
+void setUp(void) {
+    control.returned = false;
+    tokenList = initTokenQueue();
+    control.bank = initMemoryBank();
+    control.out = stdout;
+    error = initError();
+    initPipeline(&pipeline, 2);
+}
+
+void tearDown(void) {
+    deleteTokenQueue(&tokenList);
+    deleteMemoryBank(&control.bank);
+    deleteError(&error);
+}
+
+SyntaxNode* parse(const char* source) {
+    tokenizeSource(&tokenList, source, error);
+    SyntaxNode* tree = parseProgram(&tokenList, error);
+    TEST_ASSERT_FALSE(error->hasError);
+    inferTypes(tree);
+    return tree;
+}
+
+// compareSyntaxTree() doesn't look at the types inferred
+void assertSameTypes(SyntaxNode* a, SyntaxNode* b) {
+    if (a == NULL || b == NULL) {
+        TEST_ASSERT_TRUE(a == b);
+        return;
+    }
+
+    TEST_ASSERT_EQUAL_INT(a->provenInt, b->provenInt);
+    if (a->type == NODE_BLOCK) {
+        for (int i = 0; a->blockStatements[i] != NULL; i++) assertSameTypes(a->blockStatements[i], b->blockStatements[i]);
+    }
+    assertSameTypes(a->subnodeA, b->subnodeA);
+    assertSameTypes(a->subnodeB, b->subnodeB);
+    assertSameTypes(a->subnodeC, b->subnodeC);
+}
+
+// Path of the entry of program with the current pipeline
+char* entryPath(void) {
+    CacheHeader header;
+    pc_header(&header, program, strlen(program), &pipeline);
+    return pc_path(TEST_CACHE_DIR, &header);
+}
+
+void testRoundTrip(void) {
+    SyntaxNode* tree = parse(program);
+    TEST_ASSERT_TRUE(storeCachedProgram(TEST_CACHE_DIR, program, strlen(program), &pipeline, tree));
+
+    SyntaxNode* cached = loadCachedProgram(TEST_CACHE_DIR, program, strlen(program), &pipeline);
+    TEST_ASSERT_NOT_NULL(cached);
+    TEST_ASSERT_TRUE(compareSyntaxTree(tree, cached));
+    assertSameTypes(tree, cached);
+
+    SimplicValue val = eval(cached, &control, error);
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_TRUE(control.returned);
+    TEST_ASSERT_EQUAL_INT(42, val.integer);
+
+    freeSyntaxTree(tree);
+    freeSyntaxTree(cached);
+}
+
+void testOtherSourceOrPassesMiss(void) {
+    SyntaxNode* tree = parse(program);
+    TEST_ASSERT_TRUE(storeCachedProgram(TEST_CACHE_DIR, program, strlen(program), &pipeline, tree));
+
+    TEST_ASSERT_NULL(loadCachedProgram(TEST_CACHE_DIR, "RETURN 1\n", 9, &pipeline));
+
+    pipeline.enabled[PASS_UNROLL] = false;
+    TEST_ASSERT_NULL(loadCachedProgram(TEST_CACHE_DIR, program, strlen(program), &pipeline));
+    pipeline.enabled[PASS_UNROLL] = true;
+    pipeline.unrollFactor++;
+    TEST_ASSERT_NULL(loadCachedProgram(TEST_CACHE_DIR, program, strlen(program), &pipeline));
+
+    // Options that don't change the tree share the entry
+    pipeline.unrollFactor--;
+    pipeline.verify = true;
+    pipeline.timing = stderr;
+    SyntaxNode* cached = loadCachedProgram(TEST_CACHE_DIR, program, strlen(program), &pipeline);
+    TEST_ASSERT_NOT_NULL(cached);
+
+    freeSyntaxTree(tree);
+    freeSyntaxTree(cached);
+}
+
+// Overwrites size bytes of the entry at offset
+void patchEntry(long offset, const void* bytes, size_t size) {
+    char* path = entryPath();
+    FILE* file = fopen(path, "r+b");
+    TEST_ASSERT_NOT_NULL(file);
+    fseek(file, offset, SEEK_SET);
+    TEST_ASSERT_EQUAL_INT(size, fwrite(bytes, 1, size, file));
+    fclose(file);
+    free(path);
+}
+
+void testOtherBuildMisses(void) {
+    SyntaxNode* tree = parse(program);
+    TEST_ASSERT_TRUE(storeCachedProgram(TEST_CACHE_DIR, program, strlen(program), &pipeline, tree));
+
+    patchEntry(offsetof(CacheHeader, build), "0.9", 3);
+    TEST_ASSERT_NULL(loadCachedProgram(TEST_CACHE_DIR, program, strlen(program), &pipeline));
+
+    // Storing again replaces the stale entry
+    TEST_ASSERT_TRUE(storeCachedProgram(TEST_CACHE_DIR, program, strlen(program), &pipeline, tree));
+    SyntaxNode* cached = loadCachedProgram(TEST_CACHE_DIR, program, strlen(program), &pipeline);
+    TEST_ASSERT_NOT_NULL(cached);
+
+    freeSyntaxTree(tree);
+    freeSyntaxTree(cached);
+}
+
+void testCorruptEntriesMiss(void) {
+    SyntaxNode* tree = parse(program);
+    char* path = entryPath();
+    CacheRecord record;
+
+    // Truncated
+    TEST_ASSERT_TRUE(storeCachedProgram(TEST_CACHE_DIR, program, strlen(program), &pipeline, tree));
+    TEST_ASSERT_EQUAL_INT(0, truncate(path, sizeof(CacheHeader) + sizeof(CacheRecord) * 3));
+    TEST_ASSERT_NULL(loadCachedProgram(TEST_CACHE_DIR, program, strlen(program), &pipeline));
+
+    // A block claiming more statements than there are records
+    TEST_ASSERT_TRUE(storeCachedProgram(TEST_CACHE_DIR, program, strlen(program), &pipeline, tree));
+    memset(&record, 0, sizeof(record));
+    record.type = NODE_BLOCK;
+    record.statements = 1000;
+    record.name = CACHE_NO_STRING;
+    record.string = CACHE_NO_STRING;
+    patchEntry(sizeof(CacheHeader), &record, sizeof(record));
+    TEST_ASSERT_NULL(loadCachedProgram(TEST_CACHE_DIR, program, strlen(program), &pipeline));
+
+    // A string out of the table
+    TEST_ASSERT_TRUE(storeCachedProgram(TEST_CACHE_DIR, program, strlen(program), &pipeline, tree));
+    uint32_t offset = 1u << 30;
+    patchEntry(sizeof(CacheHeader) + sizeof(CacheRecord) + offsetof(CacheRecord, name), &offset, sizeof(offset));
+    TEST_ASSERT_NULL(loadCachedProgram(TEST_CACHE_DIR, program, strlen(program), &pipeline));
+
+    // A node that is not valid where it is, the first statement becomes a number
+    TEST_ASSERT_TRUE(storeCachedProgram(TEST_CACHE_DIR, program, strlen(program), &pipeline, tree));
+    uint8_t type = NODE_NUMBER;
+    patchEntry(sizeof(CacheHeader) + sizeof(CacheRecord) + offsetof(CacheRecord, type), &type, sizeof(type));
+    TEST_ASSERT_NULL(loadCachedProgram(TEST_CACHE_DIR, program, strlen(program), &pipeline));
+
+    free(path);
+    freeSyntaxTree(tree);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(testRoundTrip);
+    RUN_TEST(testOtherSourceOrPassesMiss);
+    RUN_TEST(testOtherBuildMisses);
+    RUN_TEST(testCorruptEntriesMiss);
+    return UNITY_END();
+}
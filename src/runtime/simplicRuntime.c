@@ -0,0 +1,72 @@
+#include <stdio.h>
+#include <string.h>
+#include "simplicRuntime.h"
+
+#define SR_CHARS_FOR_INT 11 // Same room the interpreter leaves for an int inside a string
+
+// Same format as printError()
+_Noreturn static void sr_fail(const char* message, const char* detail) {
+    printf("\nError: ");
+    printf(message, detail);
+    printf("\n");
+    exit(EXIT_FAILURE);
+}
+
+SrValue sr_str(const char* s) {
+    SrValue res = { .type = SR_STR, .integer = 0, .string = NULL };
+    res.string = malloc(strlen(s) + 1);
+    strcpy(res.string, s);
+    return res;
+}
+
+SrValue sr_concat(SrValue l, SrValue r) {
+    size_t len = SR_CHARS_FOR_INT + 1;
+    len += (l.type == SR_STR) ? strlen(l.string) : 0;
+    len += (r.type == SR_STR) ? strlen(r.string) : 0;
+    char* buffer = malloc(len);
+
+    if (l.type == SR_STR && r.type == SR_STR) {
+        snprintf(buffer, len, "%s%s", l.string, r.string);
+    } else if (l.type == SR_STR) {
+        snprintf(buffer, len, "%s%d", l.string, r.integer);
+    } else {
+        snprintf(buffer, len, "%d%s", l.integer, r.string);
+    }
+
+    if (l.type == SR_STR) free(l.string);
+    if (r.type == SR_STR) free(r.string);
+    return (SrValue){ .type = SR_STR, .integer = 0, .string = buffer };
+}
+
+void sr_print(SrValue v, bool newline) {
+    if (v.type == SR_STR) {
+        printf("%s%s", v.string, newline ? "\n" : "");
+        free(v.string);
+    } else {
+        printf("%d%s", v.integer, newline ? "\n" : "");
+    }
+}
+
+void sr_unset(SrValue* var, const char* name) {
+    if (var->type == SR_VOID) sr_fail("Tried to unset undeclared variable %s", name);
+    if (var->type == SR_STR) free(var->string);
+    *var = SR_UNDECLARED;
+}
+
+_Noreturn void sr_return(SrValue v) {
+    printf("Program ended with return code: %d\n", v.integer); // Strings end with code 0, like in the interpreter
+    if (v.type == SR_STR) free(v.string);
+    exit(EXIT_SUCCESS);
+}
+
+_Noreturn void sr_undeclared(const char* name) {
+    sr_fail("Variable %s not initialized", name);
+}
+
+_Noreturn void sr_divisionByZero(void) {
+    sr_fail("%s", "Division by 0, execution halted");
+}
+
+_Noreturn void sr_conditionMismatch(const char* statement) {
+    sr_fail("%s condition must be integer", statement);
+}
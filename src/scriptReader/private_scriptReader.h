@@ -0,0 +1,17 @@
+#ifndef PRIVATE_SCRIPTREADER_H
+#define PRIVATE_SCRIPTREADER_H
+
+#include <errno.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "scriptReader.h"
+
+#define READ_CHUNK_SIZE 65536 // First size of the buffer of scripts that can't be mapped
+
+static bool sr_mapFile(int fd, Script* script); // false if fd is not a regular file or can't be mapped
+static bool sr_readAll(int fd, Script* script, SimplicError* error);
+
+#endif
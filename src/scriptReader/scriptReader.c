@@ -1,29 +1,84 @@
-#include "scriptReader.h"
+#ifndef _DEFAULT_SOURCE
+    #define _DEFAULT_SOURCE // mmap() and read() are not part of ISO C
+#endif
+#include "private_scriptReader.h"
 
-const char* readScriptFile(const char* fileName, SimplicError* error) {
-    FILE *script = fopen(fileName, "rb");
-    if (!script) {
+bool sr_mapFile(int fd, Script* script) {
+    struct stat info;
+
+    // An empty file can't be mapped, and has nothing to copy anyway
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0) return false;
+    if ((uint64_t)info.st_size > SIZE_MAX) return false;
+
+    void* text = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (text == MAP_FAILED) return false;
+
+    // The lexer reads the script once from start to end
+    madvise(text, info.st_size, MADV_SEQUENTIAL);
+    script->text = text;
+    script->length = info.st_size;
+    script->mapped = true;
+    return true;
+}
+
+bool sr_readAll(int fd, Script* script, SimplicError* error) {
+    size_t capacity = READ_CHUNK_SIZE;
+    size_t length = 0;
+    char* buffer = malloc(capacity);
+
+    while (buffer != NULL) {
+        if (length == capacity) {
+            char* bigger = realloc(buffer, capacity * 2);
+            if (bigger == NULL) break;
+            buffer = bigger;
+            capacity *= 2;
+        }
+
+        ssize_t count = read(fd, buffer + length, capacity - length);
+        if (count == 0) {
+            script->text = buffer;
+            script->length = length;
+            script->mapped = false;
+            return true;
+        }
+        if (count < 0 && errno != EINTR) {
+            setError(error, ERROR_READING_SCRIPT_FILE, "Could not read script: %s", strerror(errno));
+            free(buffer);
+            return false;
+        }
+        if (count > 0) length += count;
+    }
+
+    setError(error, ERROR_MALLOC_FAILURE, "Could not allocate memory for script file");
+    free(buffer);
+    return false;
+}
+
+Script* readScript(const char* fileName, SimplicError* error) {
+    bool standardInput = strcmp(fileName, "-") == 0;
+    int fd = standardInput ? STDIN_FILENO : open(fileName, O_RDONLY);
+    if (fd < 0) {
         setError(error, ERROR_READING_SCRIPT_FILE, "Could not open script %s", fileName);
         return NULL;
     }
 
-    // Get file size
-    fseek(script, 0, SEEK_END);
-    int size = ftell(script);
-    rewind(script);
+    Script* script = malloc(sizeof(Script));
+    bool ok = sr_mapFile(fd, script) || sr_readAll(fd, script, error);
+    if (!standardInput) close(fd); // The mapping stays valid after closing
 
-    char *buffer = malloc(size + 1);
-    if (!buffer) {
-        setError(error, ERROR_MALLOC_FAILURE, "Could not allocate memory for script file");
-        fclose(script);
+    if (!ok) {
+        free(script);
         return NULL;
     }
+    return script;
+}
+
+void deleteScript(Script** script) {
+    if (*script == NULL) return;
 
-    // Add EOF
-    int read = fread(buffer, 1, size, script);
-    buffer[read] = '\0';
-    fclose(script);
+    if ((*script)->mapped) munmap((void*)(*script)->text, (*script)->length);
+    else free((void*)(*script)->text);
 
-    const char *res = buffer; // Make const
-    return res;
+    free(*script);
+    *script = NULL;
 }
@@ -0,0 +1,96 @@
+#define _DEFAULT_SOURCE // Before any system header, like in scriptReader.c
+#include "unity.h"
+#include "unity_internals.h"
+
+#include "scriptReader.c"
+#include <sys/wait.h>
+
+#define TEST_SCRIPT "build/tests/scriptReaderTest.sim"
+
+SimplicError* error;
+
+void setUp(void) {
+    error = initError();
+}
+
+void tearDown(void) {
+    deleteError(&error);
+    remove(TEST_SCRIPT);
+}
+
+void writeScript(const char* text) {
+    FILE* file = fopen(TEST_SCRIPT, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    fputs(text, file);
+    fclose(file);
+}
+
+void testFilesAreMapped(void) {
+    writeScript("SET X = 1\nPRINTLN X\n");
+
+    Script* script = readScript(TEST_SCRIPT, error);
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_NOT_NULL(script);
+    TEST_ASSERT_TRUE(script->mapped);
+    TEST_ASSERT_EQUAL_INT(20, script->length);
+    TEST_ASSERT_EQUAL_MEMORY("SET X = 1\nPRINTLN X\n", script->text, 20);
+
+    deleteScript(&script);
+    TEST_ASSERT_NULL(script);
+}
+
+void testEmptyFile(void) {
+    writeScript("");
+
+    Script* script = readScript(TEST_SCRIPT, error);
+    TEST_ASSERT_NOT_NULL(script);
+    TEST_ASSERT_FALSE(script->mapped);
+    TEST_ASSERT_EQUAL_INT(0, script->length);
+    deleteScript(&script);
+}
+
+void testMissingFile(void) {
+    Script* script = readScript("build/tests/noSuchScript.sim", error);
+    TEST_ASSERT_NULL(script);
+    TEST_ASSERT_TRUE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(ERROR_READING_SCRIPT_FILE, error->errCode);
+}
+
+void testPipesAreRead(void) {
+    int fds[2];
+    Script script;
+    TEST_ASSERT_EQUAL_INT(0, pipe(fds));
+
+    // More than the first buffer, the pipe is fed by a child so the parent can drain it
+    size_t size = READ_CHUNK_SIZE * 3 + 5;
+    pid_t child = fork();
+    if (child == 0) {
+        close(fds[0]);
+        for (size_t i = 0; i < size; i++) {
+            char c = 'A' + i % 26;
+            if (write(fds[1], &c, 1) != 1) _exit(1);
+        }
+        _exit(0);
+    }
+    close(fds[1]);
+
+    TEST_ASSERT_FALSE(sr_mapFile(fds[0], &script));
+    TEST_ASSERT_TRUE(sr_readAll(fds[0], &script, error));
+    close(fds[0]);
+    waitpid(child, NULL, 0);
+
+    TEST_ASSERT_FALSE(script.mapped);
+    TEST_ASSERT_EQUAL_INT(size, script.length);
+    TEST_ASSERT_EQUAL_CHAR('A', script.text[0]);
+    TEST_ASSERT_EQUAL_CHAR('A' + (size - 1) % 26, script.text[size - 1]);
+    free((char*)script.text);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(testFilesAreMapped);
+    RUN_TEST(testEmptyFile);
+    RUN_TEST(testMissingFile);
+    RUN_TEST(testPipesAreRead);
+    return UNITY_END();
+}
@@ -0,0 +1,49 @@
+#ifndef PRIVATE_SERVER_H
+#define PRIVATE_SERVER_H
+
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "server.h"
+
+#define SERVER_BACKLOG 64 // Clients waiting while a script runs
+#ifndef SERVER_REQUEST_TIMEOUT_MS
+    #define SERVER_REQUEST_TIMEOUT_MS 5000 // Time a client has to send its request before it is dropped
+#endif
+
+typedef enum {
+    REQUEST_PATH, // The body is the absolute path of the script
+    REQUEST_SOURCE, // The body is the script itself
+    REQUEST_STOP
+} RequestKind;
+
+// Sent first on each connection, with the client's stdout and stderr attached
+typedef struct RequestHeader RequestHeader;
+struct RequestHeader {
+    uint32_t kind;
+    uint32_t reserved;
+    uint64_t length; // Size of the body that follows
+};
+
+static bool sv_address(const char* socketPath, struct sockaddr_un* address, SimplicError* error);
+static int sv_connect(const char* socketPath, SimplicError* error); // -1 if it fails
+
+// Whole buffers, retrying short transfers and interrupted calls
+static bool sv_readAll(int fd, void* buffer, size_t size);
+static bool sv_writeAll(int fd, const void* buffer, size_t size);
+
+static bool sv_sendHeader(int socket, const RequestHeader* header, int out, int err); // out or err -1 sends no descriptors
+static bool sv_receiveHeader(int socket, RequestHeader* header, int* out, int* err);
+
+static bool sv_serveClient(int client, ScriptRunner runner, void* context); // false if the client asked to stop
+static void sv_runIsolated(int client, const RequestHeader* header, char* body, int out, int err, ScriptRunner runner, void* context);
+static void sv_runRequest(const RequestHeader* header, char* body, ScriptRunner runner, void* context, RunResult* result);
+
+#endif
@@ -0,0 +1,318 @@
+#ifndef _DEFAULT_SOURCE
+    #define _DEFAULT_SOURCE // Sockets, descriptor passing and realpath() are not part of ISO C
+#endif
+#include "private_server.h"
+
+bool sv_address(const char* socketPath, struct sockaddr_un* address, SimplicError* error) {
+    memset(address, 0, sizeof(struct sockaddr_un));
+    address->sun_family = AF_UNIX;
+
+    if (strlen(socketPath) >= sizeof(address->sun_path)) {
+        setError(error, ERROR_MISC, "Socket path is too long: %s", socketPath);
+        return false;
+    }
+    strcpy(address->sun_path, socketPath);
+    return true;
+}
+
+int sv_connect(const char* socketPath, SimplicError* error) {
+    struct sockaddr_un address;
+    if (!sv_address(socketPath, &address, error)) return -1;
+
+    int connection = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (connection < 0 || connect(connection, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        setError(error, ERROR_MISC, "Could not connect to the server at %s: %s", socketPath, strerror(errno));
+        if (connection >= 0) close(connection);
+        return -1;
+    }
+    return connection;
+}
+
+bool sv_readAll(int fd, void* buffer, size_t size) {
+    char* bytes = buffer;
+    while (size > 0) {
+        ssize_t count = read(fd, bytes, size);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) return false;
+        bytes += count;
+        size -= count;
+    }
+    return true;
+}
+
+bool sv_writeAll(int fd, const void* buffer, size_t size) {
+    const char* bytes = buffer;
+    while (size > 0) {
+        ssize_t count = write(fd, bytes, size);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) return false;
+        bytes += count;
+        size -= count;
+    }
+    return true;
+}
+
+bool sv_sendHeader(int connection, const RequestHeader* header, int out, int err) {
+    union {
+        char buffer[CMSG_SPACE(sizeof(int) * 2)];
+        struct cmsghdr align;
+    } control;
+    struct iovec part = { .iov_base = (void*)header, .iov_len = sizeof(RequestHeader) };
+    struct msghdr message;
+
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &part;
+    message.msg_iovlen = 1;
+
+    if (out >= 0 && err >= 0) {
+        int fds[2] = { out, err };
+        memset(&control, 0, sizeof(control));
+        message.msg_control = control.buffer;
+        message.msg_controllen = sizeof(control.buffer);
+
+        struct cmsghdr* attached = CMSG_FIRSTHDR(&message);
+        attached->cmsg_level = SOL_SOCKET;
+        attached->cmsg_type = SCM_RIGHTS;
+        attached->cmsg_len = CMSG_LEN(sizeof(fds));
+        memcpy(CMSG_DATA(attached), fds, sizeof(fds));
+    }
+
+    ssize_t sent;
+    do {
+        sent = sendmsg(connection, &message, 0);
+    } while (sent < 0 && errno == EINTR);
+
+    // The descriptors went with the first byte, the rest is plain data
+    return sent > 0 && sv_writeAll(connection, (const char*)header + sent, sizeof(RequestHeader) - sent);
+}
+
+bool sv_receiveHeader(int connection, RequestHeader* header, int* out, int* err) {
+    union {
+        char buffer[CMSG_SPACE(sizeof(int) * 2)];
+        struct cmsghdr align;
+    } control;
+    struct iovec part = { .iov_base = header, .iov_len = sizeof(RequestHeader) };
+    struct msghdr message;
+
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &part;
+    message.msg_iovlen = 1;
+    message.msg_control = control.buffer;
+    message.msg_controllen = sizeof(control.buffer);
+
+    ssize_t received;
+    do {
+        received = recvmsg(connection, &message, 0);
+    } while (received < 0 && errno == EINTR);
+    if (received <= 0) return false;
+
+    for (struct cmsghdr* attached = CMSG_FIRSTHDR(&message); attached != NULL; attached = CMSG_NXTHDR(&message, attached)) {
+        if (attached->cmsg_level != SOL_SOCKET || attached->cmsg_type != SCM_RIGHTS) continue;
+
+        int fds[2];
+        size_t count = (attached->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (size_t i = 0; i < count; i++) {
+            int fd;
+            memcpy(&fd, CMSG_DATA(attached) + i * sizeof(int), sizeof(int));
+            if (count == 2) fds[i] = fd;
+            else close(fd); // Not what a client sends, don't leak them
+        }
+        if (count == 2) {
+            *out = fds[0];
+            *err = fds[1];
+        }
+    }
+
+    return sv_readAll(connection, (char*)header + received, sizeof(RequestHeader) - received);
+}
+
+void sv_runRequest(const RequestHeader* header, char* body, ScriptRunner runner, void* context, RunResult* result) {
+    if (header->kind == REQUEST_SOURCE) {
+        Script script = { .text = body, .length = header->length, .mapped = false };
+        runner("-", &script, stdout, result, context);
+        return;
+    }
+
+    SimplicError* error = initError();
+    Script* script = readScript(body, error);
+    if (error->hasError) {
+        printError(error);
+        result->status = 1;
+    } else {
+        runner(body, script, stdout, result, context);
+    }
+    deleteScript(&script);
+    deleteError(&error);
+}
+
+void sv_runIsolated(int client, const RequestHeader* header, char* body, int out, int err, ScriptRunner runner, void* context) {
+    const char* name = (header->kind == REQUEST_SOURCE) ? "-" : body;
+
+    // Anything still buffered would be written again by the child
+    fflush(stdout);
+    fflush(stderr);
+
+    pid_t child = fork();
+    if (child == 0) {
+        // The script writes straight to the client's stdout and stderr
+        RunResult result = { .status = 0, .returned = false, .returnCode = 0 };
+        dup2(out, STDOUT_FILENO);
+        dup2(err, STDERR_FILENO);
+
+        sv_runRequest(header, body, runner, context, &result);
+
+        fflush(stdout);
+        fflush(stderr);
+        sv_writeAll(client, &result, sizeof(result));
+        _exit(0);
+    }
+
+    int status = 0;
+    if (child > 0) {
+        while (waitpid(child, &status, 0) < 0 && errno == EINTR) {}
+        if (WIFEXITED(status) && WEXITSTATUS(status) == 0) return;
+    }
+
+    // The run crashed (or never started), only this client hears about it
+    RunResult result = { .status = 1, .returned = false, .returnCode = 0 };
+    if (child < 0) {
+        dprintf(err, "Could not start a process to run %s: %s\n", name, strerror(errno));
+    } else if (WIFSIGNALED(status)) {
+        result.status = 128 + WTERMSIG(status); // What a shell reports for a process killed by a signal
+        dprintf(err, "Script %s was killed by signal %d\n", name, WTERMSIG(status));
+    } else {
+        result.status = WEXITSTATUS(status);
+    }
+    sv_writeAll(client, &result, sizeof(result));
+}
+
+bool sv_serveClient(int client, ScriptRunner runner, void* context) {
+    RequestHeader header;
+    int out = -1, err = -1;
+    char* body = NULL;
+
+    bool valid = sv_receiveHeader(client, &header, &out, &err);
+    if (valid && header.kind == REQUEST_STOP) return false;
+
+    valid = valid && (header.kind == REQUEST_PATH || header.kind == REQUEST_SOURCE) && out >= 0 && err >= 0 && header.length < SIZE_MAX;
+    if (valid) body = malloc(header.length + 1);
+    valid = valid && body != NULL && sv_readAll(client, body, header.length);
+
+    if (valid) {
+        body[header.length] = '\0';
+        sv_runIsolated(client, &header, body, out, err, runner, context);
+    }
+
+    if (out >= 0) close(out);
+    if (err >= 0) close(err);
+    free(body);
+    return true;
+}
+
+bool serveScripts(const char* socketPath, ScriptRunner runner, void* context, SimplicError* error) {
+    struct sockaddr_un address;
+    struct stat info;
+
+    if (!sv_address(socketPath, &address, error)) return false;
+
+    // Replace the socket of a server that didn't stop cleanly, but nothing else
+    if (lstat(socketPath, &info) == 0) {
+        SimplicError* probe = initError();
+        int running = S_ISSOCK(info.st_mode) ? sv_connect(socketPath, probe) : -1;
+        deleteError(&probe);
+
+        if (!S_ISSOCK(info.st_mode) || running >= 0) {
+            if (running >= 0) close(running);
+            setError(error, ERROR_MISC, "%s is already in use", socketPath);
+            return false;
+        }
+        unlink(socketPath);
+    }
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0 || bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(listener, SERVER_BACKLOG) != 0) {
+        setError(error, ERROR_MISC, "Could not listen on %s: %s", socketPath, strerror(errno));
+        if (listener >= 0) close(listener);
+        return false;
+    }
+
+    // A client that goes away while its script prints must not take the server down
+    signal(SIGPIPE, SIG_IGN);
+
+    int client = -1;
+    while (true) {
+        client = accept(listener, NULL, NULL);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            setError(error, ERROR_MISC, "Could not accept clients on %s: %s", socketPath, strerror(errno));
+            break;
+        }
+
+        // A client that connects and sends nothing can't hold up the ones behind it
+        struct timeval timeout = { .tv_sec = SERVER_REQUEST_TIMEOUT_MS / 1000, .tv_usec = (SERVER_REQUEST_TIMEOUT_MS % 1000) * 1000 };
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        if (!sv_serveClient(client, runner, context)) break;
+        close(client);
+    }
+
+    close(listener);
+    unlink(socketPath);
+
+    // The client that asked to stop hears back once nobody else can connect
+    if (client >= 0) {
+        RunResult result = { .status = 0, .returned = false, .returnCode = 0 };
+        sv_writeAll(client, &result, sizeof(result));
+        close(client);
+    }
+    return !error->hasError;
+}
+
+bool submitScript(const char* socketPath, const char* fileName, const Script* script, int out, int err, RunResult* result, SimplicError* error) {
+    RequestHeader header = { .kind = REQUEST_SOURCE, .reserved = 0, .length = 0 };
+    const char* body = NULL;
+    char* path = NULL;
+
+    if (script != NULL) {
+        body = script->text;
+        header.length = script->length;
+    } else {
+        // The server may run from another directory
+        path = realpath(fileName, NULL);
+        if (path == NULL) {
+            setError(error, ERROR_READING_SCRIPT_FILE, "Could not open script %s", fileName);
+            return false;
+        }
+        header.kind = REQUEST_PATH;
+        body = path;
+        header.length = strlen(path);
+    }
+
+    int connection = sv_connect(socketPath, error);
+    if (connection < 0) {
+        free(path);
+        return false;
+    }
+
+    bool ok = sv_sendHeader(connection, &header, out, err) && sv_writeAll(connection, body, header.length) &&
+              sv_readAll(connection, result, sizeof(RunResult));
+    if (!ok) setError(error, ERROR_MISC, "The server at %s did not run %s", socketPath, fileName);
+
+    close(connection);
+    free(path);
+    return ok;
+}
+
+bool stopServer(const char* socketPath, SimplicError* error) {
+    RequestHeader header = { .kind = REQUEST_STOP, .reserved = 0, .length = 0 };
+    RunResult result;
+
+    int connection = sv_connect(socketPath, error);
+    if (connection < 0) return false;
+
+    bool ok = sv_sendHeader(connection, &header, -1, -1) && sv_readAll(connection, &result, sizeof(result));
+    if (!ok) setError(error, ERROR_MISC, "The server at %s did not stop", socketPath);
+
+    close(connection);
+    return ok;
+}
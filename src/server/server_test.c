@@ -0,0 +1,188 @@
+#define _DEFAULT_SOURCE // Before any system header, like in server.c
+#include "unity.h"
+#include "unity_internals.h"
+
+#define SERVER_REQUEST_TIMEOUT_MS 200 // Silent clients are dropped quickly in tests
+#include "server.c"
+#include <sys/wait.h>
+
+#define TEST_SOCKET "build/tests/serverTest.sock"
+#define TEST_SCRIPT "build/tests/serverTest.sim"
+
+SimplicError* error;
+
+void setUp(void) {
+    error = initError();
+}
+
+void tearDown(void) {
+    deleteError(&error);
+    remove(TEST_SCRIPT);
+}
+
+// Prints what it was given and returns the length of the script, scripts starting with CRASH abort
+void echoRunner(const char* name, const Script* script, FILE* out, RunResult* result, void* context) {
+    int* runs = context;
+    (*runs)++;
+    if (strncmp(script->text, "CRASH", 5) == 0) abort();
+
+    fprintf(out, "%s:", name);
+    fwrite(script->text, 1, script->length, out);
+    fprintf(stderr, "run %d", *runs);
+
+    result->status = 0;
+    result->returned = true;
+    result->returnCode = (int)script->length;
+}
+
+// Starts a server in a child process and waits until it accepts clients
+pid_t startServer(void) {
+    fflush(stdout); // The server flushes before each run, Unity's output must not be in its copy of the buffer
+    pid_t child = fork();
+    if (child == 0) {
+        int runs = 0;
+        SimplicError* childError = initError();
+        _exit(serveScripts(TEST_SOCKET, echoRunner, &runs, childError) ? 0 : 1);
+    }
+
+    for (int i = 0; i < 500; i++) {
+        SimplicError* probe = initError();
+        int connection = sv_connect(TEST_SOCKET, probe);
+        deleteError(&probe);
+        if (connection >= 0) {
+            // A connection that sends nothing is dropped by the server
+            close(connection);
+            return child;
+        }
+        usleep(2000);
+    }
+    TEST_FAIL_MESSAGE("Server did not start");
+    return child;
+}
+
+// Submits a script, what it wrote to stdout and stderr is left in output and messages
+void submit(const char* fileName, const Script* script, RunResult* result, char* output, char* messages) {
+    FILE* out = tmpfile();
+    FILE* err = tmpfile();
+
+    TEST_ASSERT_TRUE(submitScript(TEST_SOCKET, fileName, script, fileno(out), fileno(err), result, error));
+
+    rewind(out);
+    rewind(err);
+    output[fread(output, 1, 255, out)] = '\0';
+    messages[fread(messages, 1, 255, err)] = '\0';
+    fclose(out);
+    fclose(err);
+}
+
+void testRunsScriptsInTurn(void) {
+    RunResult result;
+    char output[256], messages[256];
+    pid_t server = startServer();
+
+    Script source = { .text = "PRINT 1", .length = 7, .mapped = false };
+    submit("-", &source, &result, output, messages);
+    TEST_ASSERT_EQUAL_STRING("-:PRINT 1", output);
+    TEST_ASSERT_EQUAL_STRING("run 1", messages);
+    TEST_ASSERT_TRUE(result.returned);
+    TEST_ASSERT_EQUAL_INT(7, result.returnCode);
+
+    // Paths are sent absolute, the server reads the file itself
+    FILE* file = fopen(TEST_SCRIPT, "wb");
+    fputs("RETURN 42\n", file);
+    fclose(file);
+    char* path = realpath(TEST_SCRIPT, NULL);
+
+    submit(TEST_SCRIPT, NULL, &result, output, messages);
+    TEST_ASSERT_EQUAL_STRING_LEN(path, output, strlen(path));
+    TEST_ASSERT_EQUAL_STRING(":RETURN 42\n", output + strlen(path));
+    TEST_ASSERT_EQUAL_STRING("run 1", messages); // Each run starts from the server as it was, in a process of its own
+    TEST_ASSERT_EQUAL_INT(0, result.status);
+    TEST_ASSERT_EQUAL_INT(10, result.returnCode);
+    free(path);
+
+    // Missing files are reported by the client, nothing is sent
+    TEST_ASSERT_FALSE(submitScript(TEST_SOCKET, "build/tests/noSuchScript.sim", NULL, 1, 2, &result, error));
+    TEST_ASSERT_EQUAL_INT(ERROR_READING_SCRIPT_FILE, error->errCode);
+
+    int status;
+    TEST_ASSERT_TRUE(stopServer(TEST_SOCKET, error));
+    TEST_ASSERT_EQUAL_INT(server, waitpid(server, &status, 0));
+    TEST_ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    TEST_ASSERT_NOT_EQUAL(0, access(TEST_SOCKET, F_OK));
+}
+
+void stopTestServer(pid_t server) {
+    int status;
+    TEST_ASSERT_TRUE(stopServer(TEST_SOCKET, error));
+    TEST_ASSERT_EQUAL_INT(server, waitpid(server, &status, 0));
+    TEST_ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+void testCrashOnlyEndsItsRun(void) {
+    RunResult result;
+    char output[256], messages[256];
+    pid_t server = startServer();
+
+    Script crash = { .text = "CRASH", .length = 5, .mapped = false };
+    submit("-", &crash, &result, output, messages);
+    TEST_ASSERT_EQUAL_INT(128 + SIGABRT, result.status);
+    TEST_ASSERT_FALSE(result.returned);
+    TEST_ASSERT_NOT_NULL(strstr(messages, "killed by signal"));
+
+    Script source = { .text = "PRINT 1", .length = 7, .mapped = false };
+    submit("-", &source, &result, output, messages);
+    TEST_ASSERT_EQUAL_STRING("-:PRINT 1", output);
+    TEST_ASSERT_EQUAL_INT(0, result.status);
+
+    stopTestServer(server);
+}
+
+// A client that connects and never sends its request is dropped, the next one is still served
+void testSilentClientIsDropped(void) {
+    RunResult result;
+    char output[256], messages[256];
+    pid_t server = startServer();
+
+    int silent = sv_connect(TEST_SOCKET, error);
+    TEST_ASSERT_TRUE(silent >= 0);
+
+    Script source = { .text = "PRINT 1", .length = 7, .mapped = false };
+    submit("-", &source, &result, output, messages);
+    TEST_ASSERT_EQUAL_STRING("-:PRINT 1", output);
+
+    // The server closed the silent connection without answering
+    char byte;
+    TEST_ASSERT_EQUAL_INT(0, read(silent, &byte, 1));
+    close(silent);
+
+    stopTestServer(server);
+}
+
+void testNoServer(void) {
+    RunResult result;
+    Script source = { .text = "PRINT 1", .length = 7, .mapped = false };
+
+    TEST_ASSERT_FALSE(submitScript(TEST_SOCKET, "-", &source, 1, 2, &result, error));
+    TEST_ASSERT_TRUE(error->hasError);
+}
+
+void testPathInUse(void) {
+    // Only sockets are replaced, never other files
+    FILE* file = fopen(TEST_SCRIPT, "wb");
+    fclose(file);
+
+    TEST_ASSERT_FALSE(serveScripts(TEST_SCRIPT, echoRunner, NULL, error));
+    TEST_ASSERT_TRUE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(0, access(TEST_SCRIPT, F_OK));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(testRunsScriptsInTurn);
+    RUN_TEST(testCrashOnlyEndsItsRun);
+    RUN_TEST(testSilentClientIsDropped);
+    RUN_TEST(testNoServer);
+    RUN_TEST(testPathInUse);
+    return UNITY_END();
+}
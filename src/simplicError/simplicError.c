@@ -42,11 +42,15 @@ void setError(SimplicError* error, SimplicErrorType errCode, const char* format,
 }
 
 void printError(SimplicError* error){
+        fprintError(stdout, error);
+}
+
+void fprintError(FILE* out, SimplicError* error){
         if(error == NULL){
                 return;
         }
 
-        printf("\nError: %s\n", error->errMsg);
+        fprintf(out, "\nError: %s\n", error->errMsg);
 }
 
 void unsetError(SimplicError* error){
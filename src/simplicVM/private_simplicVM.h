@@ -0,0 +1,13 @@
+#ifndef PRIVATE_SIMPLICVM_H
+#define PRIVATE_SIMPLICVM_H
+
+#include "simplicVM.h"
+#include "lexer.h"
+#include "parser.h"
+#include "pipelinedParser.h"
+
+// Below this many chars a second thread costs more than it saves
+#define PIPELINE_MIN_LENGTH (256 * 1024)
+#define PIPELINE_BATCH_TOKENS 4096
+
+#endif
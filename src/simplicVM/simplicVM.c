@@ -0,0 +1,53 @@
+#include "private_simplicVM.h"
+
+SimplicVM* initSimplicVM(FILE* out, const PassPipeline* pipeline) {
+    SimplicVM* vm = malloc(sizeof(SimplicVM));
+
+    vm->error = initError();
+    vm->tokens = initTokenQueue();
+    vm->pipeline = *pipeline;
+    vm->pipelinedParse = false;
+    vm->control = (ControlState){ .bank = initMemoryBank(), .out = out, .returned = false, .unwind = NULL };
+    return vm;
+}
+
+void resetSimplicVM(SimplicVM* vm) {
+    FILE* out = vm->control.out;
+
+    deleteMemoryBank(&vm->control.bank);
+    deleteTokenQueue(&vm->tokens);
+    unsetError(vm->error);
+    vm->control = (ControlState){ .bank = initMemoryBank(), .out = out, .returned = false, .unwind = NULL };
+}
+
+void deleteSimplicVM(SimplicVM** vm) {
+    if (*vm == NULL) return;
+
+    deleteMemoryBank(&(*vm)->control.bank);
+    deleteTokenQueue(&(*vm)->tokens);
+    deleteError(&(*vm)->error);
+    free(*vm);
+    *vm = NULL;
+}
+
+SyntaxNode* parseScript(SimplicVM* vm, const char* src, size_t length) {
+    SyntaxNode* tree = NULL;
+
+    // The whole program is parsed before running so it can be optimized as a unit
+    if (vm->pipelinedParse && length >= PIPELINE_MIN_LENGTH) {
+        tree = parsePipelined(src, length, PIPELINE_BATCH_TOKENS, vm->error);
+    } else {
+        tokenizeSourceLength(&vm->tokens, src, length, vm->error);
+        if (!vm->error->hasError)
+            tree = parseProgram(&vm->tokens, vm->error);
+    }
+
+    if (!vm->error->hasError)
+        runPipeline(&vm->pipeline, tree, vm->error);
+
+    if (vm->error->hasError) {
+        freeSyntaxTree(tree);
+        return NULL;
+    }
+    return tree;
+}
@@ -0,0 +1,201 @@
+#include "unity.h"
+#include "unity_internals.h"
+
+#include "simplicVM.c"
+#include "closure.h"
+#include <pthread.h>
+
+#define THREAD_COUNT 4
+#define ROUNDS 50
+
+PassPipeline pipeline;
+
+void setUp(void) {
+    initPipeline(&pipeline, 2);
+}
+
+void tearDown(void) {
+    ;
+}
+
+// Script whose variables have the same names in every thread but different values
+void makeScript(char* buffer, size_t size, int k) {
+    snprintf(buffer, size,
+             "SET S = 0\nSET I = 0\nWHILE I LT 300 DO\nSET S = S + I * %d\nINCR I\nDONE\n"
+             "SET T = \"k\" + %d\nPRINT T\nPRINTLN S\nRETURN S %% 1000\n", k, k);
+}
+
+typedef struct ThreadRun ThreadRun;
+struct ThreadRun {
+    int k;
+    int failures;
+};
+
+// Runs its script again and again on one SimplicVM, alternating eval() and closures
+void* runThread(void* argument) {
+    ThreadRun* run = argument;
+    char script[512], expected[64], output[64];
+    int sum = 0;
+
+    makeScript(script, sizeof(script), run->k);
+    for (int i = 0; i < 300; i++) sum += i * run->k;
+    snprintf(expected, sizeof(expected), "k%d%d\n", run->k, sum);
+
+    FILE* out = tmpfile();
+    SimplicVM* vm = initSimplicVM(out, &pipeline);
+
+    for (int round = 0; round < ROUNDS; round++) {
+        SimplicValue val = { .type = VALUE_VOID, .integer = 0, .string = NULL };
+        SyntaxNode* tree = parseScript(vm, script, strlen(script));
+
+        if (tree != NULL && round % 2 == 0) {
+            val = eval(tree, &vm->control, vm->error);
+        } else if (tree != NULL) {
+            Closure* closure = compileClosure(tree, vm->error);
+            val = runClosure(closure, &vm->control, vm->error);
+            deleteClosure(&closure);
+        }
+
+        rewind(out);
+        size_t length = fread(output, 1, sizeof(output) - 1, out);
+        output[length] = '\0';
+        if (vm->error->hasError || !vm->control.returned || val.integer != sum % 1000 || strcmp(output, expected) != 0)
+            run->failures++;
+
+        freeSyntaxTree(tree);
+        rewind(out);
+        resetSimplicVM(vm);
+    }
+
+    deleteSimplicVM(&vm);
+    fclose(out);
+    return NULL;
+}
+
+void testConcurrentVMs(void) {
+    pthread_t threads[THREAD_COUNT];
+    ThreadRun runs[THREAD_COUNT];
+
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        runs[i] = (ThreadRun){ .k = i + 2, .failures = 0 };
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&threads[i], NULL, runThread, &runs[i]));
+    }
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        pthread_join(threads[i], NULL);
+        TEST_ASSERT_EQUAL_INT(0, runs[i].failures);
+    }
+}
+
+void testResetForgetsScript(void) {
+    SimplicVM* vm = initSimplicVM(stdout, &pipeline);
+
+    SyntaxNode* tree = parseScript(vm, "SET X = 4\nRETURN X\n", 20);
+    TEST_ASSERT_NOT_NULL(tree);
+    eval(tree, &vm->control, vm->error);
+    TEST_ASSERT_TRUE(vm->control.returned);
+    freeSyntaxTree(tree);
+
+    resetSimplicVM(vm);
+    TEST_ASSERT_FALSE(vm->control.returned);
+    TEST_ASSERT_EQUAL_PTR(stdout, vm->control.out);
+
+    // X belonged to the last script
+    tree = parseScript(vm, "PRINT X\n", 8);
+    eval(tree, &vm->control, vm->error);
+    TEST_ASSERT_TRUE(vm->error->hasError);
+    TEST_ASSERT_EQUAL_INT(ERROR_ACCESS_TO_UNDECLARED_VAR, vm->error->errCode);
+    freeSyntaxTree(tree);
+
+    deleteSimplicVM(&vm);
+    TEST_ASSERT_NULL(vm);
+}
+
+void testParseErrors(void) {
+    SimplicVM* vm = initSimplicVM(stdout, &pipeline);
+
+    TEST_ASSERT_NULL(parseScript(vm, "PRINT \"abc\n", 11));
+    TEST_ASSERT_TRUE(vm->error->hasError);
+    TEST_ASSERT_EQUAL_INT(ERROR_NON_TERMINATED_STRING_LITERAL, vm->error->errCode);
+
+    resetSimplicVM(vm);
+    TEST_ASSERT_FALSE(vm->error->hasError);
+    deleteSimplicVM(&vm);
+}
+
+// A PRINTLN of "s" + X + 1 + ... with the given operators, then a RETURN inside nesting loops
+char* makeDeepScript(int operators, int nesting) {
+    char* script = malloc(64 + operators * 4 + nesting * 24);
+    char* end = script + sprintf(script, "SET X = 2\nPRINTLN \"s\" + X");
+    for (int i = 1; i < operators; i++) end += sprintf(end, " + 1");
+    end += sprintf(end, "\nSET I = 0\n");
+    for (int i = 0; i < nesting; i++) end += sprintf(end, "WHILE I LT 1 DO\n");
+    end += sprintf(end, "INCR I\n");
+    for (int i = 0; i < nesting; i++) end += sprintf(end, "DONE\n");
+    sprintf(end, "RETURN I\n");
+    return script;
+}
+
+// Scripts as deep as the parser allows go through every pass and run, one level more is an error
+void testDeepScripts(void) {
+    char* script = makeDeepScript(MAX_EXPRESSION_DEPTH, MAX_BLOCK_NESTING);
+    char* expected = malloc(MAX_EXPRESSION_DEPTH + 4);
+    sprintf(expected, "s2");
+    memset(expected + 2, '1', MAX_EXPRESSION_DEPTH - 1);
+    strcpy(expected + MAX_EXPRESSION_DEPTH + 1, "\n");
+
+    size_t size = strlen(expected) + 1;
+    char* output = malloc(size);
+    FILE* out = tmpfile();
+    SimplicVM* vm = initSimplicVM(out, &pipeline);
+
+    for (int round = 0; round < 2; round++) {
+        SimplicValue val;
+        SyntaxNode* tree = parseScript(vm, script, strlen(script));
+        TEST_ASSERT_NOT_NULL(tree);
+
+        if (round == 0) {
+            val = eval(tree, &vm->control, vm->error);
+        } else {
+            Closure* closure = compileClosure(tree, vm->error);
+            val = runClosure(closure, &vm->control, vm->error);
+            deleteClosure(&closure);
+        }
+        TEST_ASSERT_FALSE(vm->error->hasError);
+        TEST_ASSERT_TRUE(vm->control.returned);
+        TEST_ASSERT_EQUAL_INT(1, val.integer);
+
+        rewind(out);
+        output[fread(output, 1, size - 1, out)] = '\0';
+        TEST_ASSERT_EQUAL_STRING(expected, output);
+
+        freeSyntaxTree(tree);
+        rewind(out);
+        resetSimplicVM(vm);
+    }
+    free(script);
+
+    script = makeDeepScript(MAX_EXPRESSION_DEPTH + 1, 0);
+    TEST_ASSERT_NULL(parseScript(vm, script, strlen(script)));
+    TEST_ASSERT_EQUAL_INT(ERROR_NESTING_TOO_DEEP, vm->error->errCode);
+    resetSimplicVM(vm);
+    free(script);
+
+    script = makeDeepScript(1, MAX_BLOCK_NESTING + 1);
+    TEST_ASSERT_NULL(parseScript(vm, script, strlen(script)));
+    TEST_ASSERT_EQUAL_INT(ERROR_NESTING_TOO_DEEP, vm->error->errCode);
+    free(script);
+
+    deleteSimplicVM(&vm);
+    fclose(out);
+    free(output);
+    free(expected);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(testConcurrentVMs);
+    RUN_TEST(testResetForgetsScript);
+    RUN_TEST(testParseErrors);
+    RUN_TEST(testDeepScripts);
+    return UNITY_END();
+}
@@ -0,0 +1,97 @@
+#ifndef PRIVATE_SSA_H
+#define PRIVATE_SSA_H
+
+#include "ssa.h"
+#include "optimizer.h"
+
+// Lattice of constant propagation, values only ever move down it
+#define SSA_TOP 0 // Not computed yet, or never computed
+#define SSA_KNOWN 1 // Always the same integer
+#define SSA_VARYING 2 // Anything else: several values, a string or no value at all
+
+// State kept while lowering the AST
+typedef struct SsaBuilder SsaBuilder;
+struct SsaBuilder {
+    SsaProgram* ssa;
+    int* defs; // Current version of each variable, indexed like varNames
+    int* marks; // Last ssa_writtenVars() call that listed each variable, indexed like varNames
+    int mark;
+    int block; // Block the statements are added to
+    bool failed; // The tree has a shape the SSA form can't express
+};
+
+// Variables a WHILE or IF may write, by index in varNames
+typedef struct SsaVarList SsaVarList;
+struct SsaVarList {
+    int* items;
+    int count;
+    int capacity;
+};
+
+// Facts found by optimizeSsa(), indexed by value
+typedef struct SsaSolver SsaSolver;
+struct SsaSolver {
+    SsaProgram* ssa;
+    unsigned char* state; // SSA_TOP, SSA_KNOWN or SSA_VARYING
+    int* constant; // Value of the SSA_KNOWN ones
+    bool** edges; // Edges that can be taken, by block and predecessor index
+    bool* maybeUndef; // Version of a variable that may not hold anything, reading it is an error
+    bool* mayFail; // Computing it may stop the program with an error
+    bool* live;
+    bool changed;
+};
+
+// Statements of an AST block being lowered
+typedef struct SsaStatements SsaStatements;
+struct SsaStatements {
+    SyntaxNode** items;
+    int count;
+    int capacity;
+};
+
+// Program
+static int ssa_newValue(SsaProgram* ssa, SsaOp op, int block);
+static int ssa_newBlock(SsaProgram* ssa);
+static void ssa_append(SsaProgram* ssa, int block, int value);
+static void ssa_addPred(SsaProgram* ssa, int block, int pred);
+static int ssa_constant(SsaProgram* ssa, int number); // New SSA_CONST value
+static int ssa_varIndex(SsaProgram* ssa, const char* name); // -1 if the program never uses it
+static void ssa_collectVars(SsaProgram* ssa, SyntaxNode* node);
+static bool ssa_isVersion(SsaProgram* ssa, int value); // The value is stored in a variable once lowered
+
+// Construction
+static int ssa_define(SsaBuilder* builder, SsaOp op, const char* name, int operand); // New version of a variable
+static int ssa_expr(SsaBuilder* builder, SyntaxNode* node);
+static void ssa_addWritten(SsaBuilder* builder, const char* name, SsaVarList* written);
+static void ssa_markWritten(SsaBuilder* builder, SyntaxNode* node, SsaVarList* written);
+static SsaVarList ssa_writtenVars(SsaBuilder* builder, SyntaxNode* node); // Sorted, so phis are made in the order of varNames
+static int ssa_compareVars(const void* a, const void* b); // qsort() order of SsaVarList
+static void ssa_while(SsaBuilder* builder, SyntaxNode* node);
+static void ssa_if(SsaBuilder* builder, SyntaxNode* node);
+static void ssa_statement(SsaBuilder* builder, SyntaxNode* node);
+static int ssa_resolve(SsaProgram* ssa, int value); // Follows the replacements of trivial phis
+static void ssa_removeTrivialPhis(SsaProgram* ssa);
+
+// Optimization
+static void ssa_setState(SsaSolver* solver, int value, unsigned char state, int constant); // Moves a value down the lattice
+static void ssa_markEdge(SsaSolver* solver, int from, int to);
+static void ssa_evaluate(SsaSolver* solver, int value);
+static void ssa_propagate(SsaSolver* solver); // Sparse conditional constant propagation
+static int ssa_replaceKnown(SsaSolver* solver, int value); // Constant to use instead of a known value
+static void ssa_rewrite(SsaSolver* solver); // Uses the constants and folds branches
+static bool ssa_operandFails(SsaSolver* solver, int value);
+static void ssa_findFailures(SsaSolver* solver);
+static void ssa_markLive(SsaSolver* solver, int value, int** stack, int* count, int* capacity);
+static void ssa_eliminateDead(SsaSolver* solver);
+
+// Lowering back to the AST
+static void ssa_push(SsaStatements* list, SyntaxNode* statement);
+static SyntaxNode* ssa_finishBlock(SsaStatements* list);
+static SyntaxNode* ssa_lowerValue(SsaProgram* ssa, int value); // Expression that computes a value
+static SyntaxNode* ssa_lowerRegion(SsaProgram* ssa, int block, int stop); // Statements from block until stop is reached
+static void ssa_lowerStatements(SsaProgram* ssa, int block, int stop, SsaStatements* list);
+
+// Debugging
+static void ssa_printOperand(SsaProgram* ssa, int value, FILE* out);
+
+#endif
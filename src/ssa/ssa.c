@@ -0,0 +1,1029 @@
+#include "private_ssa.h"
+
+int ssa_newValue(SsaProgram* ssa, SsaOp op, int block) {
+    if (ssa->valueCount == ssa->valueCapacity) {
+        ssa->valueCapacity = (ssa->valueCapacity == 0) ? 64 : ssa->valueCapacity * 2;
+        ssa->values = realloc(ssa->values, sizeof(SsaValue) * ssa->valueCapacity);
+    }
+
+    SsaValue* value = &ssa->values[ssa->valueCount];
+    value->op = op;
+    value->block = block;
+    value->varName[0] = '\0';
+    value->operator[0] = '\0';
+    value->number = 0;
+    value->string = NULL;
+    value->a = -1;
+    value->b = -1;
+    value->args = NULL;
+    value->replacement = -1;
+
+    if (block >= 0) ssa_append(ssa, block, ssa->valueCount);
+    return ssa->valueCount++;
+}
+
+int ssa_newBlock(SsaProgram* ssa) {
+    if (ssa->blockCount == ssa->blockCapacity) {
+        ssa->blockCapacity = (ssa->blockCapacity == 0) ? 16 : ssa->blockCapacity * 2;
+        ssa->blocks = realloc(ssa->blocks, sizeof(SsaBlock) * ssa->blockCapacity);
+    }
+
+    SsaBlock* block = &ssa->blocks[ssa->blockCount];
+    block->values = NULL;
+    block->count = 0;
+    block->capacity = 0;
+    block->preds = NULL;
+    block->predCount = 0;
+    block->predCapacity = 0;
+    block->exit = SSA_HALT;
+    block->cond = -1;
+    block->target[0] = -1;
+    block->target[1] = -1;
+    block->merge = -1;
+    block->loop = false;
+    block->reachable = true;
+    return ssa->blockCount++;
+}
+
+void ssa_append(SsaProgram* ssa, int block, int value) {
+    SsaBlock* b = &ssa->blocks[block];
+    if (b->count == b->capacity) {
+        b->capacity = (b->capacity == 0) ? 8 : b->capacity * 2;
+        b->values = realloc(b->values, sizeof(int) * b->capacity);
+    }
+    b->values[b->count++] = value;
+}
+
+void ssa_addPred(SsaProgram* ssa, int block, int pred) {
+    SsaBlock* b = &ssa->blocks[block];
+    if (b->predCount == b->predCapacity) {
+        b->predCapacity = (b->predCapacity == 0) ? 2 : b->predCapacity * 2;
+        b->preds = realloc(b->preds, sizeof(int) * b->predCapacity);
+    }
+    b->preds[b->predCount++] = pred;
+}
+
+int ssa_constant(SsaProgram* ssa, int number) {
+    int value = ssa_newValue(ssa, SSA_CONST, -1);
+    ssa->values[value].number = number;
+    return value;
+}
+
+int ssa_varIndex(SsaProgram* ssa, const char* name) {
+    unsigned int hash = hashName(name);
+    int cursor;
+    for (int i = hashIndexFirst(&ssa->varIndex, hash, &cursor); i >= 0; i = hashIndexNext(&ssa->varIndex, hash, &cursor)) {
+        if (strcmp(ssa->varNames[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+void ssa_collectVars(SsaProgram* ssa, SyntaxNode* node) {
+    int i;
+    if (node == NULL) return;
+
+    if ((node->type == NODE_VAR || node->type == NODE_ASSIGN || node->type == NODE_UNASSIGN) && ssa_varIndex(ssa, node->varName) < 0) {
+        if (ssa->varCount == ssa->varCapacity) {
+            ssa->varCapacity = (ssa->varCapacity == 0) ? 16 : ssa->varCapacity * 2;
+            ssa->varNames = realloc(ssa->varNames, sizeof(*ssa->varNames) * ssa->varCapacity);
+        }
+        strcpy(ssa->varNames[ssa->varCount], node->varName);
+        hashIndexAdd(&ssa->varIndex, hashName(node->varName), ssa->varCount++);
+    }
+
+    if (node->type == NODE_BLOCK) {
+        for (i = 0; node->blockStatements[i] != NULL; i++) {
+            ssa_collectVars(ssa, node->blockStatements[i]);
+        }
+    }
+    ssa_collectVars(ssa, node->subnodeA);
+    ssa_collectVars(ssa, node->subnodeB);
+    ssa_collectVars(ssa, node->subnodeC);
+}
+
+bool ssa_isVersion(SsaProgram* ssa, int value) {
+    SsaOp op = ssa->values[value].op;
+    return op == SSA_UNDEF || op == SSA_PHI || op == SSA_SET || op == SSA_INCR || op == SSA_DECR || op == SSA_UNSET;
+}
+
+int ssa_define(SsaBuilder* builder, SsaOp op, const char* name, int operand) {
+    SsaProgram* ssa = builder->ssa;
+    int value = ssa_newValue(ssa, op, builder->block);
+    strcpy(ssa->values[value].varName, name);
+    ssa->values[value].a = operand;
+    builder->defs[ssa_varIndex(ssa, name)] = value;
+    return value;
+}
+
+int ssa_expr(SsaBuilder* builder, SyntaxNode* node) {
+    SsaProgram* ssa = builder->ssa;
+    int a, b, value;
+
+    switch (node->type) {
+        case NODE_NUMBER:
+            return ssa_constant(ssa, node->numberValue);
+
+        case NODE_STRING:
+            value = ssa_newValue(ssa, SSA_STRING, -1);
+            ssa->values[value].string = malloc(strlen(node->string) + 1);
+            strcpy(ssa->values[value].string, node->string);
+            return value;
+
+        case NODE_VAR:
+            return builder->defs[ssa_varIndex(ssa, node->varName)];
+
+        case NODE_BIN_OP:
+            a = ssa_expr(builder, node->subnodeA);
+            b = ssa_expr(builder, node->subnodeB);
+            value = ssa_newValue(ssa, SSA_BIN_OP, builder->block);
+            strcpy(ssa->values[value].operator, node->operator);
+            ssa->values[value].a = a;
+            ssa->values[value].b = b;
+            return value;
+
+        default:
+            builder->failed = true;
+            return ssa_constant(ssa, 0);
+    }
+}
+
+void ssa_addWritten(SsaBuilder* builder, const char* name, SsaVarList* written) {
+    int v = ssa_varIndex(builder->ssa, name);
+    if (builder->marks[v] == builder->mark) return;
+    builder->marks[v] = builder->mark;
+
+    if (written->count == written->capacity) {
+        written->capacity = (written->capacity == 0) ? 8 : written->capacity * 2;
+        written->items = realloc(written->items, sizeof(int) * written->capacity);
+    }
+    written->items[written->count++] = v;
+}
+
+void ssa_markWritten(SsaBuilder* builder, SyntaxNode* node, SsaVarList* written) {
+    int i;
+    if (node == NULL) return;
+
+    switch (node->type) {
+        case NODE_ASSIGN:
+        case NODE_UNASSIGN:
+            ssa_addWritten(builder, node->varName, written);
+            break;
+
+        case NODE_INCREMENT:
+        case NODE_DECREMENT:
+            if (node->subnodeB != NULL && node->subnodeB->type == NODE_VAR)
+                ssa_addWritten(builder, node->subnodeB->varName, written);
+            break;
+
+        case NODE_BLOCK:
+            for (i = 0; node->blockStatements[i] != NULL; i++) {
+                ssa_markWritten(builder, node->blockStatements[i], written);
+            }
+            break;
+
+        case NODE_WHILE:
+        case NODE_IF:
+            ssa_markWritten(builder, node->subnodeB, written);
+            ssa_markWritten(builder, node->subnodeC, written);
+            break;
+
+        default:
+            break;
+    }
+}
+
+int ssa_compareVars(const void* a, const void* b) {
+    return *(const int*)a - *(const int*)b;
+}
+
+SsaVarList ssa_writtenVars(SsaBuilder* builder, SyntaxNode* node) {
+    SsaVarList written = { .items = NULL, .count = 0, .capacity = 0 };
+
+    // Only the variables written inside get phis, so a loop or IF costs the same however many the program has
+    builder->mark++;
+    ssa_markWritten(builder, node, &written);
+    if (written.count > 1) qsort(written.items, written.count, sizeof(int), ssa_compareVars);
+    return written;
+}
+
+void ssa_while(SsaBuilder* builder, SyntaxNode* node) {
+    SsaProgram* ssa = builder->ssa;
+    SsaVarList written = ssa_writtenVars(builder, node->subnodeB);
+    int* phis = malloc(sizeof(int) * (written.count + 1));
+    int i;
+
+    int header = ssa_newBlock(ssa);
+    ssa->blocks[builder->block].exit = SSA_JUMP;
+    ssa->blocks[builder->block].target[0] = header;
+    ssa_addPred(ssa, header, builder->block);
+
+    // Each variable the body writes gets a phi merging its value before the loop and after an iteration,
+    // the second argument is only known once the body is done
+    for (i = 0; i < written.count; i++) {
+        int v = written.items[i];
+        phis[i] = ssa_newValue(ssa, SSA_PHI, header);
+        strcpy(ssa->values[phis[i]].varName, ssa->varNames[v]);
+        ssa->values[phis[i]].args = malloc(sizeof(int) * 2);
+        ssa->values[phis[i]].args[0] = builder->defs[v];
+        builder->defs[v] = phis[i];
+    }
+
+    builder->block = header;
+    int cond = ssa_expr(builder, node->subnodeA);
+
+    int body = ssa_newBlock(ssa);
+    ssa_addPred(ssa, body, header);
+    builder->block = body;
+    ssa_statement(builder, node->subnodeB);
+
+    ssa->blocks[builder->block].exit = SSA_JUMP;
+    ssa->blocks[builder->block].target[0] = header;
+    ssa_addPred(ssa, header, builder->block);
+    for (i = 0; i < written.count; i++) {
+        int v = written.items[i];
+        ssa->values[phis[i]].args[1] = builder->defs[v];
+        builder->defs[v] = phis[i]; // The loop is left from its header
+    }
+
+    int exit = ssa_newBlock(ssa);
+    ssa_addPred(ssa, exit, header);
+
+    SsaBlock* h = &ssa->blocks[header];
+    h->exit = SSA_BRANCH;
+    h->cond = cond;
+    h->target[0] = body;
+    h->target[1] = exit;
+    h->merge = exit;
+    h->loop = true;
+
+    builder->block = exit;
+    free(written.items);
+    free(phis);
+}
+
+void ssa_if(SsaBuilder* builder, SyntaxNode* node) {
+    SsaProgram* ssa = builder->ssa;
+    SsaVarList written = ssa_writtenVars(builder, node);
+    int* before = malloc(sizeof(int) * (written.count + 1));
+    int* thenDefs = malloc(sizeof(int) * (written.count + 1));
+    int i;
+
+    int cond = ssa_expr(builder, node->subnodeA);
+    int head = builder->block;
+    for (i = 0; i < written.count; i++) before[i] = builder->defs[written.items[i]];
+
+    int thenBlock = ssa_newBlock(ssa);
+    ssa_addPred(ssa, thenBlock, head);
+    builder->block = thenBlock;
+    ssa_statement(builder, node->subnodeB);
+    int thenEnd = builder->block;
+    for (i = 0; i < written.count; i++) {
+        thenDefs[i] = builder->defs[written.items[i]];
+        builder->defs[written.items[i]] = before[i];
+    }
+
+    int elseBlock = -1;
+    int elseEnd = head;
+    if (node->subnodeC != NULL) {
+        elseBlock = ssa_newBlock(ssa);
+        ssa_addPred(ssa, elseBlock, head);
+        builder->block = elseBlock;
+        ssa_statement(builder, node->subnodeC);
+        elseEnd = builder->block;
+    }
+
+    int merge = ssa_newBlock(ssa);
+    ssa_addPred(ssa, merge, thenEnd);
+    ssa_addPred(ssa, merge, elseEnd);
+    ssa->blocks[thenEnd].exit = SSA_JUMP;
+    ssa->blocks[thenEnd].target[0] = merge;
+    if (elseBlock >= 0) {
+        ssa->blocks[elseEnd].exit = SSA_JUMP;
+        ssa->blocks[elseEnd].target[0] = merge;
+    }
+
+    SsaBlock* h = &ssa->blocks[head];
+    h->exit = SSA_BRANCH;
+    h->cond = cond;
+    h->target[0] = thenBlock;
+    h->target[1] = (elseBlock >= 0) ? elseBlock : merge;
+    h->merge = merge;
+
+    // Variables whose version depends on the side taken
+    for (i = 0; i < written.count; i++) {
+        int v = written.items[i];
+        if (thenDefs[i] == builder->defs[v]) continue;
+        int phi = ssa_newValue(ssa, SSA_PHI, merge);
+        strcpy(ssa->values[phi].varName, ssa->varNames[v]);
+        ssa->values[phi].args = malloc(sizeof(int) * 2);
+        ssa->values[phi].args[0] = thenDefs[i];
+        ssa->values[phi].args[1] = builder->defs[v];
+        builder->defs[v] = phi;
+    }
+
+    builder->block = merge;
+    free(written.items);
+    free(before);
+    free(thenDefs);
+}
+
+void ssa_statement(SsaBuilder* builder, SyntaxNode* node) {
+    SsaProgram* ssa = builder->ssa;
+    int i, value;
+    if (node == NULL || builder->failed) return;
+
+    switch (node->type) {
+        case NODE_BLOCK:
+            for (i = 0; node->blockStatements[i] != NULL; i++) {
+                ssa_statement(builder, node->blockStatements[i]);
+            }
+            break;
+
+        case NODE_ASSIGN:
+            ssa_define(builder, SSA_SET, node->varName, ssa_expr(builder, node->subnodeB));
+            break;
+
+        case NODE_UNASSIGN:
+            ssa_define(builder, SSA_UNSET, node->varName, builder->defs[ssa_varIndex(ssa, node->varName)]);
+            break;
+
+        case NODE_INCREMENT:
+        case NODE_DECREMENT:
+            if (node->subnodeB == NULL || node->subnodeB->type != NODE_VAR) {
+                builder->failed = true;
+                break;
+            }
+            value = builder->defs[ssa_varIndex(ssa, node->subnodeB->varName)];
+            ssa_define(builder, (node->type == NODE_INCREMENT) ? SSA_INCR : SSA_DECR, node->subnodeB->varName, value);
+            break;
+
+        case NODE_PRINT:
+        case NODE_PRINTLN:
+            value = ssa_expr(builder, node->subnodeB);
+            i = ssa_newValue(ssa, (node->type == NODE_PRINT) ? SSA_PRINT : SSA_PRINTLN, builder->block);
+            ssa->values[i].a = value;
+            break;
+
+        case NODE_RETURN:
+            value = ssa_expr(builder, node->subnodeB);
+            ssa->blocks[builder->block].exit = SSA_RETURN;
+            ssa->blocks[builder->block].cond = value;
+            builder->block = ssa_newBlock(ssa); // Whatever follows has no predecessor and never runs
+            break;
+
+        case NODE_WHILE:
+            ssa_while(builder, node);
+            break;
+
+        case NODE_IF:
+            ssa_if(builder, node);
+            break;
+
+        default:
+            builder->failed = true;
+            break;
+    }
+}
+
+int ssa_resolve(SsaProgram* ssa, int value) {
+    while (value >= 0 && ssa->values[value].replacement >= 0) {
+        value = ssa->values[value].replacement;
+    }
+    return value;
+}
+
+void ssa_removeTrivialPhis(SsaProgram* ssa) {
+    int v, i;
+    bool changed = true;
+
+    // A phi whose arguments are all one value (or the phi itself) is that value. Replacing a phi
+    // can make the phis that use it trivial, so this goes on until nothing changes
+    while (changed) {
+        changed = false;
+        for (v = 0; v < ssa->valueCount; v++) {
+            SsaValue* phi = &ssa->values[v];
+            if (phi->op != SSA_PHI || phi->replacement >= 0) continue;
+
+            int same = -1;
+            bool trivial = true;
+            for (i = 0; i < ssa->blocks[phi->block].predCount && trivial; i++) {
+                int arg = ssa_resolve(ssa, phi->args[i]);
+                if (arg == v || arg == same) continue;
+                if (same >= 0) trivial = false;
+                same = arg;
+            }
+
+            if (trivial && same >= 0) {
+                phi->replacement = same;
+                changed = true;
+            }
+        }
+    }
+
+    // Uses now point at the values that stay, replaced phis leave their block
+    for (v = 0; v < ssa->valueCount; v++) {
+        SsaValue* value = &ssa->values[v];
+        value->a = ssa_resolve(ssa, value->a);
+        value->b = ssa_resolve(ssa, value->b);
+        if (value->op == SSA_PHI) {
+            for (i = 0; i < ssa->blocks[value->block].predCount; i++) {
+                value->args[i] = ssa_resolve(ssa, value->args[i]);
+            }
+        }
+    }
+
+    for (int b = 0; b < ssa->blockCount; b++) {
+        SsaBlock* block = &ssa->blocks[b];
+        int kept = 0;
+        block->cond = ssa_resolve(ssa, block->cond);
+        for (i = 0; i < block->count; i++) {
+            if (ssa->values[block->values[i]].replacement < 0) block->values[kept++] = block->values[i];
+        }
+        block->count = kept;
+    }
+}
+
+SsaProgram* buildSsa(SyntaxNode* program) {
+    SsaProgram* ssa = calloc(1, sizeof(SsaProgram));
+    ssa_collectVars(ssa, program);
+
+    SsaBuilder builder = { .ssa = ssa, .defs = malloc(sizeof(int) * (ssa->varCount + 1)), .marks = calloc(ssa->varCount + 1, sizeof(int)),
+                           .mark = 0, .block = -1, .failed = false };
+    builder.block = ssa_newBlock(ssa);
+
+    // Every variable starts out undeclared
+    for (int v = 0; v < ssa->varCount; v++) {
+        builder.defs[v] = ssa_newValue(ssa, SSA_UNDEF, -1);
+        strcpy(ssa->values[builder.defs[v]].varName, ssa->varNames[v]);
+    }
+
+    ssa_statement(&builder, program);
+    free(builder.defs);
+    free(builder.marks);
+
+    if (builder.failed) {
+        deleteSsa(&ssa);
+        return NULL;
+    }
+
+    ssa_removeTrivialPhis(ssa);
+    return ssa;
+}
+
+void ssa_setState(SsaSolver* solver, int value, unsigned char state, int constant) {
+    unsigned char old = solver->state[value];
+    if (state == SSA_TOP || old == SSA_VARYING) return;
+
+    if (old == SSA_KNOWN) {
+        if (state == SSA_KNOWN && constant == solver->constant[value]) return;
+        state = SSA_VARYING;
+    }
+
+    solver->state[value] = state;
+    solver->constant[value] = constant;
+    solver->changed = true;
+}
+
+void ssa_markEdge(SsaSolver* solver, int from, int to) {
+    SsaBlock* block = &solver->ssa->blocks[to];
+    for (int i = 0; i < block->predCount; i++) {
+        if (block->preds[i] == from && !solver->edges[to][i]) {
+            solver->edges[to][i] = true;
+            block->reachable = true;
+            solver->changed = true;
+        }
+    }
+}
+
+void ssa_evaluate(SsaSolver* solver, int v) {
+    SsaProgram* ssa = solver->ssa;
+    SsaValue* value = &ssa->values[v];
+    unsigned char a = (value->a >= 0) ? solver->state[value->a] : SSA_VARYING;
+    unsigned char b = (value->b >= 0) ? solver->state[value->b] : SSA_VARYING;
+    int result;
+
+    switch (value->op) {
+        case SSA_PHI:
+            // Only the edges that can be taken bring a value
+            for (int i = 0; i < ssa->blocks[value->block].predCount; i++) {
+                if (solver->edges[value->block][i])
+                    ssa_setState(solver, v, solver->state[value->args[i]], solver->constant[value->args[i]]);
+            }
+            break;
+
+        case SSA_BIN_OP:
+            if (a == SSA_VARYING || b == SSA_VARYING) {
+                ssa_setState(solver, v, SSA_VARYING, 0);
+            } else if (a == SSA_KNOWN && b == SSA_KNOWN) {
+                if (foldBinOp(value->operator, solver->constant[value->a], solver->constant[value->b], &result)) {
+                    ssa_setState(solver, v, SSA_KNOWN, result);
+                } else {
+                    ssa_setState(solver, v, SSA_VARYING, 0);
+                }
+            }
+            break;
+
+        case SSA_SET:
+            ssa_setState(solver, v, a, solver->constant[value->a]);
+            break;
+
+        case SSA_INCR:
+        case SSA_DECR:
+            result = (int)((unsigned int)solver->constant[value->a] + ((value->op == SSA_INCR) ? 1u : -1u));
+            ssa_setState(solver, v, a, result);
+            break;
+
+        default:
+            ssa_setState(solver, v, SSA_VARYING, 0);
+            break;
+    }
+}
+
+void ssa_propagate(SsaSolver* solver) {
+    SsaProgram* ssa = solver->ssa;
+
+    // Blocks are numbered in program order, so a sweep sees most definitions before their uses and
+    // only the values carried around loops need more sweeps
+    do {
+        solver->changed = false;
+        for (int b = 0; b < ssa->blockCount; b++) {
+            SsaBlock* block = &ssa->blocks[b];
+            if (!block->reachable) continue;
+
+            for (int i = 0; i < block->count; i++) {
+                ssa_evaluate(solver, block->values[i]);
+            }
+
+            if (block->exit == SSA_JUMP) {
+                ssa_markEdge(solver, b, block->target[0]);
+            } else if (block->exit == SSA_BRANCH) {
+                unsigned char cond = solver->state[block->cond];
+                if (cond == SSA_VARYING || (cond == SSA_KNOWN && solver->constant[block->cond] != 0))
+                    ssa_markEdge(solver, b, block->target[0]);
+                if (cond == SSA_VARYING || (cond == SSA_KNOWN && solver->constant[block->cond] == 0))
+                    ssa_markEdge(solver, b, block->target[1]);
+            }
+        }
+    } while (solver->changed);
+}
+
+int ssa_replaceKnown(SsaSolver* solver, int value) {
+    // Constants made by the rewrite come after the values the solver knows about
+    if (value < 0 || solver->ssa->values[value].op == SSA_CONST || solver->state[value] != SSA_KNOWN) return value;
+    return ssa_constant(solver->ssa, solver->constant[value]);
+}
+
+void ssa_rewrite(SsaSolver* solver) {
+    SsaProgram* ssa = solver->ssa;
+
+    for (int b = 0; b < ssa->blockCount; b++) {
+        if (!ssa->blocks[b].reachable) continue;
+
+        // INCR, DECR and UNSET keep their operand: once lowered they read the variable itself
+        for (int i = 0; i < ssa->blocks[b].count; i++) {
+            int v = ssa->blocks[b].values[i];
+            SsaOp op = ssa->values[v].op;
+            if (op != SSA_BIN_OP && op != SSA_SET && op != SSA_PRINT && op != SSA_PRINTLN) continue;
+
+            int a = ssa_replaceKnown(solver, ssa->values[v].a);
+            int c = ssa_replaceKnown(solver, ssa->values[v].b);
+            ssa->values[v].a = a;
+            ssa->values[v].b = c;
+        }
+
+        SsaBlock* block = &ssa->blocks[b];
+        if (block->exit != SSA_BRANCH && block->exit != SSA_RETURN) continue;
+        int cond = ssa_replaceKnown(solver, block->cond);
+        block = &ssa->blocks[b];
+        block->cond = cond;
+
+        // Branches with a known condition become jumps, except loops that never end by their condition
+        if (block->exit == SSA_BRANCH && ssa->values[cond].op == SSA_CONST) {
+            bool taken = ssa->values[cond].number != 0;
+            if (!block->loop) {
+                block->exit = SSA_JUMP;
+                block->target[0] = taken ? block->target[0] : block->target[1];
+            } else if (!taken) {
+                block->exit = SSA_JUMP;
+                block->target[0] = block->target[1];
+            }
+        }
+    }
+}
+
+bool ssa_operandFails(SsaSolver* solver, int value) {
+    if (value < 0) return false;
+    if (ssa_isVersion(solver->ssa, value)) return solver->maybeUndef[value];
+    return solver->mayFail[value];
+}
+
+void ssa_findFailures(SsaSolver* solver) {
+    SsaProgram* ssa = solver->ssa;
+    int v, i;
+    bool changed = true;
+
+    // A version may be empty if it comes from no assignment, an UNSET or a phi that merges one of those
+    for (v = 0; v < ssa->valueCount; v++) {
+        solver->maybeUndef[v] = ssa->values[v].op == SSA_UNDEF || ssa->values[v].op == SSA_UNSET;
+    }
+    while (changed) {
+        changed = false;
+        for (v = 0; v < ssa->valueCount; v++) {
+            SsaValue* phi = &ssa->values[v];
+            if (phi->op != SSA_PHI || phi->replacement >= 0 || solver->maybeUndef[v]) continue;
+            for (i = 0; i < ssa->blocks[phi->block].predCount; i++) {
+                if (solver->maybeUndef[phi->args[i]]) {
+                    solver->maybeUndef[v] = true;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Temporaries come before their uses, so one pass in block order is enough
+    for (int b = 0; b < ssa->blockCount; b++) {
+        for (i = 0; i < ssa->blocks[b].count; i++) {
+            v = ssa->blocks[b].values[i];
+            SsaValue* value = &ssa->values[v];
+
+            switch (value->op) {
+                case SSA_BIN_OP:
+                    solver->mayFail[v] = ssa_operandFails(solver, value->a) || ssa_operandFails(solver, value->b);
+                    if (strcmp(value->operator, "/") == 0 || strcmp(value->operator, "%") == 0) {
+                        SsaValue* divisor = &ssa->values[value->b];
+                        if (divisor->op != SSA_CONST || divisor->number == 0 || divisor->number == -1) solver->mayFail[v] = true;
+                    }
+                    break;
+
+                case SSA_SET:
+                case SSA_INCR:
+                case SSA_DECR:
+                case SSA_PRINT:
+                case SSA_PRINTLN:
+                    solver->mayFail[v] = ssa_operandFails(solver, value->a);
+                    break;
+
+                default:
+                    solver->mayFail[v] = false;
+                    break;
+            }
+        }
+    }
+}
+
+void ssa_markLive(SsaSolver* solver, int value, int** stack, int* count, int* capacity) {
+    if (value < 0 || solver->live[value]) return;
+    solver->live[value] = true;
+
+    if (*count == *capacity) {
+        *capacity = (*capacity == 0) ? 64 : *capacity * 2;
+        *stack = realloc(*stack, sizeof(int) * *capacity);
+    }
+    (*stack)[(*count)++] = value;
+}
+
+void ssa_eliminateDead(SsaSolver* solver) {
+    SsaProgram* ssa = solver->ssa;
+    int* stack = NULL;
+    int count = 0, capacity = 0;
+    int b, i;
+
+    // Outputs, conditions, UNSETs (they fail on undeclared variables) and whatever may fail are kept
+    for (b = 0; b < ssa->blockCount; b++) {
+        SsaBlock* block = &ssa->blocks[b];
+        if (!block->reachable) continue;
+
+        for (i = 0; i < block->count; i++) {
+            int v = block->values[i];
+            SsaOp op = ssa->values[v].op;
+            if (op == SSA_PRINT || op == SSA_PRINTLN || op == SSA_UNSET || solver->mayFail[v])
+                ssa_markLive(solver, v, &stack, &count, &capacity);
+        }
+        if (block->exit == SSA_BRANCH || block->exit == SSA_RETURN)
+            ssa_markLive(solver, block->cond, &stack, &count, &capacity);
+    }
+
+    while (count > 0) {
+        SsaValue* value = &ssa->values[stack[--count]];
+        ssa_markLive(solver, value->a, &stack, &count, &capacity);
+        ssa_markLive(solver, value->b, &stack, &count, &capacity);
+        if (value->op == SSA_PHI) {
+            for (i = 0; i < ssa->blocks[value->block].predCount; i++) {
+                ssa_markLive(solver, value->args[i], &stack, &count, &capacity);
+            }
+        }
+    }
+    free(stack);
+
+    for (b = 0; b < ssa->blockCount; b++) {
+        SsaBlock* block = &ssa->blocks[b];
+        int kept = 0;
+        for (i = 0; i < block->count && block->reachable; i++) {
+            if (solver->live[block->values[i]]) block->values[kept++] = block->values[i];
+        }
+        block->count = kept;
+    }
+}
+
+void optimizeSsa(SsaProgram* ssa) {
+    int count = ssa->valueCount;
+    int v, b;
+    SsaSolver solver = { .ssa = ssa, .changed = false };
+
+    solver.state = calloc(count + 1, sizeof(unsigned char));
+    solver.constant = calloc(count + 1, sizeof(int));
+    solver.edges = malloc(sizeof(bool*) * ssa->blockCount);
+    for (b = 0; b < ssa->blockCount; b++) {
+        solver.edges[b] = calloc(ssa->blocks[b].predCount + 1, sizeof(bool));
+        ssa->blocks[b].reachable = (b == 0);
+    }
+
+    // Values outside blocks never change: constants are known, strings and undeclared variables are not integers
+    for (v = 0; v < count; v++) {
+        if (ssa->values[v].op == SSA_CONST) {
+            solver.state[v] = SSA_KNOWN;
+            solver.constant[v] = ssa->values[v].number;
+        } else if (ssa->values[v].block < 0) {
+            solver.state[v] = SSA_VARYING;
+        }
+    }
+
+    ssa_propagate(&solver);
+    ssa_rewrite(&solver);
+
+    // The rewrite added constants, so the remaining facts are sized for the final program
+    solver.maybeUndef = calloc(ssa->valueCount, sizeof(bool));
+    solver.mayFail = calloc(ssa->valueCount, sizeof(bool));
+    solver.live = calloc(ssa->valueCount, sizeof(bool));
+    ssa_findFailures(&solver);
+    ssa_eliminateDead(&solver);
+
+    for (b = 0; b < ssa->blockCount; b++) {
+        free(solver.edges[b]);
+    }
+    free(solver.edges);
+    free(solver.state);
+    free(solver.constant);
+    free(solver.maybeUndef);
+    free(solver.mayFail);
+    free(solver.live);
+}
+
+void ssa_push(SsaStatements* list, SyntaxNode* statement) {
+    if (list->count == list->capacity) {
+        list->capacity = (list->capacity == 0) ? 8 : list->capacity * 2;
+        list->items = realloc(list->items, sizeof(SyntaxNode*) * list->capacity);
+    }
+    list->items[list->count++] = statement;
+}
+
+SyntaxNode* ssa_finishBlock(SsaStatements* list) {
+    SyntaxNode* block = initNode();
+    block->type = NODE_BLOCK;
+    block->blockStatements = realloc(list->items, sizeof(SyntaxNode*) * (list->count + 1));
+    block->blockStatements[list->count] = NULL;
+    return block;
+}
+
+SyntaxNode* ssa_lowerValue(SsaProgram* ssa, int v) {
+    SsaValue* value = &ssa->values[v];
+    SyntaxNode* node = initNode();
+
+    switch (value->op) {
+        case SSA_CONST:
+            node->type = NODE_NUMBER;
+            node->numberValue = value->number;
+            break;
+
+        case SSA_STRING:
+            node->type = NODE_STRING;
+            node->string = malloc(strlen(value->string) + 1);
+            strcpy(node->string, value->string);
+            break;
+
+        case SSA_BIN_OP:
+            node->type = NODE_BIN_OP;
+            strcpy(node->operator, value->operator);
+            node->subnodeA = ssa_lowerValue(ssa, value->a);
+            node->subnodeB = ssa_lowerValue(ssa, value->b);
+            break;
+
+        default:
+            // Every version of a variable lives in the variable
+            node->type = NODE_VAR;
+            strcpy(node->varName, value->varName);
+            break;
+    }
+    return node;
+}
+
+void ssa_lowerStatements(SsaProgram* ssa, int b, int stop, SsaStatements* list) {
+    while (b >= 0 && b != stop && ssa->blocks[b].reachable) {
+        SsaBlock* block = &ssa->blocks[b];
+        SyntaxNode* node;
+
+        for (int i = 0; i < block->count; i++) {
+            SsaValue* value = &ssa->values[block->values[i]];
+
+            switch (value->op) {
+                case SSA_SET:
+                    node = initNode();
+                    node->type = NODE_ASSIGN;
+                    strcpy(node->varName, value->varName);
+                    node->subnodeB = ssa_lowerValue(ssa, value->a);
+                    break;
+
+                case SSA_INCR:
+                case SSA_DECR:
+                    node = initNode();
+                    node->type = (value->op == SSA_INCR) ? NODE_INCREMENT : NODE_DECREMENT;
+                    node->subnodeB = initNode();
+                    node->subnodeB->type = NODE_VAR;
+                    strcpy(node->subnodeB->varName, value->varName);
+                    break;
+
+                case SSA_UNSET:
+                    node = initNode();
+                    node->type = NODE_UNASSIGN;
+                    strcpy(node->varName, value->varName);
+                    break;
+
+                case SSA_PRINT:
+                case SSA_PRINTLN:
+                    node = initNode();
+                    node->type = (value->op == SSA_PRINT) ? NODE_PRINT : NODE_PRINTLN;
+                    node->subnodeB = ssa_lowerValue(ssa, value->a);
+                    break;
+
+                default:
+                    // Phis disappear and temporaries are part of the expression that uses them
+                    node = NULL;
+                    break;
+            }
+            if (node != NULL) ssa_push(list, node);
+        }
+
+        switch (block->exit) {
+            case SSA_JUMP:
+                b = block->target[0];
+                break;
+
+            case SSA_BRANCH:
+                node = initNode();
+                node->subnodeA = ssa_lowerValue(ssa, block->cond);
+                if (block->loop) {
+                    node->type = NODE_WHILE;
+                    node->subnodeB = ssa_lowerRegion(ssa, block->target[0], b);
+                } else {
+                    node->type = NODE_IF;
+                    node->subnodeB = ssa_lowerRegion(ssa, block->target[0], block->merge);
+                    if (block->target[1] != block->merge) {
+                        node->subnodeC = ssa_lowerRegion(ssa, block->target[1], block->merge);
+                        if (node->subnodeC->blockStatements[0] == NULL) {
+                            freeSyntaxTree(node->subnodeC);
+                            node->subnodeC = NULL;
+                        }
+                    }
+                }
+                ssa_push(list, node);
+                b = block->merge;
+                break;
+
+            case SSA_RETURN:
+                node = initNode();
+                node->type = NODE_RETURN;
+                node->subnodeB = ssa_lowerValue(ssa, block->cond);
+                ssa_push(list, node);
+                return;
+
+            default:
+                return;
+        }
+    }
+}
+
+SyntaxNode* ssa_lowerRegion(SsaProgram* ssa, int block, int stop) {
+    SsaStatements list = { .items = NULL, .count = 0, .capacity = 0 };
+    ssa_lowerStatements(ssa, block, stop, &list);
+    return ssa_finishBlock(&list);
+}
+
+SyntaxNode* lowerSsa(SsaProgram* ssa) {
+    return ssa_lowerRegion(ssa, 0, -1);
+}
+
+void optimizeWithSsa(SyntaxNode* program) {
+    if (program == NULL || program->type != NODE_BLOCK) return;
+
+    SsaProgram* ssa = buildSsa(program);
+    if (ssa == NULL) return;
+    optimizeSsa(ssa);
+
+    // The lowered block takes the old statements and frees them
+    SyntaxNode* lowered = lowerSsa(ssa);
+    SyntaxNode** statements = program->blockStatements;
+    program->blockStatements = lowered->blockStatements;
+    lowered->blockStatements = statements;
+    freeSyntaxTree(lowered);
+    deleteSsa(&ssa);
+}
+
+void ssa_printOperand(SsaProgram* ssa, int v, FILE* out) {
+    SsaValue* value = &ssa->values[v];
+    if (value->op == SSA_CONST) fprintf(out, " %d", value->number);
+    else if (value->op == SSA_STRING) fprintf(out, " \"%s\"", value->string);
+    else if (value->op == SSA_UNDEF) fprintf(out, " undef");
+    else fprintf(out, " v%d", v);
+}
+
+void printSsa(SsaProgram* ssa, FILE* out) {
+    static const char* names[] = {
+        [SSA_PHI] = "phi", [SSA_SET] = "set", [SSA_INCR] = "incr", [SSA_DECR] = "decr", [SSA_UNSET] = "unset",
+        [SSA_PRINT] = "print", [SSA_PRINTLN] = "println"
+    };
+
+    for (int b = 0; b < ssa->blockCount; b++) {
+        SsaBlock* block = &ssa->blocks[b];
+        fprintf(out, "b%d:", b);
+        for (int i = 0; i < block->predCount; i++) {
+            fprintf(out, "%s b%d", (i == 0) ? " preds" : "", block->preds[i]);
+        }
+        fprintf(out, "%s\n", block->reachable ? "" : " (unreachable)");
+
+        for (int i = 0; i < block->count; i++) {
+            int v = block->values[i];
+            SsaValue* value = &ssa->values[v];
+
+            switch (value->op) {
+                case SSA_PHI:
+                    fprintf(out, "  v%d = phi %s", v, value->varName);
+                    for (int j = 0; j < block->predCount; j++) {
+                        ssa_printOperand(ssa, value->args[j], out);
+                    }
+                    break;
+
+                case SSA_BIN_OP:
+                    fprintf(out, "  v%d =", v);
+                    ssa_printOperand(ssa, value->a, out);
+                    fprintf(out, " %s", value->operator);
+                    ssa_printOperand(ssa, value->b, out);
+                    break;
+
+                case SSA_PRINT:
+                case SSA_PRINTLN:
+                    fprintf(out, "  %s", names[value->op]);
+                    ssa_printOperand(ssa, value->a, out);
+                    break;
+
+                default:
+                    fprintf(out, "  v%d = %s %s", v, names[value->op], value->varName);
+                    ssa_printOperand(ssa, value->a, out);
+                    break;
+            }
+            fputc('\n', out);
+        }
+
+        switch (block->exit) {
+            case SSA_JUMP:
+                fprintf(out, "  jump b%d\n", block->target[0]);
+                break;
+
+            case SSA_BRANCH:
+                fprintf(out, "  %s", block->loop ? "while" : "branch");
+                ssa_printOperand(ssa, block->cond, out);
+                fprintf(out, " b%d b%d\n", block->target[0], block->target[1]);
+                break;
+
+            case SSA_RETURN:
+                fprintf(out, "  return");
+                ssa_printOperand(ssa, block->cond, out);
+                fputc('\n', out);
+                break;
+
+            default:
+                fprintf(out, "  halt\n");
+                break;
+        }
+    }
+}
+
+void deleteSsa(SsaProgram** ssa) {
+    if (*ssa == NULL) return;
+
+    for (int v = 0; v < (*ssa)->valueCount; v++) {
+        free((*ssa)->values[v].string);
+        free((*ssa)->values[v].args);
+    }
+    for (int b = 0; b < (*ssa)->blockCount; b++) {
+        free((*ssa)->blocks[b].values);
+        free((*ssa)->blocks[b].preds);
+    }
+
+    free((*ssa)->values);
+    free((*ssa)->blocks);
+    free((*ssa)->varNames);
+    freeHashIndex(&(*ssa)->varIndex);
+    free(*ssa);
+    *ssa = NULL;
+}
@@ -0,0 +1,215 @@
+#include "unity.h"
+#include "unity_internals.h"
+
+#include "ssa.c"
+#include "interpreter.h"
+#include "parser.h"
+#include "differential.h"
+
+Token* tokenList;
+SimplicError* error;
+ControlState control;
+
+void setUp(void) {
+    control.returned = false;
+    tokenList = initTokenQueue();
+    control.bank = initMemoryBank();
+    control.out = stdout;
+    error = initError();
+}
+
+void tearDown(void) {
+    deleteTokenQueue(&tokenList);
+    deleteMemoryBank(&control.bank);
+    deleteError(&error);
+}
+
+SyntaxNode* parse(const char* program) {
+    tokenizeSource(&tokenList, program, error);
+    return parseProgram(&tokenList, error);
+}
+
+// Optimizes a program through its SSA form and compares it with the tree of the expected program
+void assertOptimizedTo(const char* program, const char* expected) {
+    SyntaxNode* tree = parse(program);
+    TEST_ASSERT_FALSE(error->hasError);
+    SyntaxNode* expectedTree = parse(expected);
+    TEST_ASSERT_FALSE(error->hasError);
+
+    optimizeWithSsa(tree);
+    TEST_ASSERT_TRUE(compareSyntaxTree(expectedTree, tree));
+
+    freeSyntaxTree(tree);
+    freeSyntaxTree(expectedTree);
+}
+
+// Goes through the SSA form, then runs the program with eval()
+SimplicValue ssaEngine(SyntaxNode* tree, ControlState* control, SimplicError* error) {
+    optimizeWithSsa(tree);
+    return eval(tree, control, error);
+}
+
+// Phi of the variable at the start of a block, -1 if the block has none
+int phiOf(SsaProgram* ssa, SsaBlock* block, const char* name) {
+    for (int i = 0; i < block->count && ssa->values[block->values[i]].op == SSA_PHI; i++) {
+        if (strcmp(ssa->values[block->values[i]].varName, name) == 0) return block->values[i];
+    }
+    return -1;
+}
+
+void testLoopHeaderMergesVersions(void) {
+    SyntaxNode* tree = parse("SET I = 0\nSET N = 3\nWHILE I LT N DO\nINCR I\nDONE\nRETURN I\n");
+    SsaProgram* ssa = buildSsa(tree);
+    TEST_ASSERT_NOT_NULL(ssa);
+
+    // Entry, header, body and the block after the loop, the unwritten N needs no phi
+    TEST_ASSERT_EQUAL_INT(5, ssa->blockCount);
+    SsaBlock* header = &ssa->blocks[1];
+    TEST_ASSERT_TRUE(header->loop);
+    TEST_ASSERT_EQUAL_INT(2, header->predCount);
+
+    SsaValue* phi = &ssa->values[header->values[0]];
+    TEST_ASSERT_EQUAL_INT(SSA_PHI, phi->op);
+    TEST_ASSERT_EQUAL_STRING("I", phi->varName);
+    TEST_ASSERT_EQUAL_INT(SSA_SET, ssa->values[phi->args[0]].op);
+    TEST_ASSERT_EQUAL_INT(SSA_INCR, ssa->values[phi->args[1]].op);
+    TEST_ASSERT_EQUAL_INT(header->values[0], ssa->values[phi->args[1]].a);
+    TEST_ASSERT_EQUAL_INT(SSA_BIN_OP, ssa->values[header->values[1]].op); // The condition
+
+    FILE* out = tmpfile();
+    printSsa(ssa, out);
+    long size = ftell(out);
+    char* text = calloc(size + 1, 1);
+    rewind(out);
+    TEST_ASSERT_EQUAL_INT(size, fread(text, 1, size, out));
+    TEST_ASSERT_NOT_NULL(strstr(text, "phi I"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "while"));
+    TEST_ASSERT_NULL(strstr(text, "phi N"));
+
+    free(text);
+    fclose(out);
+    deleteSsa(&ssa);
+    TEST_ASSERT_NULL(ssa);
+    freeSyntaxTree(tree);
+}
+
+void testIfJoinMergesVersions(void) {
+    SyntaxNode* tree = parse(
+        "SET X = 1\nSET Y = 5\n"
+        "IF Y GT 1 THEN\nSET X = 2\nSET X = X + 1\nELSE\nSET Z = 3\nFI\n"
+        "PRINT X + Y\nPRINT Z\n");
+    SsaProgram* ssa = buildSsa(tree);
+    TEST_ASSERT_NOT_NULL(ssa);
+
+    // Entry with the condition, both sides and the join
+    TEST_ASSERT_EQUAL_INT(4, ssa->blockCount);
+    SsaBlock* entry = &ssa->blocks[0];
+    SsaBlock* then = &ssa->blocks[entry->target[0]];
+    SsaBlock* join = &ssa->blocks[entry->merge];
+    TEST_ASSERT_EQUAL_INT(SSA_BRANCH, entry->exit);
+    TEST_ASSERT_EQUAL_INT(2, join->predCount);
+
+    // Each SET of X is a version of its own, the read in between uses the first one of the branch
+    SsaValue* firstX = &ssa->values[then->values[0]];
+    SsaValue* sum = &ssa->values[then->values[1]];
+    SsaValue* secondX = &ssa->values[then->values[2]];
+    TEST_ASSERT_EQUAL_INT(SSA_SET, firstX->op);
+    TEST_ASSERT_EQUAL_INT(then->values[0], sum->a);
+    TEST_ASSERT_EQUAL_INT(SSA_SET, secondX->op);
+    TEST_ASSERT_EQUAL_INT(then->values[1], secondX->a);
+
+    // X and Z are written on one side at least, so they are merged, Y isn't
+    int phiX = phiOf(ssa, join, "X");
+    int phiZ = phiOf(ssa, join, "Z");
+    TEST_ASSERT_NOT_EQUAL(-1, phiX);
+    TEST_ASSERT_NOT_EQUAL(-1, phiZ);
+    TEST_ASSERT_EQUAL_INT(-1, phiOf(ssa, join, "Y"));
+    TEST_ASSERT_EQUAL_INT(then->values[2], ssa->values[phiX].args[0]);
+    TEST_ASSERT_EQUAL_INT(entry->values[0], ssa->values[phiX].args[1]);
+    TEST_ASSERT_EQUAL_INT(SSA_UNDEF, ssa->values[ssa->values[phiZ].args[0]].op);
+    TEST_ASSERT_EQUAL_INT(SSA_SET, ssa->values[ssa->values[phiZ].args[1]].op);
+
+    // After the join X is read through its phi and Y straight from the entry
+    SsaValue* read = &ssa->values[join->values[2]];
+    TEST_ASSERT_EQUAL_INT(SSA_BIN_OP, read->op);
+    TEST_ASSERT_EQUAL_INT(phiX, read->a);
+    TEST_ASSERT_EQUAL_INT(entry->values[1], read->b);
+
+    deleteSsa(&ssa);
+    freeSyntaxTree(tree);
+}
+
+void testConstantThroughBranches(void) {
+    // Both sides give X the same value, so it is known after the IF
+    assertOptimizedTo(
+        "SET C = 0\nWHILE C LT 5 DO\nINCR C\nDONE\n"
+        "IF C GT 2 THEN\nSET X = 2\nPRINT C\nELSE\nSET X = 1 + 1\nFI\n"
+        "PRINT X * 3\n",
+        "SET C = 0\nWHILE C LT 5 DO\nINCR C\nDONE\n"
+        "IF C GT 2 THEN\nPRINT C\nFI\n"
+        "PRINT 6\n");
+}
+
+void testConstantCarriedByLoop(void) {
+    // K is written in the loop, but always with the value it already has
+    assertOptimizedTo(
+        "SET K = 4\nSET I = 0\nWHILE I LT 10 DO\nSET K = 4\nSET S = I * K\nPRINT S\nINCR I\nDONE\n",
+        "SET I = 0\nWHILE I LT 10 DO\nSET S = I * 4\nPRINT S\nINCR I\nDONE\n");
+}
+
+void testDeadStores(void) {
+    assertOptimizedTo(
+        "SET A = 5\nSET B = A * 2\nSET A = 7\nSET I = 0\nWHILE I LT 3 DO\nSET T = I * 2\nINCR I\nDONE\nPRINT A\n",
+        "SET I = 0\nWHILE I LT 3 DO\nINCR I\nDONE\nPRINT 7\n");
+}
+
+void testStoresThatMayFailStay(void) {
+    // Nobody reads X or Z, but the division by 0 and the undeclared Y must still stop the program
+    assertOptimizedTo(
+        "SET D = 0\nSET I = 0\nWHILE I LT 3 DO\nSET X = 10 / I\nINCR I\nDONE\nSET Z = Y + 1\n",
+        "SET I = 0\nWHILE I LT 3 DO\nSET X = 10 / I\nINCR I\nDONE\nSET Z = Y + 1\n");
+
+    DifferentialRun run = runDifferential("SET Z = Y + 1\n", ssaEngine);
+    TEST_ASSERT_TRUE(run.error->hasError);
+    TEST_ASSERT_EQUAL_INT(ERROR_ACCESS_TO_UNDECLARED_VAR, run.error->errCode);
+    deleteRun(&run);
+}
+
+void testMaybeUndeclaredIsNotConstant(void) {
+    // X is only declared on one side, reading it after the IF may fail
+    assertOptimizedTo(
+        "SET C = 0\nWHILE C LT 2 DO\nINCR C\nDONE\nIF C EQ 5 THEN\nSET X = 1\nFI\nPRINT X\n",
+        "SET C = 0\nWHILE C LT 2 DO\nINCR C\nDONE\nIF C EQ 5 THEN\nSET X = 1\nFI\nPRINT X\n");
+}
+
+void testBranchesNeverTaken(void) {
+    assertOptimizedTo("SET N = 0\nWHILE N GT 0 DO\nPRINT N\nDECR N\nDONE\nPRINT \"done\"\n", "PRINT \"done\"\n");
+    assertOptimizedTo("SET X = 1\nIF X THEN\nRETURN 4\nFI\nPRINT 9\n", "RETURN 4\n");
+    assertOptimizedTo("SET X = 1\nIF X LT 0 THEN\nPRINT 1\nELSE\nPRINT X + 1\nFI\n", "PRINT 2\n");
+}
+
+// Every program must give the same result, output and error before and after going through the SSA form
+void testSameResultsAsEval(void) {
+    const char* programs[] = {
+        "SET K = 4\nSET I = 0\nWHILE I LT 3 DO\nSET K = 4\nPRINTLN I * K\nINCR I\nDONE\nPRINTLN K\n",
+        "SET C = 0\nWHILE C LT 2 DO\nINCR C\nDONE\nIF C EQ 5 THEN\nSET X = 1\nFI\nPRINT X\n",
+        "SET X = 1\nIF X LT 0 THEN\nPRINT 1\nELSE\nPRINT X + 1\nFI\nSET X = \"S\"\nPRINTLN X\n",
+        "SET A = 5\nSET B = A * 2\nSET A = 7\nPRINT A\nSET Z = Y + 1\nPRINT Z\n",
+        "SET N = 0\nWHILE N GT 0 DO\nPRINT N\nDECR N\nDONE\nPRINTLN \"done\"\nRETURN N\n",
+    };
+    assertAllSameAsEval(ssaEngine, programs, sizeof(programs) / sizeof(programs[0]));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(testLoopHeaderMergesVersions);
+    RUN_TEST(testIfJoinMergesVersions);
+    RUN_TEST(testConstantThroughBranches);
+    RUN_TEST(testConstantCarriedByLoop);
+    RUN_TEST(testDeadStores);
+    RUN_TEST(testStoresThatMayFailStay);
+    RUN_TEST(testMaybeUndeclaredIsNotConstant);
+    RUN_TEST(testBranchesNeverTaken);
+    RUN_TEST(testSameResultsAsEval);
+    return UNITY_END();
+}
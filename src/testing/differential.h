@@ -0,0 +1,124 @@
+#ifndef DIFFERENTIAL_H
+#define DIFFERENTIAL_H
+
+/*
+=======================================================================================
+ Differential tests of the execution engines and of the passes that rewrite the AST.
+ A program is run with eval(), the reference, and with the engine under test, then
+ everything a user can see is compared: the error with its message, the printed
+ output and the value given to RETURN. Included by the test of each engine, next to
+ the .c file being tested
+=======================================================================================
+*/
+
+#include "unity.h"
+#include "interpreter.h"
+#include "lexer.h"
+#include "parser.h"
+
+// Runs a whole program the way the engine under test does, with the same contract as eval()
+typedef SimplicValue (*EngineRun)(SyntaxNode* program, ControlState* control, SimplicError* error);
+
+// What one run of a program left behind
+typedef struct DifferentialRun DifferentialRun;
+struct DifferentialRun {
+    SimplicValue value;
+    bool returned;
+    char* output; // Everything PRINT and PRINTLN wrote
+    SimplicError* error;
+};
+
+// Programs every engine must run like eval(), with the errors each operand order gives
+const char* differentialPrograms[] = {
+    "SET X = 1 GT 0\nRETURN 54 + X GEQ 55\n",
+    "SET X\nRETURN X LEQ 54 LT 3\n",
+    "SET X\nRETURN X EQ 54 LT 3\n",
+    "SET X = 99 NEQ 0\nRETURN X GT 0\n",
+    "SET X = 5 EQ 5 AND 7 LT 3\nSET Y = 77 LEQ 77 OR 6 GT 99\nRETURN X OR Y\n",
+    "SET A = 0\nSET B = 1\nSET I = 0\nWHILE I LT 20 DO\nSET T = A + B\nSET A = B\nSET B = T\nINCR I\nDONE\nRETURN A\n",
+    "SET X = 2\nSET C = 0\nWHILE X LT 200 DO\nSET Y = 2\nSET P = 1\nWHILE Y * Y LEQ X DO\nIF X % Y EQ 0 THEN\nSET P = 0\nFI\nINCR Y\nDONE\nSET C = C + P\nINCR X\nDONE\nRETURN C\n",
+    "SET N = 10\nSET I = 0\nSET S = 0\nWHILE I LT N DO\nSET S = S + I * 3\nINCR I\nDONE\nRETURN S\n",
+    "SET S = \"A\"\nSET I = 0\nWHILE I LT 5 DO\nSET S = S + I\nINCR I\nDONE\nRETURN S\n",
+    "SET S = \"A\"\nINCR S\nRETURN S * 3 - 1\n",
+    "SET X = 7\nUNSET X\nSET X = \"B\"\nRETURN 1 + X\n",
+    "SET X = 7\nUNSET X\nRETURN X\n",
+    "SET X = 5\nRETURN X % 0\n",
+    "UNSET Q\n",
+    "SET X = 1\nSET I = 0\nWHILE I LT 3 DO\nSET Y = X + 1\nSET X = \"A\"\nINCR I\nDONE\nRETURN Y\n",
+    "SET X = 1\nIF X THEN\nSET X = \"S\"\nFI\nRETURN X - 1\n",
+    "SET X = 1\nUNSET X\nSET Y = 2\nWHILE Y LT 4 DO\nINCR Y\nDONE\nRETURN X + Y\n",
+    "SET X = 3\nIF X GT 1 THEN\nSET X = X * 2\nELSE\nSET X = 0\nFI\nRETURN X + 1\n",
+    "SET I = 0\nWHILE 1 DO\nINCR I\nIF I EQ 7 THEN\nRETURN I * 2\nFI\nDONE\n",
+    "SET I = 0\nWHILE I LT 4 DO\nIF I EQ 2 THEN\nSET K = I\nFI\nINCR I\nDONE\nRETURN K\n",
+    "SET H = 1\nSET T = 0\nWHILE H LEQ 9 DO\nIF H EQ 1 THEN\nSET T = T + 1\nFI\nIF H EQ 3 THEN\nSET T = T * 2\nFI\n"
+        "IF H EQ 4 THEN\nSET T = T - 3\nFI\nIF H EQ 9 THEN\nSET T = T * 7\nFI\nINCR H\nDONE\nRETURN T\n",
+
+    // The left operand is read first, whatever the right one needs to compute
+    "SET D = 1\nSET C = A + I1 * 7\n",
+    "SET C = A - B * 2\n",
+    "SET B = 2\nPRINTLN \"before\"\nPRINT A * B + C\n",
+    "SET C = A * 2 + B % 3\n",
+    "SET X = 1\nWHILE X LT 3 DO\nPRINTLN X\nINCR X\nDONE\nSET Y = Z + X * X\n",
+
+    // Output up to the error, and after a RETURN nothing more
+    "SET S = \"N: \"\nSET I = 0\nWHILE I LT 4 DO\nPRINT S + I\nPRINTLN \"\"\nINCR I\nDONE\nSET Z = I - 4\nPRINTLN 10 / Z\n",
+    "PRINT 1\nPRINT \"A\" + 2\nPRINTLN 3 LT 4\nRETURN 0\nPRINTLN \"never\"\n",
+};
+const int differentialProgramCount = sizeof(differentialPrograms) / sizeof(differentialPrograms[0]);
+
+// Lexes, parses and runs a program with its own memory bank and output, freed with deleteRun()
+DifferentialRun runDifferential(const char* program, EngineRun engine) {
+    DifferentialRun run = { .value = { .type = VALUE_VOID, .integer = 0, .string = NULL }, .returned = false, .output = NULL, .error = initError() };
+    ControlState control = { .bank = initMemoryBank(), .out = tmpfile(), .returned = false, .unwind = NULL };
+    Token* tokens = initTokenQueue();
+    SyntaxNode* tree = NULL;
+    TEST_ASSERT_NOT_NULL(control.out);
+
+    tokenizeSource(&tokens, program, run.error);
+    if (!run.error->hasError) tree = parseProgram(&tokens, run.error);
+    if (!run.error->hasError) run.value = engine(tree, &control, run.error);
+    run.returned = control.returned;
+
+    long size = ftell(control.out);
+    run.output = calloc(size + 1, 1);
+    rewind(control.out);
+    TEST_ASSERT_EQUAL_INT(size, fread(run.output, 1, size, control.out));
+    fclose(control.out);
+
+    freeSyntaxTree(tree);
+    deleteTokenQueue(&tokens);
+    deleteMemoryBank(&control.bank);
+    return run;
+}
+
+void deleteRun(DifferentialRun* run) {
+    free(run->value.string);
+    free(run->output);
+    deleteError(&run->error);
+}
+
+// The program must fail the same way, print the same and return the same as with eval()
+void assertSameAsEval(const char* program, EngineRun engine) {
+    DifferentialRun expected = runDifferential(program, eval);
+    DifferentialRun run = runDifferential(program, engine);
+
+    TEST_ASSERT_EQUAL_MESSAGE(expected.error->hasError, run.error->hasError, program);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(expected.error->errCode, run.error->errCode, program);
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(expected.error->errMsg, run.error->errMsg, program);
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(expected.output, run.output, program);
+    TEST_ASSERT_EQUAL_MESSAGE(expected.returned, run.returned, program);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(expected.value.integer, run.value.integer, program);
+    if (expected.returned) TEST_ASSERT_EQUAL_INT_MESSAGE(expected.value.type, run.value.type, program);
+    if (expected.value.string != NULL) TEST_ASSERT_EQUAL_STRING_MESSAGE(expected.value.string, run.value.string, program);
+
+    deleteRun(&expected);
+    deleteRun(&run);
+}
+
+// Runs differentialPrograms and then the engine's own programs
+void assertAllSameAsEval(EngineRun engine, const char** programs, int count) {
+    for (int i = 0; i < differentialProgramCount; i++) assertSameAsEval(differentialPrograms[i], engine);
+    for (int i = 0; i < count; i++) assertSameAsEval(programs[i], engine);
+}
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef PRIVATE_TRANSPILER_H
+#define PRIVATE_TRANSPILER_H
+
+#include <limits.h>
+#include "transpiler.h"
+
+// State kept while writing the C program
+typedef struct Transpiler Transpiler;
+struct Transpiler {
+    FILE* out;
+    int indent; // Nesting level of the statement being written
+    int tempCount; // Temporaries are numbered across the whole program, so they never shadow each other
+    char (*vars)[IDENTIFIER_SIZE]; // Every variable of the program, declared at the top of main()
+    int varCount;
+    int varCapacity;
+    SimplicError* error;
+};
+
+static void tr_collectVars(Transpiler* t, SyntaxNode* node);
+static void tr_addVar(Transpiler* t, const char* name);
+static const char* tr_binOpFunction(const char* operator); // Runtime function of an operator, NULL if unknown
+
+// Writers
+static void tr_line(Transpiler* t, const char* format, ...); // Indented line
+static void tr_string(Transpiler* t, const char* s); // C string literal
+static int tr_expr(Transpiler* t, SyntaxNode* node); // Returns the temporary that holds the result
+static void tr_statement(Transpiler* t, SyntaxNode* node);
+
+#endif
@@ -0,0 +1,237 @@
+#include "private_transpiler.h"
+
+void tr_addVar(Transpiler* t, const char* name) {
+    for (int i = 0; i < t->varCount; i++) {
+        if (strcmp(t->vars[i], name) == 0) return;
+    }
+
+    if (t->varCount == t->varCapacity) {
+        t->varCapacity = (t->varCapacity == 0) ? 16 : t->varCapacity * 2;
+        t->vars = realloc(t->vars, sizeof(*t->vars) * t->varCapacity);
+    }
+    strcpy(t->vars[t->varCount++], name);
+}
+
+void tr_collectVars(Transpiler* t, SyntaxNode* node) {
+    int i;
+    if (node == NULL) return;
+
+    switch (node->type) {
+        case NODE_VAR:
+        case NODE_ASSIGN:
+        case NODE_UNASSIGN:
+            tr_addVar(t, node->varName);
+            tr_collectVars(t, node->subnodeB);
+            break;
+
+        case NODE_BLOCK:
+            i = 0;
+            while (node->blockStatements[i] != NULL) {
+                tr_collectVars(t, node->blockStatements[i++]);
+            }
+            break;
+
+        default:
+            tr_collectVars(t, node->subnodeA);
+            tr_collectVars(t, node->subnodeB);
+            tr_collectVars(t, node->subnodeC);
+            break;
+    }
+}
+
+const char* tr_binOpFunction(const char* operator) {
+    static const char* table[][2] = {
+        { "+", "sr_add" }, { "-", "sr_sub" }, { "*", "sr_mul" }, { "/", "sr_div" }, { "%", "sr_mod" },
+        { "<", "sr_lt" }, { "<=", "sr_leq" }, { ">", "sr_gt" }, { ">=", "sr_geq" },
+        { "==", "sr_eq" }, { "!=", "sr_neq" }, { "&&", "sr_and" }, { "||", "sr_or" }
+    };
+
+    for (unsigned int i = 0; i < sizeof(table) / sizeof(table[0]); i++) {
+        if (strcmp(table[i][0], operator) == 0) return table[i][1];
+    }
+    return NULL;
+}
+
+void tr_line(Transpiler* t, const char* format, ...) {
+    va_list args;
+    fprintf(t->out, "%*s", 4 * t->indent, "");
+
+    va_start(args, format);
+    vfprintf(t->out, format, args);
+    va_end(args);
+
+    fputc('\n', t->out);
+}
+
+void tr_string(Transpiler* t, const char* s) {
+    fputc('"', t->out);
+    for (const unsigned char* c = (const unsigned char*)s; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            fprintf(t->out, "\\%c", *c);
+        } else if (*c < 0x20 || *c >= 0x7F) {
+            fprintf(t->out, "\\%03o", *c); // Octal escapes never merge with the next character
+        } else {
+            fputc(*c, t->out);
+        }
+    }
+    fputc('"', t->out);
+}
+
+int tr_expr(Transpiler* t, SyntaxNode* node) {
+    int temp;
+
+    switch (node->type) {
+        case NODE_NUMBER:
+            temp = t->tempCount++;
+            if (node->numberValue == INT_MIN) {
+                tr_line(t, "SrValue t%d = sr_int(-2147483647 - 1);", temp); // -2147483648 is not an int literal in C
+            } else {
+                tr_line(t, "SrValue t%d = sr_int(%d);", temp, node->numberValue);
+            }
+            return temp;
+
+        case NODE_STRING:
+            temp = t->tempCount++;
+            fprintf(t->out, "%*sSrValue t%d = sr_str(", 4 * t->indent, "", temp);
+            tr_string(t, node->string);
+            fprintf(t->out, ");\n");
+            return temp;
+
+        case NODE_VAR:
+            temp = t->tempCount++;
+            tr_line(t, "SrValue t%d = sr_var(&v_%s, \"%s\");", temp, node->varName, node->varName);
+            return temp;
+
+        case NODE_BIN_OP: {
+            const char* function = tr_binOpFunction(node->operator);
+            if (function == NULL) {
+                setError(t->error, ERROR_INVALID_EXPR, "Unknown operator: %s", node->operator);
+                return 0;
+            }
+
+            // Left operand first, like eval()
+            int l = tr_expr(t, node->subnodeA);
+            int r = tr_expr(t, node->subnodeB);
+            temp = t->tempCount++;
+            tr_line(t, "SrValue t%d = %s(t%d, t%d);", temp, function, l, r);
+            return temp;
+        }
+
+        default:
+            setError(t->error, ERROR_INVALID_EXPR, "Tried to transpile unknown expression of type: %d", node->type);
+            return 0;
+    }
+}
+
+void tr_statement(Transpiler* t, SyntaxNode* node) {
+    int i, temp;
+    if (t->error->hasError) return;
+
+    switch (node->type) {
+        case NODE_ASSIGN:
+            // Temporaries of a statement live in their own block
+            tr_line(t, "{");
+            t->indent++;
+            temp = tr_expr(t, node->subnodeB);
+            tr_line(t, "sr_assign(&v_%s, t%d);", node->varName, temp);
+            t->indent--;
+            tr_line(t, "}");
+            break;
+
+        case NODE_UNASSIGN:
+            tr_line(t, "sr_unset(&v_%s, \"%s\");", node->varName, node->varName);
+            break;
+
+        case NODE_PRINT:
+        case NODE_PRINTLN:
+            tr_line(t, "{");
+            t->indent++;
+            temp = tr_expr(t, node->subnodeB);
+            tr_line(t, "sr_print(t%d, %s);", temp, (node->type == NODE_PRINTLN) ? "true" : "false");
+            t->indent--;
+            tr_line(t, "}");
+            break;
+
+        case NODE_RETURN:
+            tr_line(t, "{");
+            t->indent++;
+            temp = tr_expr(t, node->subnodeB);
+            tr_line(t, "sr_return(t%d);", temp);
+            t->indent--;
+            tr_line(t, "}");
+            break;
+
+        case NODE_INCREMENT:
+        case NODE_DECREMENT:
+            if (node->subnodeB->type != NODE_VAR) {
+                setError(t->error, ERROR_INVALID_EXPR, "INCR/DECR can only be applied to a variable");
+                return;
+            }
+            tr_line(t, "sr_incr(&v_%s, \"%s\", %d);", node->subnodeB->varName, node->subnodeB->varName,
+                    (node->type == NODE_INCREMENT) ? 1 : -1);
+            break;
+
+        case NODE_BLOCK:
+            i = 0;
+            while (node->blockStatements[i] != NULL) {
+                tr_statement(t, node->blockStatements[i++]);
+            }
+            break;
+
+        case NODE_WHILE:
+            tr_line(t, "for (;;) {");
+            t->indent++;
+            temp = tr_expr(t, node->subnodeA);
+            tr_line(t, "if (!sr_cond(t%d, \"WHILE\")) break;", temp);
+            tr_statement(t, node->subnodeB);
+            t->indent--;
+            tr_line(t, "}");
+            break;
+
+        case NODE_IF:
+            tr_line(t, "{");
+            t->indent++;
+            temp = tr_expr(t, node->subnodeA);
+            tr_line(t, "if (sr_cond(t%d, \"IF\")) {", temp);
+            t->indent++;
+            tr_statement(t, node->subnodeB);
+            t->indent--;
+
+            if (node->subnodeC != NULL) {
+                tr_line(t, "} else {");
+                t->indent++;
+                tr_statement(t, node->subnodeC);
+                t->indent--;
+            }
+            tr_line(t, "}");
+            t->indent--;
+            tr_line(t, "}");
+            break;
+
+        default:
+            setError(t->error, ERROR_UNKNOWN_INSTRUCTION, "Tried to transpile unknown statement of type: %d", node->type);
+            return;
+    }
+}
+
+void transpileProgram(SyntaxNode* program, const char* name, FILE* out, SimplicError* error) {
+    Transpiler t = { .out = out, .indent = 0, .tempCount = 0, .vars = NULL, .varCount = 0, .varCapacity = 0, .error = error };
+
+    tr_collectVars(&t, program);
+
+    fprintf(out, "// Generated by simplic --emit-c from %s\n", name);
+    fprintf(out, "#include \"simplicRuntime.h\"\n\n");
+    fprintf(out, "int main(void) {\n");
+    t.indent = 1;
+
+    for (int i = 0; i < t.varCount; i++) {
+        tr_line(&t, "SrValue v_%s = SR_UNDECLARED;", t.vars[i]);
+    }
+    if (t.varCount > 0) fputc('\n', out);
+
+    tr_statement(&t, program);
+
+    tr_line(&t, "return 0;");
+    fprintf(out, "}\n");
+    free(t.vars);
+}
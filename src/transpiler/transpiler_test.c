@@ -0,0 +1,132 @@
+#define _POSIX_C_SOURCE 200809L // popen()
+#include "unity.h"
+#include "unity_internals.h"
+
+#include "transpiler.c"
+#include "parser.h"
+
+// Generated programs are built with the system C compiler, paths are relative to the repository root
+#define GENERATED_SOURCE "build/tests/transpiled.c"
+#define GENERATED_BINARY "build/tests/transpiled"
+#define BUILD_COMMAND "cc -std=c17 -O1 -I include " GENERATED_SOURCE " src/runtime/simplicRuntime.c -o " GENERATED_BINARY
+
+Token* tokenList;
+SimplicError* error;
+char output[4096];
+
+void setUp(void) {
+    tokenList = initTokenQueue();
+    error = initError();
+    output[0] = '\0';
+}
+
+void tearDown(void) {
+    deleteTokenQueue(&tokenList);
+    deleteError(&error);
+}
+
+// Transpiles a program, builds it and stores what it prints in output
+void runTranspiled(const char* program) {
+    tokenizeSource(&tokenList, program, error);
+    SyntaxNode* tree = parseProgram(&tokenList, error);
+    TEST_ASSERT_FALSE(error->hasError);
+
+    FILE* source = fopen(GENERATED_SOURCE, "w");
+    TEST_ASSERT_NOT_NULL(source);
+    transpileProgram(tree, "test", source, error);
+    fclose(source);
+    freeSyntaxTree(tree);
+    TEST_ASSERT_FALSE(error->hasError);
+
+    if (system(BUILD_COMMAND) != 0) TEST_FAIL_MESSAGE("Generated program does not compile");
+
+    FILE* run = popen("./" GENERATED_BINARY, "r");
+    TEST_ASSERT_NOT_NULL(run);
+    size_t len = fread(output, 1, sizeof(output) - 1, run);
+    output[len] = '\0';
+    pclose(run);
+}
+
+void testReturnCode(void) {
+    runTranspiled("SET X = 2 * 4 + 3\nINCR X\nDECR X\nSET X = X * 2\nRETURN X\n");
+    TEST_ASSERT_EQUAL_STRING("Program ended with return code: 22\n", output);
+}
+
+void testPrintAndConcatenation(void) {
+    runTranspiled(
+        "SET X = \"HELLO\"\n"
+        "SET Y = \"WORLD\"\n"
+        "PRINTLN X + \" \" + Y\n"
+        "PRINT \"LUCKY: \" + 2 * 76 % 3\n"
+        "PRINTLN \"\"\n");
+    TEST_ASSERT_EQUAL_STRING("HELLO WORLD\nLUCKY: 2\n", output);
+}
+
+void testStringLiteralEscapes(void) {
+    FILE* out = tmpfile();
+    Transpiler t = { .out = out, .indent = 0, .tempCount = 0, .vars = NULL, .varCount = 0, .varCapacity = 0, .error = error };
+    tr_string(&t, "A\"B\\C\n\t1");
+
+    rewind(out);
+    size_t len = fread(output, 1, sizeof(output) - 1, out);
+    output[len] = '\0';
+    fclose(out);
+    TEST_ASSERT_EQUAL_STRING("\"A\\\"B\\\\C\\012\\0111\"", output);
+}
+
+void testLoopsAndConditions(void) {
+    runTranspiled(
+        "SET X = 2\n"
+        "SET C = 0\n"
+        "WHILE X LT 100 DO\n"
+            "SET Y = 2\n"
+            "SET P = 1\n"
+            "WHILE Y * Y LEQ X DO\n"
+                "IF X % Y EQ 0 THEN\n"
+                    "SET P = 0\n"
+                "FI\n"
+                "INCR Y\n"
+            "DONE\n"
+            "IF P THEN\n"
+                "INCR C\n"
+            "ELSE\n"
+                "SET C = C + 0\n"
+            "FI\n"
+            "INCR X\n"
+        "DONE\n"
+        "RETURN C\n");
+    TEST_ASSERT_EQUAL_STRING("Program ended with return code: 25\n", output);
+}
+
+void testDivisionByZeroMessage(void) {
+    runTranspiled("SET X = 9\nPRINTLN X\nSET Y = 0\nSET Z = X / Y\nPRINT Z\n");
+    TEST_ASSERT_EQUAL_STRING("9\n\nError: Division by 0, execution halted\n", output);
+}
+
+void testUndeclaredVariableMessage(void) {
+    runTranspiled("SET X = 1\nUNSET X\nSET Y = X + 1\n");
+    TEST_ASSERT_EQUAL_STRING("\nError: Variable X not initialized\n", output);
+}
+
+void testLeftOperandFailsFirst(void) {
+    runTranspiled("SET Z = A + 1 / 0\n");
+    TEST_ASSERT_EQUAL_STRING("\nError: Variable A not initialized\n", output);
+}
+
+void testConditionMismatchMessage(void) {
+    runTranspiled("SET S = \"A\"\nIF S THEN\nPRINT 1\nFI\n");
+    TEST_ASSERT_EQUAL_STRING("\nError: IF condition must be integer\n", output);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(testReturnCode);
+    RUN_TEST(testPrintAndConcatenation);
+    RUN_TEST(testStringLiteralEscapes);
+    RUN_TEST(testLoopsAndConditions);
+    RUN_TEST(testDivisionByZeroMessage);
+    RUN_TEST(testUndeclaredVariableMessage);
+    RUN_TEST(testLeftOperandFailsFirst);
+    RUN_TEST(testConditionMismatchMessage);
+    return UNITY_END();
+}
@@ -0,0 +1,524 @@
+#include "private_compiler.h"
+
+int findVar(Compiler* c, const char* name) {
+    unsigned int hash = hashName(name);
+    int cursor;
+    for (int i = hashIndexFirst(&c->varIndex, hash, &cursor); i >= 0; i = hashIndexNext(&c->varIndex, hash, &cursor)) {
+        if (strcmp(c->program->varNames[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+int addVar(Compiler* c, const char* name) {
+    int i = findVar(c, name);
+    if (i >= 0) return i;
+
+    VMProgram* p = c->program;
+    if (p->varCount == c->varCapacity) {
+        c->varCapacity = (c->varCapacity == 0) ? 16 : c->varCapacity * 2;
+        p->varNames = realloc(p->varNames, sizeof(*p->varNames) * c->varCapacity);
+        c->intVars = realloc(c->intVars, sizeof(bool) * c->varCapacity);
+    }
+    strcpy(p->varNames[p->varCount], name);
+    c->intVars[p->varCount] = false;
+    hashIndexAdd(&c->varIndex, hashName(name), p->varCount);
+    return p->varCount++;
+}
+
+int findIntConstant(Compiler* c, int n) {
+    unsigned int hash = hashInt(n);
+    int cursor;
+    for (int i = hashIndexFirst(&c->constIndex, hash, &cursor); i >= 0; i = hashIndexNext(&c->constIndex, hash, &cursor)) {
+        SimplicValue k = c->program->constants[i];
+        if (k.type == VALUE_INT && k.integer == n) return i;
+    }
+    return -1;
+}
+
+int findStrConstant(Compiler* c, const char* s) {
+    unsigned int hash = hashName(s);
+    int cursor;
+    for (int i = hashIndexFirst(&c->constIndex, hash, &cursor); i >= 0; i = hashIndexNext(&c->constIndex, hash, &cursor)) {
+        SimplicValue k = c->program->constants[i];
+        if (k.type == VALUE_STR && strcmp(k.string, s) == 0) return i;
+    }
+    return -1;
+}
+
+int addConstant(Compiler* c, SimplicValue value) {
+    VMProgram* p = c->program;
+    if (p->constCount == c->constCapacity) {
+        c->constCapacity = (c->constCapacity == 0) ? 16 : c->constCapacity * 2;
+        p->constants = realloc(p->constants, sizeof(SimplicValue) * c->constCapacity);
+    }
+    p->constants[p->constCount] = value;
+    hashIndexAdd(&c->constIndex, (value.type == VALUE_STR) ? hashName(value.string) : hashInt(value.integer), p->constCount);
+    return p->constCount++;
+}
+
+void collectSymbols(Compiler* c, SyntaxNode* node) {
+    int i;
+    if (node == NULL) return;
+
+    switch (node->type) {
+        case NODE_NUMBER:
+            if (findIntConstant(c, node->numberValue) < 0)
+                addConstant(c, (SimplicValue){ .type = VALUE_INT, .integer = node->numberValue, .string = NULL });
+            break;
+
+        case NODE_STRING:
+            if (findStrConstant(c, node->string) < 0) {
+                char* copy = malloc(sizeof(char) * (strlen(node->string) + 1));
+                strcpy(copy, node->string);
+                addConstant(c, (SimplicValue){ .type = VALUE_STR, .integer = 0, .string = copy });
+            }
+            break;
+
+        case NODE_ASSIGN:
+            // Every assignment to the variable is flagged the same way
+            i = addVar(c, node->varName);
+            c->intVars[i] = node->provenInt;
+            collectSymbols(c, node->subnodeB);
+            break;
+
+        case NODE_VAR:
+        case NODE_UNASSIGN:
+            addVar(c, node->varName);
+            collectSymbols(c, node->subnodeB);
+            break;
+
+        case NODE_BLOCK:
+            i = 0;
+            while (node->blockStatements[i] != NULL) {
+                collectSymbols(c, node->blockStatements[i++]);
+            }
+            break;
+
+        default:
+            collectSymbols(c, node->subnodeA);
+            collectSymbols(c, node->subnodeB);
+            collectSymbols(c, node->subnodeC);
+            break;
+    }
+}
+
+int allocTemp(Compiler* c) {
+    int reg = c->program->varCount + c->program->constCount + c->intTempCount + c->tempTop++;
+    if (c->tempTop > c->tempMax) c->tempMax = c->tempTop;
+    return reg;
+}
+
+int allocIntTemp(Compiler* c) {
+    return c->program->varCount + c->program->constCount + c->intTempTop++;
+}
+
+int intTempsNeeded(SyntaxNode* expr) {
+    if (expr->type != NODE_BIN_OP) return 0;
+
+    // Same order as compileExpr(): the left operand's result is kept while the right one is computed
+    int left = intTempsNeeded(expr->subnodeA);
+    int right = intTempsNeeded(expr->subnodeB);
+    if (expr->subnodeA->type == NODE_BIN_OP && expr->subnodeA->provenInt) right++;
+
+    int needed = (left > right) ? left : right;
+    if (expr->provenInt && needed < 1) needed = 1;
+    return needed;
+}
+
+void countIntTemps(Compiler* c, SyntaxNode* node) {
+    int i, needed = 0;
+
+    switch (node->type) {
+        case NODE_ASSIGN:
+        case NODE_PRINT:
+        case NODE_PRINTLN:
+        case NODE_RETURN:
+            needed = intTempsNeeded(node->subnodeB);
+            break;
+
+        case NODE_BLOCK:
+            i = 0;
+            while (node->blockStatements[i] != NULL) {
+                countIntTemps(c, node->blockStatements[i++]);
+            }
+            break;
+
+        case NODE_WHILE:
+        case NODE_IF:
+            needed = intTempsNeeded(node->subnodeA);
+            countIntTemps(c, node->subnodeB);
+            if (node->subnodeC != NULL) countIntTemps(c, node->subnodeC);
+            break;
+
+        default:
+            break;
+    }
+
+    if (needed > c->intTempCount) c->intTempCount = needed;
+}
+
+bool neverString(Compiler* c, int reg) {
+    int temps = c->program->varCount + c->program->constCount;
+    if (reg < c->program->varCount) return c->intVars[reg];
+    return reg >= temps && reg < temps + c->intTempCount;
+}
+
+int emit(Compiler* c, OpCode opcode, int a, int b, int c_) {
+    VMProgram* p = c->program;
+    if (p->codeSize == c->codeCapacity) {
+        c->codeCapacity = (c->codeCapacity == 0) ? 64 : c->codeCapacity * 2;
+        p->code = realloc(p->code, sizeof(Instruction) * c->codeCapacity);
+    }
+    p->code[p->codeSize] = (Instruction){ .opcode = opcode, .a = a, .b = b, .c = c_, .handler = NULL };
+    return p->codeSize++;
+}
+
+bool binOpCode(const char* operator, OpCode* opcode) {
+    if (strcmp(operator, "+") == 0) { *opcode = OP_ADD; return true; }
+    if (strcmp(operator, "-") == 0) { *opcode = OP_SUB; return true; }
+    if (strcmp(operator, "*") == 0) { *opcode = OP_MUL; return true; }
+    if (strcmp(operator, "/") == 0) { *opcode = OP_DIV; return true; }
+    if (strcmp(operator, "%") == 0) { *opcode = OP_MOD; return true; }
+    if (strcmp(operator, "<") == 0) { *opcode = OP_LT; return true; }
+    if (strcmp(operator, "<=") == 0) { *opcode = OP_LEQ; return true; }
+    if (strcmp(operator, ">") == 0) { *opcode = OP_GT; return true; }
+    if (strcmp(operator, ">=") == 0) { *opcode = OP_GEQ; return true; }
+    if (strcmp(operator, "==") == 0) { *opcode = OP_EQ; return true; }
+    if (strcmp(operator, "!=") == 0) { *opcode = OP_NEQ; return true; }
+    if (strcmp(operator, "&&") == 0) { *opcode = OP_AND; return true; }
+    if (strcmp(operator, "||") == 0) { *opcode = OP_OR; return true; }
+    return false;
+}
+
+int compileExpr(Compiler* c, SyntaxNode* node, int dest) {
+    int src;
+
+    switch (node->type) {
+        case NODE_NUMBER:
+            src = c->program->varCount + findIntConstant(c, node->numberValue);
+            break;
+
+        case NODE_STRING:
+            src = c->program->varCount + findStrConstant(c, node->string);
+            break;
+
+        case NODE_VAR:
+            src = findVar(c, node->varName);
+            break;
+
+        case NODE_BIN_OP: {
+            OpCode opcode;
+            if (!binOpCode(node->operator, &opcode)) {
+                setError(c->error, ERROR_INVALID_EXPR, "Unknown operator: %s", node->operator);
+                return 0;
+            }
+
+            // Operands are read before the result is written, so their temporaries can be reused
+            int savedTop = c->tempTop;
+            int savedIntTop = c->intTempTop;
+            // A variable that may be unset is checked before the right operand's code runs, so the first
+            // undeclared variable is the one reported, like in eval(). The checked MOVE does it
+            bool checkFirst = node->subnodeA->type == NODE_VAR && !node->subnodeA->provenInt && node->subnodeB->type == NODE_BIN_OP;
+            int l = compileExpr(c, node->subnodeA, checkFirst ? allocTemp(c) : -1);
+            int r = compileExpr(c, node->subnodeB, -1);
+            c->tempTop = savedTop;
+            c->intTempTop = savedIntTop;
+
+            if (dest < 0) dest = node->provenInt ? allocIntTemp(c) : allocTemp(c);
+            if (node->provenInt && neverString(c, dest)) opcode = OP_IADD + (opcode - OP_ADD);
+            emit(c, opcode, dest, l, r);
+            return dest;
+        }
+
+        default:
+            setError(c->error, ERROR_INVALID_EXPR, "Tried to compile unknown expression of type: %d", node->type);
+            return 0;
+    }
+
+    // Leaves are already stored in a register, they are only copied if a destination was requested
+    if (dest < 0) return src;
+    emit(c, (node->provenInt && neverString(c, dest)) ? OP_IMOVE : OP_MOVE, dest, src, 0);
+    return dest;
+}
+
+bool fusedBranchCode(const char* operator, bool onTrue, OpCode* opcode) {
+    // Jumping when the condition is false is jumping when the opposite comparison is true
+    static const struct { const char* operator; OpCode onTrue; OpCode onFalse; } table[] = {
+        { "<", OP_JLT, OP_JGEQ }, { "<=", OP_JLEQ, OP_JGT }, { ">", OP_JGT, OP_JLEQ },
+        { ">=", OP_JGEQ, OP_JLT }, { "==", OP_JEQ, OP_JNEQ }, { "!=", OP_JNEQ, OP_JEQ }
+    };
+
+    for (unsigned int i = 0; i < sizeof(table) / sizeof(table[0]); i++) {
+        if (strcmp(table[i].operator, operator) == 0) {
+            *opcode = onTrue ? table[i].onTrue : table[i].onFalse;
+            return true;
+        }
+    }
+    return false;
+}
+
+int compileBranch(Compiler* c, SyntaxNode* cond, bool onTrue, int target, ConditionKind kind) {
+    OpCode opcode;
+
+    if (cond->type == NODE_BIN_OP && cond->provenInt && fusedBranchCode(cond->operator, onTrue, &opcode)) {
+        SyntaxNode* l = cond->subnodeA;
+        SyntaxNode* r = cond->subnodeB;
+
+        // X % C EQ 0 and X % C NEQ 0 test the remainder straight away
+        bool modTest = (opcode == OP_JEQ || opcode == OP_JNEQ) && l->type == NODE_BIN_OP && strcmp(l->operator, "%") == 0
+                       && r->type == NODE_NUMBER && r->numberValue == 0;
+        if (modTest) {
+            bool onZero = (strcmp(cond->operator, "==") == 0) == onTrue;
+            opcode = onZero ? OP_JMODZ : OP_JMODNZ;
+            r = l->subnodeB;
+            l = l->subnodeA;
+        }
+
+        int a = compileExpr(c, l, -1);
+        int b = compileExpr(c, r, -1);
+        return emit(c, opcode, a, target, b);
+    }
+
+    int reg = compileExpr(c, cond, -1);
+    if (cond->provenInt) return emit(c, onTrue ? OP_IJMPT : OP_IJMPF, reg, target, kind);
+    return emit(c, onTrue ? OP_JMPT : OP_JMPF, reg, target, kind);
+}
+
+bool writesVar(SyntaxNode* node, const char* name) {
+    int i;
+    if (node == NULL) return false;
+
+    switch (node->type) {
+        case NODE_ASSIGN:
+        case NODE_UNASSIGN:
+            return strcmp(node->varName, name) == 0;
+
+        case NODE_INCREMENT:
+        case NODE_DECREMENT:
+            return node->subnodeB->type == NODE_VAR && strcmp(node->subnodeB->varName, name) == 0;
+
+        case NODE_BLOCK:
+            i = 0;
+            while (node->blockStatements[i] != NULL) {
+                if (writesVar(node->blockStatements[i++], name)) return true;
+            }
+            return false;
+
+        case NODE_WHILE:
+        case NODE_IF:
+            return writesVar(node->subnodeB, name) || writesVar(node->subnodeC, name);
+
+        default:
+            return false;
+    }
+}
+
+bool switchCase(SyntaxNode* node, const char** var, int* value) {
+    if (node->type != NODE_IF || node->subnodeC != NULL) return false;
+
+    SyntaxNode* cond = node->subnodeA;
+    if (cond->type != NODE_BIN_OP || strcmp(cond->operator, "==") != 0) return false;
+    if (cond->subnodeA->type != NODE_VAR || !cond->subnodeA->provenInt || cond->subnodeB->type != NODE_NUMBER) return false;
+
+    *var = cond->subnodeA->varName;
+    *value = cond->subnodeB->numberValue;
+    return true;
+}
+
+int switchRunLength(SyntaxNode** statements) {
+    const char* var;
+    const char* next;
+    int value, other, count = 0;
+
+    if (!switchCase(statements[0], &var, &value)) return 0;
+
+    while (statements[count] != NULL && switchCase(statements[count], &next, &value) && strcmp(next, var) == 0) {
+        // Both bodies of a repeated value would run
+        for (int i = 0; i < count; i++) {
+            switchCase(statements[i], &next, &other);
+            if (other == value) return count;
+        }
+
+        // Once the variable changes the following IFs could match too, so this is the last case
+        if (writesVar(statements[count++]->subnodeB, var)) break;
+    }
+    return count;
+}
+
+int compareSwitchCases(const void* a, const void* b) {
+    int l = ((const SwitchCase*)a)->value;
+    int r = ((const SwitchCase*)b)->value;
+    return (l > r) - (l < r);
+}
+
+void fillJumpTable(JumpTable* table, SwitchCase* cases, int count, int otherwise) {
+    qsort(cases, count, sizeof(SwitchCase), compareSwitchCases);
+    long long span = (long long)cases[count - 1].value - cases[0].value + 1;
+
+    table->low = cases[0].value;
+    table->otherwise = otherwise;
+
+    if (span <= (long long)count * SWITCH_MAX_SPAN) {
+        table->count = (int)span;
+        table->keys = NULL;
+        table->targets = malloc(sizeof(int) * table->count);
+        for (int i = 0; i < table->count; i++) {
+            table->targets[i] = otherwise;
+        }
+        for (int i = 0; i < count; i++) {
+            table->targets[cases[i].value - table->low] = cases[i].target;
+        }
+    } else {
+        table->count = count;
+        table->keys = malloc(sizeof(int) * count);
+        table->targets = malloc(sizeof(int) * count);
+        for (int i = 0; i < count; i++) {
+            table->keys[i] = cases[i].value;
+            table->targets[i] = cases[i].target;
+        }
+    }
+}
+
+void compileSwitch(Compiler* c, SyntaxNode** cases, int count) {
+    VMProgram* p = c->program;
+    SwitchCase* table = malloc(sizeof(SwitchCase) * count);
+    int* exits = malloc(sizeof(int) * count);
+    const char* var;
+
+    // The table is filled once the bodies have an address, they may contain switches too
+    if (p->jumpTableCount == c->tableCapacity) {
+        c->tableCapacity = (c->tableCapacity == 0) ? 4 : c->tableCapacity * 2;
+        p->jumpTables = realloc(p->jumpTables, sizeof(JumpTable) * c->tableCapacity);
+    }
+    int index = p->jumpTableCount++;
+    p->jumpTables[index] = (JumpTable){ .low = 0, .count = 0, .keys = NULL, .targets = NULL, .otherwise = 0 };
+
+    switchCase(cases[0], &var, &table[0].value);
+    emit(c, OP_SWITCH, findVar(c, var), index, 0);
+
+    // At most one body runs, each one jumps past the others
+    for (int i = 0; i < count; i++) {
+        switchCase(cases[i], &var, &table[i].value);
+        table[i].target = p->codeSize;
+        compileStatement(c, cases[i]->subnodeB);
+        if (i < count - 1) exits[i] = emit(c, OP_JMP, 0, 0, 0);
+    }
+    for (int i = 0; i < count - 1; i++) {
+        p->code[exits[i]].b = p->codeSize;
+    }
+
+    fillJumpTable(&p->jumpTables[index], table, count, p->codeSize);
+    free(table);
+    free(exits);
+}
+
+void compileStatement(Compiler* c, SyntaxNode* node) {
+    int i, reg, jump, start;
+    if (c->error->hasError) return;
+
+    switch (node->type) {
+        case NODE_ASSIGN:
+            // The expression is computed straight into the variable's register
+            compileExpr(c, node->subnodeB, findVar(c, node->varName));
+            break;
+
+        case NODE_UNASSIGN:
+            emit(c, OP_UNSET, findVar(c, node->varName), 0, 0);
+            break;
+
+        case NODE_PRINT:
+        case NODE_PRINTLN:
+            reg = compileExpr(c, node->subnodeB, -1);
+            emit(c, (node->type == NODE_PRINT) ? OP_PRINT : OP_PRINTLN, reg, 0, 0);
+            break;
+
+        case NODE_RETURN:
+            reg = compileExpr(c, node->subnodeB, -1);
+            emit(c, OP_RETURN, reg, 0, 0);
+            break;
+
+        case NODE_INCREMENT:
+        case NODE_DECREMENT:
+            if (node->subnodeB->type != NODE_VAR) {
+                setError(c->error, ERROR_INVALID_EXPR, "INCR/DECR can only be applied to a variable");
+                return;
+            }
+            if (node->subnodeB->provenInt) {
+                emit(c, (node->type == NODE_INCREMENT) ? OP_IINCR : OP_IDECR, findVar(c, node->subnodeB->varName), 0, 0);
+            } else {
+                emit(c, (node->type == NODE_INCREMENT) ? OP_INCR : OP_DECR, findVar(c, node->subnodeB->varName), 0, 0);
+            }
+            break;
+
+        case NODE_BLOCK:
+            i = 0;
+            while (node->blockStatements[i] != NULL) {
+                // Runs of IFs testing one variable against constants take a single jump
+                int run = switchRunLength(&node->blockStatements[i]);
+                if (run >= SWITCH_MIN_CASES) {
+                    compileSwitch(c, &node->blockStatements[i], run);
+                    i += run;
+                } else {
+                    compileStatement(c, node->blockStatements[i++]);
+                }
+            }
+            break;
+
+        case NODE_WHILE:
+            // The condition is placed after the body, so each iteration only takes one jump
+            jump = emit(c, OP_JMP, 0, 0, 0);
+            start = c->program->codeSize;
+            compileStatement(c, node->subnodeB);
+            c->program->code[jump].b = c->program->codeSize;
+            compileBranch(c, node->subnodeA, true, start, COND_WHILE);
+            break;
+
+        case NODE_IF:
+            jump = compileBranch(c, node->subnodeA, false, 0, COND_IF);
+            compileStatement(c, node->subnodeB);
+
+            if (node->subnodeC != NULL) {
+                int skipElse = emit(c, OP_JMP, 0, 0, 0);
+                c->program->code[jump].b = c->program->codeSize;
+                compileStatement(c, node->subnodeC);
+                c->program->code[skipElse].b = c->program->codeSize;
+            } else {
+                c->program->code[jump].b = c->program->codeSize;
+            }
+            break;
+
+        default:
+            setError(c->error, ERROR_UNKNOWN_INSTRUCTION, "Tried to compile unknown statement of type: %d", node->type);
+            return;
+    }
+
+    // Temporaries do not outlive a statement
+    c->tempTop = 0;
+    c->intTempTop = 0;
+}
+
+VMProgram* compileProgram(SyntaxNode* program, SimplicError* error) {
+    VMProgram* p = malloc(sizeof(VMProgram));
+    *p = (VMProgram){ .code = NULL, .codeSize = 0, .varNames = NULL, .varCount = 0, .constants = NULL, .constCount = 0, .registerCount = 0, .threaded = false,
+                        .jumpTables = NULL, .jumpTableCount = 0, .jitLoops = NULL, .jitLoopCount = 0 };
+
+    Compiler c = { .program = p, .codeCapacity = 0, .varCapacity = 0, .constCapacity = 0, .tempTop = 0, .tempMax = 0,
+                   .intTempTop = 0, .intTempCount = 0, .intVars = NULL, .tableCapacity = 0, .varIndex = initHashIndex(),
+                   .constIndex = initHashIndex(), .error = error };
+
+    collectSymbols(&c, program);
+    countIntTemps(&c, program);
+    compileStatement(&c, program);
+    emit(&c, OP_HALT, 0, 0, 0);
+
+    p->registerCount = p->varCount + p->constCount + c.intTempCount + c.tempMax;
+    free(c.intVars);
+    freeHashIndex(&c.varIndex);
+    freeHashIndex(&c.constIndex);
+
+    if (error->hasError) {
+        deleteProgram(&p);
+        return NULL;
+    }
+    return p;
+}
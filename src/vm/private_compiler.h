@@ -0,0 +1,63 @@
+#ifndef PRIVATE_COMPILER_H
+#define PRIVATE_COMPILER_H
+
+#include "vm.h"
+#include "dataStructures/hashIndex.h"
+
+#define SWITCH_MIN_CASES 3 // Shorter runs of IFs are cheaper as fused compare-and-jumps
+#define SWITCH_MAX_SPAN 2 // A jump table is dense while its values span at most this many entries per case
+
+// Case of a SWITCH, sorted by value when building its jump table
+typedef struct SwitchCase SwitchCase;
+struct SwitchCase {
+    int value;
+    int target;
+};
+
+// State kept while translating the AST into instructions
+typedef struct Compiler Compiler;
+struct Compiler {
+    VMProgram* program;
+    int codeCapacity;
+    int varCapacity;
+    int constCapacity;
+    int tempTop; // Next free temporary, temporaries are used like a stack
+    int tempMax;
+    int intTempTop; // Temporaries that only hold integers, placed before the other ones
+    int intTempCount; // Known before emitting, so the other temporaries can be placed after them
+    bool* intVars; // Variables that never hold a string, by register
+    int tableCapacity;
+    HashIndex varIndex; // Register of each name in program->varNames
+    HashIndex constIndex; // Position of each value in program->constants
+    SimplicError* error;
+};
+
+// Symbol tables, variables and constants are given a register before emitting code
+static void collectSymbols(Compiler* c, SyntaxNode* node); // Registers every var and constant of a tree
+static int findVar(Compiler* c, const char* name); // Register of the variable or -1
+static int addVar(Compiler* c, const char* name);
+static int findIntConstant(Compiler* c, int n); // Register of the constant or -1
+static int findStrConstant(Compiler* c, const char* s);
+static int addConstant(Compiler* c, SimplicValue value);
+
+static int allocTemp(Compiler* c);
+static int allocIntTemp(Compiler* c);
+static int intTempsNeeded(SyntaxNode* expr); // Integer temporaries used at once while computing expr
+static void countIntTemps(Compiler* c, SyntaxNode* node);
+static bool neverString(Compiler* c, int reg); // True if int forms can write the register
+static int emit(Compiler* c, OpCode opcode, int a, int b, int c_); // Returns the address of the instruction
+static bool binOpCode(const char* operator, OpCode* opcode); // Operator string to opcode
+
+// Code generators
+static int compileExpr(Compiler* c, SyntaxNode* node, int dest); // Returns register holding the result
+static void compileStatement(Compiler* c, SyntaxNode* node);
+static int compileBranch(Compiler* c, SyntaxNode* cond, bool onTrue, int target, ConditionKind kind); // Returns the address of the jump
+static bool writesVar(SyntaxNode* node, const char* name); // True if a statement may change the variable
+static bool switchCase(SyntaxNode* node, const char** var, int* value); // True for IF var EQ value THEN ... FI
+static int switchRunLength(SyntaxNode** statements); // IFs from the first statement that can share a SWITCH
+static void compileSwitch(Compiler* c, SyntaxNode** cases, int count);
+static int compareSwitchCases(const void* a, const void* b); // qsort() order of SwitchCase
+static void fillJumpTable(JumpTable* table, SwitchCase* cases, int count, int otherwise);
+static bool fusedBranchCode(const char* operator, bool onTrue, OpCode* opcode); // Superinstruction of a comparison
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef PRIVATE_VM_H
+#define PRIVATE_VM_H
+
+#include "vm.h"
+#include "jit.h"
+
+// Register helpers, a register owns the string it stores (except constant registers)
+static void vm_setInt(SimplicValue* reg, int n);
+static void vm_setStr(SimplicValue* reg, char* s); // Takes ownership of s
+static void vm_copy(SimplicValue* dest, const SimplicValue* src);
+static void vm_clear(SimplicValue* reg); // Leaves the register empty (VALUE_VOID)
+static int vm_intOf(const SimplicValue* reg); // Strings count as 0 in arithmetic, like in eval()
+
+static char* vm_concat(const SimplicValue* l, const SimplicValue* r); // String concatenation of + operator
+static int vm_switchTarget(const JumpTable* table, int value);
+static void vm_undeclaredVar(VMProgram* program, int reg, SimplicError* error);
+static const char* vm_opName(OpCode opcode); // Used by the disassembler
+
+#endif
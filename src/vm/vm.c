@@ -0,0 +1,362 @@
+#include "private_vm.h"
+
+void vm_setInt(SimplicValue* reg, int n) {
+    if (reg->type == VALUE_STR) free(reg->string);
+    *reg = (SimplicValue){ .type = VALUE_INT, .integer = n, .string = NULL };
+}
+
+void vm_setStr(SimplicValue* reg, char* s) {
+    if (reg->type == VALUE_STR) free(reg->string);
+    *reg = (SimplicValue){ .type = VALUE_STR, .integer = 0, .string = s };
+}
+
+void vm_copy(SimplicValue* dest, const SimplicValue* src) {
+    if (dest == src) return;
+
+    if (src->type == VALUE_STR) {
+        char* copy = malloc(sizeof(char) * (strlen(src->string) + 1));
+        strcpy(copy, src->string);
+        vm_setStr(dest, copy);
+    } else {
+        vm_setInt(dest, src->integer);
+    }
+}
+
+void vm_clear(SimplicValue* reg) {
+    if (reg->type == VALUE_STR) free(reg->string);
+    *reg = (SimplicValue){ .type = VALUE_VOID, .integer = 0, .string = NULL };
+}
+
+int vm_intOf(const SimplicValue* reg) {
+    return (reg->type == VALUE_INT) ? reg->integer : 0;
+}
+
+char* vm_concat(const SimplicValue* l, const SimplicValue* r) {
+    int len = CHARS_FOR_INT_TO_STRING + 1;
+    len += (l->type == VALUE_STR) ? strlen(l->string) : 0;
+    len += (r->type == VALUE_STR) ? strlen(r->string) : 0;
+    char* buffer = malloc(sizeof(char) * (len + 1));
+
+    if (l->type == VALUE_STR && r->type == VALUE_STR) {
+        snprintf(buffer, len + 1, "%s%s", l->string, r->string);
+    } else if (l->type == VALUE_STR) {
+        snprintf(buffer, len + 1, "%s%d", l->string, r->integer);
+    } else {
+        snprintf(buffer, len + 1, "%d%s", l->integer, r->string);
+    }
+    return buffer;
+}
+
+int vm_switchTarget(const JumpTable* table, int value) {
+    if (table->keys == NULL) {
+        unsigned int i = (unsigned int)value - (unsigned int)table->low; // Values below low wrap to large indexes
+        return (i < (unsigned int)table->count) ? table->targets[i] : table->otherwise;
+    }
+
+    int lo = 0, hi = table->count - 1;
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (table->keys[mid] == value) return table->targets[mid];
+        if (table->keys[mid] < value) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return table->otherwise;
+}
+
+void vm_undeclaredVar(VMProgram* program, int reg, SimplicError* error) {
+    const char* name = (reg < program->varCount) ? program->varNames[reg] : "?";
+    setError(error, ERROR_ACCESS_TO_UNDECLARED_VAR, "Variable %s not initialized", name);
+}
+
+// Threaded code needs GCC's labels as values, other compilers use a switch inside a loop
+#if defined(__GNUC__) && !defined(SIMPLIC_NO_COMPUTED_GOTO)
+    #define VM_THREADED
+    #pragma GCC diagnostic ignored "-Wpedantic"
+    #define VM_CASE(opcode) L_##opcode:
+    #define VM_NEXT() do { ins = &code[pc++]; goto *ins->handler; } while (0)
+#else
+    #define VM_CASE(opcode) case opcode:
+    #define VM_NEXT() continue
+#endif
+
+// Int forms write registers that never hold a string, so there is nothing to free
+#define VM_STORE_INT(n) do { R[ins->a].type = VALUE_INT; R[ins->a].integer = (n); } while (0)
+#define VM_INT(reg) (R[ins->reg].integer)
+
+// Binary operations check their operands before computing
+#define VM_BINOP_OPERANDS() \
+    l = &R[ins->b]; \
+    r = &R[ins->c]; \
+    if (l->type == VALUE_VOID) { vm_undeclaredVar(program, ins->b, error); goto end; } \
+    if (r->type == VALUE_VOID) { vm_undeclaredVar(program, ins->c, error); goto end; }
+
+SimplicValue runProgram(VMProgram* program, ControlState* control, SimplicError* error) {
+    SimplicValue result = { .type = VALUE_VOID, .integer = 0, .string = NULL };
+    SimplicValue* R = malloc(sizeof(SimplicValue) * program->registerCount);
+    Instruction* code = program->code;
+    Instruction* ins;
+    SimplicValue* l;
+    SimplicValue* r;
+    int pc = 0;
+
+#ifdef VM_THREADED
+    // Same order as OpCode
+    static const void* handlers[] = {
+        &&L_OP_HALT, &&L_OP_MOVE, &&L_OP_ADD, &&L_OP_SUB, &&L_OP_MUL, &&L_OP_DIV, &&L_OP_MOD,
+        &&L_OP_LT, &&L_OP_LEQ, &&L_OP_GT, &&L_OP_GEQ, &&L_OP_EQ, &&L_OP_NEQ, &&L_OP_AND, &&L_OP_OR,
+        &&L_OP_INCR, &&L_OP_DECR, &&L_OP_UNSET, &&L_OP_PRINT, &&L_OP_PRINTLN, &&L_OP_RETURN,
+        &&L_OP_JMP, &&L_OP_JMPF, &&L_OP_JMPT, &&L_OP_JIT_LOOP,
+        &&L_OP_IMOVE, &&L_OP_IADD, &&L_OP_ISUB, &&L_OP_IMUL, &&L_OP_IDIV, &&L_OP_IMOD,
+        &&L_OP_ILT, &&L_OP_ILEQ, &&L_OP_IGT, &&L_OP_IGEQ, &&L_OP_IEQ, &&L_OP_INEQ, &&L_OP_IAND, &&L_OP_IOR,
+        &&L_OP_IINCR, &&L_OP_IDECR, &&L_OP_IJMPF, &&L_OP_IJMPT,
+        &&L_OP_JLT, &&L_OP_JLEQ, &&L_OP_JGT, &&L_OP_JGEQ, &&L_OP_JEQ, &&L_OP_JNEQ, &&L_OP_JMODZ, &&L_OP_JMODNZ,
+        &&L_OP_SWITCH
+    };
+
+    // Handlers are resolved once per instruction, then each one jumps straight to the next
+    if (!program->threaded) {
+        for (int i = 0; i < program->codeSize; i++) {
+            code[i].handler = handlers[code[i].opcode];
+        }
+        program->threaded = true;
+    }
+#endif
+
+    // Variables and temporaries start empty, constants are shared with the program
+    for (int i = 0; i < program->registerCount; i++) {
+        R[i] = (SimplicValue){ .type = VALUE_VOID, .integer = 0, .string = NULL };
+    }
+    memcpy(R + program->varCount, program->constants, sizeof(SimplicValue) * program->constCount);
+
+#ifdef VM_THREADED
+    VM_NEXT();
+    {
+#else
+    for (;;) {
+        ins = &code[pc++];
+        switch (ins->opcode) {
+#endif
+            VM_CASE(OP_HALT)
+                goto end;
+
+            VM_CASE(OP_MOVE)
+                l = &R[ins->b];
+                if (l->type == VALUE_VOID) { vm_undeclaredVar(program, ins->b, error); goto end; }
+                vm_copy(&R[ins->a], l);
+                VM_NEXT();
+
+            VM_CASE(OP_ADD)
+                VM_BINOP_OPERANDS();
+                if (l->type == VALUE_STR || r->type == VALUE_STR) {
+                    vm_setStr(&R[ins->a], vm_concat(l, r)); // Result is built before the destination is released
+                } else {
+                    vm_setInt(&R[ins->a], l->integer + r->integer);
+                }
+                VM_NEXT();
+
+            VM_CASE(OP_SUB) VM_BINOP_OPERANDS(); vm_setInt(&R[ins->a], vm_intOf(l) - vm_intOf(r)); VM_NEXT();
+            VM_CASE(OP_MUL) VM_BINOP_OPERANDS(); vm_setInt(&R[ins->a], vm_intOf(l) * vm_intOf(r)); VM_NEXT();
+
+            VM_CASE(OP_DIV)
+            VM_CASE(OP_MOD)
+                VM_BINOP_OPERANDS();
+                if (vm_intOf(r) == 0) {
+                    setError(error, ERROR_DIVISION_BY_ZERO, "Division by 0, execution halted");
+                    goto end;
+                }
+                vm_setInt(&R[ins->a], (ins->opcode == OP_DIV) ? vm_intOf(l) / vm_intOf(r) : vm_intOf(l) % vm_intOf(r));
+                VM_NEXT();
+
+            VM_CASE(OP_LT) VM_BINOP_OPERANDS(); vm_setInt(&R[ins->a], vm_intOf(l) < vm_intOf(r)); VM_NEXT();
+            VM_CASE(OP_LEQ) VM_BINOP_OPERANDS(); vm_setInt(&R[ins->a], vm_intOf(l) <= vm_intOf(r)); VM_NEXT();
+            VM_CASE(OP_GT) VM_BINOP_OPERANDS(); vm_setInt(&R[ins->a], vm_intOf(l) > vm_intOf(r)); VM_NEXT();
+            VM_CASE(OP_GEQ) VM_BINOP_OPERANDS(); vm_setInt(&R[ins->a], vm_intOf(l) >= vm_intOf(r)); VM_NEXT();
+            VM_CASE(OP_EQ) VM_BINOP_OPERANDS(); vm_setInt(&R[ins->a], vm_intOf(l) == vm_intOf(r)); VM_NEXT();
+            VM_CASE(OP_NEQ) VM_BINOP_OPERANDS(); vm_setInt(&R[ins->a], vm_intOf(l) != vm_intOf(r)); VM_NEXT();
+            VM_CASE(OP_AND) VM_BINOP_OPERANDS(); vm_setInt(&R[ins->a], vm_intOf(l) && vm_intOf(r)); VM_NEXT();
+            VM_CASE(OP_OR) VM_BINOP_OPERANDS(); vm_setInt(&R[ins->a], vm_intOf(l) || vm_intOf(r)); VM_NEXT();
+
+            VM_CASE(OP_INCR)
+            VM_CASE(OP_DECR)
+                if (R[ins->a].type == VALUE_VOID) { vm_undeclaredVar(program, ins->a, error); goto end; }
+                if (R[ins->a].type == VALUE_INT) R[ins->a].integer += (ins->opcode == OP_INCR) ? 1 : -1;
+                VM_NEXT();
+
+            VM_CASE(OP_UNSET)
+                if (R[ins->a].type == VALUE_VOID) {
+                    setError(error, ERROR_ACCESS_TO_UNDECLARED_VAR, "Tried to unset undeclared variable %s", program->varNames[ins->a]);
+                    goto end;
+                }
+                vm_clear(&R[ins->a]);
+                VM_NEXT();
+
+            VM_CASE(OP_PRINT)
+            VM_CASE(OP_PRINTLN)
+                l = &R[ins->a];
+                if (l->type == VALUE_VOID) { vm_undeclaredVar(program, ins->a, error); goto end; }
+
+                if (l->type == VALUE_INT) {
+                    fprintf(control->out, "%d%s", l->integer, (ins->opcode == OP_PRINTLN) ? "\n" : ""); // Add \n if PRINTLN
+                } else {
+                    fprintf(control->out, "%s%s", l->string, (ins->opcode == OP_PRINTLN) ? "\n" : "");
+                }
+                VM_NEXT();
+
+            VM_CASE(OP_RETURN)
+                if (R[ins->a].type == VALUE_VOID) { vm_undeclaredVar(program, ins->a, error); goto end; }
+                vm_copy(&result, &R[ins->a]);
+                control->returned = true;
+                goto end;
+
+            VM_CASE(OP_JMP)
+                pc = ins->b;
+                VM_NEXT();
+
+            VM_CASE(OP_JMPF)
+            VM_CASE(OP_JMPT)
+                l = &R[ins->a];
+                if (l->type == VALUE_VOID) { vm_undeclaredVar(program, ins->a, error); goto end; }
+                if (l->type != VALUE_INT) {
+                    setError(error, ERROR_TYPE_MISMATCH, (ins->c == COND_WHILE) ? "WHILE condition must be integer" : "IF condition must be integer");
+                    goto end;
+                }
+                if ((l->integer != 0) == (ins->opcode == OP_JMPT)) pc = ins->b;
+                VM_NEXT();
+
+            VM_CASE(OP_JIT_LOOP)
+                pc = jitRunLoop(&program->jitLoops[ins->a], R, ins->b); // Returns where the bytecode resumes
+                VM_NEXT();
+
+            VM_CASE(OP_IMOVE) VM_STORE_INT(VM_INT(b)); VM_NEXT();
+            VM_CASE(OP_IADD) VM_STORE_INT(VM_INT(b) + VM_INT(c)); VM_NEXT();
+            VM_CASE(OP_ISUB) VM_STORE_INT(VM_INT(b) - VM_INT(c)); VM_NEXT();
+            VM_CASE(OP_IMUL) VM_STORE_INT(VM_INT(b) * VM_INT(c)); VM_NEXT();
+
+            VM_CASE(OP_IDIV)
+            VM_CASE(OP_IMOD)
+                if (VM_INT(c) == 0) {
+                    setError(error, ERROR_DIVISION_BY_ZERO, "Division by 0, execution halted");
+                    goto end;
+                }
+                VM_STORE_INT((ins->opcode == OP_IDIV) ? VM_INT(b) / VM_INT(c) : VM_INT(b) % VM_INT(c));
+                VM_NEXT();
+
+            VM_CASE(OP_ILT) VM_STORE_INT(VM_INT(b) < VM_INT(c)); VM_NEXT();
+            VM_CASE(OP_ILEQ) VM_STORE_INT(VM_INT(b) <= VM_INT(c)); VM_NEXT();
+            VM_CASE(OP_IGT) VM_STORE_INT(VM_INT(b) > VM_INT(c)); VM_NEXT();
+            VM_CASE(OP_IGEQ) VM_STORE_INT(VM_INT(b) >= VM_INT(c)); VM_NEXT();
+            VM_CASE(OP_IEQ) VM_STORE_INT(VM_INT(b) == VM_INT(c)); VM_NEXT();
+            VM_CASE(OP_INEQ) VM_STORE_INT(VM_INT(b) != VM_INT(c)); VM_NEXT();
+            VM_CASE(OP_IAND) VM_STORE_INT(VM_INT(b) && VM_INT(c)); VM_NEXT();
+            VM_CASE(OP_IOR) VM_STORE_INT(VM_INT(b) || VM_INT(c)); VM_NEXT();
+
+            VM_CASE(OP_IINCR) VM_INT(a)++; VM_NEXT();
+            VM_CASE(OP_IDECR) VM_INT(a)--; VM_NEXT();
+
+            VM_CASE(OP_IJMPF) if (VM_INT(a) == 0) pc = ins->b; VM_NEXT();
+            VM_CASE(OP_IJMPT) if (VM_INT(a) != 0) pc = ins->b; VM_NEXT();
+
+            VM_CASE(OP_JLT) if (VM_INT(a) < VM_INT(c)) pc = ins->b; VM_NEXT();
+            VM_CASE(OP_JLEQ) if (VM_INT(a) <= VM_INT(c)) pc = ins->b; VM_NEXT();
+            VM_CASE(OP_JGT) if (VM_INT(a) > VM_INT(c)) pc = ins->b; VM_NEXT();
+            VM_CASE(OP_JGEQ) if (VM_INT(a) >= VM_INT(c)) pc = ins->b; VM_NEXT();
+            VM_CASE(OP_JEQ) if (VM_INT(a) == VM_INT(c)) pc = ins->b; VM_NEXT();
+            VM_CASE(OP_JNEQ) if (VM_INT(a) != VM_INT(c)) pc = ins->b; VM_NEXT();
+
+            VM_CASE(OP_JMODZ)
+            VM_CASE(OP_JMODNZ)
+                if (VM_INT(c) == 0) {
+                    setError(error, ERROR_DIVISION_BY_ZERO, "Division by 0, execution halted");
+                    goto end;
+                }
+                if ((VM_INT(a) % VM_INT(c) == 0) == (ins->opcode == OP_JMODZ)) pc = ins->b;
+                VM_NEXT();
+
+            VM_CASE(OP_SWITCH)
+                pc = vm_switchTarget(&program->jumpTables[ins->b], VM_INT(a));
+                VM_NEXT();
+#ifndef VM_THREADED
+        }
+#endif
+    }
+
+end:
+    // Constant registers belong to the program
+    for (int i = 0; i < program->registerCount; i++) {
+        if (i < program->varCount || i >= program->varCount + program->constCount) vm_clear(&R[i]);
+    }
+    free(R);
+    return result;
+}
+
+const char* vm_opName(OpCode opcode) {
+    static const char* names[] = {
+        "HALT", "MOVE", "ADD", "SUB", "MUL", "DIV", "MOD", "LT", "LEQ", "GT", "GEQ", "EQ", "NEQ",
+        "AND", "OR", "INCR", "DECR", "UNSET", "PRINT", "PRINTLN", "RETURN", "JMP", "JMPF", "JMPT", "JITLOOP",
+        "IMOVE", "IADD", "ISUB", "IMUL", "IDIV", "IMOD", "ILT", "ILEQ", "IGT", "IGEQ", "IEQ", "INEQ",
+        "IAND", "IOR", "IINCR", "IDECR", "IJMPF", "IJMPT",
+        "JLT", "JLEQ", "JGT", "JGEQ", "JEQ", "JNEQ", "JMODZ", "JMODNZ", "SWITCH"
+    };
+    return names[opcode];
+}
+
+OpCode genericOpcode(OpCode opcode) {
+    static const OpCode generic[] = {
+        OP_MOVE, OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_MOD, OP_LT, OP_LEQ, OP_GT, OP_GEQ, OP_EQ, OP_NEQ,
+        OP_AND, OP_OR, OP_INCR, OP_DECR, OP_JMPF, OP_JMPT
+    };
+    return (opcode >= OP_IMOVE && opcode <= OP_IJMPT) ? generic[opcode - OP_IMOVE] : opcode;
+}
+
+void printProgram(VMProgram* program) {
+    printf("; %d variables, %d constants, %d registers\n", program->varCount, program->constCount, program->registerCount);
+    for (int i = 0; i < program->varCount; i++) {
+        printf(";   r%d = %s\n", i, program->varNames[i]);
+    }
+    for (int i = 0; i < program->constCount; i++) {
+        SimplicValue k = program->constants[i];
+        if (k.type == VALUE_INT) {
+            printf(";   r%d = %d\n", program->varCount + i, k.integer);
+        } else {
+            printf(";   r%d = \"%s\"\n", program->varCount + i, k.string);
+        }
+    }
+
+    for (int i = 0; i < program->codeSize; i++) {
+        Instruction ins = program->code[i];
+        printf("%04d  %-8s %d, %d, %d\n", i, vm_opName(ins.opcode), ins.a, ins.b, ins.c);
+    }
+
+    for (int i = 0; i < program->jumpTableCount; i++) {
+        JumpTable* t = &program->jumpTables[i];
+        printf("; table %d, otherwise %04d:", i, t->otherwise);
+        for (int j = 0; j < t->count; j++) {
+            if (t->keys == NULL && t->targets[j] == t->otherwise) continue; // Hole of a dense table
+            printf(" %d->%04d", (t->keys == NULL) ? t->low + j : t->keys[j], t->targets[j]);
+        }
+        printf("\n");
+    }
+}
+
+void deleteProgram(VMProgram** program) {
+    if (program == NULL || *program == NULL) return;
+
+    VMProgram* p = *program;
+    for (int i = 0; i < p->constCount; i++) {
+        if (p->constants[i].type == VALUE_STR) free(p->constants[i].string);
+    }
+    for (int i = 0; i < p->jumpTableCount; i++) {
+        free(p->jumpTables[i].keys);
+        free(p->jumpTables[i].targets);
+    }
+    free(p->jumpTables);
+    jitDeleteLoops(p);
+    free(p->constants);
+    free(p->varNames);
+    free(p->code);
+    free(p);
+    *program = NULL;
+}
@@ -0,0 +1,277 @@
+#include "unity.h"
+#include "unity_internals.h"
+
+#include "compiler.c"
+#include "vm.c"
+#include "parser.h"
+#include "optimizer.h"
+#include "differential.h"
+
+Token* tokenList;
+SimplicError* error;
+ControlState control;
+
+void setUp(void) {
+    control.returned = false;
+    tokenList = initTokenQueue();
+    control.bank = initMemoryBank();
+    control.out = stdout;
+    error = initError();
+}
+
+void tearDown(void) {
+    deleteTokenQueue(&tokenList);
+    deleteMemoryBank(&control.bank);
+    deleteError(&error);
+}
+
+// Compiles and runs a parsed program in the VM, with the int forms type inference allows
+SimplicValue vmEngine(SyntaxNode* tree, ControlState* control, SimplicError* error) {
+    SimplicValue val = { .type = VALUE_VOID, .integer = 0, .string = NULL };
+    inferTypes(tree);
+    VMProgram* code = compileProgram(tree, error);
+    if (!error->hasError)
+        val = runProgram(code, control, error);
+    deleteProgram(&code);
+    return val;
+}
+
+// Compiles and runs a whole program in the VM
+SimplicValue runVM(const char* program) {
+    SimplicValue val = { .type = VALUE_VOID, .integer = 0, .string = NULL };
+    tokenizeSource(&tokenList, program, error);
+    SyntaxNode* tree = parseProgram(&tokenList, error);
+
+    if (!error->hasError)
+        val = vmEngine(tree, &control, error);
+
+    freeSyntaxTree(tree);
+    return val;
+}
+
+void testReturnCorrectInt(void) {
+    SimplicValue val = runVM("SET X = 7\nRETURN X\n");
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_TRUE(control.returned);
+    TEST_ASSERT_EQUAL_INT(7, val.integer);
+}
+
+void testComplexOperations(void) {
+    SimplicValue val = runVM(
+        "SET X = 2 * 4 + 3\n"
+        "INCR X\n"
+        "DECR X\n"
+        "SET X = X * 2\n"
+        "RETURN X\n");
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(22, val.integer);
+}
+
+void testAccessToUndeclaredVariable(void) {
+    runVM("SET X = X\n");
+    TEST_ASSERT_TRUE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(ERROR_ACCESS_TO_UNDECLARED_VAR, error->errCode);
+    TEST_ASSERT_EQUAL_STRING("Variable X not initialized", error->errMsg);
+}
+
+void testDivisionByZero(void) {
+    runVM("SET X = 9\nSET Y = 0\nSET Z = X / Y\nPRINT Z\n");
+    TEST_ASSERT_TRUE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(ERROR_DIVISION_BY_ZERO, error->errCode);
+}
+
+void testStringConcatenation(void) {
+    SimplicValue val = runVM(
+        "SET X = \"HELLO\"\n"
+        "SET Y = \"WORLD\"\n"
+        "SET X = X + \" \" + Y\n"
+        "RETURN X\n");
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_EQUAL_STRING("HELLO WORLD", val.string);
+    free(val.string);
+}
+
+void testStringAndNumberConcatenation(void) {
+    SimplicValue val = runVM(
+        "SET X = 2 * 76 % 3\n"
+        "SET Y = \"YOUR LUCKY NUMBER IS: \"\n"
+        "RETURN Y + X\n");
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_EQUAL_STRING("YOUR LUCKY NUMBER IS: 2", val.string);
+    free(val.string);
+}
+
+void testUnsetVariable(void) {
+    runVM("SET X = 99\nUNSET X\nRETURN X\n");
+    TEST_ASSERT_TRUE(error->hasError);
+}
+
+void testNestedWhileLoop(void) {
+    SimplicValue val = runVM(
+        "SET X = 0\n"
+        "SET Y = 0\n"
+        "SET ITERS = 0\n"
+        "WHILE X LT 5 DO\n"
+            "WHILE Y LT 5 DO\n"
+                "INCR Y\n"
+                "INCR ITERS\n"
+            "DONE\n"
+            "SET Y = 0\n"
+            "INCR X\n"
+            "INCR ITERS\n"
+        "DONE\n"
+        "RETURN ITERS\n");
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(30, val.integer);
+}
+
+void testIfElse(void) {
+    SimplicValue val = runVM(
+        "SET X = 4\n"
+        "IF X % 2 NEQ 0 THEN\n"
+            "RETURN 1\n"
+        "ELSE\n"
+            "RETURN 0\n"
+        "FI\n");
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(0, val.integer);
+}
+
+void testReturnFromNested(void) {
+    SimplicValue val = runVM(
+        "SET X = 0\n"
+        "WHILE X LT 5 DO\n"
+            "INCR X\n"
+            "IF X EQ 5 THEN\n"
+                "RETURN 0\n"
+            "FI\n"
+        "DONE\n"
+        "RETURN 1\n");
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(0, val.integer);
+}
+
+void testStringConditionIsTypeMismatch(void) {
+    runVM("SET S = \"A\"\nWHILE S DO\nPRINT S\nDONE\n");
+    TEST_ASSERT_TRUE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(ERROR_TYPE_MISMATCH, error->errCode);
+}
+
+// Compiles a program after type inference and tells if it uses an opcode
+bool usesOpcode(const char* program, OpCode opcode) {
+    bool found = false;
+    tokenizeSource(&tokenList, program, error);
+    SyntaxNode* tree = parseProgram(&tokenList, error);
+    TEST_ASSERT_FALSE(error->hasError);
+
+    inferTypes(tree);
+    VMProgram* code = compileProgram(tree, error);
+    for (int i = 0; i < code->codeSize; i++) {
+        if (code->code[i].opcode == opcode) found = true;
+    }
+
+    deleteProgram(&code);
+    freeSyntaxTree(tree);
+    return found;
+}
+
+void testIntFormsForProvenIntegers(void) {
+    const char* counter = "SET I = 0\nSET J = I\nWHILE I * 2 LT 10 DO\nINCR I\nDONE\nRETURN I\n";
+    TEST_ASSERT_TRUE(usesOpcode(counter, OP_IMOVE));
+    TEST_ASSERT_TRUE(usesOpcode(counter, OP_IMUL));
+    TEST_ASSERT_TRUE(usesOpcode(counter, OP_IINCR));
+    TEST_ASSERT_FALSE(usesOpcode(counter, OP_MUL));
+
+    // S is a string on the second iteration, so the loop condition must stay generic
+    const char* mixed = "SET S = 0\nWHILE S LT 10 DO\nSET S = \"A\"\nDONE\n";
+    TEST_ASSERT_TRUE(usesOpcode(mixed, OP_LT));
+    TEST_ASSERT_FALSE(usesOpcode(mixed, OP_ILT));
+}
+
+void testSuperinstructions(void) {
+    const char* loop = "SET I = 0\nWHILE I LT 10 DO\nIF I % 3 EQ 0 THEN\nPRINT I\nFI\nINCR I\nDONE\n";
+    TEST_ASSERT_TRUE(usesOpcode(loop, OP_JLT));
+    TEST_ASSERT_TRUE(usesOpcode(loop, OP_JMODNZ)); // Skips the THEN branch
+    TEST_ASSERT_FALSE(usesOpcode(loop, OP_IMOD));
+    TEST_ASSERT_FALSE(usesOpcode(loop, OP_IJMPT));
+
+    // The condition of an IF jumps when it is false
+    TEST_ASSERT_TRUE(usesOpcode("SET X = 1\nIF X LT 5 THEN\nPRINT X\nFI\n", OP_JGEQ));
+
+    SimplicValue val = runVM("SET X = 0\nSET C = 0\nWHILE X LEQ 20 DO\nIF X % 4 NEQ 0 THEN\nINCR C\nFI\nINCR X\nDONE\nRETURN C\n");
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(15, val.integer);
+    tearDown();
+    setUp();
+
+    runVM("SET X = 4\nSET Y = 0\nIF X % Y EQ 0 THEN\nPRINT X\nFI\n");
+    TEST_ASSERT_EQUAL_INT(ERROR_DIVISION_BY_ZERO, error->errCode);
+}
+
+void testIfChainsBecomeJumpTables(void) {
+    const char* dense = "SET H = 2\nIF H EQ 1 THEN\nPRINT 1\nFI\nIF H EQ 2 THEN\nPRINT 2\nFI\nIF H EQ 3 THEN\nPRINT 3\nFI\n";
+    TEST_ASSERT_TRUE(usesOpcode(dense, OP_SWITCH));
+
+    // Too few cases, or the first body changes the variable the next IF tests
+    TEST_ASSERT_FALSE(usesOpcode("SET H = 2\nIF H EQ 1 THEN\nPRINT 1\nFI\nIF H EQ 2 THEN\nPRINT 2\nFI\n", OP_SWITCH));
+    TEST_ASSERT_FALSE(usesOpcode("SET H = 1\nIF H EQ 1 THEN\nINCR H\nFI\nIF H EQ 2 THEN\nPRINT 2\nFI\nIF H EQ 3 THEN\nPRINT 3\nFI\n", OP_SWITCH));
+
+    // Sparse values use a sorted table, the last case may write the variable
+    SimplicValue val = runVM(
+        "SET H = 0\n"
+        "SET R = 0\n"
+        "WHILE H LT 2000 DO\n"
+            "IF H EQ 1000 THEN\nSET R = R + 1\nFI\n"
+            "IF H EQ 7 THEN\nSET R = R + 10\nFI\n"
+            "IF H EQ 0 - 5 THEN\nSET R = R + 100\nFI\n"
+            "IF H EQ 300 THEN\nSET R = R + 1000\nSET H = 999\nFI\n"
+            "INCR H\n"
+        "DONE\n"
+        "RETURN R\n");
+    TEST_ASSERT_FALSE(error->hasError);
+    TEST_ASSERT_EQUAL_INT(1011, val.integer);
+}
+
+void testSameResultsAsEval(void) {
+    // Operands may be copied to a temporary so they are checked first, like eval() reads them
+    const char* programs[] = {
+        "SET I1 = 2\nSET C = A + I1 * 7\n",
+        "SET A = \"S\"\nSET C = A + I1 * 7\n",
+        "SET A = 1\nSET B = A + B * 2 + C\n",
+        "SET X = 4\nIF X LT Y + 1 THEN\nPRINT X\nFI\n",
+    };
+    assertAllSameAsEval(vmEngine, programs, sizeof(programs) / sizeof(programs[0]));
+}
+
+void testUnsetLeftOperandIsReportedFirst(void) {
+    runVM("SET D = 1\nSET C = A + I1 * 7\n");
+    TEST_ASSERT_EQUAL_INT(ERROR_ACCESS_TO_UNDECLARED_VAR, error->errCode);
+    TEST_ASSERT_EQUAL_STRING("Variable A not initialized", error->errMsg);
+    tearDown();
+    setUp();
+
+    // Proven integers are always set, they are read in place
+    TEST_ASSERT_FALSE(usesOpcode("SET A = 1\nSET B = 2\nSET C = A + B * 7\n", OP_MOVE));
+    TEST_ASSERT_TRUE(usesOpcode("SET B = 2\nSET C = A + B * 7\n", OP_MOVE));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(testReturnCorrectInt);
+    RUN_TEST(testComplexOperations);
+    RUN_TEST(testAccessToUndeclaredVariable);
+    RUN_TEST(testDivisionByZero);
+    RUN_TEST(testStringConcatenation);
+    RUN_TEST(testStringAndNumberConcatenation);
+    RUN_TEST(testUnsetVariable);
+    RUN_TEST(testNestedWhileLoop);
+    RUN_TEST(testIfElse);
+    RUN_TEST(testReturnFromNested);
+    RUN_TEST(testStringConditionIsTypeMismatch);
+    RUN_TEST(testIntFormsForProvenIntegers);
+    RUN_TEST(testSuperinstructions);
+    RUN_TEST(testIfChainsBecomeJumpTables);
+    RUN_TEST(testSameResultsAsEval);
+    RUN_TEST(testUnsetLeftOperandIsReportedFirst);
+    return UNITY_END();
+}